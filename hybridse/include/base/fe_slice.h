@@ -146,9 +146,13 @@ class RefCountedSlice : public Slice {
     RefCountedSlice() : Slice(nullptr, 0), ref_cnt_(nullptr) {}
 
     RefCountedSlice(const RefCountedSlice &slice);
-    RefCountedSlice(RefCountedSlice &&);
+    RefCountedSlice(RefCountedSlice &&) noexcept;
     RefCountedSlice &operator=(const RefCountedSlice &);
-    RefCountedSlice &operator=(RefCountedSlice &&);
+    RefCountedSlice &operator=(RefCountedSlice &&) noexcept;
+
+    // update the reference counts atomically in the calling thread, it is
+    // set by the threads that share rows, e.g. the parallel window aggregation
+    static void SetAtomicRefCount(bool atomic) { atomic_ref_cnt_ = atomic; }
 
  private:
     RefCountedSlice(int8_t *data, size_t size, bool managed)
@@ -163,6 +167,8 @@ class RefCountedSlice : public Slice {
     void Update(const RefCountedSlice &slice);
 
     int32_t *ref_cnt_;
+
+    static thread_local bool atomic_ref_cnt_;
 };
 
 }  // namespace base
@@ -94,6 +94,8 @@ enum SqlNodeType {
     kCreateFunctionStmt,
     kDynamicUdfFnDef,
     kDynamicUdafFnDef,
+    kBinlogCompression,
+    kBinlogDurable,
     kUnknow = -1
 };
 
@@ -382,6 +382,10 @@ class NodeManager {
 
     SqlNode *MakeStorageModeNode(StorageMode storage_mode);
 
+    SqlNode *MakeBinlogCompressionNode(const std::string &compression);
+
+    SqlNode *MakeBinlogDurableNode(bool durable);
+
     SqlNode *MakePartitionNumNode(int num);
 
     SqlNode *MakeDistributionsNode(const NodePointVector& distribution_list);
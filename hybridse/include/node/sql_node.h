@@ -1884,6 +1884,35 @@ class StorageModeNode : public SqlNode {
     StorageMode storage_mode_;
 };
 
+class BinlogCompressionNode : public SqlNode {
+ public:
+    explicit BinlogCompressionNode(const std::string &compression)
+        : SqlNode(kBinlogCompression, 0, 0), compression_(compression) {}
+
+    ~BinlogCompressionNode() {}
+
+    const std::string &GetCompression() const { return compression_; }
+
+    void Print(std::ostream &output, const std::string &org_tab) const;
+
+ private:
+    std::string compression_;
+};
+
+class BinlogDurableNode : public SqlNode {
+ public:
+    explicit BinlogDurableNode(bool durable) : SqlNode(kBinlogDurable, 0, 0), durable_(durable) {}
+
+    ~BinlogDurableNode() {}
+
+    bool GetDurable() const { return durable_; }
+
+    void Print(std::ostream &output, const std::string &org_tab) const;
+
+ private:
+    bool durable_;
+};
+
 class CreateStmt : public SqlNode {
  public:
     CreateStmt()
@@ -258,6 +258,12 @@ class TableHandler : public DataHandler {
         const std::string& index_name, const std::vector<std::string>& pks) {
         return std::shared_ptr<Tablet>();
     }
+
+    /// Return the write version of the dataset to `version`, which changes
+    /// whenever its rows are written, so that results read from it can be
+    /// cached while the version is unchanged.
+    /// Return `false` by default, which means the version is unknown.
+    virtual bool GetWriteVersion(uint64_t* version) { return false; }
 };
 
 /// \brief A table dataset's error handler, representing a error table
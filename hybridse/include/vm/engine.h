@@ -37,6 +37,9 @@
 #include "vm/router.h"
 
 namespace hybridse {
+namespace base {
+class ThreadPool;
+}  // namespace base
 namespace vm {
 
 using ::hybridse::codec::Row;
@@ -440,6 +443,8 @@ class Engine {
     EngineOptions options_;
     base::SpinMutex mu_;
     EngineLRUCache lru_cache_;
+    // the threads of the batch window aggregation shared by the queries
+    std::shared_ptr<base::ThreadPool> window_thread_pool_;
 };
 
 /// \brief Local tablet is responsible to run a task locally.
@@ -240,6 +240,19 @@ class MemTimeTableHandler : public TableHandler {
     OrderType order_type_;
 };
 
+// WindowListener is told of the rows entering and leaving the effective
+// window, so the aggregates over the window can be maintained incrementally
+class WindowListener {
+ public:
+    virtual ~WindowListener() {}
+    // the row becomes the newest row of the window
+    virtual void OnAddFront(const Row& row) = 0;
+    // the oldest row leaves the window
+    virtual void OnPopBack(const Row& row) = 0;
+    // the newest row leaves the window
+    virtual void OnPopFront(const Row& row) = 0;
+};
+
 class Window : public MemTimeTableHandler {
  public:
     enum WindowFrameType {
@@ -280,10 +293,34 @@ class Window : public MemTimeTableHandler {
     bool exclude_current_row() const { return exclude_current_row_; }
     void set_exclude_current_row(bool flag) { exclude_current_row_ = flag; }
 
+    // the listener should outlive the window
+    void set_listener(WindowListener* listener) { listener_ = listener; }
+
+    // the same as those of MemTimeTableHandler, the listener is told of the change
+    void AddFrontRow(const uint64_t key, const Row& row) {
+        MemTimeTableHandler::AddFrontRow(key, row);
+        if (listener_ != nullptr) {
+            listener_->OnAddFront(row);
+        }
+    }
+    void PopBackRow() {
+        if (listener_ != nullptr) {
+            listener_->OnPopBack(table_.back().second);
+        }
+        MemTimeTableHandler::PopBackRow();
+    }
+    void PopFrontRow() {
+        if (listener_ != nullptr) {
+            listener_->OnPopFront(table_.front().second);
+        }
+        MemTimeTableHandler::PopFrontRow();
+    }
+
  protected:
     bool exclude_current_time_ = false;
     bool exclude_current_row_ = false;
     bool instance_not_in_window_ = false;
+    WindowListener* listener_ = nullptr;
 };
 class WindowRange {
  public:
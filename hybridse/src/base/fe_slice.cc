@@ -19,12 +19,17 @@
 namespace hybridse {
 namespace base {
 
+thread_local bool RefCountedSlice::atomic_ref_cnt_ = false;
+
 RefCountedSlice::~RefCountedSlice() { Release(); }
 
+// an atomic update costs about ten times a plain one, so it is only done by
+// the threads which share rows
 void RefCountedSlice::Release() {
     if (this->ref_cnt_ != nullptr) {
-        auto& cnt = *this->ref_cnt_;
-        cnt -= 1;
+        int32_t cnt = atomic_ref_cnt_
+                          ? __atomic_sub_fetch(this->ref_cnt_, 1, __ATOMIC_ACQ_REL)
+                          : --(*this->ref_cnt_);
         if (cnt == 0) {
             free(buf());
             delete this->ref_cnt_;
@@ -35,8 +40,13 @@ void RefCountedSlice::Release() {
 void RefCountedSlice::Update(const RefCountedSlice& slice) {
     reset(slice.data(), slice.size());
     this->ref_cnt_ = slice.ref_cnt_;
-    if (this->ref_cnt_ != nullptr) {
-        (*this->ref_cnt_) += 1;
+    if (this->ref_cnt_ == nullptr) {
+        return;
+    }
+    if (atomic_ref_cnt_) {
+        __atomic_add_fetch(this->ref_cnt_, 1, __ATOMIC_RELAXED);
+    } else {
+        (*this->ref_cnt_)++;
     }
 }
 
@@ -44,8 +54,11 @@ RefCountedSlice::RefCountedSlice(const RefCountedSlice& slice) {
     this->Update(slice);
 }
 
-RefCountedSlice::RefCountedSlice(RefCountedSlice&& slice) {
-    this->Update(slice);
+// the moved slice hands over its reference, the count is not touched
+RefCountedSlice::RefCountedSlice(RefCountedSlice&& slice) noexcept
+    : Slice(slice.data(), slice.size()), ref_cnt_(slice.ref_cnt_) {
+    slice.reset(nullptr, 0);
+    slice.ref_cnt_ = nullptr;
 }
 
 RefCountedSlice& RefCountedSlice::operator=(const RefCountedSlice& slice) {
@@ -57,12 +70,15 @@ RefCountedSlice& RefCountedSlice::operator=(const RefCountedSlice& slice) {
     return *this;
 }
 
-RefCountedSlice& RefCountedSlice::operator=(RefCountedSlice&& slice) {
+RefCountedSlice& RefCountedSlice::operator=(RefCountedSlice&& slice) noexcept {
     if (&slice == this) {
         return *this;
     }
     this->Release();
-    this->Update(slice);
+    reset(slice.data(), slice.size());
+    this->ref_cnt_ = slice.ref_cnt_;
+    slice.reset(nullptr, 0);
+    slice.ref_cnt_ = nullptr;
     return *this;
 }
 
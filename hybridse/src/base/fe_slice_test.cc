@@ -15,6 +15,11 @@
  */
 
 #include "base/fe_slice.h"
+
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 namespace hybridse {
@@ -46,6 +51,46 @@ TEST_F(SliceTest, ref_cnt_slice) {
     ASSERT_EQ(0, strcmp(reinterpret_cast<char*>(ref.buf()), "hello world"));
 }
 
+TEST_F(SliceTest, ref_cnt_slice_shared_by_threads) {
+    auto buf = reinterpret_cast<int8_t*>(malloc(1024));
+    strcpy(reinterpret_cast<char*>(buf), "hello world");  // NOLINT
+    auto slice = RefCountedSlice::CreateManaged(buf, 1024);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&slice]() {
+            RefCountedSlice::SetAtomicRefCount(true);
+            for (int j = 0; j < 100000; j++) {
+                RefCountedSlice copy = slice;
+                RefCountedSlice other;
+                other = copy;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(0, strcmp(reinterpret_cast<char*>(slice.buf()), "hello world"));
+}
+
+TEST_F(SliceTest, ref_cnt_slice_move) {
+    auto buf = reinterpret_cast<int8_t*>(malloc(1024));
+    strcpy(reinterpret_cast<char*>(buf), "hello world");  // NOLINT
+    auto slice = RefCountedSlice::CreateManaged(buf, 1024);
+    RefCountedSlice moved(std::move(slice));
+    ASSERT_EQ(nullptr, slice.buf());  // NOLINT
+    ASSERT_EQ(0u, slice.size());  // NOLINT
+    RefCountedSlice other;
+    other = std::move(moved);
+    ASSERT_EQ(nullptr, moved.buf());  // NOLINT
+    ASSERT_EQ(buf, other.buf());
+    ASSERT_EQ(1024u, other.size());
+    {
+        RefCountedSlice copy = other;
+        ASSERT_EQ(buf, copy.buf());
+    }
+    ASSERT_EQ(0, strcmp(reinterpret_cast<char*>(other.buf()), "hello world"));
+}
+
 }  // namespace base
 }  // namespace hybridse
 
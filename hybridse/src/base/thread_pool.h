@@ -0,0 +1,88 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_BASE_THREAD_POOL_H_
+#define HYBRIDSE_SRC_BASE_THREAD_POOL_H_
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace hybridse {
+namespace base {
+
+// ThreadPool runs the tasks on a fixed number of threads in the order they are
+// added, the tasks left are run before the threads exit
+class ThreadPool {
+ public:
+    explicit ThreadPool(size_t thread_num) {
+        for (size_t i = 0; i < thread_num; i++) {
+            threads_.emplace_back([this]() { Loop(); });
+        }
+    }
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadNum() const { return threads_.size(); }
+
+    void AddTask(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+ private:
+    void Loop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace base
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_BASE_THREAD_POOL_H_
@@ -22,3 +22,32 @@ DEFINE_string(default_db_name, "_hybridse",
 // Offline Spark config
 DEFINE_bool(enable_spark_unsaferow_format, false,
             "config if codec uses Spark UnsafeRow format");
+
+// Batch window aggregation config
+DEFINE_bool(enable_incremental_window_agg, true,
+            "config if the sum/count/avg/min/max over a window of batch mode are "
+            "updated as the rows slide through the window");
+DEFINE_int32(batch_window_parallelism, 1,
+             "config the number of threads to compute the window aggregation "
+             "of the partition keys in batch mode, including the thread of the query. "
+             "the other threads are created with an engine and shared by its queries, "
+             "1 to compute them in order");
+
+// Batch project and filter config
+DEFINE_bool(enable_vectorized_project, true,
+            "config if the arithmetic, comparisons and logical operations over "
+            "numeric columns of table project and filter are evaluated in batches of rows");
+
+// Batch join config
+DEFINE_bool(enable_batch_hash_join, true,
+            "config if last join of batch mode builds a hash table of the right "
+            "table once when it is not partitioned by an index");
+
+// Request window cache config
+DEFINE_int32(request_window_cache_capacity, 0,
+             "the max count of windows of the recent requests that a request union "
+             "keeps, a window is reused while the segments it's read from are not "
+             "written. 0 means disabled");
+DEFINE_int64(request_window_cache_max_bytes, 64 * 1024 * 1024,
+             "the max bytes of the rows of the windows that a request union keeps, "
+             "a window larger than it is not kept");
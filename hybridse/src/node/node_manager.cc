@@ -1049,6 +1049,16 @@ SqlNode *NodeManager::MakeStorageModeNode(StorageMode storage_mode) {
     return RegisterNode(node_ptr);
 }
 
+SqlNode *NodeManager::MakeBinlogCompressionNode(const std::string &compression) {
+    SqlNode *node_ptr = new BinlogCompressionNode(compression);
+    return RegisterNode(node_ptr);
+}
+
+SqlNode *NodeManager::MakeBinlogDurableNode(bool durable) {
+    SqlNode *node_ptr = new BinlogDurableNode(durable);
+    return RegisterNode(node_ptr);
+}
+
 SqlNode *NodeManager::MakePartitionNumNode(int num) {
     SqlNode *node_ptr = new PartitionNumNode(num);
     return RegisterNode(node_ptr);
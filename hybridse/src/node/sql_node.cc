@@ -1180,6 +1180,12 @@ std::string NameOfSqlNodeType(const SqlNodeType &type) {
         case kStorageMode:
             output = "kStorageMode";
             break;
+        case kBinlogCompression:
+            output = "kBinlogCompression";
+            break;
+        case kBinlogDurable:
+            output = "kBinlogDurable";
+            break;
         case kFn:
             output = "kFn";
             break;
@@ -2554,6 +2560,20 @@ void StorageModeNode::Print(std::ostream &output, const std::string &org_tab) co
     PrintValue(output, tab, StorageModeName(storage_mode_), "storage_mode", true);
 }
 
+void BinlogCompressionNode::Print(std::ostream &output, const std::string &org_tab) const {
+    SqlNode::Print(output, org_tab);
+    const std::string tab = org_tab + INDENT + SPACE_ED;
+    output << "\n";
+    PrintValue(output, tab, compression_, "binlog_compression", true);
+}
+
+void BinlogDurableNode::Print(std::ostream &output, const std::string &org_tab) const {
+    SqlNode::Print(output, org_tab);
+    const std::string tab = org_tab + INDENT + SPACE_ED;
+    output << "\n";
+    PrintValue(output, tab, durable_ ? "true" : "false", "binlog_durable", true);
+}
+
 void PartitionNumNode::Print(std::ostream &output, const std::string &org_tab) const {
     SqlNode::Print(output, org_tab);
     const std::string tab = org_tab + INDENT + SPACE_ED;
@@ -1707,6 +1707,15 @@ base::Status ConvertTableOption(const zetasql::ASTOptionsEntry* entry, node::Nod
         CHECK_STATUS(AstStringLiteralToString(entry->value(), &storage_mode));
         boost::to_lower(storage_mode);
         *output = node_manager->MakeStorageModeNode(node::NameToStorageMode(storage_mode));
+    } else if (boost::equals("binlog_compression", identifier)) {
+        std::string compression;
+        CHECK_STATUS(AstStringLiteralToString(entry->value(), &compression));
+        boost::to_lower(compression);
+        *output = node_manager->MakeBinlogCompressionNode(compression);
+    } else if (boost::equals("binlog_durable", identifier)) {
+        const auto literal = entry->value()->GetAsOrNull<zetasql::ASTBooleanLiteral>();
+        CHECK_TRUE(literal != nullptr, common::kSqlAstError, "binlog_durable should be true or false");
+        *output = node_manager->MakeBinlogDurableNode(boost::iequals("true", literal->image()));
     } else {
         return base::Status(common::kOk, "create table option ignored");
     }
@@ -75,5 +75,27 @@ std::shared_ptr<PartitionHandler> TableFilterWrapper::GetPartition(
             new PartitionFilterWrapper(partition, parameter_, fun_));
     }
 }
+
+void IteratorBatchFilterWrapper::NextBatch() {
+    keys_.clear();
+    rows_.clear();
+    pos_ = 0;
+    while (rows_.empty() && iter_->Valid()) {
+        batch_keys_.clear();
+        batch_rows_.clear();
+        while (iter_->Valid() && batch_rows_.size() < COLUMN_BATCH_SIZE) {
+            batch_keys_.push_back(iter_->GetKey());
+            batch_rows_.push_back(iter_->GetValue());
+            iter_->Next();
+        }
+        plan_->Evaluate(batch_rows_.data(), batch_rows_.size(), &batch_);
+        for (size_t i = 0; i < batch_rows_.size(); i++) {
+            if (plan_->Condition(batch_, i)) {
+                keys_.push_back(batch_keys_[i]);
+                rows_.push_back(batch_rows_[i]);
+            }
+        }
+    }
+}
 }  // namespace vm
 }  // namespace hybridse
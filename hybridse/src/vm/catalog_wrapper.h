@@ -19,7 +19,9 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 #include "vm/catalog.h"
+#include "vm/vectorized_project.h"
 namespace hybridse {
 namespace vm {
 
@@ -90,6 +92,54 @@ class IteratorFilterWrapper : public RowIterator {
     const PredicateFun* predicate_;
 };
 
+// IteratorBatchFilterWrapper evaluates the condition of the plan over the
+// rows of `iter` a batch at a time, and buffers the rows that pass
+class IteratorBatchFilterWrapper : public RowIterator {
+ public:
+    IteratorBatchFilterWrapper(std::unique_ptr<RowIterator> iter, const VectorizedProjectPlan* plan)
+        : RowIterator(),
+          iter_(std::move(iter)),
+          plan_(plan),
+          batch_(plan),
+          keys_(),
+          rows_(),
+          batch_keys_(),
+          batch_rows_(),
+          pos_(0) {}
+    virtual ~IteratorBatchFilterWrapper() {}
+    bool Valid() const override { return pos_ < rows_.size(); }
+    void Next() override {
+        if (++pos_ >= rows_.size()) {
+            NextBatch();
+        }
+    }
+    const uint64_t& GetKey() const override { return keys_[pos_]; }
+    const Row& GetValue() override { return rows_[pos_]; }
+    void Seek(const uint64_t& k) override {
+        iter_->Seek(k);
+        NextBatch();
+    }
+    void SeekToFirst() override {
+        iter_->SeekToFirst();
+        NextBatch();
+    }
+    bool IsSeekable() const override { return iter_->IsSeekable(); }
+
+ private:
+    // read batches from `iter` until some of the rows pass or it ends
+    void NextBatch();
+
+    std::unique_ptr<RowIterator> iter_;
+    const VectorizedProjectPlan* plan_;
+    ColumnBatch batch_;
+    // the rows passed
+    std::vector<uint64_t> keys_;
+    std::vector<Row> rows_;
+    std::vector<uint64_t> batch_keys_;
+    std::vector<Row> batch_rows_;
+    size_t pos_;
+};
+
 // iterator start from `iter` but limit rows count
 // stop when `iter` is invalid or reaches limit count
 class LimitIterator : public RowIterator {
@@ -386,14 +436,17 @@ class TableProjectWrapper : public TableHandler {
 
 class TableFilterWrapper : public TableHandler {
  public:
-    TableFilterWrapper(std::shared_ptr<TableHandler> table_handler, const Row& parameter, const PredicateFun* fun)
-        : TableHandler(), table_hander_(table_handler), parameter_(parameter), fun_(fun) {}
+    TableFilterWrapper(std::shared_ptr<TableHandler> table_handler, const Row& parameter, const PredicateFun* fun,
+                       const VectorizedProjectPlan* plan = nullptr)
+        : TableHandler(), table_hander_(table_handler), parameter_(parameter), fun_(fun), plan_(plan) {}
     virtual ~TableFilterWrapper() {}
 
     std::unique_ptr<RowIterator> GetIterator() override {
         auto iter = table_hander_->GetIterator();
         if (!iter) {
             return std::unique_ptr<RowIterator>();
+        } else if (plan_ != nullptr) {
+            return std::make_unique<IteratorBatchFilterWrapper>(std::move(iter), plan_);
         } else {
             return std::make_unique<IteratorFilterWrapper>(std::move(iter), parameter_, fun_);
         }
@@ -424,6 +477,9 @@ class TableFilterWrapper : public TableHandler {
     const Row& parameter_;
     Row value_;
     const PredicateFun* fun_;
+    // the condition evaluated in batches while iterating the table, the
+    // partitions and windows are filtered by fun_
+    const VectorizedProjectPlan* plan_;
 };
 
 class LimitTableHandler : public TableHandler {
@@ -19,6 +19,7 @@
 #include <utility>
 #include <vector>
 #include "base/fe_strings.h"
+#include "base/thread_pool.h"
 #include "boost/none.hpp"
 #include "boost/optional.hpp"
 #include "codec/fe_row_codec.h"
@@ -33,6 +34,7 @@
 #include "vm/sql_compiler.h"
 
 DECLARE_bool(enable_spark_unsaferow_format);
+DECLARE_int32(batch_window_parallelism);
 
 namespace hybridse {
 namespace vm {
@@ -51,9 +53,19 @@ EngineOptions::EngineOptions()
       max_sql_cache_size_(50) {
 }
 
-Engine::Engine(const std::shared_ptr<Catalog>& catalog) : cl_(catalog), options_(), mu_(), lru_cache_() {}
+// the thread running a query works on its window aggregation as well, so the
+// pool has one thread less than batch_window_parallelism
+static std::shared_ptr<base::ThreadPool> NewWindowThreadPool() {
+    if (FLAGS_batch_window_parallelism <= 1) {
+        return nullptr;
+    }
+    return std::make_shared<base::ThreadPool>(FLAGS_batch_window_parallelism - 1);
+}
+
+Engine::Engine(const std::shared_ptr<Catalog>& catalog)
+    : cl_(catalog), options_(), mu_(), lru_cache_(), window_thread_pool_(NewWindowThreadPool()) {}
 Engine::Engine(const std::shared_ptr<Catalog>& catalog, const EngineOptions& options)
-    : cl_(catalog), options_(options), mu_(), lru_cache_() {}
+    : cl_(catalog), options_(options), mu_(), lru_cache_(), window_thread_pool_(NewWindowThreadPool()) {}
 Engine::~Engine() {}
 void Engine::InitializeGlobalLLVM() {
     if (LLVM_IS_INITIALIZED) return;
@@ -226,6 +238,7 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     sql_context.enable_expr_optimize = options_.IsEnableExprOptimize();
     sql_context.jit_options = options_.jit_options();
     sql_context.options = session.GetOptions();
+    sql_context.window_thread_pool = window_thread_pool_;
     if (session.engine_mode() == kBatchMode) {
         sql_context.parameter_types = dynamic_cast<BatchRunSession*>(&session)->GetParameterSchema();
     } else if (session.engine_mode() == kBatchRequestMode) {
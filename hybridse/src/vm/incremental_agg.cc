@@ -0,0 +1,359 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/incremental_agg.h"
+
+#include <stdlib.h>
+
+#include <string>
+
+#include "boost/algorithm/string.hpp"
+#include "glog/logging.h"
+
+namespace hybridse {
+namespace vm {
+
+static bool IsNumericType(type::Type type) {
+    switch (type) {
+        case type::kInt16:
+        case type::kInt32:
+        case type::kInt64:
+        case type::kFloat:
+        case type::kDouble:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// the same aggregates as AggregateIRBuilder evaluates over a window
+static bool GetAggKind(const std::string& fn_name, IncrementalAggColumn::Kind* kind) {
+    if (fn_name == "sum") {
+        *kind = IncrementalAggColumn::kSum;
+    } else if (fn_name == "count") {
+        *kind = IncrementalAggColumn::kCount;
+    } else if (fn_name == "avg") {
+        *kind = IncrementalAggColumn::kAvg;
+    } else if (fn_name == "min") {
+        *kind = IncrementalAggColumn::kMin;
+    } else if (fn_name == "max") {
+        *kind = IncrementalAggColumn::kMax;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<IncrementalAggPlan> IncrementalAggPlan::Create(const ColumnProjects& projects,
+                                                               const SchemasContext* schemas_ctx,
+                                                               const Schema& output_schema) {
+    if (schemas_ctx == nullptr || projects.size() != static_cast<size_t>(output_schema.size())) {
+        return nullptr;
+    }
+    std::vector<IncrementalAggColumn> columns;
+    for (size_t i = 0; i < projects.size(); i++) {
+        const node::ExprNode* expr = projects.GetExpr(i);
+        IncrementalAggColumn column;
+        const node::ColumnRefNode* col = nullptr;
+        if (expr->GetExprType() == node::kExprColumnRef) {
+            column.kind = IncrementalAggColumn::kColumn;
+            col = dynamic_cast<const node::ColumnRefNode*>(expr);
+        } else if (expr->GetExprType() == node::kExprCall) {
+            auto call = dynamic_cast<const node::CallExprNode*>(expr);
+            std::string fn_name;
+            switch (call->GetFnDef()->GetType()) {
+                case node::kExternalFnDef:
+                    fn_name = dynamic_cast<const node::ExternalFnDefNode*>(call->GetFnDef())->function_name();
+                    break;
+                case node::kUdafDef:
+                    fn_name = dynamic_cast<const node::UdafDefNode*>(call->GetFnDef())->GetName();
+                    break;
+                default:
+                    return nullptr;
+            }
+            boost::to_lower(fn_name);
+            if (!GetAggKind(fn_name, &column.kind) || call->GetChildNum() != 1 ||
+                call->GetChild(0)->GetExprType() != node::kExprColumnRef) {
+                return nullptr;
+            }
+            // the compiled function aggregates a part of the window for a pure
+            // history frame or another frame, which is not kept by the window
+            const node::FrameNode* frame = projects.GetFrame(i);
+            const node::FrameNode* primary_frame = projects.GetPrimaryFrame();
+            if (frame == nullptr || primary_frame == nullptr || primary_frame->IsPureHistoryFrame() ||
+                !frame->Equals(primary_frame)) {
+                return nullptr;
+            }
+            col = dynamic_cast<const node::ColumnRefNode*>(call->GetChild(0));
+        } else {
+            return nullptr;
+        }
+        if (col == nullptr || !schemas_ctx->ResolveColumnRefIndex(col, &column.schema_idx, &column.col_idx).isOK()) {
+            return nullptr;
+        }
+        column.type = schemas_ctx->GetSchema(column.schema_idx)->Get(column.col_idx).type();
+        if (column.kind == IncrementalAggColumn::kColumn) {
+            if (output_schema.Get(i).type() != column.type) {
+                return nullptr;
+            }
+        } else if (!IsNumericType(column.type) || !IsNumericType(output_schema.Get(i).type())) {
+            return nullptr;
+        }
+        columns.push_back(column);
+    }
+    return std::make_shared<IncrementalAggPlan>(schemas_ctx, output_schema, columns);
+}
+
+IncrementalAggState::IncrementalAggState(const IncrementalAggPlan* plan)
+    : plan_(plan), views_(), states_(), state_idxs_(), row_builder_(plan->output_schema()) {
+    const SchemasContext* schemas_ctx = plan->schemas_ctx();
+    for (size_t i = 0; i < schemas_ctx->GetSchemaSourceSize(); i++) {
+        views_.emplace_back(*schemas_ctx->GetSchema(i));
+    }
+    for (const auto& column : plan->columns()) {
+        if (column.kind == IncrementalAggColumn::kColumn) {
+            state_idxs_.push_back(-1);
+            continue;
+        }
+        size_t pos = 0;
+        while (pos < states_.size() &&
+               (states_[pos].schema_idx != column.schema_idx || states_[pos].col_idx != column.col_idx)) {
+            pos++;
+        }
+        if (pos == states_.size()) {
+            ColumnState state;
+            state.schema_idx = column.schema_idx;
+            state.col_idx = column.col_idx;
+            state.type = column.type;
+            state.is_float = column.type == type::kFloat || column.type == type::kDouble;
+            state.need_sum = false;
+            state.need_min = false;
+            state.need_max = false;
+            state.cnt = 0;
+            state.int_sum = 0;
+            states_.push_back(state);
+        }
+        ColumnState& state = states_[pos];
+        state.need_sum = state.need_sum || column.kind == IncrementalAggColumn::kSum ||
+                         column.kind == IncrementalAggColumn::kAvg;
+        state.need_min = state.need_min || column.kind == IncrementalAggColumn::kMin;
+        state.need_max = state.need_max || column.kind == IncrementalAggColumn::kMax;
+        state_idxs_.push_back(pos);
+    }
+}
+
+void IncrementalAggState::OnAddFront(const Row& row) { Update(row, kAddFront); }
+
+void IncrementalAggState::OnPopBack(const Row& row) { Update(row, kPopBack); }
+
+void IncrementalAggState::OnPopFront(const Row& row) { Update(row, kPopFront); }
+
+void IncrementalAggState::Update(const Row& row, Event event) {
+    for (auto& state : states_) {
+        codec::RowView& view = views_[state.schema_idx];
+        if (!view.Reset(row.buf(state.schema_idx), row.size(state.schema_idx)) || view.IsNULL(state.col_idx)) {
+            continue;
+        }
+        int64_t int_val = 0;
+        double float_val = 0;
+        switch (state.type) {
+            case type::kInt16:
+                int_val = view.GetInt16Unsafe(state.col_idx);
+                break;
+            case type::kInt32:
+                int_val = view.GetInt32Unsafe(state.col_idx);
+                break;
+            case type::kInt64:
+                int_val = view.GetInt64Unsafe(state.col_idx);
+                break;
+            case type::kFloat:
+                float_val = view.GetFloatUnsafe(state.col_idx);
+                break;
+            case type::kDouble:
+                float_val = view.GetDoubleUnsafe(state.col_idx);
+                break;
+            default:
+                continue;
+        }
+        switch (event) {
+            case kAddFront: {
+                state.cnt++;
+                if (state.is_float) {
+                    if (state.need_sum) state.float_sum.PushFront(float_val);
+                    if (state.need_min) state.float_min.PushFront(float_val);
+                    if (state.need_max) state.float_max.PushFront(float_val);
+                } else {
+                    state.int_sum += int_val;
+                    if (state.need_min) state.int_min.PushFront(int_val);
+                    if (state.need_max) state.int_max.PushFront(int_val);
+                }
+                break;
+            }
+            case kPopBack: {
+                state.cnt--;
+                if (state.is_float) {
+                    if (state.need_sum) state.float_sum.PopBack();
+                    if (state.need_min) state.float_min.PopBack();
+                    if (state.need_max) state.float_max.PopBack();
+                } else {
+                    state.int_sum -= int_val;
+                    if (state.need_min) state.int_min.PopBack();
+                    if (state.need_max) state.int_max.PopBack();
+                }
+                break;
+            }
+            case kPopFront: {
+                state.cnt--;
+                if (state.is_float) {
+                    if (state.need_sum) state.float_sum.PopFront();
+                    if (state.need_min) state.float_min.PopFront();
+                    if (state.need_max) state.float_max.PopFront();
+                } else {
+                    state.int_sum -= int_val;
+                    if (state.need_min) state.int_min.PopFront();
+                    if (state.need_max) state.int_max.PopFront();
+                }
+                break;
+            }
+        }
+    }
+}
+
+template <class T>
+static bool AppendNumber(codec::RowBuilder* builder, type::Type type, T val) {
+    switch (type) {
+        case type::kInt16:
+            return builder->AppendInt16(static_cast<int16_t>(val));
+        case type::kInt32:
+            return builder->AppendInt32(static_cast<int32_t>(val));
+        case type::kInt64:
+            return builder->AppendInt64(static_cast<int64_t>(val));
+        case type::kFloat:
+            return builder->AppendFloat(static_cast<float>(val));
+        case type::kDouble:
+            return builder->AppendDouble(static_cast<double>(val));
+        default:
+            return false;
+    }
+}
+
+bool IncrementalAggState::AppendAgg(const IncrementalAggColumn& column, const ColumnState& state,
+                                    const type::Type output_type) {
+    if (column.kind == IncrementalAggColumn::kCount) {
+        return AppendNumber(&row_builder_, output_type, state.cnt);
+    }
+    // the aggregates of no value are null
+    if (state.cnt == 0) {
+        return row_builder_.AppendNULL();
+    }
+    switch (column.kind) {
+        case IncrementalAggColumn::kSum:
+            return state.is_float ? AppendNumber(&row_builder_, output_type, state.float_sum.Get())
+                                  : AppendNumber(&row_builder_, output_type, state.int_sum);
+        case IncrementalAggColumn::kAvg: {
+            double sum = state.is_float ? state.float_sum.Get() : static_cast<double>(state.int_sum);
+            return AppendNumber(&row_builder_, output_type, sum / state.cnt);
+        }
+        case IncrementalAggColumn::kMin:
+            return state.is_float ? AppendNumber(&row_builder_, output_type, state.float_min.Get())
+                                  : AppendNumber(&row_builder_, output_type, state.int_min.Get());
+        case IncrementalAggColumn::kMax:
+            return state.is_float ? AppendNumber(&row_builder_, output_type, state.float_max.Get())
+                                  : AppendNumber(&row_builder_, output_type, state.int_max.Get());
+        default:
+            return false;
+    }
+}
+
+Row IncrementalAggState::Output(const Row& row) {
+    const auto& columns = plan_->columns();
+    const Schema& output_schema = plan_->output_schema();
+    uint32_t str_len = 0;
+    for (const auto& column : columns) {
+        if (column.kind == IncrementalAggColumn::kColumn && column.type == type::kVarchar) {
+            codec::RowView& view = views_[column.schema_idx];
+            const char* str = nullptr;
+            uint32_t len = 0;
+            if (view.Reset(row.buf(column.schema_idx), row.size(column.schema_idx)) &&
+                view.GetString(column.col_idx, &str, &len) == 0) {
+                str_len += len;
+            }
+        }
+    }
+    uint32_t total_len = row_builder_.CalTotalLength(str_len);
+    int8_t* buf = static_cast<int8_t*>(malloc(total_len));
+    row_builder_.SetBuffer(buf, total_len);
+    for (size_t i = 0; i < columns.size(); i++) {
+        const auto& column = columns[i];
+        bool ok = true;
+        if (column.kind != IncrementalAggColumn::kColumn) {
+            ok = AppendAgg(column, states_[state_idxs_[i]], output_schema.Get(i).type());
+        } else {
+            codec::RowView& view = views_[column.schema_idx];
+            if (!view.Reset(row.buf(column.schema_idx), row.size(column.schema_idx)) ||
+                view.IsNULL(column.col_idx)) {
+                ok = row_builder_.AppendNULL();
+            } else {
+                uint32_t idx = column.col_idx;
+                switch (column.type) {
+                    case type::kBool:
+                        ok = row_builder_.AppendBool(view.GetBoolUnsafe(idx));
+                        break;
+                    case type::kInt16:
+                        ok = row_builder_.AppendInt16(view.GetInt16Unsafe(idx));
+                        break;
+                    case type::kInt32:
+                        ok = row_builder_.AppendInt32(view.GetInt32Unsafe(idx));
+                        break;
+                    case type::kInt64:
+                        ok = row_builder_.AppendInt64(view.GetInt64Unsafe(idx));
+                        break;
+                    case type::kFloat:
+                        ok = row_builder_.AppendFloat(view.GetFloatUnsafe(idx));
+                        break;
+                    case type::kDouble:
+                        ok = row_builder_.AppendDouble(view.GetDoubleUnsafe(idx));
+                        break;
+                    case type::kTimestamp:
+                        ok = row_builder_.AppendTimestamp(view.GetTimestampUnsafe(idx));
+                        break;
+                    case type::kDate:
+                        ok = row_builder_.AppendDate(view.GetDateUnsafe(idx));
+                        break;
+                    case type::kVarchar: {
+                        const char* str = nullptr;
+                        uint32_t len = 0;
+                        view.GetString(idx, &str, &len);
+                        ok = row_builder_.AppendString(str, len);
+                        break;
+                    }
+                    default:
+                        ok = false;
+                        break;
+                }
+            }
+        }
+        if (!ok) {
+            LOG(WARNING) << "fail to encode column " << output_schema.Get(i).name() << " of window aggregation";
+            free(buf);
+            return Row();
+        }
+    }
+    return Row(base::RefCountedSlice::CreateManaged(buf, total_len));
+}
+
+}  // namespace vm
+}  // namespace hybridse
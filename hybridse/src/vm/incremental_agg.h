@@ -0,0 +1,212 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_INCREMENTAL_AGG_H_
+#define HYBRIDSE_SRC_VM_INCREMENTAL_AGG_H_
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "codec/fe_row_codec.h"
+#include "vm/mem_catalog.h"
+#include "vm/physical_op.h"
+#include "vm/schemas_context.h"
+
+namespace hybridse {
+namespace vm {
+
+struct MinOp {
+    template <class T>
+    T operator()(const T& a, const T& b) const {
+        return std::min(a, b);
+    }
+};
+
+struct MaxOp {
+    template <class T>
+    T operator()(const T& a, const T& b) const {
+        return std::max(a, b);
+    }
+};
+
+struct PlusOp {
+    template <class T>
+    T operator()(const T& a, const T& b) const {
+        return a + b;
+    }
+};
+
+// SlidingAgg aggregates the values of a sliding window with an associative
+// op. The values are added at the newest end and leave at both ends, the
+// partial aggregates are kept on two stacks, so it costs O(1) amortized
+// without inverting the op
+template <class T, class Op>
+class SlidingAgg {
+ public:
+    SlidingAgg() : newer_(), older_(), op_() {}
+
+    bool Empty() const { return newer_.empty() && older_.empty(); }
+
+    // REQUIRES: !Empty()
+    T Get() const {
+        if (newer_.empty()) {
+            return older_.back().second;
+        } else if (older_.empty()) {
+            return newer_.back().second;
+        }
+        return op_(newer_.back().second, older_.back().second);
+    }
+
+    void PushFront(const T& val) {
+        newer_.emplace_back(val, newer_.empty() ? val : op_(newer_.back().second, val));
+    }
+
+    void PopBack() {
+        if (older_.empty()) {
+            // the newest value goes to the bottom
+            while (!newer_.empty()) {
+                T val = newer_.back().first;
+                newer_.pop_back();
+                older_.emplace_back(val, older_.empty() ? val : op_(older_.back().second, val));
+            }
+        }
+        if (!older_.empty()) {
+            older_.pop_back();
+        }
+    }
+
+    void PopFront() {
+        if (!newer_.empty()) {
+            newer_.pop_back();
+            return;
+        }
+        if (older_.empty()) {
+            return;
+        }
+        // the newest value is at the bottom of older_, which happens once
+        // after the stacks are swapped
+        for (size_t i = 1; i < older_.size(); i++) {
+            const T& val = older_[i].first;
+            older_[i - 1] = std::make_pair(val, i == 1 ? val : op_(older_[i - 2].second, val));
+        }
+        older_.pop_back();
+    }
+
+ private:
+    // the newest value is at the top
+    std::vector<std::pair<T, T>> newer_;
+    // the oldest value is at the top
+    std::vector<std::pair<T, T>> older_;
+    Op op_;
+};
+
+// an output column of IncrementalAggPlan
+struct IncrementalAggColumn {
+    enum Kind {
+        // the column of the current row
+        kColumn,
+        kSum,
+        kCount,
+        kAvg,
+        kMin,
+        kMax,
+    };
+    Kind kind;
+    size_t schema_idx;
+    size_t col_idx;
+    // the type of the input column
+    type::Type type;
+};
+
+// IncrementalAggPlan is a window projection that consists of the columns of
+// the current row and sum/count/avg/min/max of the numeric columns of the
+// window. It is evaluated by IncrementalAggState as the rows slide through
+// the window, instead of aggregating the whole window for every row
+class IncrementalAggPlan {
+ public:
+    IncrementalAggPlan(const SchemasContext* schemas_ctx, const Schema& output_schema,
+                       const std::vector<IncrementalAggColumn>& columns)
+        : schemas_ctx_(schemas_ctx), output_schema_(output_schema), columns_(columns) {}
+
+    // return nullptr if some of the projects can not be evaluated incrementally
+    static std::shared_ptr<IncrementalAggPlan> Create(const ColumnProjects& projects,
+                                                      const SchemasContext* schemas_ctx,
+                                                      const Schema& output_schema);
+
+    const SchemasContext* schemas_ctx() const { return schemas_ctx_; }
+    const Schema& output_schema() const { return output_schema_; }
+    const std::vector<IncrementalAggColumn>& columns() const { return columns_; }
+
+ private:
+    const SchemasContext* schemas_ctx_;
+    const Schema output_schema_;
+    const std::vector<IncrementalAggColumn> columns_;
+};
+
+// IncrementalAggState keeps the aggregates of a window of a key, it should
+// be set as the listener of the window
+class IncrementalAggState : public WindowListener {
+ public:
+    explicit IncrementalAggState(const IncrementalAggPlan* plan);
+    ~IncrementalAggState() {}
+
+    void OnAddFront(const Row& row) override;
+    void OnPopBack(const Row& row) override;
+    void OnPopFront(const Row& row) override;
+
+    // encode the output of the current row with the aggregates of the window
+    Row Output(const Row& row);
+
+ private:
+    enum Event { kAddFront, kPopBack, kPopFront };
+
+    // the aggregates of an input column, the integers are summed exactly
+    // and inverted, the others are kept by SlidingAgg
+    struct ColumnState {
+        size_t schema_idx;
+        size_t col_idx;
+        type::Type type;
+        bool is_float;
+        bool need_sum;
+        bool need_min;
+        bool need_max;
+        int64_t cnt;
+        int64_t int_sum;
+        SlidingAgg<double, PlusOp> float_sum;
+        SlidingAgg<int64_t, MinOp> int_min;
+        SlidingAgg<int64_t, MaxOp> int_max;
+        SlidingAgg<double, MinOp> float_min;
+        SlidingAgg<double, MaxOp> float_max;
+    };
+
+    void Update(const Row& row, Event event);
+
+    bool AppendAgg(const IncrementalAggColumn& column, const ColumnState& state, const type::Type output_type);
+
+    const IncrementalAggPlan* plan_;
+    std::vector<codec::RowView> views_;
+    std::vector<ColumnState> states_;
+    // the state of the output columns, -1 for the columns of the current row
+    std::vector<int> state_idxs_;
+    codec::RowBuilder row_builder_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+
+#endif  // HYBRIDSE_SRC_VM_INCREMENTAL_AGG_H_
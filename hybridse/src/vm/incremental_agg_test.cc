@@ -0,0 +1,257 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/incremental_agg.h"
+
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "node/node_manager.h"
+
+namespace hybridse {
+namespace vm {
+
+class IncrementalAggTest : public ::testing::Test {
+ public:
+    IncrementalAggTest() {
+        AddColumn("ts", type::kInt64);
+        AddColumn("x", type::kInt32);
+        AddColumn("y", type::kDouble);
+        AddColumn("s", type::kVarchar);
+        schemas_ctx_.BuildTrivial({&schema_});
+    }
+
+    void AddColumn(const std::string& name, type::Type type) {
+        type::ColumnDef* column = schema_.Add();
+        column->set_name(name);
+        column->set_type(type);
+    }
+
+    Row MakeRow(int64_t ts, bool x_null, int32_t x, bool y_null, double y, const std::string& s) {
+        codec::RowBuilder builder(schema_);
+        uint32_t size = builder.CalTotalLength(s.size());
+        int8_t* buf = static_cast<int8_t*>(malloc(size));
+        builder.SetBuffer(buf, size);
+        builder.AppendInt64(ts);
+        x_null ? builder.AppendNULL() : builder.AppendInt32(x);
+        y_null ? builder.AppendNULL() : builder.AppendDouble(y);
+        builder.AppendString(s.c_str(), s.size());
+        return Row(base::RefCountedSlice::CreateManaged(buf, size));
+    }
+
+    // aggregate the rows of the window one by one and check the output
+    void CheckOutput(Window* window, const Row& instance, const Schema& output_schema, const Row& output) {
+        int32_t sum_x = 0;
+        int64_t cnt_x = 0;
+        int32_t max_x = std::numeric_limits<int32_t>::min();
+        double sum_y = 0;
+        int64_t cnt_y = 0;
+        double min_y = std::numeric_limits<double>::max();
+        codec::RowView view(schema_);
+        auto iter = window->GetIterator();
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+            const Row& row = iter->GetValue();
+            view.Reset(row.buf(), row.size());
+            if (!view.IsNULL(1)) {
+                sum_x += view.GetInt32Unsafe(1);
+                max_x = std::max(max_x, view.GetInt32Unsafe(1));
+                cnt_x++;
+            }
+            if (!view.IsNULL(2)) {
+                sum_y += view.GetDoubleUnsafe(2);
+                min_y = std::min(min_y, view.GetDoubleUnsafe(2));
+                cnt_y++;
+            }
+        }
+        view.Reset(instance.buf(), instance.size());
+        codec::RowView out_view(output_schema);
+        ASSERT_TRUE(out_view.Reset(output.buf(), output.size()));
+        ASSERT_EQ(view.GetStringUnsafe(3), out_view.GetStringUnsafe(0));
+        ASSERT_EQ(cnt_x, out_view.GetInt64Unsafe(2));
+        if (cnt_x == 0) {
+            ASSERT_TRUE(out_view.IsNULL(1));
+            ASSERT_TRUE(out_view.IsNULL(5));
+        } else {
+            ASSERT_EQ(sum_x, out_view.GetInt32Unsafe(1));
+            ASSERT_EQ(max_x, out_view.GetInt32Unsafe(5));
+        }
+        if (cnt_y == 0) {
+            ASSERT_TRUE(out_view.IsNULL(3));
+            ASSERT_TRUE(out_view.IsNULL(4));
+        } else {
+            ASSERT_NEAR(sum_y / cnt_y, out_view.GetDoubleUnsafe(3), 1e-9);
+            ASSERT_EQ(min_y, out_view.GetDoubleUnsafe(4));
+        }
+    }
+
+    void RunWindow(Window* window) {
+        // s, sum(x), count(x), avg(y), min(y), max(x)
+        Schema output_schema;
+        std::vector<std::pair<std::string, type::Type>> output_columns = {
+            {"s", type::kVarchar}, {"sum_x", type::kInt32}, {"cnt_x", type::kInt64},
+            {"avg_y", type::kDouble}, {"min_y", type::kDouble}, {"max_x", type::kInt32}};
+        for (const auto& pair : output_columns) {
+            type::ColumnDef* column = output_schema.Add();
+            column->set_name(pair.first);
+            column->set_type(pair.second);
+        }
+        IncrementalAggPlan plan(&schemas_ctx_, output_schema,
+                                {{IncrementalAggColumn::kColumn, 0, 3, type::kVarchar},
+                                 {IncrementalAggColumn::kSum, 0, 1, type::kInt32},
+                                 {IncrementalAggColumn::kCount, 0, 1, type::kInt32},
+                                 {IncrementalAggColumn::kAvg, 0, 2, type::kDouble},
+                                 {IncrementalAggColumn::kMin, 0, 2, type::kDouble},
+                                 {IncrementalAggColumn::kMax, 0, 1, type::kInt32}});
+        IncrementalAggState state(&plan);
+        window->set_listener(&state);
+        int64_t ts = 1000;
+        for (int i = 0; i < 2000; i++) {
+            ts += rand() % 5;  // NOLINT
+            Row row = MakeRow(ts, rand() % 10 == 0, rand() % 1000 - 500,  // NOLINT
+                              rand() % 10 == 0, (rand() % 10000) / 100.0, "s" + std::to_string(i));  // NOLINT
+            ASSERT_TRUE(window->BufferData(ts, row));
+            Row output = state.Output(row);
+            ASSERT_FALSE(output.empty());
+            CheckOutput(window, row, output_schema, output);
+            if (window->instance_not_in_window()) {
+                window->PopFrontData();
+            }
+        }
+    }
+
+ protected:
+    Schema schema_;
+    SchemasContext schemas_ctx_;
+};
+
+TEST_F(IncrementalAggTest, SlidingAgg) {
+    SlidingAgg<int64_t, MinOp> min_agg;
+    SlidingAgg<int64_t, PlusOp> sum_agg;
+    std::deque<int64_t> values;
+    for (int i = 0; i < 10000; i++) {
+        int op = rand() % 4;  // NOLINT
+        if (op < 2 || values.empty()) {
+            int64_t val = rand() % 1000;  // NOLINT
+            min_agg.PushFront(val);
+            sum_agg.PushFront(val);
+            values.push_front(val);
+        } else if (op == 2) {
+            min_agg.PopBack();
+            sum_agg.PopBack();
+            values.pop_back();
+        } else {
+            min_agg.PopFront();
+            sum_agg.PopFront();
+            values.pop_front();
+        }
+        ASSERT_EQ(values.empty(), min_agg.Empty());
+        if (!values.empty()) {
+            int64_t min = values.front();
+            int64_t sum = 0;
+            for (auto val : values) {
+                min = std::min(min, val);
+                sum += val;
+            }
+            ASSERT_EQ(min, min_agg.Get());
+            ASSERT_EQ(sum, sum_agg.Get());
+        }
+    }
+}
+
+TEST_F(IncrementalAggTest, RowsRangeWindow) {
+    CurrentHistoryWindow window(WindowRange::CreateRowsRangeWindow(-30, 0));
+    RunWindow(&window);
+}
+
+TEST_F(IncrementalAggTest, RowsWindowWithMaxSize) {
+    CurrentHistoryWindow window(WindowRange::CreateRowsMergeRowsRangeWindow(-30, 10, 20));
+    RunWindow(&window);
+}
+
+TEST_F(IncrementalAggTest, ExcludeCurrentTime) {
+    CurrentHistoryWindow window(WindowRange::CreateRowsRangeWindow(-30, 0));
+    window.set_exclude_current_time(true);
+    RunWindow(&window);
+}
+
+TEST_F(IncrementalAggTest, InstanceNotInWindow) {
+    HistoryWindow window(WindowRange::CreateRowsRangeWindow(-30, 0));
+    window.set_instance_not_in_window(true);
+    RunWindow(&window);
+}
+
+TEST_F(IncrementalAggTest, CreatePlan) {
+    node::NodeManager nm;
+    auto frame = dynamic_cast<node::FrameNode*>(nm.MakeFrameNode(
+        node::kFrameRowsRange,
+        nm.MakeFrameExtent(nm.MakeFrameBound(node::kPreceding, 30), nm.MakeFrameBound(node::kCurrent)), nullptr,
+        0));
+    ASSERT_TRUE(frame != nullptr);
+    Schema output_schema;
+    auto add_output = [&output_schema](const std::string& name, type::Type type) {
+        type::ColumnDef* column = output_schema.Add();
+        column->set_name(name);
+        column->set_type(type);
+    };
+    {
+        ColumnProjects projects;
+        projects.Add("s", nm.MakeColumnRefNode("s", ""), nullptr);
+        projects.Add("sum_x", nm.MakeFuncNode("sum", {nm.MakeColumnRefNode("x", "")}, nullptr), frame);
+        projects.Add("max_y", nm.MakeFuncNode("max", {nm.MakeColumnRefNode("y", "")}, nullptr), frame);
+        projects.SetPrimaryFrame(frame);
+        add_output("s", type::kVarchar);
+        add_output("sum_x", type::kInt32);
+        add_output("max_y", type::kDouble);
+        auto plan = IncrementalAggPlan::Create(projects, &schemas_ctx_, output_schema);
+        ASSERT_TRUE(plan != nullptr);
+        ASSERT_EQ(3u, plan->columns().size());
+        ASSERT_EQ(IncrementalAggColumn::kColumn, plan->columns()[0].kind);
+        ASSERT_EQ(3u, plan->columns()[0].col_idx);
+        ASSERT_EQ(IncrementalAggColumn::kSum, plan->columns()[1].kind);
+        ASSERT_EQ(1u, plan->columns()[1].col_idx);
+        ASSERT_EQ(IncrementalAggColumn::kMax, plan->columns()[2].kind);
+        ASSERT_EQ(2u, plan->columns()[2].col_idx);
+    }
+    {
+        // the aggregates of strings and other functions are evaluated by the compiled function
+        ColumnProjects projects;
+        projects.Add("max_s", nm.MakeFuncNode("max", {nm.MakeColumnRefNode("s", "")}, nullptr), frame);
+        projects.SetPrimaryFrame(frame);
+        output_schema.Clear();
+        add_output("max_s", type::kVarchar);
+        ASSERT_TRUE(IncrementalAggPlan::Create(projects, &schemas_ctx_, output_schema) == nullptr);
+    }
+    {
+        ColumnProjects projects;
+        projects.Add("top_x", nm.MakeFuncNode("top", {nm.MakeColumnRefNode("x", "")}, nullptr), frame);
+        projects.SetPrimaryFrame(frame);
+        output_schema.Clear();
+        add_output("top_x", type::kVarchar);
+        ASSERT_TRUE(IncrementalAggPlan::Create(projects, &schemas_ctx_, output_schema) == nullptr);
+    }
+}
+
+}  // namespace vm
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -16,6 +16,10 @@
 
 #include "vm/runner.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -33,6 +37,11 @@
 #include "vm/mem_catalog.h"
 
 DECLARE_bool(enable_spark_unsaferow_format);
+DECLARE_bool(enable_incremental_window_agg);
+DECLARE_bool(enable_vectorized_project);
+DECLARE_bool(enable_batch_hash_join);
+DECLARE_int32(request_window_cache_capacity);
+DECLARE_int64(request_window_cache_max_bytes);
 
 namespace hybridse {
 namespace vm {
@@ -191,6 +200,9 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                     TableProjectRunner* runner = nullptr;
                     CreateRunner<TableProjectRunner>(
                         &runner, id_++, node->schemas_ctx(), op->GetLimitCnt(), op->project().fn_info());
+                    if (FLAGS_enable_vectorized_project && !FLAGS_enable_spark_unsaferow_format) {
+                        runner->SetVectorizedProject(VectorizedProjectPlan::Create(op->project().fn_info()));
+                    }
                     return RegisterTask(node,
                                         UnaryInheritTask(cluster_task, runner));
                 }
@@ -248,6 +260,12 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                                                   op->project().fn_info(), op->instance_not_in_window(),
                                                   op->exclude_current_time(), op->exclude_current_row(),
                                                   op->need_append_input());
+                    runner->SetThreadPool(window_thread_pool_);
+                    if (FLAGS_enable_incremental_window_agg && !FLAGS_enable_spark_unsaferow_format) {
+                        runner->SetIncrementalAgg(IncrementalAggPlan::Create(
+                            op->project(), op->project().fn_info().schemas_ctx(),
+                            *op->project().fn_info().fn_schema()));
+                    }
                     size_t input_slices =
                         input->output_schemas()->GetSchemaSourceSize();
                     if (!op->window_unions_.Empty()) {
@@ -318,6 +336,11 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                 op->window().range_, op->exclude_current_time(),
                 op->output_request_row());
             runner->exclude_current_row_ = op->exclude_current_row_;
+            if (FLAGS_request_window_cache_capacity > 0 && !FLAGS_enable_spark_unsaferow_format) {
+                runner->SetWindowCache(std::make_shared<RequestWindowCache>(
+                    FLAGS_request_window_cache_capacity,
+                    static_cast<uint64_t>(std::max<int64_t>(0, FLAGS_request_window_cache_max_bytes))));
+            }
             Key index_key;
             if (!op->instance_not_in_window()) {
                 runner->AddWindowUnion(op->window_, right);
@@ -493,6 +516,10 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
             FilterRunner* runner = nullptr;
             CreateRunner<FilterRunner>(&runner, id_++, node->schemas_ctx(),
                                        op->GetLimitCnt(), op->filter_);
+            if (FLAGS_enable_vectorized_project && !FLAGS_enable_spark_unsaferow_format) {
+                runner->filter_gen_.SetVectorizedCondition(
+                    VectorizedProjectPlan::Create(op->filter_.condition_.fn_info()));
+            }
             return RegisterTask(node, UnaryInheritTask(cluster_task, runner));
         }
         case kPhysicalOpLimit: {
@@ -1308,6 +1335,28 @@ std::shared_ptr<DataHandler> TableProjectRunner::Run(
     auto& parameter = ctx.GetParameterRow();
     iter->SeekToFirst();
     int32_t cnt = 0;
+    if (vectorized_plan_) {
+        ColumnBatch batch(vectorized_plan_.get());
+        std::vector<Row> rows;
+        rows.reserve(COLUMN_BATCH_SIZE);
+        while (iter->Valid()) {
+            rows.clear();
+            while (iter->Valid() && rows.size() < COLUMN_BATCH_SIZE &&
+                   !(limit_cnt_.has_value() && cnt >= limit_cnt_.value())) {
+                rows.push_back(iter->GetValue());
+                iter->Next();
+                cnt++;
+            }
+            if (rows.empty()) {
+                break;
+            }
+            vectorized_plan_->Evaluate(rows.data(), rows.size(), &batch);
+            for (size_t i = 0; i < rows.size(); i++) {
+                output_table->AddRow(vectorized_plan_->Output(rows[i], i, &batch));
+            }
+        }
+        return output_table;
+    }
     while (iter->Valid()) {
         if (limit_cnt_.has_value() && cnt++ >= limit_cnt_) {
             break;
@@ -1451,6 +1500,16 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
 
     // Compute output
     std::shared_ptr<MemTableHandler> output_table = std::make_shared<MemTableHandler>();
+    if (thread_pool_) {
+        std::vector<std::string> keys;
+        while (instance_partition_iter->Valid()) {
+            keys.push_back(instance_partition_iter->GetKey().ToString());
+            instance_partition_iter->Next();
+        }
+        RunWindowAggParallel(parameter, instance_partition, union_partitions, join_right_tables, keys,
+                             output_table);
+        return output_table;
+    }
     while (instance_partition_iter->Valid()) {
         auto key = instance_partition_iter->GetKey().ToString();
         RunWindowAggOnKey(parameter, instance_partition, union_partitions,
@@ -1460,6 +1519,78 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
     return output_table;
 }
 
+// Run Window Aggeregation of the keys on the thread of the query and the
+// threads of the pool, the threads take the next key when they are done, the
+// outputs are merged in the order of keys
+void WindowAggRunner::RunWindowAggParallel(
+    const Row& parameter,
+    std::shared_ptr<PartitionHandler> instance_partition,
+    const std::vector<std::shared_ptr<PartitionHandler>>& union_partitions,
+    const std::vector<std::shared_ptr<DataHandler>>& join_right_tables,
+    const std::vector<std::string>& keys,
+    std::shared_ptr<MemTableHandler> output_table) {
+    // the pool tasks of a batch which have not started when the thread of the
+    // query is done with it are skipped, so it only waits for the running ones
+    struct BatchWorkers {
+        std::mutex mu;
+        std::condition_variable cv;
+        bool closed = false;
+        size_t running = 0;
+    };
+    size_t thread_num = std::min(thread_pool_->GetThreadNum() + 1, keys.size());
+    // with a limit, the keys are run batch by batch so that it stops early,
+    // the batch grows to bound the number of batches
+    size_t batch_size = limit_cnt_.has_value() ? thread_num * 4 : keys.size();
+    std::vector<std::shared_ptr<MemTableHandler>> outputs;
+    for (size_t start = 0; start < keys.size(); start += batch_size, batch_size *= 2) {
+        size_t end = std::min(keys.size(), start + batch_size);
+        outputs.assign(end - start, nullptr);
+        std::atomic<size_t> next(start);
+        // the rows of parameter, unions and joins are shared by the workers
+        auto worker = [&]() {
+            base::RefCountedSlice::SetAtomicRefCount(true);
+            for (size_t i = next.fetch_add(1); i < end; i = next.fetch_add(1)) {
+                auto output = std::make_shared<MemTableHandler>();
+                RunWindowAggOnKey(parameter, instance_partition, union_partitions, join_right_tables, keys[i],
+                                  output);
+                outputs[i - start] = output;
+            }
+            base::RefCountedSlice::SetAtomicRefCount(false);
+        };
+        auto workers = std::make_shared<BatchWorkers>();
+        for (size_t i = 1; i < std::min(thread_num, end - start); i++) {
+            thread_pool_->AddTask([workers, &worker]() {
+                {
+                    std::lock_guard<std::mutex> lock(workers->mu);
+                    if (workers->closed) {
+                        return;
+                    }
+                    workers->running++;
+                }
+                worker();
+                std::lock_guard<std::mutex> lock(workers->mu);
+                if (--workers->running == 0) {
+                    workers->cv.notify_all();
+                }
+            });
+        }
+        worker();
+        {
+            std::unique_lock<std::mutex> lock(workers->mu);
+            workers->closed = true;
+            workers->cv.wait(lock, [&workers]() { return workers->running == 0; });
+        }
+        for (auto& output : outputs) {
+            for (uint64_t i = 0; i < output->GetCount(); i++) {
+                if (limit_cnt_.has_value() && output_table->GetCount() >= static_cast<uint64_t>(limit_cnt_.value())) {
+                    return;
+                }
+                output_table->AddRow(output->At(i));
+            }
+        }
+    }
+}
+
 // Run Window Aggeregation on given key
 void WindowAggRunner::RunWindowAggOnKey(
     const Row& parameter,
@@ -1519,6 +1650,12 @@ void WindowAggRunner::RunWindowAggOnKey(
     window.set_instance_not_in_window(instance_not_in_window_);
     window.set_exclude_current_time(exclude_current_time_);
     window.set_exclude_current_row(exclude_current_row_);
+    // the aggregates are updated as the rows enter and leave the window
+    std::unique_ptr<IncrementalAggState> agg_state;
+    if (incremental_agg_plan_) {
+        agg_state = std::make_unique<IncrementalAggState>(incremental_agg_plan_.get());
+        window.set_listener(agg_state.get());
+    }
 
     while (instance_segment_iter->Valid()) {
         if (limit_cnt_.has_value() && cnt >= limit_cnt_) {
@@ -1534,9 +1671,14 @@ void WindowAggRunner::RunWindowAggOnKey(
             if (windows_join_gen_.Valid()) {
                 row = windows_join_gen_.Join(row, join_right_tables, parameter);
             }
-            window_project_gen_.Gen(
-                union_segment_iters[min_union_pos]->GetKey(), row, parameter,
-                false, append_slices_, &window);
+            if (agg_state) {
+                IncrementalProject(union_segment_iters[min_union_pos]->GetKey(), row, false, &window,
+                                   agg_state.get());
+            } else {
+                window_project_gen_.Gen(
+                    union_segment_iters[min_union_pos]->GetKey(), row, parameter,
+                    false, append_slices_, &window);
+            }
 
             // Update Iterator Status
             union_segment_iters[min_union_pos]->Next();
@@ -1550,7 +1692,12 @@ void WindowAggRunner::RunWindowAggOnKey(
             min_union_pos = IteratorStatus::FindLastIteratorWithMininumKey(union_segment_status);
         }
 
-        if (windows_join_gen_.Valid()) {
+        if (agg_state) {
+            Row row = windows_join_gen_.Valid()
+                          ? windows_join_gen_.Join(instance_row, join_right_tables, parameter)
+                          : instance_row;
+            output_table->AddRow(IncrementalProject(instance_order, row, true, &window, agg_state.get()));
+        } else if (windows_join_gen_.Valid()) {
             Row row = windows_join_gen_.Join(instance_row, join_right_tables, parameter);
             output_table->AddRow(
                 window_project_gen_.Gen(instance_order, row, parameter, true, append_slices_, &window));
@@ -1564,6 +1711,28 @@ void WindowAggRunner::RunWindowAggOnKey(
     }
 }
 
+Row WindowAggRunner::IncrementalProject(const uint64_t key, const Row& row, bool is_instance,
+                                        Window* window, IncrementalAggState* state) {
+    if (row.empty()) {
+        return row;
+    }
+    if (!window->BufferData(key, row)) {
+        LOG(WARNING) << "fail to buffer data";
+        return Row();
+    }
+    if (!is_instance) {
+        return Row();
+    }
+    Row out = state->Output(row);
+    if (window->instance_not_in_window()) {
+        window->PopFrontData();
+    }
+    if (append_slices_ > 0 && !out.empty()) {
+        return Row(out.GetSlice(0), append_slices_, row);
+    }
+    return out;
+}
+
 std::shared_ptr<DataHandler> RequestLastJoinRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {  // NOLINT
@@ -1612,6 +1781,18 @@ std::shared_ptr<DataHandler> LastJoinRunner::Run(RunnerContext& ctx,
 
     switch (left->GetHandlerType()) {
         case kTableHandler: {
+            if (FLAGS_enable_batch_hash_join && join_gen_.right_group_gen_.Valid() &&
+                kTableHandler == right->GetHandlerType()) {
+                // the right table is not partitioned by an index
+                auto left_table = std::dynamic_pointer_cast<TableHandler>(left);
+                auto output_table = std::make_shared<MemTimeTableHandler>();
+                output_table->SetOrderType(left_table->GetOrderType());
+                if (!join_gen_.TableHashJoin(left_table, std::dynamic_pointer_cast<TableHandler>(right), parameter,
+                                             output_table)) {
+                    return fail_ptr;
+                }
+                return output_table;
+            }
             if (join_gen_.right_group_gen_.Valid()) {
                 right = join_gen_.right_group_gen_.Partition(right, parameter);
             }
@@ -2041,6 +2222,70 @@ bool JoinGenerator::TableJoin(std::shared_ptr<TableHandler> left,
     return true;
 }
 
+bool JoinGenerator::TableHashJoin(std::shared_ptr<TableHandler> left,
+                                  std::shared_ptr<TableHandler> right,
+                                  const Row& parameter,
+                                  std::shared_ptr<MemTimeTableHandler> output) {
+    if (!right_group_gen_.Valid()) {
+        LOG(WARNING) << "can't hash join right table when right_group_gen_ is invalid";
+        return false;
+    }
+    if (!left_key_gen_.Valid() && !index_key_gen_.Valid()) {
+        LOG(WARNING) << "can't hash join right table when neither left_key_gen_ or index_key_gen_ is valid";
+        return false;
+    }
+    auto left_iter = left->GetIterator();
+    if (!left_iter) {
+        LOG(WARNING) << "fail to run last join: left input empty";
+        return false;
+    }
+
+    // build: the segments of the right keys, each is sorted once here
+    // instead of for every left row
+    absl::flat_hash_map<std::string, std::shared_ptr<MemTimeTableHandler>> segments;
+    auto right_iter = right->GetIterator();
+    if (right_iter) {
+        right_iter->SeekToFirst();
+        while (right_iter->Valid()) {
+            auto& segment = segments[right_group_gen_.GetKey(right_iter->GetValue(), parameter)];
+            if (!segment) {
+                segment = std::make_shared<MemTimeTableHandler>(right->GetSchema());
+                segment->SetOrderType(right->GetOrderType());
+            }
+            segment->AddRow(right_iter->GetKey(), right_iter->GetValue());
+            right_iter->Next();
+        }
+    }
+    absl::flat_hash_map<std::string, std::shared_ptr<TableHandler>> hash_table;
+    hash_table.reserve(segments.size());
+    for (auto& segment : segments) {
+        hash_table.emplace(segment.first,
+                           right_sort_gen_.Sort(std::static_pointer_cast<TableHandler>(segment.second), true));
+    }
+    segments.clear();
+
+    // probe: the same key as TableJoin with the right partition
+    left_iter->SeekToFirst();
+    while (left_iter->Valid()) {
+        const Row& left_row = left_iter->GetValue();
+        std::string key_str = index_key_gen_.Valid() ? index_key_gen_.Gen(left_row, parameter) : "";
+        if (left_key_gen_.Valid()) {
+            key_str = key_str.empty() ? left_key_gen_.Gen(left_row, parameter)
+                                      : key_str + "|" + left_key_gen_.Gen(left_row, parameter);
+        }
+        auto iter = hash_table.find(key_str);
+        if (iter == hash_table.end() || !iter->second) {
+            output->AddRow(left_iter->GetKey(), Row(left_slices_, left_row, right_slices_, Row()));
+        } else {
+            output->AddRow(left_iter->GetKey(), Runner::RowLastJoinSortedTable(left_slices_, left_row, right_slices_,
+                                                                               iter->second, parameter,
+                                                                               condition_gen_));
+        }
+        left_iter->Next();
+    }
+    return true;
+}
+
 bool JoinGenerator::PartitionJoin(std::shared_ptr<PartitionHandler> left,
                                   std::shared_ptr<TableHandler> right,
                                   const Row& parameter,
@@ -2137,6 +2382,12 @@ const Row Runner::RowLastJoinTable(size_t left_slices, const Row& left_row,
         LOG(WARNING) << "Last Join right table is empty";
         return Row(left_slices, left_row, right_slices, Row());
     }
+    return RowLastJoinSortedTable(left_slices, left_row, right_slices, right_table, parameter, cond_gen);
+}
+
+const Row Runner::RowLastJoinSortedTable(size_t left_slices, const Row& left_row, size_t right_slices,
+                                         std::shared_ptr<TableHandler> right_table, const Row& parameter,
+                                         ConditionGenerator& cond_gen) {
     auto right_iter = right_table->GetIterator();
     if (!right_iter) {
         DLOG(WARNING) << "Last Join right table is empty";
@@ -3220,6 +3471,9 @@ std::shared_ptr<DataHandler> RequestUnionRunner::Run(
 
     // Prepare Union Window
     auto union_inputs = windows_union_gen_.RunInputs(ctx);
+    if (window_cache_) {
+        return RunWithWindowCache(request, ctx.GetParameterRow(), ts_gen, union_inputs);
+    }
     auto union_segments =
         windows_union_gen_.GetRequestWindows(request, ctx.GetParameterRow(), union_inputs);
     // build window with start and end offset
@@ -3227,6 +3481,112 @@ std::shared_ptr<DataHandler> RequestUnionRunner::Run(
                               range_gen_.window_range_, output_request_row_,
                               exclude_current_time_, exclude_current_row_);
 }
+
+static base::RefCountedSlice CopySlice(const int8_t* buf, int32_t size) {
+    if (buf == nullptr || size <= 0) {
+        return base::RefCountedSlice();
+    }
+    auto copy = reinterpret_cast<int8_t*>(malloc(size));
+    memcpy(copy, buf, size);
+    return base::RefCountedSlice::CreateManaged(copy, size);
+}
+
+// copy the slices of the row into buffers owned by the returned row
+static Row CopyRow(const Row& row) {
+    Row copy(CopySlice(row.buf(0), row.size(0)));
+    for (int32_t i = 1; i < row.GetRowPtrCnt(); i++) {
+        copy.Append(CopySlice(row.buf(i), row.size(i)));
+    }
+    return copy;
+}
+
+// the returned row refers to the slices of the row without owning them
+static Row ViewRow(const Row& row) {
+    Row view(base::RefCountedSlice::Create(row.buf(0), row.size(0)));
+    for (int32_t i = 1; i < row.GetRowPtrCnt(); i++) {
+        view.Append(base::RefCountedSlice::Create(row.buf(i), row.size(i)));
+    }
+    return view;
+}
+
+std::shared_ptr<TableHandler> RequestUnionRunner::RunWithWindowCache(
+    const Row& request, const Row& parameter, int64_t ts_gen,
+    const std::vector<std::shared_ptr<DataHandler>>& union_inputs) {
+    // the versions are read before the segments, so a window read while
+    // they are written is cached with the old versions
+    std::string cache_key = std::to_string(ts_gen);
+    bool cacheable = windows_union_gen_.GetCacheKey(request, parameter, union_inputs, &cache_key);
+    uint64_t request_key = ts_gen > 0 ? static_cast<uint64_t>(ts_gen) : 0;
+    if (cacheable) {
+        auto cached = window_cache_->Get(cache_key);
+        if (cached) {
+            DLOG(INFO) << "RUNNER ID " << id_ << " HIT WINDOW CACHE!";
+            auto window_table = std::make_shared<CachedWindowHandler>(cached);
+            if (output_request_row_) {
+                window_table->AddRow(request_key, request);
+            }
+            auto iter = cached->GetIterator();
+            for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+                window_table->AddRow(iter->GetKey(), ViewRow(iter->GetValue()));
+            }
+            return window_table;
+        }
+    }
+    auto union_segments = windows_union_gen_.GetRequestWindows(request, parameter, union_inputs);
+    auto window = RequestUnionWindow(request, union_segments, ts_gen, range_gen_.window_range_, output_request_row_,
+                                     exclude_current_time_, exclude_current_row_);
+    if (cacheable && window) {
+        auto cached = std::make_shared<MemTimeTableHandler>();
+        uint64_t bytes = 0;
+        auto iter = window->GetIterator();
+        iter->SeekToFirst();
+        if (output_request_row_ && iter->Valid()) {
+            iter->Next();
+        }
+        for (; iter->Valid(); iter->Next()) {
+            const Row& row = iter->GetValue();
+            for (int32_t i = 0; i < row.GetRowPtrCnt(); i++) {
+                bytes += row.size(i);
+            }
+            cached->AddRow(iter->GetKey(), CopyRow(row));
+        }
+        window_cache_->Put(cache_key, cached, bytes);
+    }
+    return window;
+}
+
+std::shared_ptr<MemTimeTableHandler> RequestWindowCache::Get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return std::shared_ptr<MemTimeTableHandler>();
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->window;
+}
+
+void RequestWindowCache::Put(const std::string& key, std::shared_ptr<MemTimeTableHandler> window, uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        Erase(it->second);
+    }
+    if (bytes > max_bytes_ || capacity_ == 0) {
+        return;
+    }
+    entries_.push_front(Entry{key, window, bytes});
+    index_.emplace(key, entries_.begin());
+    bytes_ += bytes;
+    while (entries_.size() > capacity_ || bytes_ > max_bytes_) {
+        Erase(std::prev(entries_.end()));
+    }
+}
+
+void RequestWindowCache::Erase(std::list<Entry>::iterator it) {
+    bytes_ -= it->bytes;
+    index_.erase(it->key);
+    entries_.erase(it);
+}
 std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
     const Row& request, std::vector<std::shared_ptr<TableHandler>> union_segments, int64_t ts_gen,
     const WindowRange& window_range, bool output_request_row, bool exclude_current_time, bool exclude_current_row) {
@@ -4055,6 +4415,28 @@ std::shared_ptr<TableHandler> IndexSeekGenerator::SegmnetOfConstKey(
         }
     }
 }
+// the parts of a cache key are prefixed with their sizes, so that different
+// keys never concat to the same one
+static void AppendCacheKeyPart(const std::string& part, std::string* cache_key) {
+    cache_key->append("|").append(std::to_string(part.size())).append(":").append(part);
+}
+
+bool RequestWindowGenertor::AppendCacheKey(const Row& row, const Row& parameter, std::shared_ptr<DataHandler> input,
+                                           std::string* cache_key) {
+    if (!index_seek_gen_.Valid() || !input || kPartitionHandler != input->GetHandlerType()) {
+        return false;
+    }
+    auto segment = index_seek_gen_.SegmentOfKey(row, parameter, input);
+    uint64_t version = 0;
+    if (!segment || !segment->GetWriteVersion(&version)) {
+        return false;
+    }
+    AppendCacheKeyPart(index_seek_gen_.index_key_gen_.Gen(row, parameter), cache_key);
+    AppendCacheKeyPart(filter_gen_.Valid() ? filter_gen_.GetKey(row, parameter) : "", cache_key);
+    AppendCacheKeyPart(std::to_string(version), cache_key);
+    return true;
+}
+
 std::shared_ptr<TableHandler> IndexSeekGenerator::SegmentOfKey(
     const Row& row, const Row& parameter, std::shared_ptr<DataHandler> input) {
     auto fail_ptr = std::shared_ptr<TableHandler>();
@@ -4126,7 +4508,7 @@ std::shared_ptr<DataHandler> FilterGenerator::Filter(std::shared_ptr<TableHandle
     }
 
     if (condition_gen_.Valid()) {
-        table = std::make_shared<TableFilterWrapper>(table, parameter, this);
+        table = std::make_shared<TableFilterWrapper>(table, parameter, this, vectorized_condition_.get());
     }
 
     if (!limit.has_value()) {
@@ -17,8 +17,10 @@
 #ifndef HYBRIDSE_SRC_VM_RUNNER_H_
 #define HYBRIDSE_SRC_VM_RUNNER_H_
 
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -28,14 +30,17 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "base/fe_status.h"
+#include "base/thread_pool.h"
 #include "codec/fe_row_codec.h"
 #include "node/node_manager.h"
 #include "vm/aggregator.h"
 #include "vm/catalog.h"
 #include "vm/catalog_wrapper.h"
 #include "vm/core_api.h"
+#include "vm/incremental_agg.h"
 #include "vm/mem_catalog.h"
 #include "vm/physical_op.h"
+#include "vm/vectorized_project.h"
 namespace hybridse {
 namespace vm {
 
@@ -259,7 +264,8 @@ class FilterGenerator : public PredicateFun {
  public:
     explicit FilterGenerator(const Filter& filter)
         : condition_gen_(filter.condition_.fn_info()),
-          index_seek_gen_(filter.index_key_) {}
+          index_seek_gen_(filter.index_key_),
+          vectorized_condition_() {}
 
     const bool Valid() const {
         return index_seek_gen_.Valid() || condition_gen_.Valid();
@@ -278,9 +284,15 @@ class FilterGenerator : public PredicateFun {
         return condition_gen_.Gen(row, parameter);
     }
 
+    // the rows of a table are filtered by the plan in batches
+    void SetVectorizedCondition(std::shared_ptr<VectorizedProjectPlan> plan) {
+        vectorized_condition_ = plan;
+    }
+
  private:
     ConditionGenerator condition_gen_;
     IndexSeekGenerator index_seek_gen_;
+    std::shared_ptr<VectorizedProjectPlan> vectorized_condition_;
 };
 class WindowGenerator {
  public:
@@ -321,6 +333,11 @@ class RequestWindowGenertor {
         }
         return segment;
     }
+    // append the keys of the window of row and the write version of its
+    // segment to cache_key. return false if the version is unknown, then
+    // the window can't be cached
+    bool AppendCacheKey(const Row& row, const Row& parameter, std::shared_ptr<DataHandler> input,
+                        std::string* cache_key);
     RequestWindowOp window_op_;
     FilterKeyGenerator filter_gen_;
     SortGenerator sort_gen_;
@@ -518,6 +535,11 @@ class Runner : public node::NodeBase<Runner> {
                                       const hybridse::codec::Row& parameter,
                                       SortGenerator& right_sort,    // NOLINT
                                       ConditionGenerator& filter);  // NOLINT
+    // the same as RowLastJoinTable with right_table sorted already
+    static const Row RowLastJoinSortedTable(size_t left_slices, const Row& left_row, size_t right_slices,
+                                            std::shared_ptr<TableHandler> right_table,
+                                            const hybridse::codec::Row& parameter,
+                                            ConditionGenerator& filter);  // NOLINT
     static std::shared_ptr<TableHandler> TableReverse(
         std::shared_ptr<TableHandler> table);
 
@@ -652,6 +674,18 @@ class RequestWindowUnionGenerator : public InputsGenerator {
         }
         return union_segments;
     }
+    bool GetCacheKey(const Row& row, const Row& parameter,
+                     const std::vector<std::shared_ptr<DataHandler>>& union_inputs, std::string* cache_key) {
+        if (windows_gen_.empty()) {
+            return false;
+        }
+        for (size_t i = 0; i < union_inputs.size(); i++) {
+            if (!windows_gen_[i].AppendCacheKey(row, parameter, union_inputs[i], cache_key)) {
+                return false;
+            }
+        }
+        return true;
+    }
     std::vector<RequestWindowGenertor> windows_gen_;
 };
 class JoinGenerator {
@@ -672,6 +706,11 @@ class JoinGenerator {
     bool TableJoin(std::shared_ptr<TableHandler> left, std::shared_ptr<PartitionHandler> right,
                    const Row& parameter,
                    std::shared_ptr<MemTimeTableHandler> output);  // NOLINT
+    // join with a right table that has no index: the right rows are hashed
+    // by the right key and sorted once, then probed by the left rows
+    bool TableHashJoin(std::shared_ptr<TableHandler> left, std::shared_ptr<TableHandler> right,
+                       const Row& parameter,
+                       std::shared_ptr<MemTimeTableHandler> output);  // NOLINT
     bool PartitionJoin(std::shared_ptr<PartitionHandler> left,
                        std::shared_ptr<TableHandler> right,
                        const Row& parameter,
@@ -801,14 +840,22 @@ class TableProjectRunner : public Runner {
  public:
     TableProjectRunner(const int32_t id, const SchemasContext* schema, const std::optional<int32_t> limit_cnt,
                        const FnInfo& fn_info)
-        : Runner(id, kRunnerTableProject, schema, limit_cnt), project_gen_(fn_info) {}
+        : Runner(id, kRunnerTableProject, schema, limit_cnt), project_gen_(fn_info), vectorized_plan_() {}
     ~TableProjectRunner() {}
 
+    // the projection is evaluated by the plan in batches instead of the
+    // compiled function
+    void SetVectorizedProject(std::shared_ptr<VectorizedProjectPlan> plan) {
+        vectorized_plan_ = plan;
+    }
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
     ProjectGenerator project_gen_;
+
+ private:
+    std::shared_ptr<VectorizedProjectPlan> vectorized_plan_;
 };
 class RowProjectRunner : public Runner {
  public:
@@ -935,7 +982,8 @@ class WindowAggRunner : public Runner {
           instance_window_gen_(window_op),
           windows_union_gen_(),
           windows_join_gen_(),
-          window_project_gen_(fn_info) {}
+          window_project_gen_(fn_info),
+          incremental_agg_plan_() {}
     ~WindowAggRunner() {}
     void AddWindowJoin(const Join& join, size_t left_slices, Runner* runner) {
         windows_join_gen_.AddWindowJoin(join, left_slices, runner);
@@ -943,6 +991,12 @@ class WindowAggRunner : public Runner {
     void AddWindowUnion(const WindowOp& window, Runner* runner) {
         windows_union_gen_.AddWindowUnion(window, runner);
     }
+    // the projection is evaluated by the plan instead of the compiled function
+    void SetIncrementalAgg(std::shared_ptr<IncrementalAggPlan> plan) {
+        incremental_agg_plan_ = plan;
+    }
+    // the keys are run on the threads of the pool as well, see RunWindowAggParallel
+    void SetThreadPool(std::shared_ptr<base::ThreadPool> thread_pool) { thread_pool_ = thread_pool; }
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
@@ -953,6 +1007,16 @@ class WindowAggRunner : public Runner {
         std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
         std::vector<std::shared_ptr<DataHandler>> joins, const std::string& key,
         std::shared_ptr<MemTableHandler> output_table);
+    void RunWindowAggParallel(
+        const Row& parameter,
+        std::shared_ptr<PartitionHandler> instance_partition,
+        const std::vector<std::shared_ptr<PartitionHandler>>& union_partitions,
+        const std::vector<std::shared_ptr<DataHandler>>& join_right_tables,
+        const std::vector<std::string>& keys,
+        std::shared_ptr<MemTableHandler> output_table);
+    // the same as WindowProjectGenerator::Gen, the output is encoded by state
+    Row IncrementalProject(const uint64_t key, const Row& row, bool is_instance,
+                           Window* window, IncrementalAggState* state);
 
     const bool instance_not_in_window_;
     const bool exclude_current_time_;
@@ -963,6 +1027,65 @@ class WindowAggRunner : public Runner {
     WindowUnionGenerator windows_union_gen_;
     WindowJoinGenerator windows_join_gen_;
     WindowProjectGenerator window_project_gen_;
+    std::shared_ptr<IncrementalAggPlan> incremental_agg_plan_;
+    std::shared_ptr<base::ThreadPool> thread_pool_;
+};
+
+// RequestWindowCache keeps the windows of the recent requests of a
+// RequestUnionRunner across requests, except the request rows. A window is
+// keyed by the keys and the write versions of the segments it's read from and
+// the request ts, so it's not hit any more once one of the segments is written.
+// It keeps at most capacity windows and max_bytes of their rows, the least
+// recently used windows are evicted first.
+// The cached rows are copies owned by the cache, since the rows read from a
+// segment may be freed by its gc, and they are only read by the requests, so
+// their reference counts are never updated by two threads
+class RequestWindowCache {
+ public:
+    RequestWindowCache(size_t capacity, uint64_t max_bytes) : capacity_(capacity), max_bytes_(max_bytes) {}
+
+    std::shared_ptr<MemTimeTableHandler> Get(const std::string& key);
+
+    // the window is not kept if its rows are larger than max_bytes
+    void Put(const std::string& key, std::shared_ptr<MemTimeTableHandler> window, uint64_t bytes);
+
+    size_t GetSize() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return entries_.size();
+    }
+    uint64_t GetBytes() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return bytes_;
+    }
+
+ private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<MemTimeTableHandler> window;
+        uint64_t bytes;
+    };
+    void Erase(std::list<Entry>::iterator it);
+
+    const size_t capacity_;
+    const uint64_t max_bytes_;
+    std::mutex mu_;
+    // the most recently used window is at the front
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    uint64_t bytes_ = 0;
+};
+
+// CachedWindowHandler is a window hit in the RequestWindowCache, its rows
+// refer to the rows of the cached window without owning them, and it keeps the
+// cached window alive instead
+class CachedWindowHandler : public MemTimeTableHandler {
+ public:
+    explicit CachedWindowHandler(std::shared_ptr<MemTimeTableHandler> cached)
+        : MemTimeTableHandler(), cached_(cached) {}
+    ~CachedWindowHandler() override {}
+
+ private:
+    std::shared_ptr<MemTimeTableHandler> cached_;
 };
 
 class RequestUnionRunner : public Runner {
@@ -987,11 +1110,18 @@ class RequestUnionRunner : public Runner {
     void AddWindowUnion(const RequestWindowOp& window, Runner* runner) {
         windows_union_gen_.AddWindowUnion(window, runner);
     }
+    void SetWindowCache(std::shared_ptr<RequestWindowCache> window_cache) { window_cache_ = window_cache; }
     RequestWindowUnionGenerator windows_union_gen_;
     RangeGenerator range_gen_;
     bool exclude_current_time_;
     bool exclude_current_row_ = false;
     bool output_request_row_;
+
+ private:
+    std::shared_ptr<TableHandler> RunWithWindowCache(const Row& request, const Row& parameter, int64_t ts_gen,
+                                                     const std::vector<std::shared_ptr<DataHandler>>& union_inputs);
+
+    std::shared_ptr<RequestWindowCache> window_cache_;
 };
 
 class RequestAggUnionRunner : public Runner {
@@ -1530,6 +1660,9 @@ class RunnerBuilder {
         return cluster_job_;
     }
 
+    // the threads the window aggregation runners share, see WindowAggRunner
+    void SetWindowThreadPool(std::shared_ptr<base::ThreadPool> thread_pool) { window_thread_pool_ = thread_pool; }
+
     template <typename Op, typename... Args>
     void CreateRunner(Op** result_runner, Args&&... args) {
         Op* runner = new Op(std::forward<Args>(args)...);
@@ -1549,6 +1682,7 @@ class RunnerBuilder {
     std::unordered_map<hybridse::vm::Runner*, ::hybridse::vm::Runner*>
         proxy_runner_map_;
     std::set<size_t> batch_common_node_set_;
+    std::shared_ptr<base::ThreadPool> window_thread_pool_;
     ClusterTask MultipleInherit(const std::vector<const ClusterTask*>& children, Runner* runner,
                                                 const Key& index_key, const TaskBiasType bias);
     ClusterTask BinaryInherit(const ClusterTask& left, const ClusterTask& right,
@@ -14,10 +14,15 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <memory>
+#include <optional>
+#include <string>
 #include <utility>
+#include <vector>
 #include "boost/algorithm/string.hpp"
 #include "case/sql_case.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
 #include "llvm/IR/Function.h"
@@ -41,6 +46,10 @@ using namespace llvm::orc;  // NOLINT
 
 ExitOnError ExitOnErr;
 
+DECLARE_int32(batch_window_parallelism);
+DECLARE_bool(enable_batch_hash_join);
+DECLARE_int32(request_window_cache_capacity);
+
 namespace hybridse {
 namespace vm {
 using hybridse::sqlcase::SqlCase;
@@ -375,6 +384,355 @@ TEST_F(RunnerTest, KeyGeneratorTest) {
     ASSERT_EQ("5|55", group_runner->partition_gen_.GetKey(rows[4], empty_parameter));
 }
 
+// compile and run the batch query, compile_info keeps the runners alive
+void RunBatchQuery(std::shared_ptr<SimpleCatalog> catalog, const std::string& sql,
+                   std::shared_ptr<SqlCompileInfo>* compile_info, std::vector<Row>* outputs) {
+    EngineOptions options;
+    Engine engine(catalog, options);
+    BatchRunSession session;
+    base::Status status;
+    ASSERT_TRUE(engine.Get(sql, "db", session, status)) << status;
+    *compile_info = std::dynamic_pointer_cast<SqlCompileInfo>(session.GetCompileInfo());
+    ASSERT_TRUE(*compile_info != nullptr);
+    ASSERT_EQ(0, session.Run(*outputs));
+}
+
+// run the batch window query with the limit, the limit is expected to be
+// pushed down to the window aggregation
+void RunWindowQuery(std::shared_ptr<SimpleCatalog> catalog, const std::string& sql,
+                    std::optional<int32_t> limit, std::vector<Row>* outputs) {
+    std::string query = limit.has_value() ? sql + " limit " + std::to_string(limit.value()) + ";" : sql + ";";
+    std::shared_ptr<SqlCompileInfo> compile_info;
+    RunBatchQuery(catalog, query, &compile_info, outputs);
+    ASSERT_TRUE(compile_info != nullptr);
+    auto runner = GetFirstRunnerOfType(compile_info->get_sql_context().cluster_job.GetMainTask().GetRoot(),
+                                       kRunnerWindowAgg);
+    ASSERT_TRUE(runner != nullptr);
+    ASSERT_EQ(limit, runner->limit_cnt_);
+    // the threads other than the one of the query are from the pool of the engine
+    auto thread_pool = dynamic_cast<WindowAggRunner*>(runner)->thread_pool_;
+    if (FLAGS_batch_window_parallelism > 1) {
+        ASSERT_TRUE(thread_pool != nullptr);
+        ASSERT_EQ(static_cast<size_t>(FLAGS_batch_window_parallelism - 1), thread_pool->GetThreadNum());
+    } else {
+        ASSERT_TRUE(thread_pool == nullptr);
+    }
+}
+
+// a row of the table built by BuildTableDef
+Row BuildTableRow(const hybridse::type::TableDef& table_def, const std::string& str, int32_t col1, int16_t col2,
+                  float col3, double col4, int64_t col5) {
+    codec::RowBuilder builder(table_def.columns());
+    uint32_t total_size = builder.CalTotalLength(str.size() * 2);
+    int8_t* ptr = static_cast<int8_t*>(malloc(total_size));
+    builder.SetBuffer(ptr, total_size);
+    builder.AppendString(str.c_str(), str.size());
+    builder.AppendInt32(col1);
+    builder.AppendInt16(col2);
+    builder.AppendFloat(col3);
+    builder.AppendDouble(col4);
+    builder.AppendInt64(col5);
+    builder.AppendString(str.c_str(), str.size());
+    return Row(base::RefCountedSlice::CreateManaged(ptr, total_size));
+}
+
+void AssertSameRows(const std::vector<Row>& expect, const std::vector<Row>& rows) {
+    ASSERT_EQ(expect.size(), rows.size());
+    for (size_t i = 0; i < expect.size(); i++) {
+        ASSERT_EQ(expect[i].size(), rows[i].size()) << "row " << i;
+        ASSERT_EQ(0, memcmp(expect[i].buf(), rows[i].buf(), expect[i].size())) << "row " << i;
+    }
+}
+
+TEST_F(RunnerTest, WindowAggParallelTest) {
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    table_def.set_name("t1");
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, table_def);
+    auto catalog = BuildSimpleCatalog(db);
+
+    // 37 keys of skewed sizes
+    std::vector<Row> rows;
+    for (int i = 0; i < 1000; i++) {
+        rows.push_back(BuildTableRow(table_def, "s" + std::to_string(i), i % 7 == 0 ? 0 : i % 37, i % 5, i * 1.5f,
+                                     i * 0.5, 1000 + (i * 7919) % 1000));
+    }
+    ASSERT_TRUE(catalog->InsertRows("db", "t1", rows));
+
+    std::string sql =
+        "select col1, col5, sum(col4) over w as w_sum, count(col0) over w as w_cnt, "
+        "max(col3) over w as w_max from t1 window w as "
+        "(partition by col1 order by col5 rows between 10 preceding and current row)";
+    int32_t parallelism = FLAGS_batch_window_parallelism;
+    std::vector<Row> expect;
+    std::vector<Row> expect_limit;
+    FLAGS_batch_window_parallelism = 1;
+    RunWindowQuery(catalog, sql, std::nullopt, &expect);
+    RunWindowQuery(catalog, sql, 100, &expect_limit);
+    ASSERT_EQ(1000u, expect.size());
+    ASSERT_EQ(100u, expect_limit.size());
+    AssertSameRows(std::vector<Row>(expect.begin(), expect.begin() + 100), expect_limit);
+
+    for (int32_t thread_num : {2, 4, 64}) {
+        FLAGS_batch_window_parallelism = thread_num;
+        // the output is merged in the order of keys
+        std::vector<Row> outputs;
+        RunWindowQuery(catalog, sql, std::nullopt, &outputs);
+        AssertSameRows(expect, outputs);
+        // the keys run batch by batch until the limit is reached
+        for (int32_t limit : {1, 100, 999, 2000}) {
+            std::vector<Row> limit_outputs;
+            RunWindowQuery(catalog, sql, limit, &limit_outputs);
+            size_t cnt = std::min(expect.size(), static_cast<size_t>(limit));
+            AssertSameRows(std::vector<Row>(expect.begin(), expect.begin() + cnt), limit_outputs);
+        }
+    }
+    FLAGS_batch_window_parallelism = parallelism;
+}
+
+TEST_F(RunnerTest, LastJoinWithoutIndexTest) {
+    hybridse::type::TableDef t1;
+    BuildTableDef(t1);
+    t1.set_name("t1");
+    hybridse::type::TableDef t2;
+    BuildTableDef(t2);
+    t2.set_name("t2");
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, t1);
+    AddTable(db, t2);
+    auto catalog = BuildSimpleCatalog(db);
+
+    // the left keys 7, 10, 11 and 12 have no match, the right keys and
+    // order keys are duplicated
+    std::vector<Row> left_rows;
+    for (int i = 0; i < 40; i++) {
+        left_rows.push_back(BuildTableRow(t1, "l" + std::to_string(i), i % 13, i % 5, i * 1.0f, i, 1000 + i % 25));
+    }
+    std::vector<Row> right_rows;
+    for (int i = 0; i < 60; i++) {
+        if (i % 10 == 7) {
+            continue;
+        }
+        right_rows.push_back(
+            BuildTableRow(t2, "r" + std::to_string(i), i % 10, i % 3, i * 0.5f, i, 1000 + (i * 37) % 20));
+    }
+    ASSERT_TRUE(catalog->InsertRows("db", "t1", left_rows));
+    ASSERT_TRUE(catalog->InsertRows("db", "t2", right_rows));
+
+    std::vector<std::string> sqls = {
+        "select t1.col0, t2.col0 as r0, t2.col5 as r5 from t1 last join t2 order by t2.col5 "
+        "on t1.col1 = t2.col1;",
+        "select t1.col0, t2.col0 as r0, t2.col5 as r5 from t1 last join t2 order by t2.col5 "
+        "on t1.col1 = t2.col1 and t2.col5 <= t1.col5;",
+        "select t1.col0, t2.col0 as r0, t2.col3 as r3 from t1 last join t2 "
+        "on t1.col1 = t2.col1 and t2.col3 < t1.col3;",
+        "select t1.col0, t2.col0 as r0, t2.col5 as r5 from t1 last join t2 order by t2.col5 "
+        "on t1.col1 = t2.col1 and t1.col2 = t2.col2;"};
+    bool enable_hash_join = FLAGS_enable_batch_hash_join;
+    for (auto& sql : sqls) {
+        std::shared_ptr<SqlCompileInfo> compile_info;
+        // the right table is partitioned for every query
+        std::vector<Row> expect;
+        FLAGS_enable_batch_hash_join = false;
+        RunBatchQuery(catalog, sql, &compile_info, &expect);
+        ASSERT_EQ(left_rows.size(), expect.size()) << sql;
+
+        // the right table is hashed once
+        std::vector<Row> outputs;
+        FLAGS_enable_batch_hash_join = true;
+        RunBatchQuery(catalog, sql, &compile_info, &outputs);
+        auto runner = dynamic_cast<LastJoinRunner*>(GetFirstRunnerOfType(
+            compile_info->get_sql_context().cluster_job.GetMainTask().GetRoot(), kRunnerLastJoin));
+        ASSERT_TRUE(runner != nullptr) << sql;
+        ASSERT_TRUE(runner->join_gen_.right_group_gen_.Valid()) << sql;
+        AssertSameRows(expect, outputs);
+    }
+    FLAGS_enable_batch_hash_join = enable_hash_join;
+}
+
+// the segments of t1 report the write version and count how many times they
+// are scanned, a window read from the cache does not scan them
+struct SegmentStat {
+    bool versioned = true;
+    uint64_t version = 1;
+    int scan_cnt = 0;
+};
+
+class VersionedSegmentHandler : public MemSegmentHandler {
+ public:
+    VersionedSegmentHandler(std::shared_ptr<PartitionHandler> partition, const std::string& key, SegmentStat* stat)
+        : MemSegmentHandler(partition, key), stat_(stat) {}
+    std::unique_ptr<RowIterator> GetIterator() override {
+        stat_->scan_cnt++;
+        return MemSegmentHandler::GetIterator();
+    }
+    RowIterator* GetRawIterator() override {
+        stat_->scan_cnt++;
+        return MemSegmentHandler::GetRawIterator();
+    }
+    // an unversioned segment is read as the remote one
+    bool GetWriteVersion(uint64_t* version) override {
+        if (!stat_->versioned) {
+            return false;
+        }
+        *version = stat_->version;
+        return true;
+    }
+
+ private:
+    SegmentStat* stat_;
+};
+
+class VersionedPartitionHandler : public PartitionHandler {
+ public:
+    VersionedPartitionHandler(std::shared_ptr<PartitionHandler> partition, SegmentStat* stat)
+        : partition_(partition), stat_(stat) {}
+    const Schema* GetSchema() override { return partition_->GetSchema(); }
+    const std::string& GetName() override { return partition_->GetName(); }
+    const std::string& GetDatabase() override { return partition_->GetDatabase(); }
+    const Types& GetTypes() override { return partition_->GetTypes(); }
+    const IndexHint& GetIndex() override { return partition_->GetIndex(); }
+    const uint64_t GetCount() override { return partition_->GetCount(); }
+    const OrderType GetOrderType() const override { return partition_->GetOrderType(); }
+    std::unique_ptr<WindowIterator> GetWindowIterator() override { return partition_->GetWindowIterator(); }
+    std::shared_ptr<TableHandler> GetSegment(const std::string& key) override {
+        return std::make_shared<VersionedSegmentHandler>(partition_, key, stat_);
+    }
+
+ private:
+    std::shared_ptr<PartitionHandler> partition_;
+    SegmentStat* stat_;
+};
+
+class VersionedTableHandler : public SimpleCatalogTableHandler {
+ public:
+    VersionedTableHandler(const std::string& db, const hybridse::type::TableDef& table_def, SegmentStat* stat)
+        : SimpleCatalogTableHandler(db, table_def), stat_(stat) {}
+    std::shared_ptr<PartitionHandler> GetPartition(const std::string& index_name) override {
+        auto partition = SimpleCatalogTableHandler::GetPartition(index_name);
+        return partition ? std::make_shared<VersionedPartitionHandler>(partition, stat_) : partition;
+    }
+
+ private:
+    SegmentStat* stat_;
+};
+
+class VersionedCatalog : public Catalog {
+ public:
+    VersionedCatalog(const hybridse::type::Database& db, std::shared_ptr<TableHandler> table)
+        : db_(std::make_shared<hybridse::type::Database>(db)), table_(table) {}
+    bool IndexSupport() override { return true; }
+    std::shared_ptr<type::Database> GetDatabase(const std::string& db) override {
+        return db == db_->name() ? db_ : nullptr;
+    }
+    std::shared_ptr<TableHandler> GetTable(const std::string& db, const std::string& table_name) override {
+        return db == db_->name() && table_name == table_->GetName() ? table_ : nullptr;
+    }
+
+ private:
+    std::shared_ptr<type::Database> db_;
+    std::shared_ptr<TableHandler> table_;
+};
+
+TEST_F(RunnerTest, RequestWindowCacheTest) {
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    table_def.set_name("t1");
+    ::hybridse::type::IndexDef* index = table_def.add_indexes();
+    index->set_name("index1");
+    index->add_first_keys("col1");
+    index->set_second_key("col5");
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, table_def);
+    SegmentStat stat;
+    auto table = std::make_shared<VersionedTableHandler>("db", table_def, &stat);
+    // the rows of a key are added in the descending order of ts as the storage
+    // keeps them
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(table->AddRow(BuildTableRow(table_def, "r" + std::to_string(i), 1, 0, i * 1.0f, i, 2000 - i)));
+    }
+    auto catalog = std::make_shared<VersionedCatalog>(db, table);
+
+    int32_t capacity = FLAGS_request_window_cache_capacity;
+    FLAGS_request_window_cache_capacity = 16;
+    EngineOptions options;
+    Engine engine(catalog, options);
+    RequestRunSession session;
+    base::Status status;
+    std::string sql =
+        "select col1, count(col0) over w as w_cnt, sum(col5) over w as w_sum from t1 window w as "
+        "(partition by col1 order by col5 rows_range between 100 preceding and current row);";
+    bool ok = engine.Get(sql, "db", session, status);
+    FLAGS_request_window_cache_capacity = capacity;
+    ASSERT_TRUE(ok) << status;
+
+    codec::RowView view(session.GetSchema());
+    Row request = BuildTableRow(table_def, "request", 1, 0, 0.0f, 0, 2005);
+    // the sum is read from the copies of the rows on a hit
+    auto check_window = [&](int64_t exp_cnt, int64_t exp_sum, bool hit) {
+        int scan_cnt = stat.scan_cnt;
+        Row output;
+        ASSERT_EQ(0, session.Run(request, &output));
+        ASSERT_TRUE(view.Reset(output.buf(), output.size()));
+        ASSERT_EQ(exp_cnt, view.GetInt64Unsafe(1));
+        ASSERT_EQ(exp_sum, view.GetInt64Unsafe(2));
+        if (hit) {
+            ASSERT_EQ(scan_cnt, stat.scan_cnt);
+        } else {
+            ASSERT_LT(scan_cnt, stat.scan_cnt);
+        }
+    };
+    // the request row and the 10 rows of key 1
+    check_window(11, 21960, false);
+    check_window(11, 21960, true);
+
+    // a put moves the version of the segment
+    ASSERT_TRUE(table->AddRow(BuildTableRow(table_def, "r10", 1, 0, 10.0f, 10, 1990)));
+    stat.version++;
+    check_window(12, 23950, false);
+    check_window(12, 23950, true);
+
+    // the window of another ts is not hit
+    request = BuildTableRow(table_def, "request", 1, 0, 0.0f, 0, 2006);
+    check_window(12, 23951, false);
+    check_window(12, 23951, true);
+
+    // the version of a remote segment is unknown, it is never cached
+    stat.versioned = false;
+    check_window(12, 23951, false);
+    check_window(12, 23951, false);
+}
+
+TEST_F(RunnerTest, RequestWindowCacheEvictTest) {
+    RequestWindowCache cache(3, 100);
+    cache.Put("a", std::make_shared<MemTimeTableHandler>(), 40);
+    cache.Put("b", std::make_shared<MemTimeTableHandler>(), 40);
+    ASSERT_TRUE(cache.Get("a") != nullptr);
+    // b is the least recently used one when the bytes exceed
+    cache.Put("c", std::make_shared<MemTimeTableHandler>(), 40);
+    ASSERT_TRUE(cache.Get("b") == nullptr);
+    ASSERT_TRUE(cache.Get("a") != nullptr);
+    ASSERT_TRUE(cache.Get("c") != nullptr);
+    ASSERT_EQ(80u, cache.GetBytes());
+
+    // a window larger than the max bytes is not kept
+    cache.Put("d", std::make_shared<MemTimeTableHandler>(), 101);
+    ASSERT_TRUE(cache.Get("d") == nullptr);
+    ASSERT_EQ(2u, cache.GetSize());
+    ASSERT_EQ(80u, cache.GetBytes());
+
+    // a is the least recently used one when the count exceeds
+    cache.Put("e", std::make_shared<MemTimeTableHandler>(), 1);
+    cache.Put("f", std::make_shared<MemTimeTableHandler>(), 1);
+    ASSERT_EQ(3u, cache.GetSize());
+    ASSERT_TRUE(cache.Get("a") == nullptr);
+    ASSERT_EQ(42u, cache.GetBytes());
+}
+
 TEST_F(RunnerTest, RunnerPrintDataTest) {
     hybridse::type::TableDef table_def;
     BuildTableDef(table_def);
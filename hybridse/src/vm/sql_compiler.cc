@@ -308,6 +308,7 @@ bool SqlCompiler::BuildClusterJob(SqlContext& ctx, Status& status) {  // NOLINT
                                  ctx.is_cluster_optimized && is_request_mode,
                                  ctx.batch_request_info.common_column_indices,
                                  ctx.batch_request_info.common_node_set);
+    runner_builder.SetWindowThreadPool(ctx.window_thread_pool);
     ctx.cluster_job = runner_builder.BuildClusterJob(ctx.physical_plan, status);
     return status.isOK();
 }
@@ -77,6 +77,10 @@ struct SqlContext {
 
     std::shared_ptr<const std::unordered_map<std::string, std::string>> options;
 
+    // the threads of the batch window aggregation, it runs in the thread of
+    // the query if null
+    std::shared_ptr<base::ThreadPool> window_thread_pool;
+
     SqlContext() {}
     ~SqlContext() {}
 };
@@ -0,0 +1,674 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/vectorized_project.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "codegen/ir_base_builder.h"
+#include "glog/logging.h"
+
+namespace hybridse {
+namespace vm {
+
+static bool IsIntType(type::Type type) {
+    switch (type) {
+        case type::kBool:
+        case type::kInt16:
+        case type::kInt32:
+        case type::kInt64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool IsFloatType(type::Type type) { return type == type::kFloat || type == type::kDouble; }
+
+// the compiled function computes in the width of the type, so the results
+// overflow the same way
+static int64_t WrapInt(type::Type type, int64_t val) {
+    switch (type) {
+        case type::kBool:
+            return val != 0;
+        case type::kInt16:
+            return static_cast<int16_t>(val);
+        case type::kInt32:
+            return static_cast<int32_t>(val);
+        default:
+            return val;
+    }
+}
+
+static void WrapInts(type::Type type, int64_t* vals, size_t size) {
+    switch (type) {
+        case type::kBool:
+            for (size_t i = 0; i < size; i++) vals[i] = vals[i] != 0;
+            break;
+        case type::kInt16:
+            for (size_t i = 0; i < size; i++) vals[i] = static_cast<int16_t>(vals[i]);
+            break;
+        case type::kInt32:
+            for (size_t i = 0; i < size; i++) vals[i] = static_cast<int32_t>(vals[i]);
+            break;
+        default:
+            break;
+    }
+}
+
+// a float is exact in a double, and the result of +, - and * of two floats
+// rounded from double is the same as computed in float
+static void RoundFloats(type::Type type, double* vals, size_t size) {
+    if (type == type::kFloat) {
+        for (size_t i = 0; i < size; i++) vals[i] = static_cast<float>(vals[i]);
+    }
+}
+
+template <class T, class Op>
+static void BinaryLoop(const T* lhs, const T* rhs, T* out, size_t size, Op op) {
+    for (size_t i = 0; i < size; i++) {
+        out[i] = op(lhs[i], rhs[i]);
+    }
+}
+
+template <class T, class Op>
+static void CompareLoop(const T* lhs, const T* rhs, int64_t* out, size_t size, Op op) {
+    for (size_t i = 0; i < size; i++) {
+        out[i] = op(lhs[i], rhs[i]);
+    }
+}
+
+// the integers wrap around instead of the undefined overflow of int64_t
+template <class Op>
+static void IntArithLoop(const int64_t* lhs, const int64_t* rhs, int64_t* out, size_t size, Op op) {
+    for (size_t i = 0; i < size; i++) {
+        out[i] = static_cast<int64_t>(op(static_cast<uint64_t>(lhs[i]), static_cast<uint64_t>(rhs[i])));
+    }
+}
+
+ColumnBatch::ColumnBatch(const VectorizedProjectPlan* plan)
+    : size_(0),
+      columns_(plan->ops().size()),
+      views_(),
+      valid_views_(plan->schemas_ctx()->GetSchemaSourceSize(), 0),
+      row_builder_(plan->output_schema()) {
+    for (size_t i = 0; i < plan->schemas_ctx()->GetSchemaSourceSize(); i++) {
+        views_.emplace_back(*plan->schemas_ctx()->GetSchema(i));
+    }
+}
+
+VectorizedProjectPlan::VectorizedProjectPlan(const SchemasContext* schemas_ctx, const Schema& output_schema,
+                                             const std::vector<VectorizedOp>& ops,
+                                             const std::vector<VectorizedOutput>& outputs)
+    : schemas_ctx_(schemas_ctx),
+      output_schema_(output_schema),
+      ops_(ops),
+      outputs_(outputs),
+      column_ops_(),
+      sources_() {
+    for (size_t i = 0; i < ops_.size(); i++) {
+        if (ops_[i].kind == VectorizedOp::kColumn) {
+            column_ops_.push_back(i);
+            if (std::find(sources_.begin(), sources_.end(), ops_[i].schema_idx) == sources_.end()) {
+                sources_.push_back(ops_[i].schema_idx);
+            }
+        }
+    }
+}
+
+std::shared_ptr<VectorizedProjectPlan> VectorizedProjectPlan::Create(const FnInfo& fn_info) {
+    const node::LambdaNode* fn_def = fn_info.fn_def();
+    const SchemasContext* schemas_ctx = fn_info.schemas_ctx();
+    const Schema& output_schema = *fn_info.fn_schema();
+    if (fn_def == nullptr || schemas_ctx == nullptr || fn_def->body() == nullptr ||
+        fn_def->body()->GetExprType() != node::kExprList ||
+        fn_def->body()->GetChildNum() != static_cast<size_t>(output_schema.size())) {
+        return nullptr;
+    }
+    const node::ExprNode* body = fn_def->body();
+    VectorizedProjectPlan builder(schemas_ctx, output_schema, {}, {});
+    std::vector<VectorizedOutput> outputs;
+    for (size_t i = 0; i < body->GetChildNum(); i++) {
+        const node::ExprNode* expr = body->GetChild(i);
+        VectorizedOutput output;
+        output.is_copy = false;
+        output.op_idx = 0;
+        output.schema_idx = 0;
+        output.col_idx = 0;
+        output.type = output_schema.Get(i).type();
+        if (expr->GetExprType() == node::kExprGetField && !IsIntType(output.type) && !IsFloatType(output.type)) {
+            // the strings, timestamps and dates are copied as they are
+            auto field = dynamic_cast<const node::GetFieldExpr*>(expr);
+            if (!schemas_ctx->ResolveColumnIndexByID(field->GetColumnID(), &output.schema_idx, &output.col_idx)
+                     .isOK() ||
+                schemas_ctx->GetSchema(output.schema_idx)->Get(output.col_idx).type() != output.type) {
+                return nullptr;
+            }
+            output.is_copy = true;
+        } else {
+            int op = builder.Compile(expr);
+            if (op < 0 || builder.ops_[op].type != output.type) {
+                return nullptr;
+            }
+            output.op_idx = op;
+        }
+        outputs.push_back(output);
+    }
+    return std::make_shared<VectorizedProjectPlan>(schemas_ctx, output_schema, builder.ops_, outputs);
+}
+
+int VectorizedProjectPlan::AddOp(const VectorizedOp& op) {
+    ops_.push_back(op);
+    return static_cast<int>(ops_.size()) - 1;
+}
+
+int VectorizedProjectPlan::CastTo(int op, type::Type type) {
+    if (op < 0) {
+        return -1;
+    }
+    type::Type from = ops_[op].type;
+    if (from == type) {
+        return op;
+    }
+    // the compiled function converts floats to integers with the platform
+    // instruction, which is not portable for the out of range values
+    if (IsFloatType(from) && IsIntType(type)) {
+        return -1;
+    }
+    VectorizedOp cast = {VectorizedOp::kCast, type, static_cast<size_t>(op), 0, 0, 0, 0, 0};
+    return AddOp(cast);
+}
+
+int VectorizedProjectPlan::Compile(const node::ExprNode* expr) {
+    type::Type type;
+    if (expr == nullptr || expr->GetOutputType() == nullptr ||
+        !codegen::DataType2SchemaType(*expr->GetOutputType(), &type) || (!IsIntType(type) && !IsFloatType(type))) {
+        return -1;
+    }
+    VectorizedOp op = {VectorizedOp::kConst, type, 0, 0, 0, 0, 0, 0};
+    switch (expr->GetExprType()) {
+        case node::kExprGetField: {
+            auto field = dynamic_cast<const node::GetFieldExpr*>(expr);
+            if (!schemas_ctx_->ResolveColumnIndexByID(field->GetColumnID(), &op.schema_idx, &op.col_idx).isOK() ||
+                schemas_ctx_->GetSchema(op.schema_idx)->Get(op.col_idx).type() != type) {
+                return -1;
+            }
+            for (size_t i = 0; i < ops_.size(); i++) {
+                if (ops_[i].kind == VectorizedOp::kColumn && ops_[i].schema_idx == op.schema_idx &&
+                    ops_[i].col_idx == op.col_idx) {
+                    return i;
+                }
+            }
+            op.kind = VectorizedOp::kColumn;
+            return AddOp(op);
+        }
+        case node::kExprPrimary: {
+            auto value = dynamic_cast<const node::ConstNode*>(expr);
+            bool is_float = false;
+            switch (value->GetDataType()) {
+                case node::kBool:
+                    op.int_val = value->GetBool();
+                    break;
+                case node::kInt16:
+                    op.int_val = value->GetSmallInt();
+                    break;
+                case node::kInt32:
+                    op.int_val = value->GetInt();
+                    break;
+                case node::kInt64:
+                    op.int_val = value->GetLong();
+                    break;
+                case node::kFloat:
+                    op.float_val = value->GetFloat();
+                    is_float = true;
+                    break;
+                case node::kDouble:
+                    op.float_val = value->GetDouble();
+                    is_float = true;
+                    break;
+                default:
+                    return -1;
+            }
+            if (is_float != IsFloatType(type)) {
+                return -1;
+            }
+            op.int_val = WrapInt(type, op.int_val);
+            if (type == type::kFloat) {
+                op.float_val = static_cast<float>(op.float_val);
+            }
+            return AddOp(op);
+        }
+        case node::kExprCast: {
+            return CastTo(Compile(expr->GetChild(0)), type);
+        }
+        case node::kExprUnary: {
+            auto unary = dynamic_cast<const node::UnaryExpr*>(expr);
+            int child = Compile(expr->GetChild(0));
+            if (child < 0) {
+                return -1;
+            }
+            switch (unary->GetOp()) {
+                case node::kFnOpBracket:
+                    return ops_[child].type == type ? child : -1;
+                case node::kFnOpNot:
+                    if (type != type::kBool || ops_[child].type != type::kBool) {
+                        return -1;
+                    }
+                    op.kind = VectorizedOp::kNot;
+                    op.lhs = child;
+                    return AddOp(op);
+                case node::kFnOpMinus:
+                    if (type == type::kBool) {
+                        return ops_[child].type == type::kBool ? child : -1;
+                    }
+                    op.kind = VectorizedOp::kNeg;
+                    op.lhs = CastTo(child, type);
+                    return op.lhs < 0 ? -1 : AddOp(op);
+                default:
+                    return -1;
+            }
+        }
+        case node::kExprBinary: {
+            auto binary = dynamic_cast<const node::BinaryExpr*>(expr);
+            int lhs = Compile(expr->GetChild(0));
+            int rhs = Compile(expr->GetChild(1));
+            if (lhs < 0 || rhs < 0) {
+                return -1;
+            }
+            switch (binary->GetOp()) {
+                case node::kFnOpAdd:
+                case node::kFnOpMinus:
+                case node::kFnOpMulti: {
+                    if (type == type::kBool) {
+                        return -1;
+                    }
+                    op.kind = binary->GetOp() == node::kFnOpAdd     ? VectorizedOp::kAdd
+                              : binary->GetOp() == node::kFnOpMinus ? VectorizedOp::kSub
+                                                                    : VectorizedOp::kMul;
+                    lhs = CastTo(lhs, type);
+                    rhs = CastTo(rhs, type);
+                    break;
+                }
+                case node::kFnOpAnd:
+                case node::kFnOpOr: {
+                    if (type != type::kBool || ops_[lhs].type != type::kBool || ops_[rhs].type != type::kBool) {
+                        return -1;
+                    }
+                    op.kind = binary->GetOp() == node::kFnOpAnd ? VectorizedOp::kAnd : VectorizedOp::kOr;
+                    break;
+                }
+                case node::kFnOpEq:
+                case node::kFnOpNeq:
+                case node::kFnOpLt:
+                case node::kFnOpLe:
+                case node::kFnOpGt:
+                case node::kFnOpGe: {
+                    if (type != type::kBool) {
+                        return -1;
+                    }
+                    switch (binary->GetOp()) {
+                        case node::kFnOpEq:
+                            op.kind = VectorizedOp::kEq;
+                            break;
+                        case node::kFnOpNeq:
+                            op.kind = VectorizedOp::kNe;
+                            break;
+                        case node::kFnOpLt:
+                            op.kind = VectorizedOp::kLt;
+                            break;
+                        case node::kFnOpLe:
+                            op.kind = VectorizedOp::kLe;
+                            break;
+                        case node::kFnOpGt:
+                            op.kind = VectorizedOp::kGt;
+                            break;
+                        default:
+                            op.kind = VectorizedOp::kGe;
+                            break;
+                    }
+                    // the integers are compared in int64 and the floats in
+                    // double, an integer is compared with a double in double.
+                    // The compiled function compares an integer with a float
+                    // in float, which is left to it
+                    bool lhs_float = IsFloatType(ops_[lhs].type);
+                    bool rhs_float = IsFloatType(ops_[rhs].type);
+                    if (lhs_float != rhs_float) {
+                        if (ops_[lhs].type == type::kFloat || ops_[rhs].type == type::kFloat) {
+                            return -1;
+                        }
+                        lhs = CastTo(lhs, type::kDouble);
+                        rhs = CastTo(rhs, type::kDouble);
+                    }
+                    break;
+                }
+                default:
+                    return -1;
+            }
+            if (lhs < 0 || rhs < 0) {
+                return -1;
+            }
+            op.lhs = lhs;
+            op.rhs = rhs;
+            return AddOp(op);
+        }
+        default:
+            return -1;
+    }
+}
+
+void VectorizedProjectPlan::Decode(const Row* rows, size_t size, ColumnBatch* batch) const {
+    std::vector<uint8_t>& valid = batch->valid_views_;
+    for (size_t pos = 0; pos < size; pos++) {
+        const Row& row = rows[pos];
+        // the view of a slice is reset once for a row
+        for (size_t schema_idx : sources_) {
+            valid[schema_idx] = static_cast<int32_t>(schema_idx) < row.GetRowPtrCnt() &&
+                                batch->views_[schema_idx].Reset(row.buf(schema_idx), row.size(schema_idx));
+        }
+        for (size_t idx : column_ops_) {
+            const VectorizedOp& op = ops_[idx];
+            ColumnVector& column = batch->columns_[idx];
+            codec::RowView& view = batch->views_[op.schema_idx];
+            column.ints[pos] = 0;
+            column.floats[pos] = 0;
+            if (!valid[op.schema_idx] || view.IsNULL(op.col_idx)) {
+                column.nulls[pos] = 1;
+                continue;
+            }
+            column.nulls[pos] = 0;
+            switch (op.type) {
+                case type::kBool:
+                    column.ints[pos] = view.GetBoolUnsafe(op.col_idx);
+                    break;
+                case type::kInt16:
+                    column.ints[pos] = view.GetInt16Unsafe(op.col_idx);
+                    break;
+                case type::kInt32:
+                    column.ints[pos] = view.GetInt32Unsafe(op.col_idx);
+                    break;
+                case type::kInt64:
+                    column.ints[pos] = view.GetInt64Unsafe(op.col_idx);
+                    break;
+                case type::kFloat:
+                    column.floats[pos] = view.GetFloatUnsafe(op.col_idx);
+                    break;
+                case type::kDouble:
+                    column.floats[pos] = view.GetDoubleUnsafe(op.col_idx);
+                    break;
+                default:
+                    column.nulls[pos] = 1;
+                    break;
+            }
+        }
+    }
+}
+
+void VectorizedProjectPlan::Evaluate(const Row* rows, size_t size, ColumnBatch* batch) const {
+    batch->size_ = size;
+    for (size_t i = 0; i < ops_.size(); i++) {
+        ColumnVector& column = batch->columns_[i];
+        column.ints.resize(size);
+        column.floats.resize(size);
+        column.nulls.resize(size);
+    }
+    Decode(rows, size, batch);
+    for (size_t i = 0; i < ops_.size(); i++) {
+        if (ops_[i].kind != VectorizedOp::kColumn) {
+            EvaluateOp(i, size, batch);
+        }
+    }
+}
+
+void VectorizedProjectPlan::EvaluateOp(size_t idx, size_t size, ColumnBatch* batch) const {
+    const VectorizedOp& op = ops_[idx];
+    ColumnVector& out = batch->columns_[idx];
+    const ColumnVector& lhs = batch->columns_[op.lhs];
+    const ColumnVector& rhs = batch->columns_[op.rhs];
+    int64_t* out_ints = out.ints.data();
+    double* out_floats = out.floats.data();
+    uint8_t* out_nulls = out.nulls.data();
+    const uint8_t* lhs_nulls = lhs.nulls.data();
+    const uint8_t* rhs_nulls = rhs.nulls.data();
+    bool is_float = IsFloatType(op.type);
+    switch (op.kind) {
+        case VectorizedOp::kConst: {
+            std::fill(out.ints.begin(), out.ints.end(), op.int_val);
+            std::fill(out.floats.begin(), out.floats.end(), op.float_val);
+            std::fill(out.nulls.begin(), out.nulls.end(), 0);
+            return;
+        }
+        case VectorizedOp::kCast: {
+            const type::Type from = ops_[op.lhs].type;
+            if (IsIntType(from) && IsIntType(op.type)) {
+                std::copy(lhs.ints.begin(), lhs.ints.end(), out.ints.begin());
+                WrapInts(op.type, out_ints, size);
+            } else if (IsIntType(from) && op.type == type::kFloat) {
+                // rounded from the integer once like the compiled function
+                for (size_t i = 0; i < size; i++) out_floats[i] = static_cast<float>(lhs.ints[i]);
+            } else if (IsIntType(from)) {
+                for (size_t i = 0; i < size; i++) out_floats[i] = static_cast<double>(lhs.ints[i]);
+            } else {
+                std::copy(lhs.floats.begin(), lhs.floats.end(), out.floats.begin());
+                RoundFloats(op.type, out_floats, size);
+            }
+            std::copy(lhs.nulls.begin(), lhs.nulls.end(), out.nulls.begin());
+            return;
+        }
+        case VectorizedOp::kNeg: {
+            if (is_float) {
+                for (size_t i = 0; i < size; i++) out_floats[i] = 0 - lhs.floats[i];
+            } else {
+                for (size_t i = 0; i < size; i++) {
+                    out_ints[i] = static_cast<int64_t>(0 - static_cast<uint64_t>(lhs.ints[i]));
+                }
+                WrapInts(op.type, out_ints, size);
+            }
+            std::copy(lhs.nulls.begin(), lhs.nulls.end(), out.nulls.begin());
+            return;
+        }
+        case VectorizedOp::kNot: {
+            for (size_t i = 0; i < size; i++) out_ints[i] = lhs.ints[i] == 0;
+            std::copy(lhs.nulls.begin(), lhs.nulls.end(), out.nulls.begin());
+            return;
+        }
+        case VectorizedOp::kAnd: {
+            // the same three-valued logic as PredicateIRBuilder
+            for (size_t i = 0; i < size; i++) {
+                uint8_t l = lhs.ints[i] != 0;
+                uint8_t r = rhs.ints[i] != 0;
+                out_ints[i] = l & r;
+                out_nulls[i] = (lhs_nulls[i] & (rhs_nulls[i] | r)) | (l & rhs_nulls[i]);
+            }
+            return;
+        }
+        case VectorizedOp::kOr: {
+            for (size_t i = 0; i < size; i++) {
+                uint8_t l = lhs.ints[i] != 0;
+                uint8_t r = rhs.ints[i] != 0;
+                out_ints[i] = l | r;
+                out_nulls[i] = (lhs_nulls[i] & (rhs_nulls[i] | (r ^ 1))) | ((l ^ 1) & rhs_nulls[i]);
+            }
+            return;
+        }
+        default:
+            break;
+    }
+    // the binary ops are null if any of the operands is null
+    for (size_t i = 0; i < size; i++) {
+        out_nulls[i] = lhs_nulls[i] | rhs_nulls[i];
+    }
+    const bool cmp_float = IsFloatType(ops_[op.lhs].type);
+    const int64_t* l_ints = lhs.ints.data();
+    const int64_t* r_ints = rhs.ints.data();
+    const double* l_floats = lhs.floats.data();
+    const double* r_floats = rhs.floats.data();
+    switch (op.kind) {
+        case VectorizedOp::kAdd:
+            if (is_float) {
+                BinaryLoop(l_floats, r_floats, out_floats, size, [](double a, double b) { return a + b; });
+            } else {
+                IntArithLoop(l_ints, r_ints, out_ints, size, [](uint64_t a, uint64_t b) { return a + b; });
+            }
+            break;
+        case VectorizedOp::kSub:
+            if (is_float) {
+                BinaryLoop(l_floats, r_floats, out_floats, size, [](double a, double b) { return a - b; });
+            } else {
+                IntArithLoop(l_ints, r_ints, out_ints, size, [](uint64_t a, uint64_t b) { return a - b; });
+            }
+            break;
+        case VectorizedOp::kMul:
+            if (is_float) {
+                BinaryLoop(l_floats, r_floats, out_floats, size, [](double a, double b) { return a * b; });
+            } else {
+                IntArithLoop(l_ints, r_ints, out_ints, size, [](uint64_t a, uint64_t b) { return a * b; });
+            }
+            break;
+        case VectorizedOp::kEq:
+            cmp_float ? CompareLoop(l_floats, r_floats, out_ints, size, [](double a, double b) { return a == b; })
+                      : CompareLoop(l_ints, r_ints, out_ints, size, [](int64_t a, int64_t b) { return a == b; });
+            break;
+        case VectorizedOp::kNe:
+            cmp_float ? CompareLoop(l_floats, r_floats, out_ints, size, [](double a, double b) { return a != b; })
+                      : CompareLoop(l_ints, r_ints, out_ints, size, [](int64_t a, int64_t b) { return a != b; });
+            break;
+        case VectorizedOp::kLt:
+            cmp_float ? CompareLoop(l_floats, r_floats, out_ints, size, [](double a, double b) { return a < b; })
+                      : CompareLoop(l_ints, r_ints, out_ints, size, [](int64_t a, int64_t b) { return a < b; });
+            break;
+        case VectorizedOp::kLe:
+            cmp_float ? CompareLoop(l_floats, r_floats, out_ints, size, [](double a, double b) { return a <= b; })
+                      : CompareLoop(l_ints, r_ints, out_ints, size, [](int64_t a, int64_t b) { return a <= b; });
+            break;
+        case VectorizedOp::kGt:
+            cmp_float ? CompareLoop(l_floats, r_floats, out_ints, size, [](double a, double b) { return a > b; })
+                      : CompareLoop(l_ints, r_ints, out_ints, size, [](int64_t a, int64_t b) { return a > b; });
+            break;
+        case VectorizedOp::kGe:
+            cmp_float ? CompareLoop(l_floats, r_floats, out_ints, size, [](double a, double b) { return a >= b; })
+                      : CompareLoop(l_ints, r_ints, out_ints, size, [](int64_t a, int64_t b) { return a >= b; });
+            break;
+        default:
+            LOG(WARNING) << "unknown vectorized op " << op.kind;
+            return;
+    }
+    if (is_float) {
+        RoundFloats(op.type, out_floats, size);
+    } else {
+        WrapInts(op.type, out_ints, size);
+    }
+}
+
+bool VectorizedProjectPlan::Condition(const ColumnBatch& batch, size_t pos) const {
+    const VectorizedOutput& output = outputs_[0];
+    if (output.is_copy) {
+        return false;
+    }
+    const ColumnVector& column = batch.columns_[output.op_idx];
+    if (column.nulls[pos]) {
+        return false;
+    }
+    return IsFloatType(output.type) ? column.floats[pos] != 0 : column.ints[pos] != 0;
+}
+
+Row VectorizedProjectPlan::Output(const Row& row, size_t pos, ColumnBatch* batch) const {
+    codec::RowBuilder& row_builder = batch->row_builder_;
+    uint32_t str_len = 0;
+    for (const auto& output : outputs_) {
+        if (output.is_copy && output.type == type::kVarchar) {
+            codec::RowView& view = batch->views_[output.schema_idx];
+            const char* str = nullptr;
+            uint32_t len = 0;
+            if (view.Reset(row.buf(output.schema_idx), row.size(output.schema_idx)) &&
+                view.GetString(output.col_idx, &str, &len) == 0) {
+                str_len += len;
+            }
+        }
+    }
+    uint32_t total_len = row_builder.CalTotalLength(str_len);
+    int8_t* buf = static_cast<int8_t*>(malloc(total_len));
+    row_builder.SetBuffer(buf, total_len);
+    for (size_t i = 0; i < outputs_.size(); i++) {
+        const auto& output = outputs_[i];
+        bool ok = true;
+        if (!output.is_copy) {
+            const ColumnVector& column = batch->columns_[output.op_idx];
+            if (column.nulls[pos]) {
+                ok = row_builder.AppendNULL();
+            } else {
+                switch (output.type) {
+                    case type::kBool:
+                        ok = row_builder.AppendBool(column.ints[pos] != 0);
+                        break;
+                    case type::kInt16:
+                        ok = row_builder.AppendInt16(static_cast<int16_t>(column.ints[pos]));
+                        break;
+                    case type::kInt32:
+                        ok = row_builder.AppendInt32(static_cast<int32_t>(column.ints[pos]));
+                        break;
+                    case type::kInt64:
+                        ok = row_builder.AppendInt64(column.ints[pos]);
+                        break;
+                    case type::kFloat:
+                        ok = row_builder.AppendFloat(static_cast<float>(column.floats[pos]));
+                        break;
+                    case type::kDouble:
+                        ok = row_builder.AppendDouble(column.floats[pos]);
+                        break;
+                    default:
+                        ok = false;
+                        break;
+                }
+            }
+        } else {
+            codec::RowView& view = batch->views_[output.schema_idx];
+            uint32_t idx = output.col_idx;
+            if (!view.Reset(row.buf(output.schema_idx), row.size(output.schema_idx)) || view.IsNULL(idx)) {
+                ok = row_builder.AppendNULL();
+            } else {
+                switch (output.type) {
+                    case type::kTimestamp:
+                        ok = row_builder.AppendTimestamp(view.GetTimestampUnsafe(idx));
+                        break;
+                    case type::kDate:
+                        ok = row_builder.AppendDate(view.GetDateUnsafe(idx));
+                        break;
+                    case type::kVarchar: {
+                        const char* str = nullptr;
+                        uint32_t len = 0;
+                        view.GetString(idx, &str, &len);
+                        ok = row_builder.AppendString(str, len);
+                        break;
+                    }
+                    default:
+                        ok = false;
+                        break;
+                }
+            }
+        }
+        if (!ok) {
+            LOG(WARNING) << "fail to encode column " << output_schema_.Get(i).name() << " of vectorized project";
+            free(buf);
+            return Row();
+        }
+    }
+    return Row(base::RefCountedSlice::CreateManaged(buf, total_len));
+}
+
+}  // namespace vm
+}  // namespace hybridse
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_VECTORIZED_PROJECT_H_
+#define HYBRIDSE_SRC_VM_VECTORIZED_PROJECT_H_
+
+#include <memory>
+#include <vector>
+
+#include "codec/fe_row_codec.h"
+#include "node/sql_node.h"
+#include "vm/physical_op.h"
+#include "vm/schemas_context.h"
+
+namespace hybridse {
+namespace vm {
+
+// the rows of a batch are decoded and evaluated together
+static const size_t COLUMN_BATCH_SIZE = 1024;
+
+// ColumnVector is a column of a batch, integers and bools are kept in ints,
+// floats and doubles in floats, a value is null if nulls is 1
+struct ColumnVector {
+    std::vector<int64_t> ints;
+    std::vector<double> floats;
+    std::vector<uint8_t> nulls;
+};
+
+// an instruction of VectorizedProjectPlan, it computes a column of the
+// batch from the columns of its operands
+struct VectorizedOp {
+    enum Kind {
+        kColumn,
+        kConst,
+        kCast,
+        kAdd,
+        kSub,
+        kMul,
+        kNeg,
+        kEq,
+        kNe,
+        kLt,
+        kLe,
+        kGt,
+        kGe,
+        kAnd,
+        kOr,
+        kNot,
+    };
+    Kind kind;
+    // the type of the result
+    type::Type type;
+    size_t lhs;
+    size_t rhs;
+    // the input column of kColumn
+    size_t schema_idx;
+    size_t col_idx;
+    // the value of kConst
+    int64_t int_val;
+    double float_val;
+};
+
+// an output column of VectorizedProjectPlan, it is either copied from the
+// input row or computed by an op
+struct VectorizedOutput {
+    bool is_copy;
+    size_t op_idx;
+    size_t schema_idx;
+    size_t col_idx;
+    type::Type type;
+};
+
+class VectorizedProjectPlan;
+
+// ColumnBatch keeps the columns of the ops of a plan over a batch of rows,
+// and the row views and the builder to decode and encode the rows
+class ColumnBatch {
+ public:
+    explicit ColumnBatch(const VectorizedProjectPlan* plan);
+
+    size_t size() const { return size_; }
+
+ private:
+    friend class VectorizedProjectPlan;
+    size_t size_;
+    std::vector<ColumnVector> columns_;
+    std::vector<codec::RowView> views_;
+    // whether the view of the slice is reset to the current row
+    std::vector<uint8_t> valid_views_;
+    codec::RowBuilder row_builder_;
+};
+
+// VectorizedProjectPlan evaluates the arithmetic, comparisons and logical
+// operations over the numeric columns of a project or a filter a batch of
+// rows at a time. Every op is a tight loop over the columns of the batch,
+// which the compiler vectorizes, instead of calling the compiled function
+// for each row and decoding the row for each expression
+class VectorizedProjectPlan {
+ public:
+    VectorizedProjectPlan(const SchemasContext* schemas_ctx, const Schema& output_schema,
+                          const std::vector<VectorizedOp>& ops, const std::vector<VectorizedOutput>& outputs);
+
+    // return nullptr if some of the expressions can not be evaluated in
+    // batches, the compiled function is used then
+    static std::shared_ptr<VectorizedProjectPlan> Create(const FnInfo& fn_info);
+
+    const SchemasContext* schemas_ctx() const { return schemas_ctx_; }
+    const Schema& output_schema() const { return output_schema_; }
+    const std::vector<VectorizedOp>& ops() const { return ops_; }
+    const std::vector<VectorizedOutput>& outputs() const { return outputs_; }
+
+    // decode and evaluate rows[0, size), size is no more than COLUMN_BATCH_SIZE
+    void Evaluate(const Row* rows, size_t size, ColumnBatch* batch) const;
+
+    // encode the output of the row at pos of the batch
+    Row Output(const Row& row, size_t pos, ColumnBatch* batch) const;
+
+    // whether the row at pos of the batch passes the condition, a null
+    // condition does not pass
+    bool Condition(const ColumnBatch& batch, size_t pos) const;
+
+ private:
+    // return the index of the op of expr, -1 if expr is not supported
+    int Compile(const node::ExprNode* expr);
+
+    // cast the result of op to type, return -1 if it is not supported
+    int CastTo(int op, type::Type type);
+
+    int AddOp(const VectorizedOp& op);
+
+    void Decode(const Row* rows, size_t size, ColumnBatch* batch) const;
+
+    void EvaluateOp(size_t idx, size_t size, ColumnBatch* batch) const;
+
+    const SchemasContext* schemas_ctx_;
+    const Schema output_schema_;
+    // the ops are in topological order, the operands go first
+    std::vector<VectorizedOp> ops_;
+    std::vector<VectorizedOutput> outputs_;
+    // the kColumn ops decoded from the rows
+    std::vector<size_t> column_ops_;
+    // the slices of the rows that the columns are decoded from
+    std::vector<size_t> sources_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+
+#endif  // HYBRIDSE_SRC_VM_VECTORIZED_PROJECT_H_
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/vectorized_project.h"
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vm/catalog_wrapper.h"
+#include "vm/mem_catalog.h"
+
+namespace hybridse {
+namespace vm {
+
+class VectorizedProjectTest : public ::testing::Test {
+ public:
+    VectorizedProjectTest() {
+        AddColumn(&schema_, "x", type::kInt32);
+        AddColumn(&schema_, "y", type::kInt32);
+        AddColumn(&schema_, "z", type::kDouble);
+        AddColumn(&schema_, "s", type::kVarchar);
+        schemas_ctx_.BuildTrivial({&schema_});
+    }
+
+    static void AddColumn(Schema* schema, const std::string& name, type::Type type) {
+        type::ColumnDef* column = schema->Add();
+        column->set_name(name);
+        column->set_type(type);
+    }
+
+    Row MakeRow(bool x_null, int32_t x, bool y_null, int32_t y, bool z_null, double z, const std::string& s) {
+        codec::RowBuilder builder(schema_);
+        uint32_t size = builder.CalTotalLength(s.size());
+        int8_t* buf = static_cast<int8_t*>(malloc(size));
+        builder.SetBuffer(buf, size);
+        x_null ? builder.AppendNULL() : builder.AppendInt32(x);
+        y_null ? builder.AppendNULL() : builder.AppendInt32(y);
+        z_null ? builder.AppendNULL() : builder.AppendDouble(z);
+        builder.AppendString(s.c_str(), s.size());
+        return Row(base::RefCountedSlice::CreateManaged(buf, size));
+    }
+
+    Row RandomRow(int i) {
+        int32_t x = i % 7 == 0 ? std::numeric_limits<int32_t>::max() - rand() % 10 : rand() % 200 - 100;  // NOLINT
+        return MakeRow(rand() % 8 == 0, x, rand() % 8 == 0, rand() % 200 - 100,  // NOLINT
+                       rand() % 8 == 0, (rand() % 2000) / 10.0, "s" + std::to_string(i));  // NOLINT
+    }
+
+    static VectorizedOp Op(VectorizedOp::Kind kind, type::Type type, size_t lhs = 0, size_t rhs = 0) {
+        VectorizedOp op = {kind, type, lhs, rhs, 0, 0, 0, 0};
+        return op;
+    }
+
+    static VectorizedOp Column(type::Type type, size_t col_idx) {
+        VectorizedOp op = {VectorizedOp::kColumn, type, 0, 0, 0, col_idx, 0, 0};
+        return op;
+    }
+
+    static VectorizedOutput Output(size_t op_idx, type::Type type) {
+        VectorizedOutput output = {false, op_idx, 0, 0, type};
+        return output;
+    }
+
+ protected:
+    Schema schema_;
+    SchemasContext schemas_ctx_;
+};
+
+// s, x + y, z * 2.0, x < z, (x > y) and (z > 50.0), (x > y) or (z > 50.0), -x
+TEST_F(VectorizedProjectTest, Project) {
+    Schema output_schema;
+    AddColumn(&output_schema, "s", type::kVarchar);
+    AddColumn(&output_schema, "add", type::kInt32);
+    AddColumn(&output_schema, "mul", type::kDouble);
+    AddColumn(&output_schema, "lt", type::kBool);
+    AddColumn(&output_schema, "and", type::kBool);
+    AddColumn(&output_schema, "or", type::kBool);
+    AddColumn(&output_schema, "neg", type::kInt32);
+    VectorizedOp two = Op(VectorizedOp::kConst, type::kDouble);
+    two.float_val = 2.0;
+    VectorizedOp fifty = Op(VectorizedOp::kConst, type::kDouble);
+    fifty.float_val = 50.0;
+    std::vector<VectorizedOp> ops = {
+        Column(type::kInt32, 0),                         // 0: x
+        Column(type::kInt32, 1),                         // 1: y
+        Column(type::kDouble, 2),                        // 2: z
+        Op(VectorizedOp::kAdd, type::kInt32, 0, 1),      // 3: x + y
+        two,                                             // 4: 2.0
+        Op(VectorizedOp::kMul, type::kDouble, 2, 4),     // 5: z * 2.0
+        Op(VectorizedOp::kCast, type::kDouble, 0),       // 6: double(x)
+        Op(VectorizedOp::kLt, type::kBool, 6, 2),        // 7: x < z
+        Op(VectorizedOp::kGt, type::kBool, 0, 1),        // 8: x > y
+        fifty,                                           // 9: 50.0
+        Op(VectorizedOp::kGt, type::kBool, 2, 9),        // 10: z > 50.0
+        Op(VectorizedOp::kAnd, type::kBool, 8, 10),      // 11
+        Op(VectorizedOp::kOr, type::kBool, 8, 10),       // 12
+        Op(VectorizedOp::kNeg, type::kInt32, 0),         // 13: -x
+    };
+    std::vector<VectorizedOutput> outputs = {{true, 0, 0, 3, type::kVarchar},
+                                             Output(3, type::kInt32),
+                                             Output(5, type::kDouble),
+                                             Output(7, type::kBool),
+                                             Output(11, type::kBool),
+                                             Output(12, type::kBool),
+                                             Output(13, type::kInt32)};
+    VectorizedProjectPlan plan(&schemas_ctx_, output_schema, ops, outputs);
+    ColumnBatch batch(&plan);
+    codec::RowView view(schema_);
+    codec::RowView out_view(output_schema);
+    for (size_t size : {COLUMN_BATCH_SIZE, static_cast<size_t>(100), static_cast<size_t>(1)}) {
+        std::vector<Row> rows;
+        for (size_t i = 0; i < size; i++) {
+            rows.push_back(RandomRow(i));
+        }
+        plan.Evaluate(rows.data(), rows.size(), &batch);
+        ASSERT_EQ(size, batch.size());
+        for (size_t i = 0; i < size; i++) {
+            Row output = plan.Output(rows[i], i, &batch);
+            ASSERT_FALSE(output.empty());
+            ASSERT_TRUE(view.Reset(rows[i].buf(), rows[i].size()));
+            ASSERT_TRUE(out_view.Reset(output.buf(), output.size()));
+            bool x_null = view.IsNULL(0);
+            bool y_null = view.IsNULL(1);
+            bool z_null = view.IsNULL(2);
+            int32_t x = x_null ? 0 : view.GetInt32Unsafe(0);
+            int32_t y = y_null ? 0 : view.GetInt32Unsafe(1);
+            double z = z_null ? 0 : view.GetDoubleUnsafe(2);
+            ASSERT_EQ(view.GetStringUnsafe(3), out_view.GetStringUnsafe(0));
+            ASSERT_EQ(x_null || y_null, out_view.IsNULL(1));
+            if (!x_null && !y_null) {
+                // overflows like int32
+                ASSERT_EQ(static_cast<int32_t>(static_cast<uint32_t>(x) + static_cast<uint32_t>(y)),
+                          out_view.GetInt32Unsafe(1));
+            }
+            ASSERT_EQ(z_null, out_view.IsNULL(2));
+            if (!z_null) {
+                ASSERT_EQ(z * 2.0, out_view.GetDoubleUnsafe(2));
+            }
+            ASSERT_EQ(x_null || z_null, out_view.IsNULL(3));
+            if (!x_null && !z_null) {
+                ASSERT_EQ(x < z, out_view.GetBoolUnsafe(3));
+            }
+            // three-valued logic
+            bool gt_null = x_null || y_null;
+            bool gt = x > y;
+            bool big = z > 50.0;
+            if ((!gt_null && !gt) || (!z_null && !big)) {
+                ASSERT_FALSE(out_view.IsNULL(4));
+                ASSERT_FALSE(out_view.GetBoolUnsafe(4));
+            } else if (gt_null || z_null) {
+                ASSERT_TRUE(out_view.IsNULL(4));
+            } else {
+                ASSERT_TRUE(out_view.GetBoolUnsafe(4));
+            }
+            if ((!gt_null && gt) || (!z_null && big)) {
+                ASSERT_FALSE(out_view.IsNULL(5));
+                ASSERT_TRUE(out_view.GetBoolUnsafe(5));
+            } else if (gt_null || z_null) {
+                ASSERT_TRUE(out_view.IsNULL(5));
+            } else {
+                ASSERT_FALSE(out_view.GetBoolUnsafe(5));
+            }
+            ASSERT_EQ(x_null, out_view.IsNULL(6));
+            if (!x_null) {
+                ASSERT_EQ(static_cast<int32_t>(0 - static_cast<uint32_t>(x)), out_view.GetInt32Unsafe(6));
+            }
+        }
+    }
+}
+
+class RowPredicate : public PredicateFun {
+ public:
+    explicit RowPredicate(const Schema& schema) : view_(schema) {}
+    bool operator()(const Row& row, const Row& parameter) const override {
+        codec::RowView view(view_);
+        view.Reset(row.buf(), row.size());
+        return !view.IsNULL(0) && !view.IsNULL(2) && view.GetInt32Unsafe(0) > 10 && view.GetDoubleUnsafe(2) < 100.0;
+    }
+
+ private:
+    codec::RowView view_;
+};
+
+// x > 10 and z < 100.0
+TEST_F(VectorizedProjectTest, Filter) {
+    Schema output_schema;
+    AddColumn(&output_schema, "cond", type::kBool);
+    VectorizedOp ten = Op(VectorizedOp::kConst, type::kInt32);
+    ten.int_val = 10;
+    VectorizedOp hundred = Op(VectorizedOp::kConst, type::kDouble);
+    hundred.float_val = 100.0;
+    std::vector<VectorizedOp> ops = {
+        Column(type::kInt32, 0),                     // 0: x
+        ten,                                         // 1
+        Op(VectorizedOp::kGt, type::kBool, 0, 1),    // 2: x > 10
+        Column(type::kDouble, 2),                    // 3: z
+        hundred,                                     // 4
+        Op(VectorizedOp::kLt, type::kBool, 3, 4),    // 5: z < 100.0
+        Op(VectorizedOp::kAnd, type::kBool, 2, 5),   // 6
+    };
+    VectorizedProjectPlan plan(&schemas_ctx_, output_schema, ops, {Output(6, type::kBool)});
+    RowPredicate predicate(schema_);
+
+    auto table = std::make_shared<MemTimeTableHandler>();
+    for (int i = 0; i < 5000; i++) {
+        table->AddRow(i, RandomRow(i));
+    }
+    Row parameter;
+    TableFilterWrapper expect_table(table, parameter, &predicate);
+    TableFilterWrapper batch_table(table, parameter, &predicate, &plan);
+    auto expect_iter = expect_table.GetIterator();
+    auto iter = batch_table.GetIterator();
+    expect_iter->SeekToFirst();
+    iter->SeekToFirst();
+    size_t cnt = 0;
+    while (expect_iter->Valid()) {
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(expect_iter->GetKey(), iter->GetKey());
+        ASSERT_EQ(expect_iter->GetValue().buf(), iter->GetValue().buf());
+        expect_iter->Next();
+        iter->Next();
+        cnt++;
+    }
+    ASSERT_FALSE(iter->Valid());
+    ASSERT_GT(cnt, 0u);
+
+    // no row passes
+    auto empty_table = std::make_shared<MemTimeTableHandler>();
+    for (int i = 0; i < 2000; i++) {
+        empty_table->AddRow(i, MakeRow(false, 1, false, 1, false, 1.0, "s"));
+    }
+    TableFilterWrapper empty_batch_table(empty_table, parameter, &predicate, &plan);
+    iter = empty_batch_table.GetIterator();
+    iter->SeekToFirst();
+    ASSERT_FALSE(iter->Valid());
+}
+
+}  // namespace vm
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
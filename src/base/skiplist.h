@@ -21,9 +21,12 @@
 #include <stdint.h>
 
 #include <atomic>
+#include <functional>
 #include <iostream>
+#include <thread>  // NOLINT
 
 #include "base/random.h"
+#include "base/slab.h"
 
 namespace openmldb {
 namespace base {
@@ -40,19 +43,24 @@ struct DefaultComparator {
 };
 
 // Skiplist node , a thread safe structure
+// node and its next pointers are allocated from the slab
 template <class K, class V>
 class Node {
  public:
     // Set data reference and Node height
     Node(const K& key, V& value, uint8_t height)  // NOLINT
         : height_(height), key_(key), value_(value) {
-        nexts_ = new std::atomic<Node<K, V>*>[height];
+        nexts_ = NewNexts(height);
     }
 
     Node(uint8_t height) : height_(height), key_(), value_() {  // NOLINT
-        nexts_ = new std::atomic<Node<K, V>*>[height];
+        nexts_ = NewNexts(height);
     }
 
+    static void* operator new(size_t size) { return Slab::Default()->Allocate(size); }
+
+    static void operator delete(void* ptr, size_t size) { Slab::Default()->Free(ptr, size); }
+
     // Set the next node with memory barrier
     void SetNext(uint8_t level, Node<K, V>* node) {
         assert(level < height_ && level >= 0);
@@ -77,11 +85,28 @@ class Node {
         return nexts_[level].load(std::memory_order_relaxed);
     }
 
+    // Set the next node only if it is still expected
+    bool CasNext(uint8_t level, Node<K, V>* expected, Node<K, V>* node) {
+        assert(level < height_ && level >= 0);
+        return nexts_[level].compare_exchange_strong(expected, node, std::memory_order_acq_rel,
+                                                     std::memory_order_acquire);
+    }
+
     V& GetValue() { return value_; }
 
     const K& GetKey() const { return key_; }
 
-    ~Node() { delete[] nexts_; }
+    ~Node() { Slab::Default()->Free(nexts_, sizeof(std::atomic<Node<K, V>*>) * height_); }
+
+ private:
+    static std::atomic<Node<K, V>*>* NewNexts(uint8_t height) {
+        void* buf = Slab::Default()->Allocate(sizeof(std::atomic<Node<K, V>*>) * height);
+        auto* nexts = reinterpret_cast<std::atomic<Node<K, V>*>*>(buf);
+        for (uint8_t i = 0; i < height; i++) {
+            new (&nexts[i]) std::atomic<Node<K, V>*>(nullptr);
+        }
+        return nexts;
+    }
 
  private:
     uint8_t const height_;
@@ -131,6 +156,29 @@ class Skiplist {
         return height;
     }
 
+    // Insert can run with other InsertConcurrently and readers, but need
+    // external synchronized with Remove/Split/Clear which unlink nodes
+    uint8_t InsertConcurrently(const K& key, V& value) {  // NOLINT
+        Node<K, V>* node = NewNode(key, value, RandomHeightConcurrently());
+        LinkConcurrently(node, false);
+        return node->Height();
+    }
+
+    // Insert the key only if it does not exist with the same constraint as
+    // InsertConcurrently. Return the node of the key in the list, inserted is
+    // set to false if the node exists already and value is not used
+    Node<K, V>* InsertIfAbsentConcurrently(const K& key, V& value, bool* inserted) {  // NOLINT
+        Node<K, V>* node = NewNode(key, value, RandomHeightConcurrently());
+        Node<K, V>* exist = LinkConcurrently(node, true);
+        if (exist != NULL) {
+            delete node;
+            *inserted = false;
+            return exist;
+        }
+        *inserted = true;
+        return node;
+    }
+
     bool IsEmpty() {
         if (head_->GetNextNoBarrier(0) == NULL) {
             return true;
@@ -376,6 +424,74 @@ class Skiplist {
         return height;
     }
 
+    uint8_t RandomHeightConcurrently() {
+        static thread_local Random rand(
+            static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+        uint8_t height = 1;
+        while (height < MaxHeight && (rand.Next() % Branch) == 0) {
+            height++;
+        }
+        return height;
+    }
+
+    // Find the position of key in the level start from node before
+    void FindSpliceForLevel(const K& key, Node<K, V>* before, uint8_t level, Node<K, V>** pre,
+                            Node<K, V>** succ) {
+        while (true) {
+            Node<K, V>* next = before->GetNext(level);
+            if (IsAfterNode(key, next)) {
+                before = next;
+            } else {
+                *pre = before;
+                *succ = next;
+                return;
+            }
+        }
+    }
+
+    // Link node from the bottom level to the top with cas, readers can see
+    // the node as soon as level 0 is linked. If unique is true and a node
+    // with the same key exists, return it without linking
+    Node<K, V>* LinkConcurrently(Node<K, V>* node, bool unique) {
+        uint8_t height = node->Height();
+        uint8_t max_height = GetMaxHeight();
+        while (height > max_height) {
+            if (max_height_.compare_exchange_weak(max_height, height, std::memory_order_relaxed)) {
+                max_height = height;
+                break;
+            }
+        }
+        Node<K, V>* pre[MaxHeight];
+        Node<K, V>* succ[MaxHeight];
+        Node<K, V>* before = head_;
+        for (int level = max_height - 1; level >= 0; level--) {
+            FindSpliceForLevel(node->GetKey(), before, level, &pre[level], &succ[level]);
+            before = pre[level];
+        }
+        for (uint8_t level = 0; level < height; level++) {
+            while (true) {
+                if (level == 0 && unique && succ[0] != NULL && compare_(succ[0]->GetKey(), node->GetKey()) == 0) {
+                    return succ[0];
+                }
+                node->SetNextNoBarrier(level, succ[level]);
+                if (pre[level]->CasNext(level, succ[level], node)) {
+                    break;
+                }
+                // the splice is changed by other insert, nodes are never removed
+                // concurrently so search again from pre
+                FindSpliceForLevel(node->GetKey(), pre[level], level, &pre[level], &succ[level]);
+            }
+        }
+        // the node which is the last one when it sets tail is the tail
+        Node<K, V>* last = tail_.load(std::memory_order_acquire);
+        while (node->GetNext(0) == NULL) {
+            if (tail_.compare_exchange_weak(last, node, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                break;
+            }
+        }
+        return NULL;
+    }
+
     Node<K, V>* FindLessOrEqual(const K& key, Node<K, V>** nodes) {
         assert(nodes != NULL);
         Node<K, V>* node = head_;
@@ -17,6 +17,7 @@
 #include "base/skiplist.h"
 
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "base/slice.h"
@@ -663,6 +664,66 @@ TEST_F(SkiplistTest, Duplicate) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SkiplistTest, InsertConcurrently) {
+    Comparator cmp;
+    Skiplist<uint32_t, uint32_t, Comparator> sl(12, 4, cmp);
+    uint32_t thread_num = 8;
+    uint32_t key_num = 10000;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < thread_num; t++) {
+        threads.emplace_back([&sl, t, thread_num, key_num] {
+            for (uint32_t idx = t; idx < key_num; idx += thread_num) {
+                uint32_t value = idx;
+                sl.InsertConcurrently(idx, value);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(key_num, sl.GetSize());
+    ASSERT_EQ(key_num - 1, sl.GetLast()->GetKey());
+    Skiplist<uint32_t, uint32_t, Comparator>::Iterator* it = sl.NewIterator();
+    it->SeekToFirst();
+    for (uint32_t idx = 0; idx < key_num; idx++) {
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(idx, it->GetKey());
+        ASSERT_EQ(idx, it->GetValue());
+        it->Next();
+    }
+    ASSERT_FALSE(it->Valid());
+    it->Seek(5000);
+    ASSERT_EQ(5000u, it->GetKey());
+    delete it;
+}
+
+TEST_F(SkiplistTest, InsertIfAbsentConcurrently) {
+    Comparator cmp;
+    Skiplist<uint32_t, uint32_t, Comparator> sl(12, 4, cmp);
+    uint32_t thread_num = 8;
+    uint32_t key_num = 1000;
+    std::atomic<uint32_t> inserted_cnt(0);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < thread_num; t++) {
+        threads.emplace_back([&sl, &inserted_cnt, t, key_num] {
+            for (uint32_t idx = 0; idx < key_num; idx++) {
+                uint32_t value = t;
+                bool inserted = false;
+                Node<uint32_t, uint32_t>* node = sl.InsertIfAbsentConcurrently(idx, value, &inserted);
+                ASSERT_EQ(idx, node->GetKey());
+                if (inserted) {
+                    inserted_cnt.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(key_num, inserted_cnt.load());
+    ASSERT_EQ(key_num, sl.GetSize());
+}
+
 }  // namespace base
 }  // namespace openmldb
 
@@ -0,0 +1,277 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_SLAB_H_
+#define SRC_BASE_SLAB_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <new>
+#include <unordered_set>
+#include <vector>
+
+#include "base/spinlock.h"
+
+namespace openmldb {
+namespace base {
+
+// Size-class slab allocator for the small, short-lived objects of the memtable
+// (skiplist nodes, their next-pointer arrays, data blocks and row payloads).
+// Objects are carved out of large chunks and recycled through a per-chunk free
+// list, so the Put hot path does not go through the global allocator and freed
+// rows are reused by rows of a similar size instead of fragmenting the heap.
+// Objects bigger than kMaxObjectSize fall back to ::operator new.
+// A chunk serves one size class at a time. Once all of its objects are freed
+// it is handed back: a few empty chunks are kept for any size class to reuse,
+// the others are returned to the system, so the memory freed by a ttl purge
+// is not pinned by the class it was allocated for.
+// Allocate and Free are thread safe, a Free may happen on any thread.
+class Slab {
+ public:
+    static constexpr uint32_t kAlignment = 16;
+    static constexpr uint32_t kMaxObjectSize = 4096;
+    static constexpr uint32_t kClassNum = kMaxObjectSize / kAlignment;
+    static constexpr uint32_t kDefaultChunkSize = 256 * 1024;
+    // the empty chunks kept for reuse, the others are returned to the system
+    static constexpr uint32_t kMaxIdleChunks = 8;
+
+    // chunk_size is rounded up to a power of two no less than 2 * kMaxObjectSize
+    explicit Slab(uint32_t chunk_size = kDefaultChunkSize)
+        : chunk_size_(ChunkSize(chunk_size)),
+          chunks_(),
+          idle_chunks_(),
+          chunk_mu_(),
+          reserved_byte_size_(0),
+          used_byte_size_(0) {}
+
+    ~Slab() {
+        for (Chunk* chunk : chunks_) {
+            ::operator delete(chunk, std::align_val_t(chunk_size_));
+        }
+        chunks_.clear();
+        idle_chunks_.clear();
+    }
+
+    Slab(const Slab&) = delete;
+    Slab& operator=(const Slab&) = delete;
+
+    // the process wide slab used by the memtable. it is never destroyed as
+    // objects allocated from it may outlive static destruction
+    static Slab* Default() {
+        static Slab* slab = new Slab();
+        return slab;
+    }
+
+    // the real number of bytes an allocation of size occupies
+    static inline uint32_t ClassSize(uint32_t size) {
+        if (size == 0) {
+            size = 1;
+        }
+        if (size > kMaxObjectSize) {
+            return size;
+        }
+        return (size + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    void* Allocate(uint32_t size) {
+        if (size > kMaxObjectSize) {
+            reserved_byte_size_.fetch_add(size, std::memory_order_relaxed);
+            used_byte_size_.fetch_add(size, std::memory_order_relaxed);
+            return ::operator new(size);
+        }
+        uint32_t class_size = ClassSize(size);
+        SizeClass& sc = classes_[class_size / kAlignment - 1];
+        void* ptr = nullptr;
+        {
+            std::lock_guard<SpinMutex> lock(sc.mu);
+            if (sc.partial != nullptr) {
+                Chunk* chunk = sc.partial;
+                ptr = chunk->free_list;
+                chunk->free_list = chunk->free_list->next;
+                if (chunk->free_list == nullptr) {
+                    Unlink(&sc, chunk);
+                }
+                chunk->live++;
+            } else {
+                if (sc.cur == nullptr || sc.cur->carved + class_size > chunk_size_) {
+                    Chunk* old = sc.cur;
+                    sc.cur = NewChunk();
+                    // the old chunk is released by its last free from now on
+                    if (old != nullptr && old->live == 0) {
+                        if (old->free_list != nullptr) {
+                            Unlink(&sc, old);
+                        }
+                        ReleaseChunk(old);
+                    }
+                }
+                ptr = reinterpret_cast<char*>(sc.cur) + sc.cur->carved;
+                sc.cur->carved += class_size;
+                sc.cur->live++;
+            }
+        }
+        used_byte_size_.fetch_add(class_size, std::memory_order_relaxed);
+        return ptr;
+    }
+
+    // size must be the same as the one passed to Allocate
+    void Free(void* ptr, uint32_t size) {
+        if (ptr == nullptr) {
+            return;
+        }
+        if (size > kMaxObjectSize) {
+            reserved_byte_size_.fetch_sub(size, std::memory_order_relaxed);
+            used_byte_size_.fetch_sub(size, std::memory_order_relaxed);
+            ::operator delete(ptr);
+            return;
+        }
+        uint32_t class_size = ClassSize(size);
+        SizeClass& sc = classes_[class_size / kAlignment - 1];
+        Chunk* chunk = reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t(chunk_size_) - 1));
+        FreeObject* obj = reinterpret_cast<FreeObject*>(ptr);
+        {
+            std::lock_guard<SpinMutex> lock(sc.mu);
+            chunk->live--;
+            if (chunk->live == 0 && chunk != sc.cur) {
+                if (chunk->free_list != nullptr) {
+                    Unlink(&sc, chunk);
+                }
+                ReleaseChunk(chunk);
+            } else {
+                obj->next = chunk->free_list;
+                chunk->free_list = obj;
+                if (obj->next == nullptr) {
+                    Link(&sc, chunk);
+                }
+            }
+        }
+        used_byte_size_.fetch_sub(class_size, std::memory_order_relaxed);
+    }
+
+    // bytes taken from the system, include the free objects and the idle chunks
+    inline uint64_t GetReservedByteSize() const { return reserved_byte_size_.load(std::memory_order_relaxed); }
+
+    // bytes of the objects which are in use
+    inline uint64_t GetUsedByteSize() const { return used_byte_size_.load(std::memory_order_relaxed); }
+
+ private:
+    struct FreeObject {
+        FreeObject* next;
+    };
+
+    // the header of a chunk, the objects are carved after it. the fields are
+    // guarded by the mutex of the size class the chunk serves
+    struct alignas(kAlignment) Chunk {
+        uint32_t live;
+        uint32_t carved;
+        FreeObject* free_list;
+        // the chunks of a size class with free objects
+        Chunk* prev;
+        Chunk* next;
+    };
+
+    struct SizeClass {
+        SizeClass() : mu(), partial(nullptr), cur(nullptr) {}
+        SpinMutex mu;
+        Chunk* partial;
+        // the chunk new objects are carved from
+        Chunk* cur;
+    };
+
+    static uint32_t ChunkSize(uint32_t chunk_size) {
+        uint32_t size = 2 * kMaxObjectSize;
+        while (size < chunk_size) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    static void Link(SizeClass* sc, Chunk* chunk) {
+        chunk->prev = nullptr;
+        chunk->next = sc->partial;
+        if (sc->partial != nullptr) {
+            sc->partial->prev = chunk;
+        }
+        sc->partial = chunk;
+    }
+
+    static void Unlink(SizeClass* sc, Chunk* chunk) {
+        if (chunk->prev != nullptr) {
+            chunk->prev->next = chunk->next;
+        } else {
+            sc->partial = chunk->next;
+        }
+        if (chunk->next != nullptr) {
+            chunk->next->prev = chunk->prev;
+        }
+        chunk->prev = nullptr;
+        chunk->next = nullptr;
+    }
+
+    Chunk* NewChunk() {
+        Chunk* chunk = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(chunk_mu_);
+            if (!idle_chunks_.empty()) {
+                chunk = idle_chunks_.back();
+                idle_chunks_.pop_back();
+            }
+        }
+        if (chunk == nullptr) {
+            // aligned to its size, so Free finds the chunk of an object by masking
+            chunk = static_cast<Chunk*>(::operator new(chunk_size_, std::align_val_t(chunk_size_)));
+            {
+                std::lock_guard<std::mutex> lock(chunk_mu_);
+                chunks_.insert(chunk);
+            }
+            reserved_byte_size_.fetch_add(chunk_size_, std::memory_order_relaxed);
+        }
+        chunk->live = 0;
+        chunk->carved = sizeof(Chunk);
+        chunk->free_list = nullptr;
+        chunk->prev = nullptr;
+        chunk->next = nullptr;
+        return chunk;
+    }
+
+    void ReleaseChunk(Chunk* chunk) {
+        {
+            std::lock_guard<std::mutex> lock(chunk_mu_);
+            if (idle_chunks_.size() < kMaxIdleChunks) {
+                idle_chunks_.push_back(chunk);
+                return;
+            }
+            chunks_.erase(chunk);
+        }
+        ::operator delete(chunk, std::align_val_t(chunk_size_));
+        reserved_byte_size_.fetch_sub(chunk_size_, std::memory_order_relaxed);
+    }
+
+ private:
+    uint32_t const chunk_size_;
+    SizeClass classes_[kClassNum];
+    std::unordered_set<Chunk*> chunks_;
+    std::vector<Chunk*> idle_chunks_;
+    std::mutex chunk_mu_;
+    std::atomic<uint64_t> reserved_byte_size_;
+    std::atomic<uint64_t> used_byte_size_;
+};
+
+}  // namespace base
+}  // namespace openmldb
+
+#endif  // SRC_BASE_SLAB_H_
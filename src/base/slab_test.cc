@@ -0,0 +1,138 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/slab.h"
+
+#include <string.h>
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace base {
+
+class SlabTest : public ::testing::Test {
+ public:
+    SlabTest() {}
+    ~SlabTest() {}
+};
+
+TEST_F(SlabTest, ClassSize) {
+    ASSERT_EQ(16u, Slab::ClassSize(0));
+    ASSERT_EQ(16u, Slab::ClassSize(1));
+    ASSERT_EQ(16u, Slab::ClassSize(16));
+    ASSERT_EQ(32u, Slab::ClassSize(17));
+    ASSERT_EQ(4096u, Slab::ClassSize(4096));
+    ASSERT_EQ(4097u, Slab::ClassSize(4097));
+}
+
+TEST_F(SlabTest, AllocateAndFree) {
+    Slab slab(4096);
+    char* a = reinterpret_cast<char*>(slab.Allocate(5));
+    char* b = reinterpret_cast<char*>(slab.Allocate(5));
+    ASSERT_NE(a, b);
+    ASSERT_EQ(0u, reinterpret_cast<uint64_t>(a) % Slab::kAlignment);
+    ASSERT_EQ(16, b - a);
+    memcpy(a, "hello", 5);
+    memcpy(b, "world", 5);
+    ASSERT_EQ(0, memcmp(a, "hello", 5));
+    ASSERT_EQ(32u, slab.GetUsedByteSize());
+    // the chunk size is at least 2 * kMaxObjectSize
+    ASSERT_EQ(8192u, slab.GetReservedByteSize());
+    slab.Free(a, 5);
+    ASSERT_EQ(16u, slab.GetUsedByteSize());
+    // the freed object is reused by the same size class
+    char* c = reinterpret_cast<char*>(slab.Allocate(10));
+    ASSERT_EQ(a, c);
+    slab.Free(b, 5);
+    slab.Free(c, 10);
+    ASSERT_EQ(0u, slab.GetUsedByteSize());
+    ASSERT_EQ(8192u, slab.GetReservedByteSize());
+}
+
+TEST_F(SlabTest, ReleaseChunk) {
+    Slab slab(8192);
+    std::vector<void*> ptrs;
+    // 100 chunks of objects of 1024 bytes
+    for (int i = 0; i < 700; i++) {
+        ptrs.push_back(slab.Allocate(1024));
+    }
+    ASSERT_EQ(100u * 8192, slab.GetReservedByteSize());
+    for (void* ptr : ptrs) {
+        slab.Free(ptr, 1024);
+    }
+    ASSERT_EQ(0u, slab.GetUsedByteSize());
+    // the current chunk and the idle chunks are kept, the others are returned
+    ASSERT_EQ((1u + Slab::kMaxIdleChunks) * 8192, slab.GetReservedByteSize());
+
+    // the idle chunks serve the other size classes
+    ptrs.clear();
+    for (int i = 0; i < 100; i++) {
+        ptrs.push_back(slab.Allocate(500));
+    }
+    ASSERT_EQ((1u + Slab::kMaxIdleChunks) * 8192, slab.GetReservedByteSize());
+    for (void* ptr : ptrs) {
+        slab.Free(ptr, 500);
+    }
+    ASSERT_EQ(0u, slab.GetUsedByteSize());
+}
+
+TEST_F(SlabTest, LargeObject) {
+    Slab slab;
+    void* ptr = slab.Allocate(Slab::kMaxObjectSize + 1);
+    ASSERT_TRUE(ptr != nullptr);
+    ASSERT_EQ(Slab::kMaxObjectSize + 1, slab.GetUsedByteSize());
+    slab.Free(ptr, Slab::kMaxObjectSize + 1);
+    ASSERT_EQ(0u, slab.GetUsedByteSize());
+    ASSERT_EQ(0u, slab.GetReservedByteSize());
+}
+
+TEST_F(SlabTest, MultiThread) {
+    Slab slab;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&slab, t] {
+            std::vector<char*> ptrs;
+            for (uint32_t i = 0; i < 10000; i++) {
+                uint32_t size = i % 200 + 1;
+                char* ptr = reinterpret_cast<char*>(slab.Allocate(size));
+                memset(ptr, t, size);
+                ptrs.push_back(ptr);
+            }
+            for (uint32_t i = 0; i < ptrs.size(); i++) {
+                uint32_t size = i % 200 + 1;
+                for (uint32_t j = 0; j < size; j++) {
+                    ASSERT_EQ(t, ptrs[i][j]);
+                }
+                slab.Free(ptrs[i], size);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(0u, slab.GetUsedByteSize());
+}
+
+}  // namespace base
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -362,6 +362,21 @@ std::shared_ptr<TabletAccessor> PartitionClientManager::GetFollower() {
     return std::shared_ptr<TabletAccessor>();
 }
 
+std::shared_ptr<TabletAccessor> PartitionClientManager::GetReadTablet() {
+    size_t replica_num = followers_.size() + 1;
+    // start from a random replica so that the idle ones share the calls
+    size_t start = rand_.Next() % replica_num;
+    std::shared_ptr<TabletAccessor> tablet;
+    for (size_t i = 0; i < replica_num; i++) {
+        size_t pos = (start + i) % replica_num;
+        const auto& replica = pos == followers_.size() ? leader_ : followers_[pos];
+        if (replica && (!tablet || replica->GetInflight() < tablet->GetInflight())) {
+            tablet = replica;
+        }
+    }
+    return tablet;
+}
+
 TableClientManager::TableClientManager(const TablePartitions& partitions, const ClientManager& client_manager) {
     for (const auto& table_partition : partitions) {
         uint32_t pid = table_partition.pid();
@@ -17,6 +17,7 @@
 #ifndef SRC_CATALOG_CLIENT_MANAGER_H_
 #define SRC_CATALOG_CLIENT_MANAGER_H_
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <set>
@@ -130,10 +131,10 @@ class AsyncTablesHandler : public ::hybridse::vm::MemTableHandler {
 
 class TabletAccessor : public ::hybridse::vm::Tablet {
  public:
-    explicit TabletAccessor(const std::string& name) : name_(name), tablet_client_() {}
+    explicit TabletAccessor(const std::string& name) : name_(name), tablet_client_(), inflight_(0) {}
 
     TabletAccessor(const std::string& name, const std::shared_ptr<::openmldb::client::TabletClient>& client)
-        : name_(name), tablet_client_(client) {}
+        : name_(name), tablet_client_(client), inflight_(0) {}
 
     std::shared_ptr<::openmldb::client::TabletClient> GetClient() {
         return std::atomic_load_explicit(&tablet_client_, std::memory_order_relaxed);
@@ -165,9 +166,15 @@ class TabletAccessor : public ::hybridse::vm::Tablet {
                                                            const bool is_debug) override;
     const std::string& GetName() const { return name_; }
 
+    // the calls in flight to the tablet, it is the queue depth of the tablet
+    // seen by this client. The caller adds 1 before the call and -1 after it
+    inline int32_t GetInflight() const { return inflight_.load(std::memory_order_relaxed); }
+    inline void AddInflight(int32_t delta) { inflight_.fetch_add(delta, std::memory_order_relaxed); }
+
  private:
     std::string name_;
     std::shared_ptr<::openmldb::client::TabletClient> tablet_client_;
+    std::atomic<int32_t> inflight_;
 };
 class TabletsAccessor : public ::hybridse::vm::Tablet {
  public:
@@ -218,6 +225,11 @@ class PartitionClientManager {
 
     std::shared_ptr<TabletAccessor> GetFollower();
 
+    // any alive replica serves the request mode queries in follower read, a
+    // follower behind the leader too much reads the partition from the leader.
+    // return the replica with the fewest calls in flight
+    std::shared_ptr<TabletAccessor> GetReadTablet();
+
  private:
     uint32_t pid_;
     std::shared_ptr<TabletAccessor> leader_;
@@ -265,6 +277,13 @@ class TableClientManager {
         }
         return std::shared_ptr<TabletAccessor>();
     }
+    std::shared_ptr<TabletAccessor> GetReadTablet(uint32_t pid) const {
+        auto partition_manager = GetPartitionClientManager(pid);
+        if (partition_manager) {
+            return partition_manager->GetReadTablet();
+        }
+        return std::shared_ptr<TabletAccessor>();
+    }
     std::shared_ptr<TabletsAccessor> GetTablet(std::vector<uint32_t> pids) const {
         std::shared_ptr<TabletsAccessor> tablets_accessor = std::shared_ptr<TabletsAccessor>(new TabletsAccessor());
         for (size_t idx = 0; idx < pids.size(); idx++) {
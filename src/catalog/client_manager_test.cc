@@ -72,6 +72,46 @@ TEST_F(ClientManagerTest, NormalTest) {
               table_client_manager.GetPartitionClientManager(0)->GetLeader()->GetClient()->GetRealEndpoint());
 }
 
+TEST_F(ClientManagerTest, GetReadTablet) {
+    ::openmldb::nameserver::TableInfo table_info;
+    table_info.set_name("t1");
+    table_info.set_db("db1");
+    table_info.set_tid(1);
+    auto pt = table_info.add_table_partition();
+    pt->set_pid(0);
+    for (int j = 0; j < 3; j++) {
+        auto meta = pt->add_partition_meta();
+        meta->set_is_leader(j == 0);
+        meta->set_is_alive(true);
+        meta->set_endpoint("name" + std::to_string(j));
+    }
+    std::map<std::string, std::shared_ptr<::openmldb::client::TabletClient>> tablet_clients;
+    for (int j = 0; j < 3; j++) {
+        tablet_clients.emplace("name" + std::to_string(j), std::make_shared<::openmldb::client::TabletClient>(
+                                                               "name" + std::to_string(j), "endpoint" + std::to_string(j)));
+    }
+    ClientManager manager;
+    manager.UpdateClient(tablet_clients);
+    TableClientManager table_client_manager(table_info.table_partition(), manager);
+    ASSERT_EQ("name0", table_client_manager.GetTablet(0)->GetName());
+    // the idle replicas share the calls
+    std::set<std::string> names;
+    for (int i = 0; i < 100; i++) {
+        names.insert(table_client_manager.GetReadTablet(0)->GetName());
+    }
+    ASSERT_EQ(3u, names.size());
+    // the replica with the fewest calls in flight is chosen
+    manager.GetTablet("name0")->AddInflight(20);
+    manager.GetTablet("name1")->AddInflight(10);
+    for (int i = 0; i < 10; i++) {
+        auto tablet = table_client_manager.GetReadTablet(0);
+        ASSERT_EQ("name2", tablet->GetName());
+        tablet->AddInflight(1);
+    }
+    manager.GetTablet("name1")->AddInflight(-10);
+    ASSERT_EQ("name1", table_client_manager.GetReadTablet(0)->GetName());
+}
+
 }  // namespace catalog
 }  // namespace openmldb
 
@@ -155,12 +155,13 @@ bool FullTableIterator::NextFromRemote() {
 }
 
 const ::hybridse::codec::Row& FullTableIterator::GetValue() {
-    if (it_ && it_->Valid()) {
+    if (it_ && it_->Valid() && !it_->IsCold()) {
         value_ = ::hybridse::codec::Row(
             ::hybridse::base::RefCountedSlice::Create(it_->GetValue().data(), it_->GetValue().size()));
         return value_;
     } else {
-        auto slice_row = kv_it_->GetValue();
+        // the cold value is dropped once the iterator moves on, so copy it
+        auto slice_row = (it_ && it_->Valid()) ? it_->GetValue() : kv_it_->GetValue();
         size_t sz = slice_row.size();
         int8_t* copyed_row_data = new int8_t[sz];
         memcpy(copyed_row_data, slice_row.data(), sz);
@@ -82,6 +82,9 @@ class SDKTableHandler : public ::hybridse::vm::TableHandler {
 
     std::shared_ptr<TabletAccessor> GetTablet(uint32_t pid);
 
+    // the leader or a follower of pid, see PartitionClientManager::GetReadTablet
+    std::shared_ptr<TabletAccessor> GetReadTablet(uint32_t pid);
+
     bool GetTablet(std::vector<std::shared_ptr<TabletAccessor>>* tablets);
 
     inline uint32_t GetTid() const { return meta_.tid(); }
@@ -38,6 +38,9 @@ TabletTableHandler::TabletTableHandler(const ::openmldb::api::TableMeta& meta,
       schema_(),
       table_st_(meta),
       tables_(std::make_shared<Tables>()),
+      follower_tables_(std::make_shared<FollowerTables>()),
+      read_tables_(tables_),
+      read_mu_(),
       types_(),
       index_pos_(0),
       index_hint_vec_(),
@@ -50,6 +53,9 @@ TabletTableHandler::TabletTableHandler(const ::openmldb::nameserver::TableInfo&
       schema_(),
       table_st_(meta),
       tables_(std::make_shared<Tables>()),
+      follower_tables_(std::make_shared<FollowerTables>()),
+      read_tables_(tables_),
+      read_mu_(),
       types_(),
       index_pos_(0),
       index_hint_vec_(),
@@ -135,7 +141,7 @@ std::unique_ptr<::hybridse::codec::WindowIterator> TabletTableHandler::GetWindow
         return std::unique_ptr<::hybridse::codec::WindowIterator>();
     }
     DLOG(INFO) << "get window it with index " << idx_name;
-    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
+    auto tables = GetReadTables();
     if (!tables) {
         LOG(WARNING) << " tables is null";
         return {};
@@ -164,7 +170,7 @@ const ::hybridse::codec::Row TabletTableHandler::Get(int32_t pos) {
 }
 
 ::hybridse::codec::RowIterator* TabletTableHandler::GetRawIterator() {
-    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
+    auto tables = GetReadTables();
     std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients;
     for (uint32_t pid = 0; pid < partition_num_; pid++) {
         if (tables->count(pid) == 0) {
@@ -212,10 +218,62 @@ void TabletTableHandler::AddTable(std::shared_ptr<::openmldb::storage::Table> ta
         new_tables = std::make_shared<Tables>(*old_tables);
         new_tables->emplace(table->GetPid(), table);
     } while (!atomic_compare_exchange_weak(&tables_, &old_tables, new_tables));
+    // the follower has changed to leader
+    std::shared_ptr<FollowerTables> old_followers;
+    std::shared_ptr<FollowerTables> new_followers;
+    do {
+        old_followers = std::atomic_load_explicit(&follower_tables_, std::memory_order_acquire);
+        if (old_followers->count(table->GetPid()) == 0) {
+            break;
+        }
+        new_followers = std::make_shared<FollowerTables>(*old_followers);
+        new_followers->erase(table->GetPid());
+    } while (!atomic_compare_exchange_weak(&follower_tables_, &old_followers, new_followers));
+    RefreshReadTables();
+}
+
+void TabletTableHandler::AddFollowerTable(std::shared_ptr<::openmldb::storage::Table> table,
+                                          std::function<bool()> readable) {
+    std::shared_ptr<FollowerTables> old_followers;
+    std::shared_ptr<FollowerTables> new_followers;
+    do {
+        old_followers = std::atomic_load_explicit(&follower_tables_, std::memory_order_acquire);
+        new_followers = std::make_shared<FollowerTables>(*old_followers);
+        (*new_followers)[table->GetPid()] = FollowerTable{table, readable};
+    } while (!atomic_compare_exchange_weak(&follower_tables_, &old_followers, new_followers));
+    RefreshReadTables();
+}
+
+std::shared_ptr<Tables> TabletTableHandler::GetReadTables() {
+    return std::atomic_load_explicit(&read_tables_, std::memory_order_acquire);
+}
+
+void TabletTableHandler::RefreshReadTables() {
+    std::lock_guard<std::mutex> lock(read_mu_);
+    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
+    auto followers = std::atomic_load_explicit(&follower_tables_, std::memory_order_acquire);
+    auto read_tables = std::atomic_load_explicit(&read_tables_, std::memory_order_acquire);
+    if (followers->empty() && read_tables == tables) {
+        return;
+    }
+    std::shared_ptr<Tables> new_read_tables = tables;
+    for (const auto& kv : *followers) {
+        if (tables->count(kv.first) == 0 && kv.second.readable()) {
+            if (new_read_tables == tables) {
+                new_read_tables = std::make_shared<Tables>(*tables);
+            }
+            new_read_tables->emplace(kv.first, kv.second.table);
+        }
+    }
+    // the snapshot is replaced only if the tables read change, the queries load it without a copy
+    if (new_read_tables == tables || *new_read_tables != *read_tables) {
+        std::atomic_store_explicit(&read_tables_, new_read_tables, std::memory_order_release);
+    }
 }
 
 bool TabletTableHandler::HasLocalTable() {
-    return !std::atomic_load_explicit(&tables_, std::memory_order_acquire)->empty();
+    return !std::atomic_load_explicit(&tables_, std::memory_order_acquire)->empty() ||
+           !std::atomic_load_explicit(&follower_tables_, std::memory_order_acquire)->empty();
 }
 
 int TabletTableHandler::DeleteTable(uint32_t pid) {
@@ -226,7 +284,15 @@ int TabletTableHandler::DeleteTable(uint32_t pid) {
         new_tables = std::make_shared<Tables>(*old_tables);
         new_tables->erase(pid);
     } while (!atomic_compare_exchange_weak(&tables_, &old_tables, new_tables));
-    return new_tables->size();
+    std::shared_ptr<FollowerTables> old_followers;
+    std::shared_ptr<FollowerTables> new_followers;
+    do {
+        old_followers = std::atomic_load_explicit(&follower_tables_, std::memory_order_acquire);
+        new_followers = std::make_shared<FollowerTables>(*old_followers);
+        new_followers->erase(pid);
+    } while (!atomic_compare_exchange_weak(&follower_tables_, &old_followers, new_followers));
+    RefreshReadTables();
+    return new_tables->size() + new_followers->size();
 }
 
 void TabletTableHandler::Update(const ::openmldb::nameserver::TableInfo& meta, const ClientManager& client_manager) {
@@ -244,6 +310,26 @@ void TabletTableHandler::Update(const ::openmldb::nameserver::TableInfo& meta, c
     }
 }
 
+bool TabletTableHandler::GetSegmentWriteVersion(const std::string& index_name, const std::string& pk,
+                                                uint64_t* version) {
+    const auto& index_hint = GetIndex();
+    auto index_it = index_hint.find(index_name);
+    if (index_it == index_hint.end()) {
+        return false;
+    }
+    uint32_t pid_num = table_st_.GetPartitionNum();
+    uint32_t pid = 0;
+    if (pid_num > 0) {
+        pid = (uint32_t)(::openmldb::base::hash64(pk) % pid_num);
+    }
+    auto tables = GetReadTables();
+    auto table_it = tables->find(pid);
+    if (table_it == tables->end()) {
+        return false;
+    }
+    return table_it->second->GetWriteVersion(index_it->second.index, pk, version);
+}
+
 std::shared_ptr<::hybridse::vm::Tablet> TabletTableHandler::GetTablet(const std::string& index_name,
                                                                       const std::string& pk) {
     uint32_t pid_num = table_st_.GetPartitionNum();
@@ -252,7 +338,7 @@ std::shared_ptr<::hybridse::vm::Tablet> TabletTableHandler::GetTablet(const std:
         pid = (uint32_t)(::openmldb::base::hash64(pk) % pid_num);
     }
     DLOG(INFO) << "pid num " << pid_num << " get tablet with pid = " << pid;
-    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_relaxed);
+    auto tables = GetReadTables();
     // return local tablet only when --enable_localtablet==true
     if (FLAGS_enable_localtablet && tables->find(pid) != tables->end()) {
         DLOG(INFO) << "get tablet index_name " << index_name << ", pk " << pk << ", local_tablet_";
@@ -320,15 +406,8 @@ std::shared_ptr<::hybridse::vm::TableHandler> TabletCatalog::GetTable(const std:
     return it->second;
 }
 
-bool TabletCatalog::AddTable(const ::openmldb::api::TableMeta& meta,
-                             std::shared_ptr<::openmldb::storage::Table> table) {
-    if (!table) {
-        LOG(WARNING) << "input table is null";
-        return false;
-    }
+std::shared_ptr<TabletTableHandler> TabletCatalog::GetOrAddHandler(const ::openmldb::api::TableMeta& meta) {
     const std::string& db_name = meta.db();
-    std::shared_ptr<TabletTableHandler> handler;
-    std::lock_guard<::openmldb::base::SpinMutex> spin_lock(mu_);
     auto db_it = tables_.find(db_name);
     if (db_it == tables_.end()) {
         auto result = tables_.emplace(db_name, std::map<std::string, std::shared_ptr<TabletTableHandler>>());
@@ -336,20 +415,64 @@ bool TabletCatalog::AddTable(const ::openmldb::api::TableMeta& meta,
     }
     const std::string& table_name = meta.name();
     auto it = db_it->second.find(table_name);
-    if (it == db_it->second.end()) {
-        handler = std::make_shared<TabletTableHandler>(meta, local_tablet_);
-        if (!handler->Init(client_manager_)) {
-            LOG(WARNING) << "tablet handler init failed";
-            return false;
-        }
-        db_it->second.emplace(table_name, handler);
-    } else {
-        handler = it->second;
+    if (it != db_it->second.end()) {
+        return it->second;
+    }
+    auto handler = std::make_shared<TabletTableHandler>(meta, local_tablet_);
+    if (!handler->Init(client_manager_)) {
+        LOG(WARNING) << "tablet handler init failed";
+        return nullptr;
+    }
+    db_it->second.emplace(table_name, handler);
+    return handler;
+}
+
+bool TabletCatalog::AddTable(const ::openmldb::api::TableMeta& meta,
+                             std::shared_ptr<::openmldb::storage::Table> table) {
+    if (!table) {
+        LOG(WARNING) << "input table is null";
+        return false;
+    }
+    std::lock_guard<::openmldb::base::SpinMutex> spin_lock(mu_);
+    auto handler = GetOrAddHandler(meta);
+    if (!handler) {
+        return false;
     }
     handler->AddTable(table);
     return true;
 }
 
+bool TabletCatalog::AddFollowerTable(const ::openmldb::api::TableMeta& meta,
+                                     std::shared_ptr<::openmldb::storage::Table> table,
+                                     std::function<bool()> readable) {
+    if (!table) {
+        LOG(WARNING) << "input table is null";
+        return false;
+    }
+    std::lock_guard<::openmldb::base::SpinMutex> spin_lock(mu_);
+    auto handler = GetOrAddHandler(meta);
+    if (!handler) {
+        return false;
+    }
+    handler->AddFollowerTable(table, readable);
+    return true;
+}
+
+void TabletCatalog::RefreshReadTables() {
+    std::vector<std::shared_ptr<TabletTableHandler>> handlers;
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> spin_lock(mu_);
+        for (const auto& db_kv : tables_) {
+            for (const auto& kv : db_kv.second) {
+                handlers.push_back(kv.second);
+            }
+        }
+    }
+    for (const auto& handler : handlers) {
+        handler->RefreshReadTables();
+    }
+}
+
 bool TabletCatalog::AddDB(const ::hybridse::type::Database& db) {
     std::lock_guard<::openmldb::base::SpinMutex> spin_lock(mu_);
     TabletDB::iterator it = db_.find(db.name());
@@ -586,6 +709,16 @@ std::unique_ptr<::hybridse::vm::RowIterator> TabletSegmentHandler::GetIterator()
     return nullptr;
 }
 
+bool TabletSegmentHandler::GetWriteVersion(uint64_t* version) {
+    auto partition = std::dynamic_pointer_cast<TabletPartitionHandler>(partition_handler_);
+    return partition && partition->GetSegmentWriteVersion(key_, version);
+}
+
+bool TabletPartitionHandler::GetSegmentWriteVersion(const std::string& key, uint64_t* version) {
+    auto table = std::dynamic_pointer_cast<TabletTableHandler>(table_handler_);
+    return table && table->GetSegmentWriteVersion(index_name_, key, version);
+}
+
 const uint64_t TabletSegmentHandler::GetCount() {
     auto iter = GetIterator();
     if (!iter) return 0;
@@ -17,8 +17,10 @@
 #ifndef SRC_CATALOG_TABLET_CATALOG_H_
 #define SRC_CATALOG_TABLET_CATALOG_H_
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
@@ -69,6 +71,8 @@ class TabletSegmentHandler : public ::hybridse::vm::TableHandler {
 
     const uint64_t GetCount() override;
 
+    bool GetWriteVersion(uint64_t *version) override;
+
     ::hybridse::vm::Row At(uint64_t pos) override {
         auto iter = GetIterator();
         if (!iter) return ::hybridse::vm::Row();
@@ -126,6 +130,8 @@ class TabletPartitionHandler : public ::hybridse::vm::PartitionHandler,
     }
     const std::string GetHandlerTypeName() override { return "TabletPartitionHandler"; }
 
+    bool GetSegmentWriteVersion(const std::string &key, uint64_t *version);
+
  private:
     std::shared_ptr<::hybridse::vm::TableHandler> table_handler_;
     std::string index_name_;
@@ -176,8 +182,20 @@ class TabletTableHandler : public ::hybridse::vm::TableHandler,
 
     inline int32_t GetTid() { return table_st_.GetTid(); }
 
+    // the write version of the segment of pk, it's known only if the
+    // partition of pk is read locally
+    bool GetSegmentWriteVersion(const std::string &index_name, const std::string &pk, uint64_t *version);
+
     void AddTable(std::shared_ptr<::openmldb::storage::Table> table);
 
+    // the local follower serves the reads as the leader does while readable
+    // returns true, see follower_read_max_lag
+    void AddFollowerTable(std::shared_ptr<::openmldb::storage::Table> table, std::function<bool()> readable);
+
+    // publish the local leaders and the followers readable now for the queries,
+    // it is called when the tables change and by TabletCatalog::RefreshReadTables
+    void RefreshReadTables();
+
     bool HasLocalTable();
 
     int DeleteTable(uint32_t pid);
@@ -185,6 +203,15 @@ class TabletTableHandler : public ::hybridse::vm::TableHandler,
     void Update(const ::openmldb::nameserver::TableInfo &meta, const ClientManager &client_manager);
 
  private:
+    struct FollowerTable {
+        std::shared_ptr<::openmldb::storage::Table> table;
+        std::function<bool()> readable;
+    };
+    using FollowerTables = std::map<uint32_t, FollowerTable>;
+
+    // the tables published by RefreshReadTables
+    std::shared_ptr<Tables> GetReadTables();
+
     inline int32_t GetColumnIndex(const std::string &column) {
         auto it = types_.find(column);
         if (it != types_.end()) {
@@ -198,6 +225,10 @@ class TabletTableHandler : public ::hybridse::vm::TableHandler,
     ::hybridse::vm::Schema schema_;
     ::openmldb::storage::TableSt table_st_;
     std::shared_ptr<Tables> tables_;
+    std::shared_ptr<FollowerTables> follower_tables_;
+    std::shared_ptr<Tables> read_tables_;
+    // serialize the refreshes of read_tables_
+    std::mutex read_mu_;
     ::hybridse::vm::Types types_;
     std::atomic<int32_t> index_pos_;
     std::vector<::hybridse::vm::IndexHint> index_hint_vec_;
@@ -221,6 +252,14 @@ class TabletCatalog : public ::hybridse::vm::Catalog {
 
     bool AddTable(const ::openmldb::api::TableMeta &meta, std::shared_ptr<::openmldb::storage::Table> table);
 
+    // add a local follower for bounded staleness reads, it is removed by DeleteTable
+    bool AddFollowerTable(const ::openmldb::api::TableMeta &meta, std::shared_ptr<::openmldb::storage::Table> table,
+                          std::function<bool()> readable);
+
+    // check the followers of all tables and publish the ones readable now, it
+    // runs every follower_read_check_interval
+    void RefreshReadTables();
+
     bool UpdateTableMeta(const ::openmldb::api::TableMeta &meta);
 
     bool UpdateTableInfo(const ::openmldb::nameserver::TableInfo& table_info);
@@ -293,6 +332,9 @@ class TabletCatalog : public ::hybridse::vm::Catalog {
         }
     };
 
+    // the caller holds mu_
+    std::shared_ptr<TabletTableHandler> GetOrAddHandler(const ::openmldb::api::TableMeta &meta);
+
     using AggrTableMap = std::unordered_map<AggrTableKey,
                                             std::vector<::hybridse::vm::AggrTableInfo>,
                                             AggrTableKeyHash,
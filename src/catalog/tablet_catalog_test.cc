@@ -688,6 +688,86 @@ TEST_F(TabletCatalogTest, get_tablet) {
     ASSERT_TRUE(real_tablet == nullptr);
 }
 
+TEST_F(TabletCatalogTest, get_tablet_of_follower) {
+    auto local_tablet =
+        std::make_shared<hybridse::vm::LocalTablet>(nullptr, std::shared_ptr<hybridse::vm::CompileInfoCache>());
+    uint32_t pid_num = 8;
+    TestArgs args = PrepareMultiPartitionTable("t1", pid_num);
+    auto handler = std::make_shared<TabletTableHandler>(args.meta[0], local_tablet);
+    ClientManager client_manager;
+    ASSERT_TRUE(handler->Init(client_manager));
+    bool readable = false;
+    handler->AddFollowerTable(args.tables[7], [&readable]() { return readable; });
+    ASSERT_TRUE(handler->HasLocalTable());
+    // key0 is in pid 7
+    std::string pk = "key0";
+    auto tablet = handler->GetTablet("", pk);
+    ASSERT_TRUE(std::dynamic_pointer_cast<hybridse::vm::LocalTablet>(tablet) == nullptr);
+    readable = true;
+    // the readable followers are published by the refresh
+    tablet = handler->GetTablet("", pk);
+    ASSERT_TRUE(std::dynamic_pointer_cast<hybridse::vm::LocalTablet>(tablet) == nullptr);
+    handler->RefreshReadTables();
+    tablet = handler->GetTablet("", pk);
+    ASSERT_TRUE(std::dynamic_pointer_cast<hybridse::vm::LocalTablet>(tablet) != nullptr);
+    readable = false;
+    handler->RefreshReadTables();
+    tablet = handler->GetTablet("", pk);
+    ASSERT_TRUE(std::dynamic_pointer_cast<hybridse::vm::LocalTablet>(tablet) == nullptr);
+    // change to leader
+    handler->AddTable(args.tables[7]);
+    tablet = handler->GetTablet("", pk);
+    ASSERT_TRUE(std::dynamic_pointer_cast<hybridse::vm::LocalTablet>(tablet) != nullptr);
+    ASSERT_EQ(0, handler->DeleteTable(7));
+    ASSERT_FALSE(handler->HasLocalTable());
+}
+
+TEST_F(TabletCatalogTest, segment_write_version) {
+    auto local_tablet =
+        std::make_shared<hybridse::vm::LocalTablet>(nullptr, std::shared_ptr<hybridse::vm::CompileInfoCache>());
+    uint32_t pid_num = 8;
+    TestArgs args = PrepareMultiPartitionTable("t1", pid_num);
+    auto handler = std::make_shared<TabletTableHandler>(args.meta[0], local_tablet);
+    ClientManager client_manager;
+    ASSERT_TRUE(handler->Init(client_manager));
+    handler->AddTable(args.tables[7]);
+    auto partition = handler->GetPartition("index0");
+    ASSERT_TRUE(partition != nullptr);
+    // key0 is in the local pid 7, the version is kept until key0 is written
+    uint64_t version = 0;
+    uint64_t cur_version = 0;
+    ASSERT_TRUE(partition->GetSegment("key0")->GetWriteVersion(&version));
+    ASSERT_TRUE(partition->GetSegment("key0")->GetWriteVersion(&cur_version));
+    ASSERT_EQ(version, cur_version);
+    ::hybridse::vm::Schema fe_schema;
+    schema::SchemaAdapter::ConvertSchema(args.meta[7].column_desc(), &fe_schema);
+    ::hybridse::codec::RowBuilder rb(fe_schema);
+    std::string pk = "key0";
+    std::string value;
+    value.resize(rb.CalTotalLength(pk.size()));
+    rb.SetBuffer(reinterpret_cast<int8_t *>(&(value[0])), value.size());
+    rb.AppendString(pk.c_str(), pk.size());
+    rb.AppendInt64(1589780888000l);
+    ASSERT_TRUE(args.tables[7]->Put(pk, 1589780888000l, value.c_str(), value.size()));
+    ASSERT_TRUE(partition->GetSegment("key0")->GetWriteVersion(&cur_version));
+    ASSERT_GT(cur_version, version);
+    // key1 is in pid 6, which is read from the remote tablet
+    ASSERT_FALSE(partition->GetSegment("key1")->GetWriteVersion(&cur_version));
+
+    // the rows expire by an absolute ttl without being written
+    ::openmldb::api::TableMeta meta(args.meta[7]);
+    meta.mutable_column_key(0)->mutable_ttl()->set_abs_ttl(10);
+    ::openmldb::storage::MemTable abs_table(meta);
+    ASSERT_TRUE(abs_table.Init());
+    ASSERT_FALSE(abs_table.GetWriteVersion(0, pk, &cur_version));
+    meta.mutable_column_key(0)->mutable_ttl()->set_ttl_type(::openmldb::type::kLatestTime);
+    meta.mutable_column_key(0)->mutable_ttl()->set_abs_ttl(0);
+    meta.mutable_column_key(0)->mutable_ttl()->set_lat_ttl(10);
+    ::openmldb::storage::MemTable lat_table(meta);
+    ASSERT_TRUE(lat_table.Init());
+    ASSERT_TRUE(lat_table.GetWriteVersion(0, pk, &cur_version));
+}
+
 TEST_F(TabletCatalogTest, aggr_table_test) {
     std::shared_ptr<TabletCatalog> catalog(new TabletCatalog());
     ASSERT_TRUE(catalog->Init());
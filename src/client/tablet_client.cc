@@ -242,12 +242,15 @@ bool TabletClient::UpdateTableMetaForAddField(uint32_t tid, const std::vector<op
 }
 
 bool TabletClient::Put(uint32_t tid, uint32_t pid, uint64_t time, const std::string& value,
-                       const std::vector<std::pair<std::string, uint32_t>>& dimensions) {
+                       const std::vector<std::pair<std::string, uint32_t>>& dimensions, bool durable) {
     ::openmldb::api::PutRequest request;
     request.set_time(time);
     request.set_value(value);
     request.set_tid(tid);
     request.set_pid(pid);
+    if (durable) {
+        request.set_durable(true);
+    }
     for (size_t i = 0; i < dimensions.size(); i++) {
         ::openmldb::api::Dimension* d = request.add_dimensions();
         d->set_key(dimensions[i].first);
@@ -263,6 +266,16 @@ bool TabletClient::Put(uint32_t tid, uint32_t pid, uint64_t time, const std::str
     return false;
 }
 
+bool TabletClient::AsyncPutBatch(const ::openmldb::api::PutBatchRequest& request,
+                                 openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    callback->GetController()->set_timeout_ms(FLAGS_request_timeout_ms);
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::PutBatch, callback->GetController().get(),
+                               &request, callback->GetResponse().get(), callback);
+}
+
 bool TabletClient::Put(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, const std::string& value) {
     ::openmldb::api::PutRequest request;
     auto dim = request.add_dimensions();
@@ -82,7 +82,11 @@ class TabletClient : public Client {
     bool Put(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, const std::string& value);
 
     bool Put(uint32_t tid, uint32_t pid, uint64_t time, const std::string& value,
-             const std::vector<std::pair<std::string, uint32_t>>& dimensions);
+             const std::vector<std::pair<std::string, uint32_t>>& dimensions, bool durable = false);
+
+    // the values of the rows are in the request attachment of the callback controller
+    bool AsyncPutBatch(const ::openmldb::api::PutBatchRequest& request,
+                       openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback);
 
     bool Get(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, std::string& value,  // NOLINT
              uint64_t& ts,                                                                          // NOLINT
@@ -63,6 +63,11 @@ DEFINE_int32(gc_pool_size, 2, "the size of tablet gc thread pool");
 DEFINE_int32(gc_safe_offset, 1, "the safe offset of tablet gc in minute");
 DEFINE_uint64(gc_on_table_recover_count, 10000000, "make a gc on recover count");
 DEFINE_uint32(gc_deleted_pk_version_delta, 2, "config the gc version delta");
+DEFINE_uint32(cold_row_compress_minute, 0,
+              "compress the rows of memory table older than it in minute on gc, 0 means disable");
+DEFINE_uint32(latest_ring_max_cnt, 0,
+              "use a ring instead of skiplist for the latest ttl index whose keep count is not greater than it, "
+              "0 means disable");
 DEFINE_double(mem_release_rate, 5, "specify memory release rate, which should be in 0 ~ 10");
 DEFINE_int32(task_pool_size, 3, "the size of tablet task thread pool");
 DEFINE_int32(io_pool_size, 2, "the size of tablet io task thread pool");
@@ -71,6 +76,12 @@ DEFINE_string(data_dir, "./data", "the path of data dir");
 DEFINE_bool(enable_distsql, false, "enable or disable distribute sql");
 DEFINE_bool(enable_localtablet, true, "enable or disable local tablet opt when distribute sql circumstance");
 DEFINE_string(bucket_size, "1d", "the default bucket size in pre-aggr table");
+DEFINE_uint64(follower_read_max_lag, 0,
+              "the max number of binlog entries a local follower may lag behind its leader to serve the request mode "
+              "queries, 0 means only the leaders serve");
+DEFINE_int32(follower_read_check_interval, 100,
+             "config the interval to check which local followers can serve the queries if follower_read_max_lag is "
+             "set. unit is milliseconds");
 
 // scan configuration
 DEFINE_uint32(scan_max_bytes_size, 2 * 1024 * 1024, "config the max size of scan bytes size");
@@ -80,6 +91,27 @@ DEFINE_uint32(preview_default_limit, 100, "config the default limit of preview")
 // binlog configuration
 DEFINE_int32(binlog_single_file_max_size, 1024 * 4, "the max size of single binlog file");
 DEFINE_int32(binlog_sync_batch_size, 32, "the batch size of sync binlog");
+DEFINE_uint32(binlog_sync_max_inflight, 1,
+              "the max number of AppendEntries requests in flight to a follower, 1 waits for the response "
+              "before sending the next batch");
+DEFINE_bool(binlog_sync_raw_record, false,
+            "send the binlog records to followers in the attachment without parsing them, the followers should "
+            "support it");
+DEFINE_string(binlog_sync_compression, "off", "Type of compression of the binlog records sent, can be off, snappy");
+DEFINE_uint32(binlog_cache_max_entries, 4096,
+              "the number of latest entries kept in memory for the replicate nodes, 0 reads all entries from binlog");
+DEFINE_uint64(binlog_cache_max_bytes, 64 * 1024 * 1024,
+              "the max memory in bytes of the latest entries kept for the replicate nodes, 0 reads all entries from "
+              "binlog");
+DEFINE_uint32(binlog_group_commit_max_entries, 256, "the max number of entries written to binlog in one group commit");
+DEFINE_uint32(binlog_compress_flush_size, 0,
+              "the group commits of a compressed binlog are buffered and compressed as one block once they have "
+              "this many bytes, or the binlog is synced or rolled. 0 compresses every group commit. the buffered "
+              "entries are acknowledged and replicated but only kept in memory, a process crash loses them and "
+              "the followers reading the binlog file wait for them until the next sync");
+DEFINE_string(binlog_compression, "off",
+              "Type of compression of the binlog blocks, can be off, snappy, zlib. It is used by the tables without "
+              "binlog_compression in table meta");
 DEFINE_bool(binlog_notify_on_put, false, "config the sync log to follower strategy");
 DEFINE_bool(binlog_enable_crc, false, "enable crc");
 DEFINE_int32(binlog_coffee_time, 1000, "config the coffee time. unit is milliseconds");
@@ -88,6 +120,9 @@ DEFINE_int32(binlog_sync_to_disk_interval, 20000,
              "config the interval of sync binlog to disk time. unit is milliseconds");
 DEFINE_int32(binlog_delete_interval, 60000, "config the interval of delete binlog. unit is milliseconds");
 DEFINE_int32(binlog_match_logoffset_interval, 1000, "config the interval of match log offset. unit is milliseconds");
+DEFINE_int32(binlog_heartbeat_interval, 1000,
+             "config the interval that the leader sends heartbeats to the idle followers if follower_read_max_lag is "
+             "set. unit is milliseconds");
 DEFINE_int32(binlog_name_length, 8, "binlog name length");
 DEFINE_uint32(check_binlog_sync_progress_delta, 100000, "config the delta of check binlog sync progress");
 DEFINE_uint32(go_back_max_try_cnt, 10, "config max try time of go back");
@@ -111,6 +146,12 @@ DEFINE_uint32(max_traverse_cnt, 50000, "max traverse iter loop cnt");
 DEFINE_uint32(traverse_cnt_limit, 1000, "limit traverse cnt");
 DEFINE_string(ssd_root_path, "", "the root ssd path of db");
 DEFINE_string(hdd_root_path, "", "the root hdd path of db");
+DEFINE_string(direct_io_root_path, "",
+              "the root paths of db whose binlog and snapshot files are read and written with direct io, separated "
+              "by comma. It falls back to buffered io if the file system does not support it. The data is "
+              "written in blocks of 256KB or when the file is synced, the latest binlog entries are only kept in "
+              "memory until then, a process crash loses them and the followers reading the binlog file wait for "
+              "them");
 
 DEFINE_uint32(task_check_interval, 1000, "config the check interval of task. unit is milliseconds");
 
@@ -130,7 +171,19 @@ DEFINE_uint32(make_snapshot_offline_interval, 60 * 60 * 24,
               "config tablet self makesnapshot when how long time do not "
               "makesnapshot from ns. unit is second");
 DEFINE_string(snapshot_compression, "off", "Type of snapshot compression, can be off, snappy, zlib");
+DEFINE_string(snapshot_format, "log",
+              "Format of the memory table snapshot, can be log or flat. a flat snapshot is loaded by mmap and "
+              "is not compressed");
+DEFINE_bool(snapshot_keep_mapped, false,
+            "the rows loaded from a flat snapshot refer to the mapped file instead of being copied to memory");
+DEFINE_uint32(snapshot_max_delta_num, 0,
+              "the max number of delta snapshots on top of the full one, a snapshot only writes the new binlog "
+              "until it is reached and then all of them are merged. 0 means every snapshot is full");
+DEFINE_uint32(snapshot_merge_rate_mb, 0, "the max write rate of merging a full snapshot in MB/s, 0 means unlimited");
 DEFINE_int32(snapshot_pool_size, 1, "the size of tablet thread pool for making snapshot");
+DEFINE_int32(follower_apply_pool_size, 4,
+             "the size of tablet thread pool for putting the entries replicated from leader, the entries are put "
+             "in the rpc thread if it is not larger than 1");
 
 DEFINE_uint32(load_index_max_wait_time, 120 * 60 * 1000,
               "config the max wait time of load index. unit is milliseconds");
@@ -158,11 +211,22 @@ DEFINE_uint32(block_cache_mb, 4096,
 DEFINE_uint32(write_buffer_mb, 128, "Memtable size");
 DEFINE_uint32(block_cache_shardbits, 8, "Divide block cache into 2^8 shards to avoid cache contention");
 DEFINE_bool(verify_compression, false, "For debug");
+DEFINE_uint32(disk_ttl_compaction_hours, 24,
+              "the sst files not compacted in it are compacted to drop the rows expired by ttl, 0 means disable");
+DEFINE_uint32(disk_bloom_bits_per_key, 10, "bits per key of the pk prefix bloom filter, 0 means disable");
+DEFINE_uint32(ssd_block_size_kb, 16, "the block size of sst files on ssd");
+DEFINE_uint32(hdd_block_size_kb, 256, "the block size of sst files on hdd");
+DEFINE_uint32(disk_write_buffer_budget_mb, 0,
+              "the memtable memory of all the disk tables, charged to the block cache, 0 means unlimited");
+DEFINE_uint32(disk_flush_threads, 1, "the flush threads shared by all the disk tables");
+DEFINE_uint32(disk_compaction_threads, 4, "the compaction threads shared by all the disk tables");
 
 // load table resouce control
 DEFINE_uint32(load_table_batch, 30, "set laod table batch size");
 DEFINE_uint32(load_table_thread_num, 3, "set load tabale thread pool size");
 DEFINE_uint32(load_table_queue_size, 1000, "set load tabale queue size");
+DEFINE_uint32(load_snapshot_chunk_mb, 256,
+              "the uncompressed snapshot file is split into chunks of it and read in parallel, 0 means disable");
 
 // multiple data center
 DEFINE_uint32(get_replica_status_interval, 10000,
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "log/direct_io.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <gflags/gflags.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <vector>
+
+#include "base/glog_wrapper.h"
+#include "base/strings.h"
+
+DECLARE_string(direct_io_root_path);
+
+namespace openmldb {
+namespace log {
+
+bool UseDirectIO(const std::string& fname) {
+    if (FLAGS_direct_io_root_path.empty()) {
+        return false;
+    }
+    std::vector<std::string> paths;
+    ::openmldb::base::SplitString(FLAGS_direct_io_root_path, ",", paths);
+    for (auto& path : paths) {
+        if (path.empty()) {
+            continue;
+        }
+        if (path.back() != '/') {
+            path.push_back('/');
+        }
+        if (fname.compare(0, path.size(), path) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::atomic<uint64_t> direct_open_cnt(0);
+
+int OpenDirect(const std::string& fname, int flags) {
+#ifdef O_DIRECT
+    int fd = open(fname.c_str(), flags | O_DIRECT);
+    if (fd < 0) {
+        PDLOG(WARNING, "fail to open %s with direct io: %s", fname.c_str(), strerror(errno));
+    } else {
+        direct_open_cnt.fetch_add(1, std::memory_order_relaxed);
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+uint64_t GetDirectOpenCount() { return direct_open_cnt.load(std::memory_order_relaxed); }
+
+char* NewAlignedBuffer() {
+    void* buf = NULL;
+    if (posix_memalign(&buf, DIRECT_IO_ALIGNMENT, DIRECT_IO_BUFFER_SIZE) != 0) {
+        return NULL;
+    }
+    return reinterpret_cast<char*>(buf);
+}
+
+}  // namespace log
+}  // namespace openmldb
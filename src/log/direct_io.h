@@ -0,0 +1,48 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_LOG_DIRECT_IO_H_
+#define SRC_LOG_DIRECT_IO_H_
+
+#include <stdint.h>
+
+#include <string>
+
+namespace openmldb {
+namespace log {
+
+// the offsets, sizes and buffers of direct io are aligned to it
+static const uint32_t DIRECT_IO_ALIGNMENT = 4096;
+// the size of the aligned buffer of a direct io file
+static const uint32_t DIRECT_IO_BUFFER_SIZE = 256 * 1024;
+
+// true if fname is under one of the paths of direct_io_root_path
+bool UseDirectIO(const std::string& fname);
+
+// open fname with O_DIRECT and flags, return -1 if it fails or the file
+// system does not support direct io
+int OpenDirect(const std::string& fname, int flags);
+
+// the number of files opened with direct io by this process
+uint64_t GetDirectOpenCount();
+
+// allocate an aligned buffer of DIRECT_IO_BUFFER_SIZE, free it with free()
+char* NewAlignedBuffer();
+
+}  // namespace log
+}  // namespace openmldb
+
+#endif  // SRC_LOG_DIRECT_IO_H_
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gflags/gflags.h>
+
+#include <string>
+#include <vector>
+
+#include "base/file_util.h"
+#include "benchmark/benchmark.h"
+#include "common/timer.h"
+#include "log/log_reader.h"
+#include "log/log_writer.h"
+#include "proto/tablet.pb.h"
+
+DECLARE_string(direct_io_root_path);
+
+namespace openmldb {
+namespace log {
+
+static const uint32_t RECORD_NUM = 200000;
+static std::string log_dir;  // NOLINT
+
+// the rows of a table look alike, that is what the compression of the blocks gains from
+static std::string GenEntry(uint64_t i) {
+    ::openmldb::api::LogEntry entry;
+    entry.set_log_index(i + 1);
+    entry.set_term(1);
+    entry.set_ts(1650000000000 + i);
+    auto dimension = entry.add_dimensions();
+    dimension->set_key("card" + std::to_string(i % 1000));
+    dimension->set_idx(0);
+    entry.set_value("mcc" + std::to_string(i % 100) + "|city" + std::to_string(i % 50) + "|amount" +
+                    std::to_string(i % 10000) + "|" + std::string(64, 'x'));
+    return entry.SerializeAsString();
+}
+
+static const std::vector<std::string>& GetRecords() {
+    static std::vector<std::string> records = [] {
+        std::vector<std::string> records;
+        records.reserve(RECORD_NUM);
+        for (uint32_t i = 0; i < RECORD_NUM; i++) {
+            records.push_back(GenEntry(i));
+        }
+        return records;
+    }();
+    return records;
+}
+
+// write the records in batches of batch_size like the group commits of the
+// leader. flush_size is the binlog_compress_flush_size of a compressed binlog,
+// a batch of 1 with flush_size 0 compresses every record alone
+static void BM_BinlogWrite(benchmark::State& state, const std::string& compression, uint32_t batch_size,  // NOLINT
+                           uint32_t flush_size, bool direct_io = false) {
+    const std::vector<std::string>& records = GetRecords();
+    FLAGS_direct_io_root_path = direct_io ? log_dir : "";
+    std::string full_path = log_dir + "/" + compression + "_" + std::to_string(batch_size) + "_" +
+                            std::to_string(flush_size) + (direct_io ? "_direct" : "") + ".log";
+    FILE* fd = fopen(full_path.c_str(), "wb");
+    if (fd == NULL) {
+        state.SkipWithError("fail to create binlog file");
+        return;
+    }
+    uint64_t raw_size = 0;
+    uint64_t file_size = 0;
+    {
+        WriteHandle wh(compression, full_path, fd);
+        wh.SetFlushSize(flush_size);
+        wh.BeginLog();
+        std::vector<Slice> batch;
+        uint32_t idx = 0;
+        for (auto _ : state) {
+            batch.clear();
+            for (uint32_t i = 0; i < batch_size; i++) {
+                const std::string& record = records[idx++ % RECORD_NUM];
+                raw_size += record.size();
+                batch.emplace_back(record);
+            }
+            if (!wh.Write(batch).ok()) {
+                state.SkipWithError("fail to write binlog");
+                break;
+            }
+        }
+        wh.EndLog();
+        file_size = wh.GetSize();
+    }
+    FLAGS_direct_io_root_path = "";
+    state.SetItemsProcessed(state.iterations() * batch_size);
+    state.counters["ratio"] = static_cast<double>(raw_size) / (file_size + 1);
+    remove(full_path.c_str());
+}
+
+// read and parse the entries like the recovery of binlog
+static void BM_BinlogRecover(benchmark::State& state, const std::string& compression, uint32_t flush_size) {  // NOLINT
+    const std::vector<std::string>& records = GetRecords();
+    std::string full_path = log_dir + "/recover_" + compression + "_" + std::to_string(flush_size) + ".log";
+    FILE* fd = fopen(full_path.c_str(), "wb");
+    if (fd == NULL) {
+        state.SkipWithError("fail to create binlog file");
+        return;
+    }
+    {
+        WriteHandle wh(compression, full_path, fd);
+        wh.SetFlushSize(flush_size);
+        wh.BeginLog();
+        for (const auto& record : records) {
+            wh.Write(std::vector<Slice>{Slice(record)});
+        }
+        wh.EndLog();
+    }
+    for (auto _ : state) {
+        fd = fopen(full_path.c_str(), "rb");
+        SequentialFile* sf = NewSeqFile(full_path, fd);
+        uint64_t cnt = 0;
+        {
+            Reader reader(sf, NULL, false, 0, compression != "off");
+            std::string buffer;
+            Slice record;
+            ::openmldb::api::LogEntry entry;
+            while (reader.ReadRecord(&record, &buffer).ok()) {
+                entry.ParseFromArray(record.data(), record.size());
+                cnt++;
+            }
+        }
+        delete sf;
+        if (cnt != RECORD_NUM) {
+            state.SkipWithError("the records read do not match the records written");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * RECORD_NUM);
+    remove(full_path.c_str());
+}
+
+BENCHMARK_CAPTURE(BM_BinlogWrite, off_batch1, std::string("off"), 1, 0);
+BENCHMARK_CAPTURE(BM_BinlogWrite, off_batch32, std::string("off"), 32, 0);
+BENCHMARK_CAPTURE(BM_BinlogWrite, off_batch1_directio, std::string("off"), 1, 0, true);
+BENCHMARK_CAPTURE(BM_BinlogWrite, off_batch32_directio, std::string("off"), 32, 0, true);
+BENCHMARK_CAPTURE(BM_BinlogWrite, snappy_batch1_noflushsize, std::string("snappy"), 1, 0);
+BENCHMARK_CAPTURE(BM_BinlogWrite, snappy_batch1, std::string("snappy"), 1, 64 * 1024);
+BENCHMARK_CAPTURE(BM_BinlogWrite, snappy_batch32, std::string("snappy"), 32, 64 * 1024);
+BENCHMARK_CAPTURE(BM_BinlogWrite, zlib_batch1_noflushsize, std::string("zlib"), 1, 0);
+BENCHMARK_CAPTURE(BM_BinlogWrite, zlib_batch1, std::string("zlib"), 1, 64 * 1024);
+BENCHMARK_CAPTURE(BM_BinlogWrite, zlib_batch32, std::string("zlib"), 32, 64 * 1024);
+
+BENCHMARK_CAPTURE(BM_BinlogRecover, off, std::string("off"), 0)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_BinlogRecover, snappy, std::string("snappy"), 64 * 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_BinlogRecover, zlib, std::string("zlib"), 64 * 1024)->Unit(benchmark::kMillisecond);
+
+}  // namespace log
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    ::openmldb::log::log_dir = "/tmp/log_bm" + std::to_string(::baidu::common::timer::get_micros());
+    ::openmldb::base::MkdirRecur(::openmldb::log::log_dir + "/");
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::openmldb::base::RemoveDirRecursive(::openmldb::log::log_dir);
+    return 0;
+}
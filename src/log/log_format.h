@@ -57,9 +57,17 @@ static const uint32_t kHeaderSize = 4 + 2 + 1;
 static const uint32_t kHeaderSizeForCompress = 4 + 4 + 1;
 
 // kHeaderSizeOfCompressBlock should be multiple of 64 bytes
-// compress_len(4 bytes), compress_type(1 byte)
+// compress_len(4 bytes), compress_type(1 byte), raw_len(4 bytes)
+// raw_len is 0 if the block is full, a binlog block is compressed when a batch
+// of records is written, so it may be shorter than kCompressBlockSize
 static const uint32_t kHeaderSizeOfCompressBlock = 64;
 
+// a compressed binlog file starts with an empty block whose header carries the
+// magic at kCompressLogMagicOffset, so the readers know the format of the file
+static const uint32_t kCompressLogMagicOffset = 16;
+static const char kCompressLogMagic[] = "OMBINLOG";  // NOLINT
+static const uint32_t kCompressLogMagicSize = 8;
+
 static const std::string ZLIB_COMPRESS_SUFFIX = ".zlib";      // NOLINT
 static const std::string SNAPPY_COMPRESS_SUFFIX = ".snappy";  // NOLINT
 
@@ -52,6 +52,7 @@ Reader::Reader(SequentialFile* file, Reporter* reporter, bool checksum, uint64_t
       last_record_end_offset_(0),
       end_of_buffer_offset_(0),
       last_end_of_buffer_offset_(0),
+      block_start_offset_(0),
       initial_offset_(initial_offset),
       resyncing_(initial_offset > 0),
       compressed_(compressed),
@@ -120,7 +121,10 @@ Status Reader::ReadRecord(Slice* record, std::string* scratch) {
         // ReadPhysicalRecord may have only had an empty trailer remaining in
         // its internal buffer. Calculate the offset of the next physical record
         // now that it has returned, properly accounting for its header size.
-        uint64_t physical_record_offset = end_of_buffer_offset_ - buffer_.size() - header_size_ - fragment.size();
+        // The offsets of a compressed file are the ones of its blocks
+        uint64_t physical_record_offset =
+            compressed_ ? block_start_offset_
+                        : end_of_buffer_offset_ - buffer_.size() - header_size_ - fragment.size();
 
         if (resyncing_) {
             if (record_type == kMiddleType) {
@@ -148,7 +152,7 @@ Status Reader::ReadRecord(Slice* record, std::string* scratch) {
                 scratch->clear();
                 *record = fragment;
                 last_record_offset_ = prospective_record_offset;
-                last_record_end_offset_ = end_of_buffer_offset_ - buffer_.size();
+                last_record_end_offset_ = compressed_ ? end_of_buffer_offset_ : end_of_buffer_offset_ - buffer_.size();
                 if (offset) {
                     last_end_of_buffer_offset_ = offset;
                 }
@@ -201,7 +205,7 @@ Status Reader::ReadRecord(Slice* record, std::string* scratch) {
                     scratch->append(fragment.data(), fragment.size());
                     *record = Slice(*scratch);
                     last_record_offset_ = prospective_record_offset;
-                    last_record_end_offset_ = end_of_buffer_offset_ - buffer_.size();
+                    last_record_end_offset_ = compressed_ ? end_of_buffer_offset_ : end_of_buffer_offset_ - buffer_.size();
                     if (offset) {
                         last_end_of_buffer_offset_ = offset;
                     }
@@ -254,7 +258,8 @@ void Reader::ReportDrop(uint64_t bytes, const Status& reason) {
 }
 
 void Reader::GoBackToLastBlock() {
-    size_t offset_in_block = last_end_of_buffer_offset_ % block_size_;
+    // the blocks of a compressed file are not fixed-size
+    size_t offset_in_block = compressed_ ? 0 : last_end_of_buffer_offset_ % block_size_;
     uint64_t block_start_location = 0;
     if (last_end_of_buffer_offset_ > offset_in_block) {
         block_start_location = last_end_of_buffer_offset_ - offset_in_block;
@@ -273,80 +278,126 @@ void Reader::GoBackToStart() {
     file_->Seek(block_start_location);
 }
 
-unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
-    if (buffer_.size() < static_cast<size_t>(header_size_)) {
-        // Last read was a full read, so this is a trailer to skip
-        buffer_.clear();
-        Status status;
-        if (!compressed_) {
-            status = file_->Read(block_size_, &buffer_, backing_store_);
-        } else {
-            // read header of compressed data
-            Slice header_of_compress;
-            status = file_->Read(kHeaderSizeOfCompressBlock, &header_of_compress, backing_store_);
-            if (!status.ok()) {
-                PDLOG(WARNING, "fail to read file %s when reading header", status.ToString().c_str());
-                return kWaitRecord;
-            }
-            const char* data = header_of_compress.data();
-            uint32_t compress_len = 0;
-            memcpy(static_cast<void*>(&compress_len), data, sizeof(uint32_t));
-            memrev32ifbe(static_cast<void*>(&compress_len));
-            CompressType compress_type = kNoCompress;
-            memcpy(static_cast<void*>(&compress_type), data + sizeof(uint32_t), 1);
-            DLOG(INFO) << "compress_len: " << compress_len << ", "
-                       << "compress_type: " << compress_type;
-            // read compressed data
-            Slice block;
-            status = file_->Read(compress_len, &block, backing_store_);
-            if (!status.ok()) {
-                PDLOG(WARNING, "fail to read file %s when reading block", status.ToString().c_str());
-                return kWaitRecord;
+unsigned int Reader::ReadCompressedBlock() {
+    while (true) {
+        // read header of compressed data
+        Slice header_of_compress;
+        Status status = file_->Read(kHeaderSizeOfCompressBlock, &header_of_compress, backing_store_);
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to read file %s when reading header", status.ToString().c_str());
+            return kWaitRecord;
+        }
+        if (header_of_compress.size() < kHeaderSizeOfCompressBlock) {
+            DEBUGLOG("read header size[%d] less than %d", header_of_compress.size(), kHeaderSizeOfCompressBlock);
+            return kWaitRecord;
+        }
+        const char* data = header_of_compress.data();
+        uint32_t compress_len = 0;
+        memcpy(static_cast<void*>(&compress_len), data, sizeof(uint32_t));
+        memrev32ifbe(static_cast<void*>(&compress_len));
+        CompressType compress_type = kNoCompress;
+        memcpy(static_cast<void*>(&compress_type), data + sizeof(uint32_t), 1);
+        uint32_t raw_len = 0;
+        memcpy(static_cast<void*>(&raw_len), data + sizeof(uint32_t) + 1, sizeof(uint32_t));
+        memrev32ifbe(static_cast<void*>(&raw_len));
+        if (raw_len == 0) {
+            raw_len = block_size_;
+        }
+        DLOG(INFO) << "compress_len: " << compress_len << ", "
+                   << "compress_type: " << compress_type << ", "
+                   << "raw_len: " << raw_len;
+        block_start_offset_ = end_of_buffer_offset_;
+        if (compress_len == 0 && compress_type == kNoCompress) {
+            // the zeros padded by a direct io writer, see kZeroType
+            DEBUGLOG("zero block at the end of file");
+            return kWaitRecord;
+        }
+        if (compress_len == 0) {
+            // the header of a compressed binlog file, the records are appended after it
+            end_of_buffer_offset_ += kHeaderSizeOfCompressBlock;
+            if (last_record_end_offset_ < end_of_buffer_offset_) {
+                last_record_end_offset_ = end_of_buffer_offset_;
             }
-            const char* block_data = block.data();
-            int32_t uncompress_len = 0;
-            switch (compress_type) {
-                case kSnappy: {
-                    snappy::GetUncompressedLength(block_data, static_cast<size_t>(compress_len),
-                                                  reinterpret_cast<size_t*>(&uncompress_len));
-                    if (!snappy::RawUncompress(block_data, static_cast<size_t>(compress_len), uncompress_buf_)) {
-                        PDLOG(WARNING, "bad record when uncompress block, compress type: %d", compress_type);
-                        return kBadRecord;
-                    }
-                    break;
+            continue;
+        }
+        if (raw_len > block_size_) {
+            PDLOG(WARNING, "bad record when uncompress block, raw_len: %u, block_size_: %u", raw_len, block_size_);
+            return kBadRecord;
+        }
+        // read compressed data
+        Slice block;
+        status = file_->Read(compress_len, &block, backing_store_);
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to read file %s when reading block", status.ToString().c_str());
+            return kWaitRecord;
+        }
+        if (block.size() < compress_len) {
+            // the block is being written
+            DEBUGLOG("read block size[%d] less than compress_len[%u]", block.size(), compress_len);
+            return kWaitRecord;
+        }
+        const char* block_data = block.data();
+        size_t uncompress_len = 0;
+        switch (compress_type) {
+            case kSnappy: {
+                if (!snappy::GetUncompressedLength(block_data, static_cast<size_t>(compress_len), &uncompress_len) ||
+                    uncompress_len > block_size_ ||
+                    !snappy::RawUncompress(block_data, static_cast<size_t>(compress_len), uncompress_buf_)) {
+                    PDLOG(WARNING, "bad record when uncompress block, compress type: %d", compress_type);
+                    return kBadRecord;
                 }
-                case kZlib: {
-                    uncompress_len = block_size_;
+                break;
+            }
+            case kZlib: {
 #ifdef __APPLE__
-                    int res = uncompress((unsigned char*)uncompress_buf_, reinterpret_cast<uLongf*>(&uncompress_len),
-                                         (const unsigned char*)block_data, compress_len);
+                uLongf dest_len = block_size_;
 #else
-                    // linux
-                    int res = uncompress((unsigned char*)uncompress_buf_, reinterpret_cast<uint64_t*>(&uncompress_len),
-                                         (const unsigned char*)block_data, compress_len);
+                // linux
+                uint64_t dest_len = block_size_;
 #endif
-                    if (res != Z_OK) {
-                        PDLOG(WARNING, "bad record when uncompress block, error code: %d, compress type: %d", res,
-                              compress_type);
-                        return kBadRecord;
-                    }
-                    break;
-                }
-                default: {
-                    PDLOG(WARNING, "unsupported compress type: %d", compress_type);
+                int res = uncompress((unsigned char*)uncompress_buf_, &dest_len, (const unsigned char*)block_data,
+                                     compress_len);
+                if (res != Z_OK) {
+                    PDLOG(WARNING, "bad record when uncompress block, error code: %d, compress type: %d", res,
+                          compress_type);
                     return kBadRecord;
                 }
+                uncompress_len = dest_len;
+                break;
             }
-            if (uncompress_len != static_cast<int32_t>(block_size_)) {
-                PDLOG(WARNING, "bad record when uncompress block, uncompress_len: %d, block_size_: %d", uncompress_len,
-                      block_size_);
+            default: {
+                PDLOG(WARNING, "unsupported compress type: %d", compress_type);
                 return kBadRecord;
             }
-            DLOG(INFO) << "uncompress_len: " << uncompress_len;
-            buffer_ = Slice(uncompress_buf_, block_size_);
         }
-        offset = end_of_buffer_offset_;
-        end_of_buffer_offset_ += buffer_.size();
+        if (uncompress_len != raw_len) {
+            PDLOG(WARNING, "bad record when uncompress block, uncompress_len: %lu, raw_len: %u", uncompress_len,
+                  raw_len);
+            return kBadRecord;
+        }
+        DLOG(INFO) << "uncompress_len: " << uncompress_len;
+        buffer_ = Slice(uncompress_buf_, raw_len);
+        end_of_buffer_offset_ += kHeaderSizeOfCompressBlock + compress_len;
+        return 0;
+    }
+}
+
+unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
+    if (buffer_.size() < static_cast<size_t>(header_size_)) {
+        // Last read was a full read, so this is a trailer to skip
+        buffer_.clear();
+        Status status;
+        if (!compressed_) {
+            status = file_->Read(block_size_, &buffer_, backing_store_);
+            offset = end_of_buffer_offset_;
+            end_of_buffer_offset_ += buffer_.size();
+        } else {
+            unsigned int ret = ReadCompressedBlock();
+            if (ret != 0) {
+                return ret;
+            }
+            offset = block_start_offset_;
+        }
         // Read log error
         if (!status.ok()) {
             buffer_.clear();
@@ -381,6 +432,13 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
         DEBUGLOG("end of file %d, header size %d data length %d", buffer_.size(), header_size_, length);
         return kWaitRecord;
     }
+    if (type == kZeroType && length == 0) {
+        // the zeros padded by a direct io writer after the data synced, or
+        // left by a crash before it truncated the file. the data after them
+        // is not written yet
+        DEBUGLOG("zero record at the end of file");
+        return kWaitRecord;
+    }
     // Check crc
     if (checksum_) {
         uint32_t expected_crc = Unmask(DecodeFixed32(header));
@@ -410,18 +468,11 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
         return kEof;
     }
 
-    if (type == kZeroType && length == 0) {
-        // Skip zero length record without reporting any drops since
-        // such records are produced by the mmap based writing code in
-        // env_posix.cc that preallocates file regions.
-        buffer_.clear();
-        PDLOG(WARNING, "bad record with zero type");
-        return kBadRecord;
-    }
-
     buffer_.remove_prefix(header_size_ + length);
     // Skip physical record that started before initial_offset_
-    if (end_of_buffer_offset_ - buffer_.size() - header_size_ - length < initial_offset_) {
+    uint64_t record_offset =
+        compressed_ ? block_start_offset_ : end_of_buffer_offset_ - buffer_.size() - header_size_ - length;
+    if (record_offset < initial_offset_) {
         result->clear();
         PDLOG(WARNING, "bad record with initial_offset");
         return kBadRecord;
@@ -430,6 +481,28 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
     return type;
 }
 
+std::string GetLogCompression(const std::string& path) {
+    FILE* fd = fopen(path.c_str(), "rb");
+    if (fd == NULL) {
+        return "off";
+    }
+    char header[kHeaderSizeOfCompressBlock];
+    size_t len = fread(header, 1, kHeaderSizeOfCompressBlock, fd);
+    fclose(fd);
+    if (len < kHeaderSizeOfCompressBlock ||
+        memcmp(header + kCompressLogMagicOffset, kCompressLogMagic, kCompressLogMagicSize) != 0) {
+        return "off";
+    }
+    switch (static_cast<CompressType>(header[sizeof(uint32_t)])) {
+        case kSnappy:
+            return "snappy";
+        case kZlib:
+            return "zlib";
+        default:
+            return "off";
+    }
+}
+
 LogReader::LogReader(LogParts* logs, const std::string& log_path, bool compressed) : log_path_(log_path) {
     sf_ = NULL;
     reader_ = NULL;
@@ -462,6 +535,18 @@ bool LogReader::SetOffset(uint64_t start_offset) {
     return true;
 }
 
+bool LogReader::Seek(uint64_t start_offset) {
+    if (!SetOffset(start_offset)) {
+        return false;
+    }
+    delete reader_;
+    reader_ = NULL;
+    delete sf_;
+    sf_ = NULL;
+    log_part_index_ = -1;
+    return true;
+}
+
 void LogReader::GoBackToLastBlock() {
     if (sf_ == NULL || reader_ == NULL) {
         return;
@@ -574,7 +659,8 @@ int LogReader::RollRLogFile() {
         }
         delete reader_;
         // roll a new log part file, reset status
-        reader_ = new Reader(sf_, NULL, FLAGS_binlog_enable_crc, 0, compressed_);
+        bool compressed = compressed_ || GetLogCompression(full_path) != "off";
+        reader_ = new Reader(sf_, NULL, FLAGS_binlog_enable_crc, 0, compressed);
         PDLOG(INFO, "roll log file from index[%d] to index[%d]", log_part_index_, index);
         log_part_index_ = index;
         return 0;
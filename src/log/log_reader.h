@@ -101,6 +101,8 @@ class Reader {
     // Offset of the first location past the end of buffer_.
     uint64_t end_of_buffer_offset_;
     uint64_t last_end_of_buffer_offset_;
+    // Offset of the compressed block in buffer_
+    uint64_t block_start_offset_;
 
     // Offset at which to start looking for the first record to return
     uint64_t initial_offset_;
@@ -137,6 +139,10 @@ class Reader {
     // Return type, or one of the preceding special values
     unsigned int ReadPhysicalRecord(Slice* result, uint64_t& offset);  // NOLINT
 
+    // Read and uncompress the next block into buffer_, the empty blocks are
+    // skipped. Return 0 on success, or kWaitRecord, kBadRecord
+    unsigned int ReadCompressedBlock();
+
     // Reports dropped bytes to the reporter.
     // buffer_ must be updated to remove the dropped bytes prior to invocation.
     void ReportCorruption(uint64_t bytes, const char* reason);
@@ -149,6 +155,10 @@ class Reader {
 
 typedef ::openmldb::base::Skiplist<uint32_t, uint64_t, ::openmldb::base::DefaultComparator> LogParts;
 
+// the compression of a binlog file written by Writer::BeginLog, it is the same
+// as the compress type of WriteHandle, "off" if the file is not compressed
+std::string GetLogCompression(const std::string& path);
+
 class LogReader {
  public:
     LogReader(LogParts* logs, const std::string& log_path, bool compressed);
@@ -162,6 +172,8 @@ class LogReader {
     int GetEndLogIndex();
     uint64_t GetLastRecordEndOffset();
     bool SetOffset(uint64_t start_offset);
+    // close the current log part, the next record is read from the part of start_offset
+    bool Seek(uint64_t start_offset);
     uint64_t GetMinOffset() const {
         return min_offset_;
     }
@@ -21,6 +21,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -29,6 +30,7 @@
 #include "config.h"  // NOLINT
 #include "log/coding.h"
 #include "log/crc32c.h"
+#include "log/direct_io.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
 #include "proto/tablet.pb.h"
@@ -37,6 +39,7 @@ using ::openmldb::base::Slice;
 using ::openmldb::log::Status;
 
 DECLARE_string(snapshot_compression);
+DECLARE_string(direct_io_root_path);
 bool compressed_ = true;
 uint32_t block_size_ = 1024 * 4;
 uint32_t header_size_ = 7;
@@ -410,6 +413,351 @@ TEST_F(LogWRTest, TestInit) {
     ASSERT_EQ(compressed_, reader.GetCompressed());
 }
 
+TEST_F(LogWRTest, TestBinlogBlock) {
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string fname = "test.log";
+    std::string full_path = log_dir + "/" + fname;
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WritableFile* wf = NewWritableFile(fname, fd_w);
+    Writer writer(FLAGS_snapshot_compression, wf);
+    ASSERT_TRUE(writer.BeginLog().ok());
+    ASSERT_EQ(FLAGS_snapshot_compression, GetLogCompression(full_path));
+    FILE* fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    SequentialFile* rf = NewSeqFile(fname, fd_r);
+    Reader reader(rf, NULL, true, 0, compressed_);
+    std::string scratch;
+    Slice value;
+    // the records of a batch are readable once it is written
+    std::vector<std::string> batch1{"a0", "a1", "a2"};
+    ASSERT_TRUE(writer.AddRecords(std::vector<Slice>(batch1.begin(), batch1.end())).ok());
+    for (const auto& record : batch1) {
+        ASSERT_TRUE(reader.ReadRecord(&value, &scratch).ok());
+        ASSERT_EQ(record, value.ToString());
+    }
+    ASSERT_TRUE(reader.ReadRecord(&value, &scratch).IsWaitRecord());
+    std::vector<std::string> batch2{"b0", std::string(100, 'b'), "b2"};
+    ASSERT_TRUE(writer.AddRecords(std::vector<Slice>(batch2.begin(), batch2.end())).ok());
+    // the reader goes back to the last block, the records read may be read again
+    Status status = reader.ReadRecord(&value, &scratch);
+    while (status.ok() && value.ToString()[0] == 'a') {
+        status = reader.ReadRecord(&value, &scratch);
+    }
+    for (const auto& record : batch2) {
+        ASSERT_TRUE(status.ok());
+        ASSERT_EQ(record, value.ToString());
+        status = reader.ReadRecord(&value, &scratch);
+    }
+    ASSERT_TRUE(status.IsWaitRecord());
+    uint64_t file_size = wf->GetSize();
+    ASSERT_EQ(file_size, reader.LastRecordEndOffset());
+    delete rf;
+
+    // a block being written is waited for
+    std::string data;
+    fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    data.resize(file_size);
+    ASSERT_EQ(file_size, fread(&data[0], 1, file_size, fd_r));
+    fclose(fd_r);
+    std::string part_path = log_dir + "/part.log";
+    FILE* fd_part = fopen(part_path.c_str(), "wb");
+    ASSERT_TRUE(fd_part != NULL);
+    ASSERT_EQ(file_size - 10, fwrite(data.data(), 1, file_size - 10, fd_part));
+    fclose(fd_part);
+    fd_r = fopen(part_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    rf = NewSeqFile(part_path, fd_r);
+    {
+        Reader part_reader(rf, NULL, true, 0, compressed_);
+        for (const auto& record : batch1) {
+            ASSERT_TRUE(part_reader.ReadRecord(&value, &scratch).ok());
+            ASSERT_EQ(record, value.ToString());
+        }
+        status = part_reader.ReadRecord(&value, &scratch);
+        if (compressed_) {
+            ASSERT_TRUE(status.IsWaitRecord());
+        }
+    }
+    delete rf;
+
+    // append the end of log after the last record like the recovery of binlog
+    FILE* fd_end = fopen(full_path.c_str(), "rb+");
+    ASSERT_TRUE(fd_end != NULL);
+    ASSERT_EQ(0, fseek(fd_end, file_size, SEEK_SET));
+    {
+        WriteHandle wh(GetLogCompression(full_path), full_path, fd_end, file_size);
+        ASSERT_TRUE(wh.EndLog().ok());
+    }
+    fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    rf = NewSeqFile(fname, fd_r);
+    {
+        Reader end_reader(rf, NULL, true, 0, compressed_);
+        for (const auto& record : batch1) {
+            ASSERT_TRUE(end_reader.ReadRecord(&value, &scratch).ok());
+            ASSERT_EQ(record, value.ToString());
+        }
+        for (const auto& record : batch2) {
+            ASSERT_TRUE(end_reader.ReadRecord(&value, &scratch).ok());
+            ASSERT_EQ(record, value.ToString());
+        }
+        ASSERT_TRUE(end_reader.ReadRecord(&value, &scratch).IsEof());
+    }
+    delete rf;
+}
+
+TEST_F(LogWRTest, TestDirectIO) {
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    // it falls back to buffered io if the file system does not support direct io
+    std::string probe_path = log_dir + "probe";
+    int probe_fd = OpenDirect(probe_path, O_CREAT | O_WRONLY);
+    bool direct_io_supported = probe_fd >= 0;
+    if (direct_io_supported) {
+        close(probe_fd);
+    }
+    unlink(probe_path.c_str());
+    uint64_t open_cnt = GetDirectOpenCount();
+    FLAGS_direct_io_root_path = log_dir;
+    std::string full_path = log_dir + "test.log";
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    FILE* fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    SequentialFile* rf = NewSeqFile(full_path, fd_r);
+    uint32_t cnt = 0;
+    std::string scratch;
+    Slice value;
+    {
+        WriteHandle wh(FLAGS_snapshot_compression, full_path, fd_w);
+        ASSERT_TRUE(wh.BeginLog().ok());
+        Reader reader(rf, NULL, true, 0, compressed_);
+        std::vector<std::string> records;
+        uint32_t read_cnt = 0;
+        // the reader goes back to the last block when it waits, so it reads
+        // some records again
+        auto read_records = [&]() {
+            Status status = reader.ReadRecord(&value, &scratch);
+            for (; status.ok(); status = reader.ReadRecord(&value, &scratch)) {
+                uint32_t idx = std::stoul(value.ToString());
+                if (idx < read_cnt) {
+                    continue;
+                }
+                ASSERT_EQ(read_cnt, idx);
+                ASSERT_EQ(records[idx], value.ToString());
+                read_cnt++;
+            }
+            ASSERT_TRUE(status.IsWaitRecord());
+        };
+        // the records cross the blocks and the buffer of direct io, they are
+        // readable once the buffer is full or the file is synced
+        for (uint32_t i = 0; i < 100; i++) {
+            std::vector<std::string> batch;
+            for (uint32_t j = 0; j < 10; j++) {
+                batch.push_back(std::to_string(cnt++) + std::string(rand() % 1000, 'a'));  // NOLINT
+            }
+            records.insert(records.end(), batch.begin(), batch.end());
+            ASSERT_TRUE(wh.Write(std::vector<Slice>(batch.begin(), batch.end())).ok());
+            read_records();
+            if (i == 0) {
+                ASSERT_EQ(direct_io_supported ? 0u : records.size(), read_cnt);
+            }
+            if (i % 40 == 39 || i == 99) {
+                ASSERT_TRUE(wh.Sync().ok());
+                read_records();
+                ASSERT_EQ(records.size(), read_cnt);
+            }
+        }
+    }
+    delete rf;
+    if (direct_io_supported) {
+        // the writer and the reader
+        ASSERT_EQ(open_cnt + 2, GetDirectOpenCount());
+    }
+
+    // append to the file like the recovery of binlog
+    fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    {
+        WriteHandle wh(GetLogCompression(full_path), full_path, fd_w);
+        for (uint32_t i = 0; i < 10; i++) {
+            ASSERT_TRUE(wh.Write(Slice(std::to_string(cnt++) + "b")).ok());
+        }
+        ASSERT_TRUE(wh.EndLog().ok());
+    }
+    fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    rf = NewSeqFile(full_path, fd_r);
+    {
+        Reader reader(rf, NULL, true, 0, compressed_);
+        uint32_t read_cnt = 0;
+        Status status = reader.ReadRecord(&value, &scratch);
+        while (status.ok()) {
+            ASSERT_EQ(0u, value.ToString().find(std::to_string(read_cnt)));
+            read_cnt++;
+            status = reader.ReadRecord(&value, &scratch);
+        }
+        ASSERT_TRUE(status.IsEof());
+        ASSERT_EQ(cnt, read_cnt);
+    }
+    delete rf;
+    FLAGS_direct_io_root_path = "";
+    ::openmldb::base::RemoveDirRecursive(log_dir);
+}
+
+TEST_F(LogWRTest, TestTruncateAndReopen) {
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string full_path = log_dir + "test.log";
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, full_path, fd_w);
+    ASSERT_TRUE(wh->Write(std::vector<Slice>{Slice("hello")}).ok());
+    uint64_t last_size = wh->GetSize();
+    // the batch is dropped like a failed write of the binlog
+    ASSERT_TRUE(wh->Write(std::vector<Slice>{Slice("dropped"), Slice("dropped1")}).ok());
+    ASSERT_GT(wh->GetSize(), last_size);
+    delete wh;
+    ASSERT_EQ(0, truncate(full_path.c_str(), last_size));
+    fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    wh = new WriteHandle(FLAGS_snapshot_compression, full_path, fd_w, last_size);
+    ASSERT_EQ(last_size, wh->GetSize());
+    ASSERT_TRUE(wh->Write(std::vector<Slice>{Slice("hello1")}).ok());
+    ASSERT_TRUE(wh->EndLog().ok());
+    delete wh;
+
+    FILE* fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    SequentialFile* rf = NewSeqFile(full_path, fd_r);
+    {
+        Reader reader(rf, NULL, true, 0, compressed_);
+        std::string scratch;
+        Slice value;
+        ASSERT_TRUE(reader.ReadRecord(&value, &scratch).ok());
+        ASSERT_EQ("hello", value.ToString());
+        ASSERT_TRUE(reader.ReadRecord(&value, &scratch).ok());
+        ASSERT_EQ("hello1", value.ToString());
+        ASSERT_TRUE(reader.ReadRecord(&value, &scratch).IsEof());
+    }
+    delete rf;
+    ::openmldb::base::RemoveDirRecursive(log_dir);
+}
+
+TEST_F(LogWRTest, TestFlushSize) {
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    for (uint32_t batch_size : {1, 7, 32}) {
+        uint64_t file_size[2] = {0, 0};
+        for (uint32_t flush_size : {0, 4096}) {
+            std::string full_path =
+                log_dir + std::to_string(batch_size) + "_" + std::to_string(flush_size) + ".log";
+            FILE* fd_w = fopen(full_path.c_str(), "ab+");
+            ASSERT_TRUE(fd_w != NULL);
+            {
+                WriteHandle wh(FLAGS_snapshot_compression, full_path, fd_w);
+                wh.SetFlushSize(flush_size);
+                ASSERT_TRUE(wh.BeginLog().ok());
+                std::vector<std::string> values;
+                std::vector<Slice> batch;
+                for (uint32_t i = 0; i < 1000; i++) {
+                    values.push_back("value" + std::to_string(i));
+                    if (values.size() == batch_size) {
+                        batch.assign(values.begin(), values.end());
+                        ASSERT_TRUE(wh.Write(batch).ok());
+                        values.clear();
+                        // the records of a compressed binlog wait for flush_size bytes
+                        ASSERT_LT(wh.GetBuffered().size(), compressed_ ? std::max(flush_size, 1u) : 1u);
+                    }
+                }
+                batch.assign(values.begin(), values.end());
+                ASSERT_TRUE(wh.Write(batch).ok());
+                ASSERT_TRUE(wh.EndLog().ok());
+                ASSERT_EQ(0u, wh.GetBuffered().size());
+                file_size[flush_size == 0 ? 0 : 1] = wh.GetSize();
+            }
+            FILE* fd_r = fopen(full_path.c_str(), "rb");
+            ASSERT_TRUE(fd_r != NULL);
+            SequentialFile* rf = NewSeqFile(full_path, fd_r);
+            {
+                Reader reader(rf, NULL, true, 0, compressed_);
+                std::string scratch;
+                Slice value;
+                for (uint32_t i = 0; i < 1000; i++) {
+                    ASSERT_TRUE(reader.ReadRecord(&value, &scratch).ok());
+                    ASSERT_EQ("value" + std::to_string(i), value.ToString());
+                }
+                ASSERT_TRUE(reader.ReadRecord(&value, &scratch).IsEof());
+            }
+            delete rf;
+        }
+        if (compressed_) {
+            // fewer blocks are written
+            ASSERT_LT(file_size[1], file_size[0]);
+        } else {
+            ASSERT_EQ(file_size[1], file_size[0]);
+        }
+    }
+    ::openmldb::base::RemoveDirRecursive(log_dir);
+}
+
+TEST_F(LogWRTest, TestFlushBuffered) {
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string full_path = log_dir + "test.log";
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, full_path, fd_w);
+    wh->SetFlushSize(64 * 1024);
+    ASSERT_TRUE(wh->BeginLog().ok());
+    ASSERT_TRUE(wh->Write(std::vector<Slice>{Slice("hello")}).ok());
+    uint64_t last_size = wh->GetSize();
+
+    FILE* fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    SequentialFile* rf = NewSeqFile(full_path, fd_r);
+    Reader reader(rf, NULL, true, 0, compressed_);
+    std::string scratch;
+    Slice value;
+    if (compressed_) {
+        // the readers do not see the buffered records until they are flushed
+        ASSERT_FALSE(reader.ReadRecord(&value, &scratch).ok());
+        ASSERT_TRUE(wh->Flush().ok());
+        ASSERT_EQ(0u, wh->GetBuffered().size());
+        ASSERT_GT(wh->GetSize(), last_size);
+    }
+    ASSERT_TRUE(reader.ReadRecord(&value, &scratch).ok());
+    ASSERT_EQ("hello", value.ToString());
+
+    // the buffered records are carried to the file reopened like a failed write
+    ASSERT_TRUE(wh->Write(std::vector<Slice>{Slice("hello1"), Slice("hello2")}).ok());
+    last_size = wh->GetSize();
+    std::string buffered = wh->GetBuffered().ToString();
+    ASSERT_EQ(compressed_, !buffered.empty());
+    ASSERT_TRUE(wh->Write(std::vector<Slice>{Slice("dropped")}).ok());
+    ASSERT_TRUE(wh->Flush().ok());
+    delete wh;
+    ASSERT_EQ(0, truncate(full_path.c_str(), last_size));
+    fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    wh = new WriteHandle(FLAGS_snapshot_compression, full_path, fd_w, last_size);
+    wh->SetBuffered(Slice(buffered));
+    ASSERT_TRUE(wh->Write(std::vector<Slice>{Slice("hello3")}).ok());
+    ASSERT_TRUE(wh->EndLog().ok());
+    delete wh;
+
+    for (const std::string& expect : {"hello1", "hello2", "hello3"}) {
+        ASSERT_TRUE(reader.ReadRecord(&value, &scratch).ok());
+        ASSERT_EQ(expect, value.ToString());
+    }
+    ASSERT_TRUE(reader.ReadRecord(&value, &scratch).IsEof());
+    delete rf;
+    ::openmldb::base::RemoveDirRecursive(log_dir);
+}
+
 }  // namespace log
 }  // namespace openmldb
 
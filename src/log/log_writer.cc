@@ -24,6 +24,8 @@
 #include <stdint.h>
 #include <zlib.h>
 
+#include <algorithm>
+
 #include "base/endianconv.h"
 #include "base/glog_wrapper.h"
 #include "log/coding.h"
@@ -32,6 +34,10 @@
 namespace openmldb {
 namespace log {
 
+static size_t GetMaxCompressedLength(uint32_t block_size) {
+    return std::max(snappy::MaxCompressedLength(block_size), static_cast<size_t>(compressBound(block_size)));
+}
+
 static void InitTypeCrc(uint32_t* type_crc) {
     for (int i = 0; i <= kMaxRecordType; i++) {
         char t = static_cast<char>(i);
@@ -45,12 +51,16 @@ Writer::Writer(const std::string& compress_type, WritableFile* dest)
       compress_type_(GetCompressType(compress_type)),
       header_size_(compress_type_ != kNoCompress ? kHeaderSizeForCompress : kHeaderSize),
       buffer_(nullptr),
-      compress_buf_(nullptr) {
+      compress_buf_(nullptr),
+      defer_flush_(false),
+      flush_size_(0),
+      batch_offset_(0),
+      batch_saved_(false) {
     InitTypeCrc(type_crc_);
     if (compress_type_ != kNoCompress) {
         block_size_ = kCompressBlockSize;
         buffer_ = new char[block_size_];
-        compress_buf_ = new char[block_size_];
+        compress_buf_ = new char[GetMaxCompressedLength(block_size_)];
     } else {
         block_size_ = kBlockSize;
     }
@@ -64,16 +74,21 @@ Writer::Writer(const std::string& compress_type, WritableFile* dest, uint64_t de
       compress_type_(GetCompressType(compress_type)),
       header_size_(compress_type_ != kNoCompress ? kHeaderSizeForCompress : kHeaderSize),
       buffer_(nullptr),
-      compress_buf_(nullptr) {
+      compress_buf_(nullptr),
+      defer_flush_(false),
+      flush_size_(0),
+      batch_offset_(0),
+      batch_saved_(false) {
     InitTypeCrc(type_crc_);
     if (compress_type_ != kNoCompress) {
         block_size_ = kCompressBlockSize;
         buffer_ = new char[block_size_];
-        compress_buf_ = new char[block_size_];
+        compress_buf_ = new char[GetMaxCompressedLength(block_size_)];
     } else {
         block_size_ = kBlockSize;
     }
-    block_offset_ = dest_length % block_size_;
+    // the records appended to a compressed file start a new block
+    block_offset_ = compress_type_ != kNoCompress ? 0 : dest_length % block_size_;
     DLOG(INFO) << "block_size_: " << block_size_ << ", "
                << "header_size_: " << header_size_ << ", "
                << "compress_type_: " << compress_type_;
@@ -180,6 +195,72 @@ Status Writer::AddRecord(const Slice& slice) {
     return s;
 }
 
+Status Writer::AddRecords(const std::vector<Slice>& slices) {
+    Status s;
+    defer_flush_ = true;
+    batch_offset_ = block_offset_;
+    batch_saved_ = false;
+    for (const auto& slice : slices) {
+        s = AddRecord(slice);
+        if (!s.ok()) {
+            break;
+        }
+    }
+    defer_flush_ = false;
+    if (compress_type_ == kNoCompress) {
+        return s.ok() ? dest_->Flush() : s;
+    }
+    // compress the records of the later calls together until the buffer is large enough
+    if (s.ok() && block_offset_ >= flush_size_) {
+        s = FlushBlock();
+    }
+    if (!s.ok()) {
+        if (batch_saved_) {
+            memcpy(buffer_, batch_buffer_.data(), batch_buffer_.size());
+        }
+        block_offset_ = batch_offset_;
+    }
+    return s;
+}
+
+Status Writer::FlushBlock() {
+    if (compress_type_ == kNoCompress || block_offset_ == 0) {
+        return Status::OK();
+    }
+    Status s = CompressRecord(block_offset_);
+    if (s.ok()) {
+        block_offset_ = 0;
+    }
+    return s;
+}
+
+void Writer::SetBuffered(const Slice& buffered) {
+    if (compress_type_ == kNoCompress || buffered.size() > block_size_) {
+        return;
+    }
+    memcpy(buffer_, buffered.data(), buffered.size());
+    block_offset_ = buffered.size();
+}
+
+Status Writer::BeginLog() {
+    if (compress_type_ == kNoCompress) {
+        return Status::OK();
+    }
+    // an empty block with the magic
+    char header[kHeaderSizeOfCompressBlock];
+    memset(header, 0, kHeaderSizeOfCompressBlock);
+    memcpy(header + sizeof(int32_t), static_cast<void*>(&compress_type_), 1);
+    memcpy(header + kCompressLogMagicOffset, kCompressLogMagic, kCompressLogMagicSize);
+    Status s = dest_->Append(Slice(header, kHeaderSizeOfCompressBlock));
+    if (s.ok()) {
+        s = dest_->Flush();
+    }
+    if (!s.ok()) {
+        PDLOG(WARNING, "write error. %s", s.ToString().c_str());
+    }
+    return s;
+}
+
 Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
     if (compress_type_ == kNoCompress) {
         assert(n <= 0xffff);  // Must fit in two bytes
@@ -211,7 +292,7 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
         Status s = dest_->Append(Slice(buf, header_size_));
         if (s.ok()) {
             s = dest_->Append(Slice(ptr, n));
-            if (s.ok()) {
+            if (s.ok() && !defer_flush_) {
                 s = dest_->Flush();
             }
         }
@@ -231,30 +312,42 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
             block_offset_ = block_size_;
         }
         if (block_offset_ == block_size_) {
-            return CompressRecord();
+            // the full block is written, it must not be flushed again
+            Status s = CompressRecord(block_size_);
+            if (s.ok()) {
+                block_offset_ = 0;
+            }
+            return s;
         }
         return Status::OK();
     }
 }
 
-Status Writer::CompressRecord() {
+Status Writer::CompressRecord(uint32_t raw_len) {
+    if (defer_flush_ && !batch_saved_) {
+        // the buffer is reused after the block is written
+        batch_buffer_.assign(buffer_, batch_offset_);
+        batch_saved_ = true;
+    }
     Status s;
     int32_t compress_len = -1;
     switch (compress_type_) {
         case kSnappy: {
-            snappy::RawCompress(buffer_, block_size_, compress_buf_, reinterpret_cast<size_t*>(&compress_len));
+            size_t dest_len = 0;
+            snappy::RawCompress(buffer_, raw_len, compress_buf_, &dest_len);
+            compress_len = static_cast<int32_t>(dest_len);
             break;
         }
         case kZlib: {
-            uint32_t dest_len = compressBound(block_size_);
+            uint64_t dest_len = compressBound(raw_len);
 
 #ifdef __APPLE__
             int res = compress((unsigned char*)compress_buf_, reinterpret_cast<uLongf*>(&dest_len),
-                               (const unsigned char*)buffer_, block_size_);
+                               (const unsigned char*)buffer_, raw_len);
 #else
 
             int res = compress((unsigned char*)compress_buf_, reinterpret_cast<uint64_t*>(&dest_len),
-                               (const unsigned char*)buffer_, block_size_);
+                               (const unsigned char*)buffer_, raw_len);
 #endif
             if (res != Z_OK) {
                 s = Status::InvalidRecord(Slice("compress failed, error code: " + res));
@@ -283,6 +376,10 @@ Status Writer::CompressRecord() {
     memcpy(head_of_compress, static_cast<void*>(&compress_len), sizeof(int32_t));
     memcpy(head_of_compress + sizeof(int32_t), static_cast<void*>(&compress_type_), 1);
     memset(head_of_compress + sizeof(int32_t) + 1, 0, kHeaderSizeOfCompressBlock - sizeof(int32_t) - 1);
+    if (raw_len != block_size_) {
+        memrev32ifbe(static_cast<void*>(&raw_len));
+        memcpy(head_of_compress + sizeof(int32_t) + 1, static_cast<void*>(&raw_len), sizeof(uint32_t));
+    }
     // write header and compressed data
     s = dest_->Append(Slice(head_of_compress, kHeaderSizeOfCompressBlock));
     if (s.ok()) {
@@ -313,8 +410,8 @@ Status Writer::AppendInternal(WritableFile* wf, int32_t leftover) {
         wf->Append(fill_slice);
         return Status::OK();
     } else {
-        memcpy(buffer_ + block_offset_, fill_slice.data(), leftover);
-        return CompressRecord();
+        memset(buffer_ + block_offset_, 0, leftover);
+        return CompressRecord(block_size_);
     }
 }
 
@@ -24,6 +24,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include "base/slice.h"
 #include "log/status.h"
@@ -50,6 +51,30 @@ class Writer {
     ~Writer();
 
     Status AddRecord(const Slice& slice);
+
+    // append the records and flush the file once. the records of a compressed
+    // file stay in the buffer until flush_size bytes are buffered, see
+    // SetFlushSize. on failure the records buffered before the call are kept
+    // and the caller should truncate the file to the size before the call
+    Status AddRecords(const std::vector<Slice>& slices);
+
+    // compress the records in the buffer as a block shorter than the block
+    // size, so the readers see them before the buffer is full. the records
+    // stay in the buffer on failure
+    Status FlushBlock();
+
+    // AddRecords of a compressed file compresses the buffer once it has at
+    // least size bytes, 0 compresses the records of every call
+    void SetFlushSize(uint32_t size) { flush_size_ = size; }
+
+    // the records buffered and not written to the file yet, they are moved to
+    // the writer of the same file after the file is reopened
+    Slice GetBuffered() const { return compress_type_ != kNoCompress ? Slice(buffer_, block_offset_) : Slice(); }
+    void SetBuffered(const Slice& buffered);
+
+    // write the header of a compressed binlog file, see kCompressLogMagic
+    Status BeginLog();
+
     Status EndLog();
 
     inline CompressType GetCompressType() { return compress_type_; }
@@ -76,7 +101,15 @@ class Writer {
     char* buffer_;
     // buffer for compressed block
     char* compress_buf_;
-    Status CompressRecord();
+    // the records of AddRecords are flushed at last
+    bool defer_flush_;
+    uint32_t flush_size_;
+    // the buffer before AddRecords, it is saved before a full block of the call
+    // is written so the buffer can be restored on failure
+    uint32_t batch_offset_;
+    bool batch_saved_;
+    std::string batch_buffer_;
+    Status CompressRecord(uint32_t raw_len);
     Status AppendInternal(WritableFile* wf, int leftover);
 
     Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length);
@@ -90,19 +123,34 @@ struct WriteHandle {
     FILE* fd_;
     WritableFile* wf_;
     Writer* lw_;
+    // the size of the file before it is opened
+    uint64_t dest_length_;
     WriteHandle(const std::string& compress_type, const std::string& fname, FILE* fd, uint64_t dest_length = 0)
-        : fd_(fd), wf_(NULL), lw_(NULL) {
+        : fd_(fd), wf_(NULL), lw_(NULL), dest_length_(dest_length) {
         wf_ = ::openmldb::log::NewWritableFile(fname, fd);
         lw_ = new Writer(compress_type, wf_, dest_length);
     }
 
     Status Write(const ::openmldb::base::Slice& slice) { return lw_->AddRecord(slice); }
 
+    Status Write(const std::vector<::openmldb::base::Slice>& slices) { return lw_->AddRecords(slices); }
+
     Status Sync() { return wf_->Sync(); }
 
+    // write the records buffered by a compressed file, see Writer::FlushBlock
+    Status Flush() { return lw_->FlushBlock(); }
+
+    void SetFlushSize(uint32_t size) { lw_->SetFlushSize(size); }
+
+    Slice GetBuffered() const { return lw_->GetBuffered(); }
+
+    void SetBuffered(const Slice& buffered) { lw_->SetBuffered(buffered); }
+
+    Status BeginLog() { return lw_->BeginLog(); }
+
     Status EndLog() { return lw_->EndLog(); }
 
-    uint64_t GetSize() { return wf_->GetSize(); }
+    uint64_t GetSize() { return dest_length_ + wf_->GetSize(); }
 
     ~WriteHandle() {
         delete lw_;
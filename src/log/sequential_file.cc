@@ -21,10 +21,19 @@
 #include "log/sequential_file.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
 
 #include "base/glog_wrapper.h"
 #include "base/slice.h"
+#include "log/direct_io.h"
 #include "log/status.h"
 
 using ::openmldb::base::Slice;
@@ -91,7 +100,112 @@ class PosixSequentialFile : public SequentialFile {
     }
 };
 
-SequentialFile* NewSeqFile(const std::string& fname, FILE* f) { return new PosixSequentialFile(fname, f); }
+// DirectSequentialFile reads the file with direct io into an aligned buffer,
+// so the binlog and snapshots loaded do not evict the pages of others. The
+// reads at the end of the file see the data appended later
+class DirectSequentialFile : public SequentialFile {
+ public:
+    // return NULL if the file can not be read with direct io
+    static DirectSequentialFile* Open(const std::string& fname, FILE* f) {
+        int64_t pos = ftell(f);
+        if (pos < 0) {
+            return NULL;
+        }
+        int fd = OpenDirect(fname, O_RDONLY);
+        if (fd < 0) {
+            return NULL;
+        }
+        char* buf = NewAlignedBuffer();
+        if (buf == NULL) {
+            close(fd);
+            return NULL;
+        }
+        return new DirectSequentialFile(fname, f, fd, buf, pos);
+    }
+
+    virtual ~DirectSequentialFile() {
+        close(fd_);
+        fclose(file_);
+        free(buf_);
+    }
+
+    virtual Status Read(size_t n, Slice* result, char* scratch) {
+        size_t copied = 0;
+        while (copied < n) {
+            if (pos_ < buf_offset_ || pos_ >= buf_offset_ + buf_len_) {
+                if (buf_len_ < DIRECT_IO_BUFFER_SIZE && pos_ >= buf_offset_ + buf_len_) {
+                    // the last read hit the end of the file, the readers at the
+                    // tail of binlog poll here, so the buffer is only read again
+                    // once the file grows
+                    struct stat st;
+                    if (fstat(fd_, &st) == 0 && static_cast<uint64_t>(st.st_size) <= pos_) {
+                        break;
+                    }
+                }
+                buf_offset_ = pos_ & ~static_cast<uint64_t>(DIRECT_IO_ALIGNMENT - 1);
+                ssize_t r = pread(fd_, buf_, DIRECT_IO_BUFFER_SIZE, buf_offset_);
+                if (r < 0) {
+                    buf_len_ = 0;
+                    *result = Slice(scratch, copied);
+                    return Status::IOError(filename_, strerror(errno));
+                }
+                buf_len_ = r;
+                if (pos_ >= buf_offset_ + buf_len_) {
+                    // We leave status as ok if we hit the end of the file
+                    break;
+                }
+            }
+            size_t len = std::min(n - copied, static_cast<size_t>(buf_offset_ + buf_len_ - pos_));
+            memcpy(scratch + copied, buf_ + (pos_ - buf_offset_), len);
+            copied += len;
+            pos_ += len;
+        }
+        *result = Slice(scratch, copied);
+        return Status::OK();
+    }
+
+    virtual Status Skip(uint64_t n) {
+        pos_ += n;
+        return Status::OK();
+    }
+
+    virtual Status Tell(uint64_t* pos) {
+        if (pos == NULL) {
+            return Status::InvalidArgument("invalid pos arg");
+        }
+        *pos = pos_;
+        return Status::OK();
+    }
+
+    virtual Status Seek(uint64_t pos) {
+        pos_ = pos;
+        return Status::OK();
+    }
+
+ private:
+    DirectSequentialFile(const std::string& fname, FILE* f, int fd, char* buf, uint64_t pos)
+        : filename_(fname), file_(f), fd_(fd), buf_(buf), buf_offset_(0), buf_len_(0), pos_(pos) {}
+
+    std::string filename_;
+    FILE* file_;
+    int fd_;
+    char* buf_;
+    // the offset in file of the buffer and the bytes read into it
+    uint64_t buf_offset_;
+    size_t buf_len_;
+    uint64_t pos_;
+};
+
+SequentialFile* NewSeqFile(const std::string& fname, FILE* f) {
+    if (UseDirectIO(fname)) {
+        SequentialFile* file = DirectSequentialFile::Open(fname, f);
+        if (file != NULL) {
+            return file;
+        }
+        PDLOG(WARNING, "fall back to buffered io for %s", fname.c_str());
+    }
+    return new PosixSequentialFile(fname, f);
+}
 
 }  // namespace log
 }  // namespace openmldb
@@ -22,10 +22,19 @@
 #include "log/writable_file.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <string>
+
+#include "base/glog_wrapper.h"
 #include "base/slice.h"
+#include "log/direct_io.h"
 #include "log/status.h"
 
 using ::openmldb::base::Slice;
@@ -103,7 +112,170 @@ class PosixWritableFile : public WritableFile {
     FILE* file_;
 };
 
-WritableFile* NewWritableFile(const std::string& fname, FILE* f) { return new PosixWritableFile(fname, f); }
+// DirectWritableFile keeps the data appended in an aligned buffer and writes
+// it with direct io once the buffer is full, so the file does not fill the
+// page cache and is written in large blocks. The buffer is also written on
+// Sync and Close, the last partial block padded with zeros, then the file is
+// truncated to its size. The data in the buffer is not seen by the readers of
+// the file until then, and is lost if the process crashes
+class DirectWritableFile : public WritableFile {
+ public:
+    // return NULL if the file can not be written with direct io
+    static DirectWritableFile* Open(const std::string& fname, FILE* f) {
+        // the data written by f is appended after it
+        if (fflush(f) != 0) {
+            return NULL;
+        }
+        int fd = OpenDirect(fname, O_RDWR);
+        if (fd < 0) {
+            return NULL;
+        }
+        char* buf = NewAlignedBuffer();
+        struct stat st;
+        if (buf == NULL || fstat(fd, &st) != 0) {
+            PDLOG(WARNING, "fail to init direct io for %s: %s", fname.c_str(), strerror(errno));
+            close(fd);
+            free(buf);
+            return NULL;
+        }
+        uint64_t size = st.st_size;
+        uint64_t aligned_offset = size & ~static_cast<uint64_t>(DIRECT_IO_ALIGNMENT - 1);
+        size_t buf_len = size - aligned_offset;
+        if (buf_len > 0 && pread(fd, buf, DIRECT_IO_ALIGNMENT, aligned_offset) != (ssize_t)buf_len) {
+            PDLOG(WARNING, "fail to read the last block of %s: %s", fname.c_str(), strerror(errno));
+            close(fd);
+            free(buf);
+            return NULL;
+        }
+        return new DirectWritableFile(fname, f, fd, buf, aligned_offset, buf_len);
+    }
+
+    ~DirectWritableFile() {
+        if (file_ != NULL) {
+            // Ignoring any potential errors
+            Close();
+        }
+        free(buf_);
+    }
+
+    virtual Status Append(const Slice& data) {
+        const char* src = data.data();
+        size_t left = data.size();
+        while (left > 0) {
+            size_t n = std::min(left, static_cast<size_t>(DIRECT_IO_BUFFER_SIZE) - buf_len_);
+            memcpy(buf_ + buf_len_, src, n);
+            buf_len_ += n;
+            src += n;
+            left -= n;
+            if (buf_len_ == DIRECT_IO_BUFFER_SIZE) {
+                Status s = WriteBlocks(buf_len_);
+                if (!s.ok()) {
+                    return s;
+                }
+            }
+        }
+        unwritten_ = unwritten_ || data.size() > 0;
+        wsize_ += data.size();
+        return Status::OK();
+    }
+
+    virtual Status Close() {
+        Status result = WriteBuffer();
+        close(fd_);
+        if (fclose(file_) != 0 && result.ok()) {
+            result = IOError(filename_, errno);
+        }
+        file_ = NULL;
+        return result;
+    }
+
+    // the data stays in the buffer until it is full or the file is synced
+    virtual Status Flush() { return Status::OK(); }
+
+    virtual Status Sync() {
+        Status s = WriteBuffer();
+        if (!s.ok()) {
+            return s;
+        }
+#if __linux__
+        if (fdatasync(fd_) != 0) {
+            return IOError(filename_, errno);
+        }
+#else
+        if (fsync(fd_) != 0) {
+            return IOError(filename_, errno);
+        }
+#endif
+        return Status::OK();
+    }
+
+ private:
+    DirectWritableFile(const std::string& fname, FILE* f, int fd, char* buf, uint64_t aligned_offset, size_t buf_len)
+        : filename_(fname),
+          file_(f),
+          fd_(fd),
+          buf_(buf),
+          aligned_offset_(aligned_offset),
+          buf_len_(buf_len),
+          unwritten_(false) {}
+
+    // write the first len bytes of the buffer, len is aligned
+    Status WriteBlocks(size_t len) {
+        if (pwrite(fd_, buf_, len, aligned_offset_) != (ssize_t)len) {
+            return IOError(filename_, errno);
+        }
+        aligned_offset_ += len;
+        buf_len_ -= len;
+        memmove(buf_, buf_ + len, buf_len_);
+        return Status::OK();
+    }
+
+    // write the buffer to the file. the partial block at the end stays in the
+    // buffer, and is written again with the data appended after it
+    Status WriteBuffer() {
+        if (!unwritten_) {
+            return Status::OK();
+        }
+        size_t aligned_len = buf_len_ & ~static_cast<size_t>(DIRECT_IO_ALIGNMENT - 1);
+        if (aligned_len > 0) {
+            Status s = WriteBlocks(aligned_len);
+            if (!s.ok()) {
+                return s;
+            }
+        }
+        if (buf_len_ > 0) {
+            // the readers take the zeros for the data not written yet
+            memset(buf_ + buf_len_, 0, DIRECT_IO_ALIGNMENT - buf_len_);
+            if (pwrite(fd_, buf_, DIRECT_IO_ALIGNMENT, aligned_offset_) != (ssize_t)DIRECT_IO_ALIGNMENT ||
+                ftruncate(fd_, aligned_offset_ + buf_len_) != 0) {
+                return IOError(filename_, errno);
+            }
+        }
+        unwritten_ = false;
+        return Status::OK();
+    }
+
+    std::string filename_;
+    FILE* file_;
+    int fd_;
+    char* buf_;
+    // the offset in file of the buffer
+    uint64_t aligned_offset_;
+    size_t buf_len_;
+    // some data appended is not written to the file
+    bool unwritten_;
+};
+
+WritableFile* NewWritableFile(const std::string& fname, FILE* f) {
+    if (UseDirectIO(fname)) {
+        WritableFile* file = DirectWritableFile::Open(fname, f);
+        if (file != NULL) {
+            return file;
+        }
+        PDLOG(WARNING, "fall back to buffered io for %s", fname.c_str());
+    }
+    return new PosixWritableFile(fname, f);
+}
 
 }  // namespace log
 }  // namespace openmldb
@@ -2310,6 +2310,13 @@ int NameServerImpl::CreateTableOnTablet(const std::shared_ptr<::openmldb::namese
     table_meta.set_format_version(table_info->format_version());
     table_meta.set_storage_mode(table_info->storage_mode());
     table_meta.set_base_table_tid(table_info->base_table_tid());
+    if (table_info->has_storage_profile()) {
+        table_meta.mutable_storage_profile()->CopyFrom(table_info->storage_profile());
+    }
+    if (table_info->has_binlog_compression()) {
+        table_meta.set_binlog_compression(table_info->binlog_compression());
+    }
+    table_meta.set_binlog_durable(table_info->binlog_durable());
     if (table_info->has_key_entry_max_height()) {
         table_meta.set_key_entry_max_height(table_info->key_entry_max_height());
     }
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "replica/log_cache.h"
+
+namespace openmldb {
+namespace replica {
+
+LogCache::LogCache(uint32_t capacity, uint64_t max_bytes)
+    : capacity_(capacity), max_bytes_(max_bytes), enabled_(false), mu_(), entries_(), sizes_(), byte_size_(0) {}
+
+void LogCache::Append(const std::vector<std::shared_ptr<::openmldb::api::LogEntry>>& entries) {
+    if (entries.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    // the cached entries are stale if the log indexes are not consecutive
+    if (!entries_.empty() && entries_.back()->log_index() + 1 != entries.front()->log_index()) {
+        entries_.clear();
+        sizes_.clear();
+        byte_size_ = 0;
+    }
+    for (const auto& entry : entries) {
+        uint64_t size = entry->ByteSizeLong() + sizeof(::openmldb::api::LogEntry);
+        entries_.push_back(entry);
+        sizes_.push_back(size);
+        byte_size_ += size;
+    }
+    while (!entries_.empty() && (entries_.size() > capacity_ || byte_size_ > max_bytes_)) {
+        byte_size_ -= sizes_.front();
+        entries_.pop_front();
+        sizes_.pop_front();
+    }
+}
+
+void LogCache::Clear() {
+    std::lock_guard<std::mutex> lock(mu_);
+    entries_.clear();
+    sizes_.clear();
+    byte_size_ = 0;
+}
+
+uint32_t LogCache::Get(uint64_t start, uint32_t max_cnt,
+                       std::vector<std::shared_ptr<::openmldb::api::LogEntry>>* entries) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (entries_.empty() || start < entries_.front()->log_index()) {
+        return 0;
+    }
+    uint32_t cnt = 0;
+    for (uint64_t pos = start - entries_.front()->log_index(); cnt < max_cnt && pos < entries_.size();
+         pos++, cnt++) {
+        entries->push_back(entries_[pos]);
+    }
+    return cnt;
+}
+
+uint64_t LogCache::GetByteSize() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return byte_size_;
+}
+
+}  // namespace replica
+}  // namespace openmldb
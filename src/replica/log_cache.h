@@ -0,0 +1,77 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_REPLICA_LOG_CACHE_H_
+#define SRC_REPLICA_LOG_CACHE_H_
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "proto/tablet.pb.h"
+
+namespace openmldb {
+namespace replica {
+
+// LogCache keeps the latest entries appended by the leader, so the replicate
+// nodes close to the head send them without reading the binlog. The oldest
+// entries are evicted when there are more than capacity entries or they take
+// more than max_bytes. The cached entries are immutable and shared by the nodes
+class LogCache {
+ public:
+    LogCache(uint32_t capacity, uint64_t max_bytes);
+
+    LogCache(const LogCache&) = delete;
+    LogCache& operator=(const LogCache&) = delete;
+
+    // the entries are not cached if it is disabled
+    void SetEnabled(bool enabled) {
+        enabled_.store(enabled && capacity_ > 0 && max_bytes_ > 0, std::memory_order_relaxed);
+    }
+
+    // drop the cached entries, the entries may be stale after the role changes
+    void Clear();
+
+    bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // the log indexes of the entries are consecutive
+    void Append(const std::vector<std::shared_ptr<::openmldb::api::LogEntry>>& entries);
+
+    // get at most max_cnt entries from log index start, stop at the first one
+    // not cached. return the number of entries got
+    uint32_t Get(uint64_t start, uint32_t max_cnt,
+                 std::vector<std::shared_ptr<::openmldb::api::LogEntry>>* entries) const;
+
+    // the estimated memory of the cached entries
+    uint64_t GetByteSize() const;
+
+ private:
+    const uint32_t capacity_;
+    const uint64_t max_bytes_;
+    std::atomic<bool> enabled_;
+    mutable std::mutex mu_;
+    // the entries with consecutive log indexes and their sizes
+    std::deque<std::shared_ptr<::openmldb::api::LogEntry>> entries_;
+    std::deque<uint64_t> sizes_;
+    uint64_t byte_size_;
+};
+
+}  // namespace replica
+}  // namespace openmldb
+
+#endif  // SRC_REPLICA_LOG_CACHE_H_
@@ -30,17 +30,30 @@
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
+#include "bvar/bvar.h"
+#include "common/timer.h"
 #include "log/log_format.h"
 #include "storage/segment.h"
 
 DECLARE_int32(binlog_single_file_max_size);
 DECLARE_int32(binlog_name_length);
 DECLARE_string(zk_cluster);
+DECLARE_uint32(binlog_group_commit_max_entries);
+DECLARE_uint32(binlog_cache_max_entries);
+DECLARE_uint64(binlog_cache_max_bytes);
+DECLARE_string(binlog_compression);
+DECLARE_uint32(binlog_compress_flush_size);
+DECLARE_int32(binlog_heartbeat_interval);
 
 namespace openmldb {
 namespace replica {
 
 static const ::openmldb::base::DefaultComparator scmp;
+// the number of entries and the latency in microseconds of the group commits
+static bvar::LatencyRecorder g_group_commit_batch_size("binlog_group_commit_batch_size");
+static bvar::LatencyRecorder g_group_commit_latency("binlog_group_commit");
+// the latency in microseconds of the fsync for the durable writes
+static bvar::LatencyRecorder g_durable_sync_latency("binlog_durable_sync");
 
 LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path,
                              const std::map<std::string, std::string>& real_ep_map,
@@ -52,6 +65,7 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
       log_offset_(0),
       logs_(NULL),
       wh_(NULL),
+      compression_(FLAGS_binlog_compression),
       role_(role),
       real_ep_map_(real_ep_map),
       nodes_(),
@@ -59,7 +73,16 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
       term_(0),
       mu_(),
       cv_(),
-      wmu_() {
+      wmu_(),
+      apply_waiters_(0),
+      log_cache_(FLAGS_binlog_cache_max_entries, FLAGS_binlog_cache_max_bytes),
+      durable_offset_(0),
+      durable_mu_(),
+      durable_cv_(),
+      durable_waiters_(),
+      durable_syncing_(false),
+      leader_offset_(0),
+      leader_offset_time_(0) {
     binlog_index_ = 0;
     snapshot_log_part_index_.store(-1, std::memory_order_relaxed);
     snapshot_last_offset_.store(0, std::memory_order_relaxed);
@@ -67,12 +90,22 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
 }
 
 LogReplicator::~LogReplicator() {
+    {
+        // the waiters are all run before the syncer exits
+        std::unique_lock<bthread::Mutex> lock(durable_mu_);
+        while (durable_syncing_) {
+            durable_cv_.wait(lock);
+        }
+    }
     DelAllReplicateNode();
     if (logs_ != NULL) {
         logs_->Clear();
     }
     delete logs_;
     logs_ = NULL;
+    if (wh_ != NULL && !wh_->Flush().ok()) {
+        PDLOG(WARNING, "fail to write the buffered records of binlog for path %s", path_.c_str());
+    }
     delete wh_;
     wh_ = NULL;
     nodes_.clear();
@@ -81,15 +114,27 @@ LogReplicator::~LogReplicator() {
 void LogReplicator::SetRole(const ReplicatorRole& role) {
     std::lock_guard<bthread::Mutex> lock(mu_);
     role_ = role;
+    log_cache_.Clear();
+}
+
+void LogReplicator::SetCompression(const std::string& compression) {
+    std::lock_guard<std::mutex> lock(wmu_);
+    compression_ = compression;
 }
 
 void LogReplicator::SyncToDisk() {
     std::lock_guard<std::mutex> lock(wmu_);
     if (wh_ != NULL) {
         uint64_t consumed = ::baidu::common::timer::get_micros();
+        uint64_t offset = log_offset_.load(std::memory_order_relaxed);
+        if (!FlushWLogFile()) {
+            return;
+        }
         ::openmldb::log::Status status = wh_->Sync();
         if (!status.ok()) {
             PDLOG(WARNING, "fail to sync data for path %s", path_.c_str());
+        } else {
+            UpdateDurableOffset(offset);
         }
         consumed = ::baidu::common::timer::get_micros() - consumed;
         if (consumed > 20000) {
@@ -98,6 +143,93 @@ void LogReplicator::SyncToDisk() {
     }
 }
 
+static void* RunDurableSync(void* args) {
+    static_cast<LogReplicator*>(args)->SyncDurable();
+    return NULL;
+}
+
+void LogReplicator::WaitDurable(uint64_t log_index, std::function<void(bool)> callback) {
+    if (log_index <= durable_offset_.load(std::memory_order_relaxed)) {
+        callback(true);
+        return;
+    }
+    {
+        std::lock_guard<bthread::Mutex> lock(durable_mu_);
+        durable_waiters_.emplace_back(log_index, std::move(callback));
+        if (durable_syncing_) {
+            return;
+        }
+        durable_syncing_ = true;
+    }
+    bthread_t tid;
+    if (bthread_start_background(&tid, NULL, RunDurableSync, this) != 0) {
+        PDLOG(WARNING, "fail to start bthread, sync binlog in place. tid %u pid %u", tid_, pid_);
+        SyncDurable();
+    }
+}
+
+void LogReplicator::SyncDurable() {
+    std::unique_lock<bthread::Mutex> lock(durable_mu_);
+    while (!durable_waiters_.empty()) {
+        // the entries of the waiters are written, the ones come during the
+        // sync wait for the next round
+        std::vector<std::pair<uint64_t, std::function<void(bool)>>> waiters;
+        waiters.swap(durable_waiters_);
+        lock.unlock();
+        bool ok = SyncBinlog();
+        uint64_t durable_offset = durable_offset_.load(std::memory_order_relaxed);
+        for (auto& waiter : waiters) {
+            waiter.second(ok && waiter.first <= durable_offset);
+        }
+        lock.lock();
+    }
+    durable_syncing_ = false;
+    durable_cv_.notify_all();
+}
+
+bool LogReplicator::SyncBinlog() {
+    uint64_t offset = 0;
+    int fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(wmu_);
+        offset = log_offset_.load(std::memory_order_relaxed);
+        if (wh_ == NULL) {
+            UpdateDurableOffset(offset);
+            return true;
+        }
+        if (!FlushWLogFile()) {
+            return false;
+        }
+        // the records are flushed to the file by the writer, the file may be
+        // rolled while syncing, so it is synced through another descriptor
+        fd = dup(fileno(wh_->fd_));
+    }
+    if (fd < 0) {
+        PDLOG(WARNING, "fail to dup binlog fd for path %s, errno %d", path_.c_str(), errno);
+        return false;
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+#if __linux__
+    int ret = fdatasync(fd);
+#else
+    int ret = fsync(fd);
+#endif
+    close(fd);
+    if (ret != 0) {
+        PDLOG(WARNING, "fail to sync binlog for path %s, errno %d", path_.c_str(), errno);
+        return false;
+    }
+    UpdateDurableOffset(offset);
+    g_durable_sync_latency << ::baidu::common::timer::get_micros() - consumed;
+    return true;
+}
+
+void LogReplicator::UpdateDurableOffset(uint64_t offset) {
+    uint64_t cur = durable_offset_.load(std::memory_order_relaxed);
+    while (cur < offset && !durable_offset_.compare_exchange_weak(cur, offset, std::memory_order_relaxed)) {
+    }
+}
+
 bool LogReplicator::Init() {
     logs_ = new LogParts(12, 4, scmp);
     log_path_ = path_ + "/binlog/";
@@ -109,7 +241,8 @@ bool LogReplicator::Init() {
         for (const auto& kv : real_ep_map_) {
             std::shared_ptr<ReplicateNode> replicate_node =
                 std::make_shared<ReplicateNode>(kv.first, logs_, log_path_, tid_, pid_, &term_,
-                                                &log_offset_, &mu_, &cv_, false, &follower_offset_, kv.second);
+                                                &log_offset_, &mu_, &cv_, false, &follower_offset_, kv.second,
+                                                &log_cache_);
             if (replicate_node->Init() < 0) {
                 PDLOG(WARNING, "init replicate node %s error", kv.first.c_str());
                 return false;
@@ -118,6 +251,7 @@ bool LogReplicator::Init() {
             local_endpoints_.push_back(kv.first);
             PDLOG(INFO, "add replica node with endpoint %s", kv.first.c_str());
         }
+        log_cache_.SetEnabled(!nodes_.empty());
         PDLOG(INFO, "init leader node for path %s ok", path_.c_str());
     }
     if (!Recover()) {
@@ -289,7 +423,40 @@ uint64_t LogReplicator::GetLeaderTerm() { return term_.load(std::memory_order_re
 
 void LogReplicator::SetLeaderTerm(uint64_t term) { term_.store(term, std::memory_order_relaxed); }
 
+void LogReplicator::SetLeaderOffset(uint64_t offset) {
+    leader_offset_.store(offset, std::memory_order_relaxed);
+    leader_offset_time_.store(::baidu::common::timer::get_micros(), std::memory_order_relaxed);
+}
+
+bool LogReplicator::IsReadable(uint64_t max_lag) {
+    uint64_t heard_time = leader_offset_time_.load(std::memory_order_relaxed);
+    // a heartbeat may be late, but the leader is gone if two are missed
+    uint64_t timeout = static_cast<uint64_t>(FLAGS_binlog_heartbeat_interval) * 2 * 1000;
+    if (heard_time == 0 || ::baidu::common::timer::get_micros() > heard_time + timeout) {
+        return false;
+    }
+    uint64_t leader_offset = leader_offset_.load(std::memory_order_relaxed);
+    uint64_t offset = GetOffset();
+    return leader_offset <= offset || leader_offset - offset <= max_lag;
+}
+
 bool LogReplicator::ApplyEntry(const LogEntry& entry) {
+    return ApplyEntries(std::vector<const LogEntry*>{&entry});
+}
+
+bool LogReplicator::ApplyEntries(const std::vector<const LogEntry*>& entries) {
+    std::vector<std::string> buffers(entries.size());
+    std::vector<::openmldb::base::Slice> records;
+    records.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i]->SerializeToString(&buffers[i]);
+        records.emplace_back(buffers[i]);
+    }
+    return ApplyRecords(entries, records);
+}
+
+bool LogReplicator::ApplyRecords(const std::vector<const LogEntry*>& entries,
+                                 const std::vector<::openmldb::base::Slice>& records) {
     std::lock_guard<std::mutex> lock(wmu_);
     uint64_t last_log_offset = GetOffset();
     if (wh_ == NULL || (wh_->GetSize() / (1024 * 1024)) > (uint32_t)FLAGS_binlog_single_file_max_size) {
@@ -298,24 +465,59 @@ bool LogReplicator::ApplyEntry(const LogEntry& entry) {
             return false;
         }
     }
-    if (entry.log_index() <= last_log_offset) {
-        PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u",
-                entry.log_index(), last_log_offset, tid_, pid_);
+    std::vector<::openmldb::base::Slice> slices;
+    slices.reserve(records.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i]->log_index() <= last_log_offset) {
+            PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u",
+                    entries[i]->log_index(), last_log_offset, tid_, pid_);
+            continue;
+        }
+        slices.push_back(records[i]);
+        last_log_offset = entries[i]->log_index();
+    }
+    if (slices.empty()) {
         return true;
     }
-    std::string buffer;
-    entry.SerializeToString(&buffer);
-    ::openmldb::base::Slice slice(buffer.c_str(), buffer.size());
-    ::openmldb::log::Status status = wh_->Write(slice);
+    uint64_t last_size = wh_->GetSize();
+    ::openmldb::log::Status status = wh_->Write(slices);
     if (!status.ok()) {
         PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
+        // the leader sends the entries again from the last offset
+        if (!TruncateWLogFile(last_size)) {
+            PDLOG(WARNING, "fail to truncate %s to %lu, roll a new file. tid %u pid %u", wh_path_.c_str(), last_size,
+                  tid_, pid_);
+        }
         return false;
     }
-    log_offset_.store(entry.log_index(), std::memory_order_relaxed);
+    log_offset_.store(last_log_offset, std::memory_order_relaxed);
     DEBUGLOG("sync log entry to offset %lu for %s", GetOffset(), path_.c_str());
+    if (apply_waiters_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<bthread::Mutex> lock(apply_mu_);
+        apply_cv_.notify_all();
+    }
     return true;
 }
 
+bool LogReplicator::WaitOffset(uint64_t offset, uint32_t timeout_ms) {
+    if (GetOffset() >= offset) {
+        return true;
+    }
+    apply_waiters_.fetch_add(1, std::memory_order_relaxed);
+    uint64_t deadline = ::baidu::common::timer::get_micros() + static_cast<uint64_t>(timeout_ms) * 1000;
+    std::unique_lock<bthread::Mutex> lock(apply_mu_);
+    while (GetOffset() < offset) {
+        uint64_t now = ::baidu::common::timer::get_micros();
+        if (now >= deadline) {
+            break;
+        }
+        // wake up in a while in case the notification is missed
+        apply_cv_.wait_for(lock, std::min(deadline - now, static_cast<uint64_t>(1000)));
+    }
+    apply_waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return GetOffset() >= offset;
+}
+
 int LogReplicator::AddReplicateNode(const std::map<std::string, std::string>& real_ep_map) {
     return AddReplicateNode(real_ep_map, UINT32_MAX);
 }
@@ -329,6 +531,15 @@ int LogReplicator::AddReplicateNode(const std::map<std::string, std::string>& re
         PDLOG(WARNING, "cur table is not leader, cannot add replicate");
         return -1;
     }
+    {
+        // the new nodes read the records buffered by a compressed binlog from
+        // the file, and the records written later from the cache
+        log_cache_.SetEnabled(true);
+        std::lock_guard<std::mutex> wlock(wmu_);
+        if (wh_ != NULL) {
+            FlushWLogFile();
+        }
+    }
     for (const auto& kv : real_ep_map) {
         const std::string& endpoint = kv.first;
         std::vector<std::shared_ptr<ReplicateNode>>::iterator it = nodes_.begin();
@@ -336,6 +547,7 @@ int LogReplicator::AddReplicateNode(const std::map<std::string, std::string>& re
             std::string ep = (*it)->GetEndPoint();
             if (ep.compare(endpoint) == 0) {
                 PDLOG(WARNING, "replica endpoint %s does exist", ep.c_str());
+                log_cache_.SetEnabled(!nodes_.empty());
                 return 1;
             }
         }
@@ -343,18 +555,21 @@ int LogReplicator::AddReplicateNode(const std::map<std::string, std::string>& re
         if (tid == UINT32_MAX) {
             replicate_node =
                 std::make_shared<ReplicateNode>(endpoint, logs_, log_path_, tid_, pid_, &term_,
-                                                &log_offset_, &mu_, &cv_, false, &follower_offset_, kv.second);
+                                                &log_offset_, &mu_, &cv_, false, &follower_offset_, kv.second,
+                                                &log_cache_);
         } else {
             replicate_node =
                 std::make_shared<ReplicateNode>(endpoint, logs_, log_path_, tid, pid_, &term_, &log_offset_,
-                                                &mu_, &cv_, true, &follower_offset_, kv.second);
+                                                &mu_, &cv_, true, &follower_offset_, kv.second, &log_cache_);
         }
         if (replicate_node->Init() < 0) {
             PDLOG(WARNING, "init replicate node %s error", endpoint.c_str());
+            log_cache_.SetEnabled(!nodes_.empty());
             return -1;
         }
         if (replicate_node->Start() != 0) {
             PDLOG(WARNING, "fail to start sync thread for table #tid %u, #pid %u", tid_, pid_);
+            log_cache_.SetEnabled(!nodes_.empty());
             return -1;
         }
         nodes_.push_back(replicate_node);
@@ -387,6 +602,10 @@ int LogReplicator::DelReplicateNode(const std::string& endpoint) {
         }
         node = *it;
         nodes_.erase(it);
+        if (nodes_.empty()) {
+            log_cache_.SetEnabled(false);
+            log_cache_.Clear();
+        }
         real_ep_map_.erase(endpoint);
         local_endpoints_.erase(std::remove(local_endpoints_.begin(), local_endpoints_.end(), endpoint),
                                local_endpoints_.end());
@@ -423,6 +642,8 @@ bool LogReplicator::DelAllReplicateNode() {
         nodes_.clear();
         real_ep_map_.clear();
         local_endpoints_.clear();
+        log_cache_.SetEnabled(false);
+        log_cache_.Clear();
     }
     std::vector<std::shared_ptr<ReplicateNode>>::iterator it = copied_nodes.begin();
     for (; it != copied_nodes.end(); ++it) {
@@ -433,38 +654,197 @@ bool LogReplicator::DelAllReplicateNode() {
     return true;
 }
 
+struct LogReplicator::AppendTask {
+    AppendTask(LogEntry* e, ::google::protobuf::Closure* c, bthread::ConditionVariable* v)
+        : entry(e), done(c), ok(false), finished(false), cv(v) {}
+    LogEntry* entry;
+    ::google::protobuf::Closure* done;
+    // the entry serialized without the log index
+    std::string buffer;
+    bool ok;
+    bool finished;
+    // shared by the tasks of an append
+    bthread::ConditionVariable* cv;
+};
+
 bool LogReplicator::AppendEntry(LogEntry& entry, ::google::protobuf::Closure* done) {
+    bthread::ConditionVariable cv;
+    std::vector<AppendTask> tasks;
+    tasks.emplace_back(&entry, done, &cv);
+    return Append(&tasks);
+}
+
+bool LogReplicator::AppendEntries(std::vector<LogEntry>* entries, ::google::protobuf::Closure* done) {
+    if (entries->empty()) {
+        return true;
+    }
+    bthread::ConditionVariable cv;
+    std::vector<AppendTask> tasks;
+    tasks.reserve(entries->size());
+    for (auto& entry : *entries) {
+        tasks.emplace_back(&entry, nullptr, &cv);
+    }
+    // the entries are queued together, so done runs after all of them are written
+    tasks.back().done = done;
+    return Append(&tasks);
+}
+
+bool LogReplicator::Append(std::vector<AppendTask>* tasks) {
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    // the leader of the group appends the log index field to the serialized
+    // entry, a field parsed later overrides the former one
+    for (auto& task : *tasks) {
+        task.entry->clear_log_index();
+        task.entry->SerializeToString(&task.buffer);
+    }
+    bthread::ConditionVariable* cv = tasks->front().cv;
+    const AppendTask& last = tasks->back();
+    uint32_t max_batch = std::max(FLAGS_binlog_group_commit_max_entries, 1u);
+    std::unique_lock<bthread::Mutex> lock(append_mu_);
+    for (auto& task : *tasks) {
+        append_queue_.push_back(&task);
+    }
+    while (!last.finished) {
+        if (append_queue_.front()->cv != cv) {
+            cv->wait(lock);
+            continue;
+        }
+        // the task at the front writes the entries queued so far as a group
+        std::vector<AppendTask*> batch;
+        for (auto it = append_queue_.begin(); it != append_queue_.end() && batch.size() < max_batch; ++it) {
+            batch.push_back(*it);
+        }
+        lock.unlock();
+        WriteBatch(batch);
+        g_group_commit_batch_size << batch.size();
+        lock.lock();
+        for (auto t : batch) {
+            append_queue_.pop_front();
+            t->finished = true;
+            if (t->cv != cv) {
+                t->cv->notify_one();
+            }
+        }
+        if (!append_queue_.empty() && append_queue_.front()->cv != cv) {
+            append_queue_.front()->cv->notify_one();
+        }
+    }
+    lock.unlock();
+    g_group_commit_latency << ::baidu::common::timer::get_micros() - start_time;
+    for (const auto& task : *tasks) {
+        if (!task.ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LogReplicator::WriteBatch(const std::vector<AppendTask*>& batch) {
     std::lock_guard<std::mutex> lock(wmu_);
     if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
         bool ok = RollWLogFile();
         if (!ok) {
-            return false;
+            return;
         }
     }
     uint64_t cur_offset = log_offset_.load(std::memory_order_relaxed);
-    entry.set_log_index(1 + cur_offset);
-    std::string buffer;
-    entry.SerializeToString(&buffer);
-    ::openmldb::base::Slice slice(buffer);
-    ::openmldb::log::Status status = wh_->Write(slice);
+    // the size of the records written completely
+    uint64_t last_size = wh_->GetSize();
+    std::vector<::openmldb::base::Slice> slices;
+    slices.reserve(batch.size());
+    for (auto task : batch) {
+        cur_offset++;
+        task->entry->set_log_index(cur_offset);
+        // the varint of field log_index
+        task->buffer.push_back(static_cast<char>(LogEntry::kLogIndexFieldNumber << 3));
+        uint64_t value = cur_offset;
+        while (value >= 0x80) {
+            task->buffer.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        task->buffer.push_back(static_cast<char>(value));
+        slices.emplace_back(task->buffer);
+    }
+    ::openmldb::log::Status status = wh_->Write(slices);
     if (!status.ok()) {
         PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
-        return false;
+        // a part of the batch may be in the file, the indexes are written again by the next batch
+        if (!TruncateWLogFile(last_size)) {
+            PDLOG(WARNING, "fail to truncate %s to %lu, roll a new file. tid %u pid %u", wh_path_.c_str(), last_size,
+                  tid_, pid_);
+        }
+        return;
+    }
+    if (log_cache_.IsEnabled()) {
+        std::vector<std::shared_ptr<LogEntry>> entries;
+        entries.reserve(batch.size());
+        for (auto task : batch) {
+            entries.push_back(std::make_shared<LogEntry>(*task->entry));
+        }
+        log_cache_.Append(entries);
     }
-    log_offset_.fetch_add(1, std::memory_order_relaxed);
+    log_offset_.store(cur_offset, std::memory_order_relaxed);
     if (local_endpoints_.empty()) {  // if local replica are dead, leader direct
                                      // sync to remote replica
-        follower_offset_.store(cur_offset + 1, std::memory_order_relaxed);
+        follower_offset_.store(cur_offset, std::memory_order_relaxed);
+    }
+    // Aggregator relies on the closures running in the order of log index
+    for (auto task : batch) {
+        task->ok = true;
+        if (task->done) {
+            task->done->Run();
+        }
+    }
+}
+
+bool LogReplicator::FlushWLogFile() {
+    uint64_t last_size = wh_->GetSize();
+    ::openmldb::log::Status status = wh_->Flush();
+    if (status.ok()) {
+        return true;
+    }
+    PDLOG(WARNING, "fail to write the buffered records of binlog in dir %s for %s", path_.c_str(),
+          status.ToString().c_str());
+    if (!TruncateWLogFile(last_size)) {
+        PDLOG(WARNING, "fail to truncate %s to %lu, roll a new file. tid %u pid %u", wh_path_.c_str(), last_size, tid_,
+              pid_);
+    }
+    return false;
+}
+
+bool LogReplicator::TruncateWLogFile(uint64_t size) {
+    // the records buffered before the failed write are written to the reopened file later
+    std::string buffered = wh_->GetBuffered().ToString();
+    // closing the file flushes the buffered part of the batch before it is truncated
+    delete wh_;
+    wh_ = NULL;
+    if (truncate(wh_path_.c_str(), size) != 0) {
+        PDLOG(WARNING, "fail to truncate %s: %s", wh_path_.c_str(), strerror(errno));
+        return false;
     }
-    if (done) {
-        done->Run();
+    FILE* fd = fopen(wh_path_.c_str(), "ab+");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open file %s", wh_path_.c_str());
+        return false;
     }
+    wh_ = new WriteHandle(compression_, wh_path_, fd, size);
+    wh_->SetFlushSize(FLAGS_binlog_compress_flush_size);
+    wh_->SetBuffered(Slice(buffered));
+    PDLOG(INFO, "truncate %s to %lu for the failed write. tid %u pid %u", wh_path_.c_str(), size, tid_, pid_);
     return true;
 }
 
 bool LogReplicator::RollWLogFile() {
     if (wh_ != NULL) {
+        // keep the buffered records in the file to roll
+        if (!FlushWLogFile()) {
+            return false;
+        }
         wh_->EndLog();
+        // the durable writes only sync the latest file
+        if (!wh_->Sync().ok()) {
+            PDLOG(WARNING, "fail to sync binlog for path %s", path_.c_str());
+        }
         delete wh_;
         wh_ = NULL;
     }
@@ -477,11 +857,22 @@ bool LogReplicator::RollWLogFile() {
         PDLOG(WARNING, "fail to create file %s", full_path.c_str());
         return false;
     }
+    wh_ = new WriteHandle(compression_, full_path, fd);
+    wh_->SetFlushSize(FLAGS_binlog_compress_flush_size);
+    wh_path_ = full_path;
+    // the readers know the format once the file is in logs_
+    ::openmldb::log::Status status = wh_->BeginLog();
+    if (!status.ok()) {
+        PDLOG(WARNING, "fail to write header of file %s for %s", full_path.c_str(), status.ToString().c_str());
+        delete wh_;
+        wh_ = NULL;
+        return false;
+    }
     uint64_t offset = log_offset_.load(std::memory_order_relaxed);
     logs_->Insert(binlog_index_.load(std::memory_order_relaxed), offset);
     binlog_index_.fetch_add(1, std::memory_order_relaxed);
-    PDLOG(INFO, "roll write log for name %s and start offset %lld. tid %u pid %u", name.c_str(), offset, tid_, pid_);
-    wh_ = new WriteHandle("off", name, fd);
+    PDLOG(INFO, "roll write log for name %s and start offset %lld, compression %s. tid %u pid %u", name.c_str(),
+          offset, compression_.c_str(), tid_, pid_);
     return true;
 }
 
@@ -19,6 +19,8 @@
 
 #include <atomic>
 #include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -33,6 +35,7 @@
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "replica/log_cache.h"
 #include "replica/replicate_node.h"
 #include "storage/table.h"
 
@@ -63,9 +66,23 @@ class LogReplicator {
     // the slave node receives master log entries
     bool ApplyEntry(const ::openmldb::api::LogEntry& entry);
 
+    // write the entries received in one batch to binlog at once
+    bool ApplyEntries(const std::vector<const ::openmldb::api::LogEntry*>& entries);
+
+    // the same as ApplyEntries, records are the serialized entries received
+    bool ApplyRecords(const std::vector<const ::openmldb::api::LogEntry*>& entries,
+                      const std::vector<::openmldb::base::Slice>& records);
+
     // the master node append entry
     bool AppendEntry(::openmldb::api::LogEntry& entry, ::google::protobuf::Closure* done = nullptr);  // NOLINT
 
+    // append the entries with consecutive log indexes, done runs once after the last one is written
+    bool AppendEntries(std::vector<::openmldb::api::LogEntry>* entries, ::google::protobuf::Closure* done = nullptr);
+
+    // wait until the entries up to offset are applied, return false on timeout.
+    // the pipelined batches of the leader may be handled out of order
+    bool WaitOffset(uint64_t offset, uint32_t timeout_ms);
+
     //  data to slave nodes
     void Notify();
     // recover logs meta
@@ -90,6 +107,23 @@ class LogReplicator {
 
     // Sync Write Buffer to Disk
     void SyncToDisk();
+
+    // run callback once the binlog up to log_index is synced to disk, the
+    // waiters share one fsync. It is run at once if the entry is synced already
+    void WaitDurable(uint64_t log_index, std::function<void(bool)> callback);
+
+    // sync the binlog for the waiters until there is none, see WaitDurable
+    void SyncDurable();
+
+    uint64_t GetDurableOffset() const { return durable_offset_.load(std::memory_order_relaxed); }
+
+    // the follower records the log offset of the leader sent with AppendEntries
+    void SetLeaderOffset(uint64_t offset);
+
+    // true if the follower is behind the leader by no more than max_lag entries
+    // and has heard from the leader lately, the idle leader sends heartbeats
+    bool IsReadable(uint64_t max_lag);
+
     void SetOffset(uint64_t offset);
 
     uint64_t GetOffset();
@@ -110,9 +144,32 @@ class LogReplicator {
 
     const std::string& GetLogPath() {return log_path_;}
 
+    // the compression of the binlog files created later, can be off, snappy, zlib
+    void SetCompression(const std::string& compression);
+
  private:
+    struct AppendTask;
+
     bool OpenSeqFile(const std::string& path, SequentialFile** sf);
 
+    // queue the tasks for the group commit and wait until they are written
+    bool Append(std::vector<AppendTask>* tasks);
+
+    // write the entries of a group commit in one batch, then run the closures in order
+    void WriteBatch(const std::vector<AppendTask*>& batch);
+
+    // drop the records of a failed write by truncating the binlog file to the
+    // size before it and reopening it, so no log index is written twice
+    bool TruncateWLogFile(uint64_t size);
+    // write the records buffered by the writer of a compressed binlog, the file
+    // is truncated like a failed write if it fails
+    bool FlushWLogFile();
+
+    // fsync the binlog file written without blocking the writers, return false if it fails
+    bool SyncBinlog();
+
+    void UpdateDurableOffset(uint64_t offset);
+
  private:
     // the replicator root data path
     uint32_t tid_;
@@ -125,6 +182,8 @@ class LogReplicator {
     std::atomic<uint32_t> binlog_index_;
     LogParts* logs_;
     WriteHandle* wh_;
+    std::string wh_path_;
+    std::string compression_;
     ReplicatorRole role_;
     std::map<std::string, std::string> real_ep_map_;
     std::vector<std::shared_ptr<ReplicateNode> > nodes_;
@@ -139,6 +198,25 @@ class LogReplicator {
     std::atomic<uint64_t> snapshot_last_offset_;
 
     std::mutex wmu_;
+    // the entries waiting for the group commit, the front one writes the group
+    bthread::Mutex append_mu_;
+    std::deque<AppendTask*> append_queue_;
+    // the AppendEntries waiting for the previous batch
+    std::atomic<uint32_t> apply_waiters_;
+    bthread::Mutex apply_mu_;
+    bthread::ConditionVariable apply_cv_;
+    // the latest entries for the replicate nodes, enabled if there are nodes
+    LogCache log_cache_;
+    // the offset synced to disk
+    std::atomic<uint64_t> durable_offset_;
+    bthread::Mutex durable_mu_;
+    bthread::ConditionVariable durable_cv_;
+    std::vector<std::pair<uint64_t, std::function<void(bool)>>> durable_waiters_;
+    // true if a bthread runs SyncDurable
+    bool durable_syncing_;
+    // the log offset of the leader and the time in microseconds it is received
+    std::atomic<uint64_t> leader_offset_;
+    std::atomic<uint64_t> leader_offset_time_;
 };
 
 }  // namespace replica
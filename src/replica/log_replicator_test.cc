@@ -16,6 +16,7 @@
 
 #include "replica/log_replicator.h"
 #include <absl/cleanup/cleanup.h>
+#include <absl/strings/str_split.h>
 #include <brpc/server.h>
 #include <gtest/gtest.h>
 #include <sched.h>
@@ -24,14 +25,21 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <filesystem>
+#include <future>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "base/glog_wrapper.h"
 #include "base/status.h"
 #include "common/thread_pool.h"
 #include "common/timer.h"
 #include "proto/tablet.pb.h"
+#include "replica/log_cache.h"
 #include "replica/replicate_node.h"
 #include "storage/mem_table.h"
 #include "storage/segment.h"
@@ -48,6 +56,9 @@ using ::openmldb::storage::TableIterator;
 using ::openmldb::storage::Ticket;
 
 DECLARE_int32(binlog_single_file_max_size);
+DECLARE_int32(binlog_sync_batch_size);
+DECLARE_uint32(binlog_sync_max_inflight);
+DECLARE_int32(binlog_heartbeat_interval);
 
 namespace openmldb {
 namespace replica {
@@ -62,7 +73,10 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
           role_(role),
           path_(path),
           real_ep_map_(real_ep_map),
-          replicator_(table->GetId(), table->GetPid(), path_, real_ep_map_, role_) {}
+          replicator_(table->GetId(), table->GetPid(), path_, real_ep_map_, role_),
+          delay_ms_(0),
+          inflight_(0),
+          max_inflight_(0) {}
 
     ~MockTabletImpl() {}
     bool Init() {
@@ -85,7 +99,30 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
 
     void AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                        ::openmldb::api::AppendEntriesResponse* response, Closure* done) {
+        if (request->entries_size() > 0) {
+            uint32_t inflight = inflight_.fetch_add(1) + 1;
+            uint32_t max_inflight = max_inflight_.load();
+            while (inflight > max_inflight && !max_inflight_.compare_exchange_weak(max_inflight, inflight)) {
+            }
+        }
+        absl::Cleanup dec = [this, request]() {
+            if (request->entries_size() > 0) {
+                inflight_.fetch_sub(1);
+            }
+        };
+        if (delay_ms_ > 0) {
+            bthread_usleep(delay_ms_ * 1000);
+        }
         uint64_t last_log_offset = replicator_.GetOffset();
+        if (request->entries_size() > 0 && request->pre_log_index() > last_log_offset) {
+            if (!replicator_.WaitOffset(request->pre_log_index(), 100)) {
+                response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+                response->set_msg("log offset mismatch");
+                done->Run();
+                return;
+            }
+            last_log_offset = replicator_.GetOffset();
+        }
         for (int32_t i = 0; i < request->entries_size(); i++) {
             if (request->entries(i).log_index() <= last_log_offset) {
                 continue;
@@ -97,6 +134,10 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
                 return;
             }
             table_->Put(entry);
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                applied_.push_back(entry.log_index());
+            }
         }
         response->set_log_offset(replicator_.GetOffset());
         done->Run();
@@ -107,6 +148,20 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
 
     bool GetMode() { return follower_.load(std::memory_order_relaxed); }
 
+    // the artificial latency of AppendEntries
+    void SetDelay(uint32_t delay_ms) { delay_ms_ = delay_ms; }
+
+    uint64_t GetOffset() { return replicator_.GetOffset(); }
+
+    // the log indexes in the order they are applied
+    std::vector<uint64_t> GetApplied() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return applied_;
+    }
+
+    // the most AppendEntries with entries handled at the same time
+    uint32_t GetMaxInflight() { return max_inflight_.load(); }
+
  private:
     std::shared_ptr<Table> table_;
     ReplicatorRole role_;
@@ -114,6 +169,11 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
     std::map<std::string, std::string> real_ep_map_;
     LogReplicator replicator_;
     std::atomic<bool> follower_;
+    uint32_t delay_ms_;
+    std::atomic<uint32_t> inflight_;
+    std::atomic<uint32_t> max_inflight_;
+    std::mutex mu_;
+    std::vector<uint64_t> applied_;
 };
 
 bool ReceiveEntry(const ::openmldb::api::LogEntry& entry) { return true; }
@@ -222,6 +282,273 @@ TEST_F(LogReplicatorTest, LogReader) {
     }
 }
 
+TEST_F(LogReplicatorTest, GroupCommit) {
+    std::map<std::string, std::string> map;
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / GenRand();
+    absl::Cleanup clean = [&folder]() { std::filesystem::remove_all(folder); };
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    ASSERT_TRUE(replicator.Init());
+    class IndexClosure : public Closure {
+     public:
+        IndexClosure(const ::openmldb::api::LogEntry* entry, std::vector<uint64_t>* indexes)
+            : entry_(entry), indexes_(indexes) {}
+        void Run() override { indexes_->push_back(entry_->log_index()); }
+
+     private:
+        const ::openmldb::api::LogEntry* entry_;
+        std::vector<uint64_t>* indexes_;
+    };
+    int thread_num = 8;
+    int num = 1000;
+    // the closures run one by one in the order of log index
+    std::vector<uint64_t> indexes;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < num; i++) {
+                ::openmldb::api::LogEntry entry;
+                entry.set_term(1);
+                entry.set_pk(absl::StrCat("key", t, "_", i));
+                entry.set_value("value");
+                entry.set_ts(9527);
+                IndexClosure closure(&entry, &indexes);
+                ASSERT_TRUE(replicator.AppendEntry(entry, &closure));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    uint64_t total = thread_num * num;
+    ASSERT_EQ(total, replicator.GetLogOffset());
+    ASSERT_EQ(total, indexes.size());
+    for (uint64_t i = 0; i < total; i++) {
+        ASSERT_EQ(i + 1, indexes[i]);
+    }
+    LogReader reader(replicator.GetLogPart(), replicator.GetLogPath(), false);
+    ASSERT_TRUE(reader.SetOffset(0));
+    std::map<int, int> next;
+    std::string buffer;
+    for (uint64_t i = 0; i < total; i++) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ASSERT_TRUE(reader.ReadNextRecord(&record, &buffer).ok());
+        ::openmldb::api::LogEntry entry;
+        ASSERT_TRUE(entry.ParseFromString(record.ToString()));
+        ASSERT_EQ(i + 1, entry.log_index());
+        // the entries of a thread are in order
+        std::vector<std::string> parts = absl::StrSplit(entry.pk().substr(3), "_");
+        int t = std::stoi(parts[0]);
+        ASSERT_EQ(next[t]++, std::stoi(parts[1]));
+    }
+}
+
+TEST_F(LogReplicatorTest, FollowerReadable) {
+    std::map<std::string, std::string> map;
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / GenRand();
+    absl::Cleanup clean = [&folder]() { std::filesystem::remove_all(folder); };
+    LogReplicator replicator(1, 1, folder, map, kFollowerNode);
+    ASSERT_TRUE(replicator.Init());
+    // never heard from the leader
+    ASSERT_FALSE(replicator.IsReadable(10));
+    ::openmldb::api::LogEntry entry;
+    entry.set_term(1);
+    entry.set_pk("key");
+    entry.set_value("value");
+    entry.set_ts(9527);
+    for (int i = 1; i <= 5; i++) {
+        entry.set_log_index(i);
+        ASSERT_TRUE(replicator.ApplyEntry(entry));
+    }
+    replicator.SetLeaderOffset(20);
+    ASSERT_TRUE(replicator.IsReadable(15));
+    ASSERT_FALSE(replicator.IsReadable(10));
+    replicator.SetLeaderOffset(5);
+    ASSERT_TRUE(replicator.IsReadable(1));
+    // the leader is gone if the heartbeats are missed
+    int32_t heartbeat_interval = FLAGS_binlog_heartbeat_interval;
+    FLAGS_binlog_heartbeat_interval = 10;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_FALSE(replicator.IsReadable(1));
+    FLAGS_binlog_heartbeat_interval = heartbeat_interval;
+}
+
+TEST_F(LogReplicatorTest, DurableWrite) {
+    std::map<std::string, std::string> map;
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / GenRand();
+    absl::Cleanup clean = [&folder]() { std::filesystem::remove_all(folder); };
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    ASSERT_TRUE(replicator.Init());
+    int thread_num = 8;
+    int num = 200;
+    std::atomic<int> succ_cnt(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < num; i++) {
+                ::openmldb::api::LogEntry entry;
+                entry.set_term(1);
+                entry.set_pk(absl::StrCat("key", t, "_", i));
+                entry.set_value("value");
+                entry.set_ts(9527);
+                ASSERT_TRUE(replicator.AppendEntry(entry));
+                // the callback runs after the entry is synced
+                std::promise<bool> synced;
+                replicator.WaitDurable(entry.log_index(), [&replicator, &synced, &entry](bool ok) {
+                    synced.set_value(ok && replicator.GetDurableOffset() >= entry.log_index());
+                });
+                if (synced.get_future().get()) {
+                    succ_cnt++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    uint64_t total = thread_num * num;
+    ASSERT_EQ(thread_num * num, succ_cnt.load());
+    ASSERT_EQ(total, replicator.GetDurableOffset());
+    // the entries synced by SyncToDisk are durable
+    ::openmldb::api::LogEntry entry;
+    entry.set_term(1);
+    entry.set_pk("key");
+    entry.set_value("value");
+    entry.set_ts(9527);
+    ASSERT_TRUE(replicator.AppendEntry(entry));
+    replicator.SyncToDisk();
+    ASSERT_EQ(total + 1, replicator.GetDurableOffset());
+    bool ok = false;
+    replicator.WaitDurable(total + 1, [&ok](bool synced) { ok = synced; });
+    ASSERT_TRUE(ok);
+}
+
+TEST_F(LogReplicatorTest, LogCache) {
+    LogCache cache(8, UINT64_MAX);
+    cache.SetEnabled(true);
+    ASSERT_TRUE(cache.IsEnabled());
+    std::vector<std::shared_ptr<::openmldb::api::LogEntry>> entries;
+    for (uint64_t i = 1; i <= 10; i++) {
+        auto entry = std::make_shared<::openmldb::api::LogEntry>();
+        entry->set_log_index(i);
+        entries.push_back(entry);
+    }
+    cache.Append(entries);
+    std::vector<std::shared_ptr<::openmldb::api::LogEntry>> cached;
+    // the first two are overwritten
+    ASSERT_EQ(0u, cache.Get(1, 5, &cached));
+    ASSERT_EQ(5u, cache.Get(3, 5, &cached));
+    ASSERT_EQ(3u, cached.front()->log_index());
+    ASSERT_EQ(entries[2].get(), cached.front().get());
+    cached.clear();
+    ASSERT_EQ(8u, cache.Get(3, 32, &cached));
+    ASSERT_EQ(10u, cached.back()->log_index());
+    cached.clear();
+    ASSERT_EQ(0u, cache.Get(11, 32, &cached));
+    cache.Clear();
+    ASSERT_EQ(0u, cache.Get(3, 32, &cached));
+    ASSERT_EQ(0u, cache.GetByteSize());
+    LogCache disabled(0, UINT64_MAX);
+    disabled.SetEnabled(true);
+    ASSERT_FALSE(disabled.IsEnabled());
+    LogCache no_memory(8, 0);
+    no_memory.SetEnabled(true);
+    ASSERT_FALSE(no_memory.IsEnabled());
+}
+
+TEST_F(LogReplicatorTest, LogCacheMaxBytes) {
+    std::vector<std::shared_ptr<::openmldb::api::LogEntry>> entries;
+    for (uint64_t i = 1; i <= 10; i++) {
+        auto entry = std::make_shared<::openmldb::api::LogEntry>();
+        entry->set_log_index(i);
+        entry->set_value(std::string(1000, 'v'));
+        entries.push_back(entry);
+    }
+    uint64_t entry_size = entries.front()->ByteSizeLong() + sizeof(::openmldb::api::LogEntry);
+    // the large entries are evicted by size before the count is reached
+    LogCache cache(1024, entry_size * 4);
+    cache.SetEnabled(true);
+    cache.Append(entries);
+    ASSERT_EQ(entry_size * 4, cache.GetByteSize());
+    std::vector<std::shared_ptr<::openmldb::api::LogEntry>> cached;
+    ASSERT_EQ(0u, cache.Get(6, 32, &cached));
+    ASSERT_EQ(4u, cache.Get(7, 32, &cached));
+    ASSERT_EQ(10u, cached.back()->log_index());
+    // an entry larger than the budget is not kept
+    auto large = std::make_shared<::openmldb::api::LogEntry>();
+    large->set_log_index(11);
+    large->set_value(std::string(entry_size * 4, 'v'));
+    cache.Append({large});
+    ASSERT_EQ(0u, cache.GetByteSize());
+    cached.clear();
+    ASSERT_EQ(0u, cache.Get(10, 32, &cached));
+    // the entries after a gap replace the stale ones
+    cache.Append({entries[0]});
+    cache.Append({entries[5]});
+    ASSERT_EQ(entry_size, cache.GetByteSize());
+    ASSERT_EQ(0u, cache.Get(1, 32, &cached));
+    ASSERT_EQ(1u, cache.Get(6, 32, &cached));
+}
+
+TEST_F(LogReplicatorTest, PipelineSync) {
+    FLAGS_binlog_sync_max_inflight = 8;
+    int32_t old_batch_size = FLAGS_binlog_sync_batch_size;
+    FLAGS_binlog_sync_batch_size = 4;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    auto table = std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    std::filesystem::path follower_folder = std::filesystem::temp_directory_path() / GenRand();
+    std::filesystem::path leader_folder = std::filesystem::temp_directory_path() / GenRand();
+    absl::Cleanup clean = [&]() {
+        std::filesystem::remove_all(follower_folder);
+        std::filesystem::remove_all(leader_folder);
+        FLAGS_binlog_sync_max_inflight = 1;
+        FLAGS_binlog_sync_batch_size = old_batch_size;
+    };
+    MockTabletImpl* follower = new MockTabletImpl(kFollowerNode, follower_folder, g_endpoints, table);
+    ASSERT_TRUE(follower->Init());
+    // the batches stay in flight for a while, so the later ones arrive before
+    // the earlier ones are applied
+    follower->SetDelay(20);
+    brpc::Server server;
+    brpc::ServerOptions options;
+    std::string follower_addr = "127.0.0.1:18540";
+    ASSERT_EQ(0, server.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+    ASSERT_EQ(0, server.Start(follower_addr.c_str(), &options));
+
+    LogReplicator leader(1, 1, leader_folder, g_endpoints, kLeaderNode);
+    ASSERT_TRUE(leader.Init());
+    int num = 200;
+    for (int i = 0; i < num; i++) {
+        ::openmldb::api::LogEntry entry;
+        ::openmldb::test::AddDimension(0, absl::StrCat("key", i % 10), &entry);
+        entry.set_value(::openmldb::test::EncodeKV("key", "value"));
+        entry.set_ts(9527 + i);
+        ASSERT_TRUE(leader.AppendEntry(entry));
+    }
+    std::map<std::string, std::string> map;
+    map.insert(std::make_pair(follower_addr, ""));
+    ASSERT_EQ(0, leader.AddReplicateNode(map));
+    leader.Notify();
+    for (int i = 0; i < 300 && follower->GetOffset() < leader.GetLogOffset(); i++) {
+        usleep(100000);
+    }
+    leader.DelAllReplicateNode();
+    server.Stop(1000);
+    server.Join();
+    ASSERT_EQ(static_cast<uint64_t>(num), follower->GetOffset());
+    // several batches are in flight and the entries are applied in order
+    // without a gap
+    ASSERT_GT(follower->GetMaxInflight(), 1u);
+    ASSERT_LE(follower->GetMaxInflight(), 8u);
+    std::vector<uint64_t> applied = follower->GetApplied();
+    ASSERT_EQ(static_cast<size_t>(num), applied.size());
+    for (int i = 0; i < num; i++) {
+        ASSERT_EQ(static_cast<uint64_t>(i + 1), applied[i]);
+    }
+}
+
 TEST_F(LogReplicatorTest, LeaderAndFollowerMulti) {
     brpc::ServerOptions options;
     brpc::Server server0;
@@ -17,16 +17,26 @@
 #include "replica/replicate_node.h"
 
 #include <gflags/gflags.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <snappy.h>
 
 #include <algorithm>
 
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
+#include "common/timer.h"
+#include "log/crc32c.h"
 
 DECLARE_int32(binlog_sync_batch_size);
+DECLARE_uint32(binlog_sync_max_inflight);
+DECLARE_bool(binlog_sync_raw_record);
+DECLARE_string(binlog_sync_compression);
 DECLARE_int32(binlog_sync_wait_time);
 DECLARE_int32(binlog_coffee_time);
 DECLARE_int32(binlog_match_logoffset_interval);
+DECLARE_int32(binlog_heartbeat_interval);
+DECLARE_uint64(follower_read_max_lag);
 DECLARE_int32(request_max_retry);
 DECLARE_int32(request_timeout_ms);
 DECLARE_string(zk_cluster);
@@ -46,12 +56,47 @@ static void* RunSyncTask(void* args) {
     return NULL;
 }
 
+// read the log index of a serialized entry without parsing the other fields
+static bool GetLogIndex(const ::openmldb::base::Slice& record, uint64_t* log_index) {
+    using ::google::protobuf::internal::WireFormatLite;
+    static const uint32_t LOG_INDEX_TAG =
+        WireFormatLite::MakeTag(::openmldb::api::LogEntry::kLogIndexFieldNumber, WireFormatLite::WIRETYPE_VARINT);
+    ::google::protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(record.data()), record.size());
+    bool found = false;
+    for (uint32_t tag = input.ReadTag(); tag != 0; tag = input.ReadTag()) {
+        if (tag == LOG_INDEX_TAG) {
+            // the last one wins like parsing
+            if (!input.ReadVarint64(log_index)) {
+                return false;
+            }
+            found = true;
+        } else if (!WireFormatLite::SkipField(&input, tag)) {
+            return false;
+        }
+    }
+    return found && input.ConsumedEntireMessage();
+}
+
+// the number of entries in request, the records are counted if it is sent without parsing
+static int GetEntryCnt(const ::openmldb::api::AppendEntriesRequest& request) {
+    return request.entries_size() > 0 ? request.entries_size() : request.record_size_size();
+}
+
+static uint64_t GetLastLogIndex(const ::openmldb::api::AppendEntriesRequest& request) {
+    if (request.entries_size() > 0) {
+        return request.entries(request.entries_size() - 1).log_index();
+    }
+    return request.pre_log_index() + request.record_size_size();
+}
+
 ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std::string& log_path, uint32_t tid,
                              uint32_t pid, std::atomic<uint64_t>* term, std::atomic<uint64_t>* leader_log_offset,
                              bthread::Mutex* mu, bthread::ConditionVariable* cv, bool rep_follower,
-                             std::atomic<uint64_t>* follower_offset, const std::string& real_point)
+                             std::atomic<uint64_t>* follower_offset, const std::string& real_point,
+                             const LogCache* log_cache)
     : log_reader_(logs, log_path, false),
       cache_(),
+      cache_records_(),
       endpoint_(point),
       last_sync_offset_(0),
       log_matched_(false),
@@ -66,7 +111,13 @@ ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std
       cv_(cv),
       go_back_cnt_(0),
       rep_node_(rep_follower),
-      follower_offset_(follower_offset) {
+      follower_offset_(follower_offset),
+      inflight_(),
+      send_offset_(0),
+      log_cache_(log_cache),
+      cached_entries_(),
+      reader_behind_(false),
+      last_send_time_(0) {
     if (!real_point.empty()) {
         rpc_client_ = openmldb::RpcClient<::openmldb::api::TabletServer_Stub>(real_point);
     }
@@ -108,6 +159,10 @@ void ReplicateNode::MatchLogOffset() {
 }
 
 void ReplicateNode::SyncData() {
+    if (FLAGS_binlog_sync_max_inflight > 1) {
+        PipelineSyncData();
+        return;
+    }
     uint32_t coffee_time = 0;
     while (is_running_.load(std::memory_order_relaxed)) {
         if (coffee_time > 0) {
@@ -117,7 +172,7 @@ void ReplicateNode::SyncData() {
         {
             std::unique_lock<bthread::Mutex> lock(*mu_);
             // no new data append and wait
-            while (last_sync_offset_ >= leader_log_offset_->load(std::memory_order_relaxed)) {
+            while (last_sync_offset_ >= leader_log_offset_->load(std::memory_order_relaxed) && !NeedHeartbeat()) {
                 cv_->wait_for(lock, FLAGS_binlog_sync_wait_time * 1000);
                 if (!is_running_.load(std::memory_order_relaxed)) {
                     PDLOG(INFO,
@@ -128,6 +183,10 @@ void ReplicateNode::SyncData() {
                 }
             }
         }
+        if (last_sync_offset_ >= leader_log_offset_->load(std::memory_order_relaxed)) {
+            SendHeartbeat();
+            continue;
+        }
         int ret;
         if (rep_node_.load(std::memory_order_relaxed)) {
             ret = SyncData(follower_offset_->load(std::memory_order_relaxed));
@@ -141,6 +200,158 @@ void ReplicateNode::SyncData() {
     PDLOG(INFO, "replicate log to endpoint %s for table #tid %u #pid %u exist", endpoint_.c_str(), tid_, pid_);
 }
 
+void ReplicateNode::PipelineSyncData() {
+    uint32_t coffee_time = 0;
+    send_offset_ = last_sync_offset_;
+    while (is_running_.load(std::memory_order_relaxed)) {
+        if (coffee_time > 0) {
+            bthread_usleep(coffee_time * 1000);
+            coffee_time = 0;
+        }
+        uint64_t log_offset = rep_node_.load(std::memory_order_relaxed)
+                                  ? follower_offset_->load(std::memory_order_relaxed)
+                                  : leader_log_offset_->load(std::memory_order_relaxed);
+        bool has_data = send_offset_ < log_offset;
+        // the acks are handled in order, block on the oldest batch if the
+        // window is full or there is nothing more to send
+        bool ok = true;
+        while (ok && !inflight_.empty() &&
+               (!has_data || inflight_.size() >= FLAGS_binlog_sync_max_inflight ||
+                inflight_.front().callback->IsDone())) {
+            ok = WaitInflight();
+        }
+        if (!ok) {
+            // the batches after the failed one are rejected by the follower,
+            // so sync again from the offset of the follower
+            ClearInflight();
+            log_matched_ = false;
+            PDLOG(WARNING, "fail to sync log to node %s, match log offset again. tid %u pid %u", endpoint_.c_str(),
+                  tid_, pid_);
+            bthread_usleep(FLAGS_binlog_coffee_time * 1000);
+            MatchLogOffset();
+            send_offset_ = last_sync_offset_;
+            continue;
+        }
+        if (!has_data) {
+            if (rep_node_.load(std::memory_order_relaxed)) {
+                coffee_time = FLAGS_binlog_coffee_time;
+                continue;
+            }
+            {
+                std::unique_lock<bthread::Mutex> lock(*mu_);
+                while (send_offset_ >= leader_log_offset_->load(std::memory_order_relaxed) &&
+                       is_running_.load(std::memory_order_relaxed) && !NeedHeartbeat()) {
+                    cv_->wait_for(lock, FLAGS_binlog_sync_wait_time * 1000);
+                }
+            }
+            if (send_offset_ >= leader_log_offset_->load(std::memory_order_relaxed) && NeedHeartbeat()) {
+                SendHeartbeat();
+            }
+            continue;
+        }
+        if (SendEntries(log_offset) == 1) {
+            coffee_time = FLAGS_binlog_coffee_time;
+        }
+    }
+    ClearInflight();
+    PDLOG(INFO, "replicate log to endpoint %s for table #tid %u #pid %u exist", endpoint_.c_str(), tid_, pid_);
+}
+
+int ReplicateNode::SendEntries(uint64_t log_offset) {
+    ::openmldb::api::AppendEntriesRequest request;
+    request.set_tid(tid_);
+    request.set_pid(pid_);
+    request.set_pre_log_index(send_offset_);
+    if (!FLAGS_zk_cluster.empty()) {
+        request.set_term(term_->load(std::memory_order_relaxed));
+    }
+    request.set_leader_offset(leader_log_offset_->load(std::memory_order_relaxed));
+    uint64_t sync_log_offset = send_offset_;
+    butil::IOBuf records;
+    bool need_wait =
+        ReadEntries(log_offset, &request, &sync_log_offset, FLAGS_binlog_sync_raw_record ? &records : nullptr);
+    if (GetEntryCnt(request) > 0) {
+        auto response = std::make_shared<::openmldb::api::AppendEntriesResponse>();
+        auto cntl = std::make_shared<brpc::Controller>();
+        cntl->set_timeout_ms(FLAGS_request_timeout_ms);
+        cntl->set_max_retry(FLAGS_request_max_retry);
+        cntl->request_attachment().swap(records);
+        auto callback = new RpcCallback<::openmldb::api::AppendEntriesResponse>(response, cntl);
+        callback->Ref();
+        if (!rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, cntl.get(), &request,
+                                     response.get(), callback)) {
+            cntl->SetFailed("fail to send request");
+            callback->Run();
+        }
+        inflight_.push_back({sync_log_offset, callback});
+        send_offset_ = sync_log_offset;
+        last_send_time_ = ::baidu::common::timer::get_micros();
+    }
+    // the request has been serialized
+    ReleaseCachedEntries(&request);
+    return need_wait ? 1 : 0;
+}
+
+bool ReplicateNode::WaitInflight() {
+    InflightBatch batch = inflight_.front();
+    inflight_.pop_front();
+    const auto& cntl = batch.callback->GetController();
+    brpc::Join(cntl->call_id());
+    const auto& response = batch.callback->GetResponse();
+    bool ok = !cntl->Failed() && response->code() == 0;
+    if (ok) {
+        DEBUGLOG("sync log to node[%s] to offset %lu", endpoint_.c_str(), batch.last_log_index);
+        last_sync_offset_ = batch.last_log_index;
+        if (!rep_node_.load(std::memory_order_relaxed) &&
+            (last_sync_offset_ > follower_offset_->load(std::memory_order_relaxed))) {
+            follower_offset_->store(last_sync_offset_, std::memory_order_relaxed);
+        }
+    } else if (cntl->Failed()) {
+        PDLOG(WARNING, "fail to sync log to node %s: %s. tid %u pid %u", endpoint_.c_str(),
+              cntl->ErrorText().c_str(), tid_, pid_);
+    } else {
+        PDLOG(WARNING, "fail to sync log to node %s: %s. tid %u pid %u", endpoint_.c_str(),
+              response->msg().c_str(), tid_, pid_);
+    }
+    batch.callback->UnRef();
+    return ok;
+}
+
+void ReplicateNode::ClearInflight() {
+    while (!inflight_.empty()) {
+        brpc::Join(inflight_.front().callback->GetController()->call_id());
+        inflight_.front().callback->UnRef();
+        inflight_.pop_front();
+    }
+}
+
+bool ReplicateNode::NeedHeartbeat() const {
+    if (FLAGS_follower_read_max_lag == 0 || FLAGS_binlog_heartbeat_interval <= 0 ||
+        rep_node_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    return ::baidu::common::timer::get_micros() >=
+           last_send_time_ + static_cast<uint64_t>(FLAGS_binlog_heartbeat_interval) * 1000;
+}
+
+void ReplicateNode::SendHeartbeat() {
+    ::openmldb::api::AppendEntriesRequest request;
+    request.set_tid(tid_);
+    request.set_pid(pid_);
+    request.set_pre_log_index(last_sync_offset_);
+    if (!FLAGS_zk_cluster.empty()) {
+        request.set_term(term_->load(std::memory_order_relaxed));
+    }
+    request.set_leader_offset(leader_log_offset_->load(std::memory_order_relaxed));
+    ::openmldb::api::AppendEntriesResponse response;
+    bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
+                                       FLAGS_request_timeout_ms, 1);
+    last_send_time_ = ::baidu::common::timer::get_micros();
+    if (!ret || response.code() != 0) {
+        DEBUGLOG("fail to send heartbeat to node %s. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
+    }
+}
+
 int ReplicateNode::GetLogIndex() { return log_reader_.GetLogIndex(); }
 
 bool ReplicateNode::IsLogMatched() { return log_matched_; }
@@ -172,6 +383,146 @@ int ReplicateNode::MatchLogOffsetFromNode() {
     return -1;
 }
 
+bool ReplicateNode::ReadEntries(uint64_t log_offset, ::openmldb::api::AppendEntriesRequest* request,
+                                uint64_t* sync_log_offset, butil::IOBuf* records) {
+    bool need_wait = false;
+    uint32_t batchSize = log_offset - *sync_log_offset;
+    batchSize = std::min(batchSize, (uint32_t)FLAGS_binlog_sync_batch_size);
+    if (ReadCachedEntries(batchSize, request, sync_log_offset)) {
+        return false;
+    }
+    if (reader_behind_) {
+        // the node lags behind the cache, read the binlog from where it is
+        log_reader_.Seek(*sync_log_offset);
+        reader_behind_ = false;
+    }
+    for (uint64_t i = 0; i < batchSize;) {
+        std::string buffer;
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &buffer);
+        if (status.ok()) {
+            uint64_t log_index = 0;
+            ::openmldb::api::LogEntry* entry = nullptr;
+            if (records != nullptr) {
+                if (!GetLogIndex(record, &log_index)) {
+                    PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
+                          ::openmldb::base::DebugString(record.ToString()).c_str(), record.size(), tid_, pid_);
+                    break;
+                }
+            } else {
+                entry = request->add_entries();
+                if (!entry->ParseFromArray(record.data(), record.size())) {
+                    PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
+                          ::openmldb::base::DebugString(record.ToString()).c_str(), record.size(), tid_, pid_);
+                    request->mutable_entries()->RemoveLast();
+                    break;
+                }
+                DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
+                log_index = entry->log_index();
+            }
+            if (log_index <= *sync_log_offset) {
+                DEBUGLOG("skip duplicate log offset %lld", log_index);
+                if (entry != nullptr) {
+                    request->mutable_entries()->RemoveLast();
+                }
+                continue;
+            }
+            // the log index should incr by 1
+            if ((*sync_log_offset + 1) != log_index) {
+                PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", *sync_log_offset + 1,
+                      log_index, tid_, pid_);
+                if (entry != nullptr) {
+                    request->mutable_entries()->RemoveLast();
+                }
+                if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
+                    log_reader_.GoBackToStart();
+                    go_back_cnt_ = 0;
+                    PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
+                } else {
+                    log_reader_.GoBackToLastBlock();
+                    go_back_cnt_++;
+                }
+                need_wait = true;
+                break;
+            }
+            if (records != nullptr) {
+                records->append(record.data(), record.size());
+                request->add_record_size(record.size());
+            }
+            *sync_log_offset = log_index;
+        } else if (status.IsWaitRecord()) {
+            DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
+            need_wait = true;
+            break;
+        } else if (status.IsInvalidRecord()) {
+            DEBUGLOG("fail to get record. %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
+            need_wait = true;
+            if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
+                log_reader_.GoBackToStart();
+                go_back_cnt_ = 0;
+                PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
+            } else {
+                log_reader_.GoBackToLastBlock();
+                go_back_cnt_++;
+            }
+            break;
+        } else {
+            PDLOG(WARNING, "fail to get record: %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
+            need_wait = true;
+            break;
+        }
+        i++;
+        go_back_cnt_ = 0;
+    }
+    if (records != nullptr && !records->empty()) {
+        PackRecords(request, records);
+    }
+    return need_wait;
+}
+
+void ReplicateNode::PackRecords(::openmldb::api::AppendEntriesRequest* request, butil::IOBuf* records) {
+    if (FLAGS_binlog_sync_compression == "snappy") {
+        std::string raw = records->to_string();
+        std::string compressed;
+        ::snappy::Compress(raw.data(), raw.size(), &compressed);
+        records->clear();
+        records->append(compressed);
+        request->set_record_compress_type(::openmldb::type::CompressType::kSnappy);
+    }
+    uint32_t crc = 0;
+    for (size_t i = 0; i < records->backing_block_num(); i++) {
+        butil::StringPiece block = records->backing_block(i);
+        crc = ::openmldb::log::Extend(crc, block.data(), block.size());
+    }
+    request->set_record_crc(crc);
+}
+
+bool ReplicateNode::ReadCachedEntries(uint32_t max_cnt, ::openmldb::api::AppendEntriesRequest* request,
+                                      uint64_t* sync_log_offset) {
+    if (log_cache_ == nullptr || !log_cache_->IsEnabled()) {
+        return false;
+    }
+    cached_entries_.clear();
+    if (log_cache_->Get(*sync_log_offset + 1, max_cnt, &cached_entries_) == 0) {
+        return false;
+    }
+    for (const auto& entry : cached_entries_) {
+        request->mutable_entries()->UnsafeArenaAddAllocated(entry.get());
+    }
+    *sync_log_offset = cached_entries_.back()->log_index();
+    reader_behind_ = true;
+    go_back_cnt_ = 0;
+    return true;
+}
+
+void ReplicateNode::ReleaseCachedEntries(::openmldb::api::AppendEntriesRequest* request) {
+    // the cached entries are the only entries of the request
+    for (size_t i = 0; i < cached_entries_.size(); i++) {
+        request->mutable_entries()->UnsafeArenaReleaseLast();
+    }
+    cached_entries_.clear();
+}
+
 int ReplicateNode::SyncData(uint64_t log_offset) {
     DEBUGLOG("node[%s] offset[%lu] log offset[%lu]", endpoint_.c_str(), last_sync_offset_, log_offset);
     if (log_offset <= last_sync_offset_) {
@@ -180,25 +531,29 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
     }
     ::openmldb::api::AppendEntriesRequest request;
     ::openmldb::api::AppendEntriesResponse response;
+    butil::IOBuf records;
     uint64_t sync_log_offset = last_sync_offset_;
     bool request_from_cache = false;
     bool need_wait = false;
     if (cache_.size() > 0) {
         request_from_cache = true;
         request = cache_[0];
-        if (request.entries_size() <= 0) {
+        records = cache_records_;
+        if (GetEntryCnt(request) <= 0) {
             cache_.clear();
+            cache_records_.clear();
             PDLOG(WARNING, "empty append entry request from node %s cache", endpoint_.c_str());
             return -1;
         }
-        const ::openmldb::api::LogEntry& entry = request.entries(request.entries_size() - 1);
-        if (entry.log_index() <= last_sync_offset_) {
+        uint64_t last_log_index = GetLastLogIndex(request);
+        if (last_log_index <= last_sync_offset_) {
             DEBUGLOG("duplicate log index from node %s cache", endpoint_.c_str());
             cache_.clear();
+            cache_records_.clear();
             return -1;
         }
-        PDLOG(INFO, "use cached request to send last index %lu. tid %u pid %u", entry.log_index(), tid_, pid_);
-        sync_log_offset = entry.log_index();
+        PDLOG(INFO, "use cached request to send last index %lu. tid %u pid %u", last_log_index, tid_, pid_);
+        sync_log_offset = last_log_index;
     } else {
         request.set_tid(tid_);
         request.set_pid(pid_);
@@ -206,72 +561,18 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
         if (!FLAGS_zk_cluster.empty()) {
             request.set_term(term_->load(std::memory_order_relaxed));
         }
-        uint32_t batchSize = log_offset - last_sync_offset_;
-        batchSize = std::min(batchSize, (uint32_t)FLAGS_binlog_sync_batch_size);
-        for (uint64_t i = 0; i < batchSize;) {
-            std::string buffer;
-            ::openmldb::base::Slice record;
-            ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &buffer);
-            if (status.ok()) {
-                ::openmldb::api::LogEntry* entry = request.add_entries();
-                if (!entry->ParseFromString(record.ToString())) {
-                    PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
-                          ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size(), tid_,
-                          pid_);
-                    request.mutable_entries()->RemoveLast();
-                    break;
-                }
-                DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
-                if (entry->log_index() <= sync_log_offset) {
-                    DEBUGLOG("skip duplicate log offset %lld", entry->log_index());
-                    request.mutable_entries()->RemoveLast();
-                    continue;
-                }
-                // the log index should incr by 1
-                if ((sync_log_offset + 1) != entry->log_index()) {
-                    PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", sync_log_offset + 1,
-                          entry->log_index(), tid_, pid_);
-                    request.mutable_entries()->RemoveLast();
-                    if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
-                        log_reader_.GoBackToStart();
-                        go_back_cnt_ = 0;
-                        PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
-                    } else {
-                        log_reader_.GoBackToLastBlock();
-                        go_back_cnt_++;
-                    }
-                    need_wait = true;
-                    break;
-                }
-                sync_log_offset = entry->log_index();
-            } else if (status.IsWaitRecord()) {
-                DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
-                need_wait = true;
-                break;
-            } else if (status.IsInvalidRecord()) {
-                DEBUGLOG("fail to get record. %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
-                need_wait = true;
-                if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
-                    log_reader_.GoBackToStart();
-                    go_back_cnt_ = 0;
-                    PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
-                } else {
-                    log_reader_.GoBackToLastBlock();
-                    go_back_cnt_++;
-                }
-                break;
-            } else {
-                PDLOG(WARNING, "fail to get record: %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
-                need_wait = true;
-                break;
-            }
-            i++;
-            go_back_cnt_ = 0;
-        }
+        request.set_leader_offset(leader_log_offset_->load(std::memory_order_relaxed));
+        need_wait =
+            ReadEntries(log_offset, &request, &sync_log_offset, FLAGS_binlog_sync_raw_record ? &records : nullptr);
     }
-    if (request.entries_size() > 0) {
-        bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
-                                           FLAGS_request_timeout_ms, FLAGS_request_max_retry);
+    if (GetEntryCnt(request) > 0) {
+        brpc::Controller cntl;
+        cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+        cntl.set_max_retry(FLAGS_request_max_retry);
+        cntl.request_attachment() = records;
+        bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &cntl, &request,
+                                           &response);
+        last_send_time_ = ::baidu::common::timer::get_micros();
         if (ret && response.code() == 0) {
             DEBUGLOG("sync log to node[%s] to offset %lld", endpoint_.c_str(), sync_log_offset);
             last_sync_offset_ = sync_log_offset;
@@ -281,15 +582,18 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
             }
             if (request_from_cache) {
                 cache_.clear();
+                cache_records_.clear();
             }
         } else {
             if (!request_from_cache) {
                 cache_.push_back(request);
+                cache_records_ = records;
             }
             need_wait = true;
             PDLOG(WARNING, "fail to sync log to node %s. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
         }
     }
+    ReleaseCachedEntries(&request);
     if (need_wait) {
         return 1;
     }
@@ -18,16 +18,20 @@
 #define SRC_REPLICA_REPLICATE_NODE_H_
 
 #include <atomic>
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "base/skiplist.h"
 #include "bthread/bthread.h"
 #include "bthread/condition_variable.h"
+#include "butil/iobuf.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "replica/log_cache.h"
 #include "rpc/rpc_client.h"
 
 namespace openmldb {
@@ -41,7 +45,7 @@ class ReplicateNode {
     ReplicateNode(const std::string& point, LogParts* logs, const std::string& log_path, uint32_t tid, uint32_t pid,
                   std::atomic<uint64_t>* term, std::atomic<uint64_t>* leader_log_offset, bthread::Mutex* mu,
                   bthread::ConditionVariable* cv, bool rep_follower, std::atomic<uint64_t>* follower_offset,
-                  const std::string& real_point);
+                  const std::string& real_point, const LogCache* log_cache);
     int Init();
 
     int Start();
@@ -70,11 +74,53 @@ class ReplicateNode {
     ReplicateNode& operator=(const ReplicateNode&) = delete;
 
  private:
+    struct InflightBatch {
+        uint64_t last_log_index;
+        RpcCallback<::openmldb::api::AppendEntriesResponse>* callback;
+    };
+
     int MatchLogOffsetFromNode();
 
+    // read the entries after sync_log_offset into request, sync_log_offset is
+    // set to the last one. return true if the reader should wait for new data
+    // the entries read from binlog are appended to records without parsing
+    // if records is not null, see binlog_sync_raw_record
+    bool ReadEntries(uint64_t log_offset, ::openmldb::api::AppendEntriesRequest* request,
+                     uint64_t* sync_log_offset, butil::IOBuf* records);
+
+    // compress the records and set the crc
+    void PackRecords(::openmldb::api::AppendEntriesRequest* request, butil::IOBuf* records);
+
+    // add the entries from the log cache to request without copy, they are
+    // released by ReleaseCachedEntries before the request is destroyed
+    bool ReadCachedEntries(uint32_t max_cnt, ::openmldb::api::AppendEntriesRequest* request,
+                           uint64_t* sync_log_offset);
+
+    void ReleaseCachedEntries(::openmldb::api::AppendEntriesRequest* request);
+
+    // send the batches without waiting for the responses, at most
+    // binlog_sync_max_inflight requests are in flight. the follower rejects a
+    // batch that does not follow its log offset, then the log offset is matched again
+    void PipelineSyncData();
+
+    int SendEntries(uint64_t log_offset);
+
+    // wait for the oldest batch in flight, return false if it failed
+    bool WaitInflight();
+
+    void ClearInflight();
+
+    // the idle leader sends heartbeats with its log offset if follower read
+    // is enabled, so the follower knows it is not behind, see follower_read_max_lag
+    bool NeedHeartbeat() const;
+
+    void SendHeartbeat();
+
  private:
     LogReader log_reader_;
     std::vector<::openmldb::api::AppendEntriesRequest> cache_;
+    // the attachment of the request in cache_
+    butil::IOBuf cache_records_;
     std::string endpoint_;
     uint64_t last_sync_offset_;
     bool log_matched_;
@@ -90,6 +136,17 @@ class ReplicateNode {
     uint32_t go_back_cnt_;
     std::atomic<bool> rep_node_;
     std::atomic<uint64_t>* follower_offset_;  // max local cluster follower offset
+    std::deque<InflightBatch> inflight_;
+    // the last log index sent to the follower, it is ahead of last_sync_offset_
+    // while batches are in flight
+    uint64_t send_offset_;
+    const LogCache* log_cache_;
+    // the entries of the cache in the request being sent
+    std::vector<std::shared_ptr<::openmldb::api::LogEntry>> cached_entries_;
+    // log_reader_ is not advanced while the entries are read from the cache
+    bool reader_behind_;
+    // the time in microseconds the last request is sent
+    uint64_t last_send_time_;
 };
 
 }  // namespace replica
@@ -534,6 +534,23 @@ std::shared_ptr<::openmldb::catalog::TabletAccessor> DBSDK::GetTablet(const std:
     return {};
 }
 
+std::shared_ptr<::openmldb::catalog::TabletAccessor> DBSDK::GetReadTablet(const std::string& db,
+                                                                          const std::string& name) {
+    auto table_handler = GetCatalog()->GetTable(db, name);
+    if (table_handler) {
+        auto* sdk_table_handler = dynamic_cast<::openmldb::catalog::SDKTableHandler*>(table_handler.get());
+        if (sdk_table_handler) {
+            uint32_t pid_num = sdk_table_handler->GetPartitionNum();
+            uint32_t pid = 0;
+            if (pid_num > 0) {
+                pid = rand_.Uniform(pid_num);
+            }
+            return sdk_table_handler->GetReadTablet(pid);
+        }
+    }
+    return {};
+}
+
 bool DBSDK::GetTablet(const std::string& db, const std::string& name,
                       std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>* tablets) {
     auto table_handler = GetCatalog()->GetTable(db, name);
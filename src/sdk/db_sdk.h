@@ -87,6 +87,8 @@ class DBSDK {
     bool GetTablet(const std::string& db, const std::string& name,
                    std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>* tablets);
     std::shared_ptr<::openmldb::catalog::TabletAccessor> GetTablet(const std::string& db, const std::string& name);
+    // a replica of a random partition for follower read
+    std::shared_ptr<::openmldb::catalog::TabletAccessor> GetReadTablet(const std::string& db, const std::string& name);
     std::shared_ptr<::openmldb::catalog::TabletAccessor> GetTablet(const std::string& db, const std::string& name,
                                                                    uint32_t pid);
     std::shared_ptr<::openmldb::catalog::TabletAccessor> GetTablet(const std::string& db, const std::string& name,
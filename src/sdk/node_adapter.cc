@@ -46,6 +46,8 @@ bool NodeAdapter::TransformToTableDef(::hybridse::node::CreatePlanNode* create_n
     hybridse::node::NodePointVector distribution_list;
 
     hybridse::node::StorageMode storage_mode = hybridse::node::kMemory;
+    std::string binlog_compression;
+    bool binlog_durable = false;
     // different default value for cluster and standalone mode
     int replica_num = 1;
     int partition_num = 1;
@@ -74,6 +76,21 @@ bool NodeAdapter::TransformToTableDef(::hybridse::node::CreatePlanNode* create_n
                     storage_mode = dynamic_cast<hybridse::node::StorageModeNode *>(table_option)->GetStorageMode();
                     break;
                 }
+                case hybridse::node::kBinlogCompression: {
+                    binlog_compression =
+                        dynamic_cast<hybridse::node::BinlogCompressionNode*>(table_option)->GetCompression();
+                    if (binlog_compression != "off" && binlog_compression != "snappy" &&
+                        binlog_compression != "zlib") {
+                        *status = {hybridse::common::kUnsupportSql,
+                                   "binlog_compression should be one of off, snappy, zlib"};
+                        return false;
+                    }
+                    break;
+                }
+                case hybridse::node::kBinlogDurable: {
+                    binlog_durable = dynamic_cast<hybridse::node::BinlogDurableNode*>(table_option)->GetDurable();
+                    break;
+                }
                 case hybridse::node::kDistributions: {
                     distribution_list =
                         dynamic_cast<hybridse::node::DistributionsNode*>(table_option)->GetDistributionList();
@@ -112,6 +129,12 @@ bool NodeAdapter::TransformToTableDef(::hybridse::node::CreatePlanNode* create_n
 
     table->set_format_version(1);
     table->set_storage_mode(static_cast<common::StorageMode>(storage_mode));
+    if (!binlog_compression.empty()) {
+        table->set_binlog_compression(binlog_compression);
+    }
+    if (binlog_durable) {
+        table->set_binlog_durable(true);
+    }
     bool has_generate_index = false;
     std::set<std::string> index_names;
     std::map<std::string, ::openmldb::common::ColumnDesc*> column_names;
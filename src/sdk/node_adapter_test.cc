@@ -120,6 +120,59 @@ static std::vector<TestInfo> cases = {
 
 INSTANTIATE_TEST_SUITE_P(NodeAdapter, NodeAdapterTest, testing::ValuesIn(cases));
 
+static bool TransformSql(const std::string& sql, ::openmldb::nameserver::TableInfo* table_info) {
+    hybridse::node::NodeManager node_manager;
+    hybridse::base::Status sql_status;
+    hybridse::node::PlanNodeList plan_trees;
+    hybridse::plan::PlanAPI::CreatePlanTreeFromScript(sql, plan_trees, &node_manager, sql_status);
+    if (plan_trees.empty() || sql_status.code != 0) {
+        return false;
+    }
+    auto create_node = dynamic_cast<hybridse::node::CreatePlanNode*>(plan_trees[0]);
+    return NodeAdapter::TransformToTableDef(create_node, table_info, 3, true, &sql_status);
+}
+
+TEST(NodeAdapterOptionTest, BinlogCompression) {
+    std::string base_sql = "CREATE TABLE t1 (col0 STRING, col1 int, std_time TIMESTAMP, INDEX(KEY=col1, TS=std_time)) ";
+    {
+        ::openmldb::nameserver::TableInfo table_info;
+        ASSERT_TRUE(TransformSql(base_sql + ";", &table_info));
+        ASSERT_FALSE(table_info.has_binlog_compression());
+    }
+    {
+        ::openmldb::nameserver::TableInfo table_info;
+        ASSERT_TRUE(TransformSql(base_sql + "OPTIONS (BINLOG_COMPRESSION='Snappy');", &table_info));
+        ASSERT_EQ("snappy", table_info.binlog_compression());
+    }
+    {
+        ::openmldb::nameserver::TableInfo table_info;
+        ASSERT_FALSE(TransformSql(base_sql + "OPTIONS (BINLOG_COMPRESSION='lz4');", &table_info));
+    }
+}
+
+TEST(NodeAdapterOptionTest, BinlogDurable) {
+    std::string base_sql = "CREATE TABLE t1 (col0 STRING, col1 int, std_time TIMESTAMP, INDEX(KEY=col1, TS=std_time)) ";
+    {
+        ::openmldb::nameserver::TableInfo table_info;
+        ASSERT_TRUE(TransformSql(base_sql + ";", &table_info));
+        ASSERT_FALSE(table_info.binlog_durable());
+    }
+    {
+        ::openmldb::nameserver::TableInfo table_info;
+        ASSERT_TRUE(TransformSql(base_sql + "OPTIONS (BINLOG_DURABLE=TRUE);", &table_info));
+        ASSERT_TRUE(table_info.binlog_durable());
+    }
+    {
+        ::openmldb::nameserver::TableInfo table_info;
+        ASSERT_TRUE(TransformSql(base_sql + "OPTIONS (binlog_durable=false);", &table_info));
+        ASSERT_FALSE(table_info.binlog_durable());
+    }
+    {
+        ::openmldb::nameserver::TableInfo table_info;
+        ASSERT_FALSE(TransformSql(base_sql + "OPTIONS (binlog_durable='yes');", &table_info));
+    }
+}
+
 }  // namespace sdk
 }  // namespace openmldb
 
@@ -1180,9 +1180,9 @@ std::shared_ptr<TableReader> SQLClusterRouter::GetTableReader() {
     return std::make_shared<TableReaderImpl>(cluster_sdk_);
 }
 
-std::shared_ptr<openmldb::client::TabletClient> SQLClusterRouter::GetTablet(const std::string& db,
-                                                                            const std::string& sp_name,
-                                                                            hybridse::sdk::Status* status) {
+std::shared_ptr<::openmldb::catalog::TabletAccessor> SQLClusterRouter::GetTablet(const std::string& db,
+                                                                                 const std::string& sp_name,
+                                                                                 hybridse::sdk::Status* status) {
     if (status == nullptr) return nullptr;
     std::shared_ptr<hybridse::sdk::ProcedureInfo> sp_info = cluster_sdk_->GetProcedureInfo(db, sp_name, &status->msg);
     if (!sp_info) {
@@ -1193,14 +1193,20 @@ std::shared_ptr<openmldb::client::TabletClient> SQLClusterRouter::GetTablet(cons
     }
     const std::string& table = sp_info->GetMainTable();
     const std::string& db_name = sp_info->GetMainDb().empty() ? db : sp_info->GetMainDb();
-    auto tablet = cluster_sdk_->GetTablet(db_name, table);
-    if (!tablet) {
+    std::shared_ptr<::openmldb::catalog::TabletAccessor> tablet;
+    auto ops = std::dynamic_pointer_cast<SQLRouterOptions>(options_);
+    if (ops && ops->enable_follower_read) {
+        tablet = cluster_sdk_->GetReadTablet(db_name, table);
+    } else {
+        tablet = cluster_sdk_->GetTablet(db_name, table);
+    }
+    if (!tablet || !tablet->GetClient()) {
         status->code = -1;
         status->msg = "fail to get tablet, table " + db_name + "." + table;
         LOG(WARNING) << status->msg;
         return nullptr;
     }
-    return tablet->GetClient();
+    return tablet;
 }
 
 bool SQLClusterRouter::IsConstQuery(::hybridse::vm::PhysicalOpNode* node) {
@@ -1405,7 +1411,7 @@ bool SQLClusterRouter::PutRow(uint32_t tid, const std::shared_ptr<SQLInsertRow>&
                 if (client) {
                     DLOG(INFO) << "put data to endpoint " << client->GetEndpoint() << " with dimensions size "
                                << kv.second.size();
-                    bool ret = client->Put(tid, pid, cur_ts, row->GetRow(), kv.second);
+                    bool ret = client->Put(tid, pid, cur_ts, row->GetRow(), kv.second, options_->durable_put);
                     if (!ret) {
                         status->msg = "fail to make a put request to table. tid " + std::to_string(tid);
                         LOG(WARNING) << status->msg;
@@ -1422,6 +1428,86 @@ bool SQLClusterRouter::PutRow(uint32_t tid, const std::shared_ptr<SQLInsertRow>&
     return true;
 }
 
+bool SQLClusterRouter::PutRows(uint32_t tid, const std::shared_ptr<SQLInsertRows>& rows,
+                               const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                               ::hybridse::sdk::Status* status) {
+    if (status == nullptr) {
+        return false;
+    }
+    uint64_t cur_ts = ::baidu::common::timer::get_micros() / 1000;
+    std::map<uint32_t, std::shared_ptr<openmldb::RpcCallback<openmldb::api::PutBatchResponse>>> callbacks;
+    std::map<uint32_t, ::openmldb::api::PutBatchRequest> requests;
+    for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
+        std::shared_ptr<SQLInsertRow> row = rows->GetRow(i);
+        for (const auto& kv : row->GetDimensions()) {
+            uint32_t pid = kv.first;
+            auto& request = requests[pid];
+            auto& callback = callbacks[pid];
+            if (!callback) {
+                request.set_tid(tid);
+                request.set_pid(pid);
+                if (options_->durable_put) {
+                    request.set_durable(true);
+                }
+                callback = std::shared_ptr<openmldb::RpcCallback<openmldb::api::PutBatchResponse>>(
+                    new openmldb::RpcCallback<openmldb::api::PutBatchResponse>(
+                        std::make_shared<openmldb::api::PutBatchResponse>(), std::make_shared<brpc::Controller>()),
+                    [](openmldb::RpcCallback<openmldb::api::PutBatchResponse>* cb) { cb->UnRef(); });
+            }
+            auto batch_row = request.add_rows();
+            batch_row->set_time(cur_ts);
+            batch_row->set_value_size(row->GetRow().size());
+            for (const auto& dim : kv.second) {
+                auto dimension = batch_row->add_dimensions();
+                dimension->set_key(dim.first);
+                dimension->set_idx(dim.second);
+            }
+            callback->GetController()->request_attachment().append(row->GetRow());
+        }
+    }
+    // the callbacks are referenced by the rpc until they are done
+    std::vector<uint32_t> sent_pids;
+    for (auto& kv : callbacks) {
+        uint32_t pid = kv.first;
+        std::shared_ptr<::openmldb::client::TabletClient> client;
+        if (pid < tablets.size() && tablets[pid]) {
+            client = tablets[pid]->GetClient();
+        }
+        if (!client) {
+            status->msg = "fail to get tablet client. pid " + std::to_string(pid);
+            LOG(WARNING) << status->msg;
+            break;
+        }
+        DLOG(INFO) << "put " << requests[pid].rows_size() << " rows to endpoint " << client->GetEndpoint();
+        kv.second->Ref();
+        if (!client->AsyncPutBatch(requests[pid], kv.second.get())) {
+            kv.second->UnRef();
+            status->msg = "fail to make a put batch request to table. tid " + std::to_string(tid);
+            LOG(WARNING) << status->msg;
+            break;
+        }
+        sent_pids.push_back(pid);
+    }
+    bool ok = sent_pids.size() == callbacks.size();
+    for (auto pid : sent_pids) {
+        const auto& callback = callbacks[pid];
+        brpc::Join(callback->GetController()->call_id());
+        if (callback->GetController()->Failed()) {
+            status->msg = "fail to make a put batch request to table. tid " + std::to_string(tid) + " pid " +
+                          std::to_string(pid) + ", " + callback->GetController()->ErrorText();
+            LOG(WARNING) << status->msg;
+            ok = false;
+        } else if (callback->GetResponse()->code() != ::openmldb::base::kOk) {
+            status->msg = "fail to put batch to table. tid " + std::to_string(tid) + " pid " + std::to_string(pid) +
+                          ", put " + std::to_string(callback->GetResponse()->put_cnt()) + " rows, " +
+                          callback->GetResponse()->msg();
+            LOG(WARNING) << status->msg;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
 bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
                                      hybridse::sdk::Status* status) {
     if (!rows || !status) {
@@ -1436,13 +1522,7 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
             status->msg = "fail to get table " + cache->GetTableName() + " tablet";
             return false;
         }
-        for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
-            std::shared_ptr<SQLInsertRow> row = rows->GetRow(i);
-            if (!PutRow(cache->GetTableId(), row, tablets, status)) {
-                return false;
-            }
-        }
-        return true;
+        return PutRows(cache->GetTableId(), rows, tablets, status);
     } else {
         status->msg = "please use getInsertRow with " + sql + " first";
         return false;
@@ -1529,8 +1609,10 @@ std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::CallProcedure(const
 
     auto cntl = std::make_shared<::brpc::Controller>();
     auto response = std::make_shared<::openmldb::api::QueryResponse>();
-    bool ok = tablet->CallProcedure(db, sp_name, row->GetRow(), cntl.get(), response.get(), options_->enable_debug,
-                                    options_->request_timeout);
+    tablet->AddInflight(1);
+    bool ok = tablet->GetClient()->CallProcedure(db, sp_name, row->GetRow(), cntl.get(), response.get(),
+                                                 options_->enable_debug, options_->request_timeout);
+    tablet->AddInflight(-1);
     if (!ok) {
         status->code = -1;
         status->msg = "request server error" + response->msg();
@@ -1560,8 +1642,10 @@ std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::CallSQLBatchRequestP
 
     auto cntl = std::make_shared<::brpc::Controller>();
     auto response = std::make_shared<::openmldb::api::SQLBatchRequestQueryResponse>();
-    bool ok = tablet->CallSQLBatchRequestProcedure(db, sp_name, row_batch, cntl.get(), response.get(),
-                                                   options_->enable_debug, options_->request_timeout);
+    tablet->AddInflight(1);
+    bool ok = tablet->GetClient()->CallSQLBatchRequestProcedure(db, sp_name, row_batch, cntl.get(), response.get(),
+                                                                options_->enable_debug, options_->request_timeout);
+    tablet->AddInflight(-1);
     if (!ok) {
         status->code = -1;
         status->msg = "request server error, msg: " + response->msg();
@@ -2200,7 +2284,9 @@ std::shared_ptr<openmldb::sdk::QueryFuture> SQLClusterRouter::CallProcedure(cons
     auto* callback = new openmldb::RpcCallback<openmldb::api::QueryResponse>(response, cntl);
 
     std::shared_ptr<openmldb::sdk::QueryFutureImpl> future = std::make_shared<openmldb::sdk::QueryFutureImpl>(callback);
-    bool ok = tablet->CallProcedure(db, sp_name, row->GetRow(), timeout_ms, options_->enable_debug, callback);
+    // the asynchronous calls are not counted in the calls in flight
+    bool ok =
+        tablet->GetClient()->CallProcedure(db, sp_name, row->GetRow(), timeout_ms, options_->enable_debug, callback);
     if (!ok) {
         status->code = -1;
         status->msg = "request server error, msg: " + response->msg();
@@ -2228,8 +2314,8 @@ std::shared_ptr<openmldb::sdk::QueryFuture> SQLClusterRouter::CallSQLBatchReques
 
     std::shared_ptr<openmldb::sdk::BatchQueryFutureImpl> future =
         std::make_shared<openmldb::sdk::BatchQueryFutureImpl>(callback);
-    bool ok =
-        tablet->CallSQLBatchRequestProcedure(db, sp_name, row_batch, options_->enable_debug, timeout_ms, callback);
+    bool ok = tablet->GetClient()->CallSQLBatchRequestProcedure(db, sp_name, row_batch, options_->enable_debug,
+                                                                timeout_ms, callback);
     if (!ok) {
         status->code = -1;
         status->msg = "request server error, msg: " + response->msg();
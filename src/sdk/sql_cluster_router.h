@@ -258,6 +258,11 @@ class SQLClusterRouter : public SQLRouter {
                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
                 ::hybridse::sdk::Status* status);
 
+    // group the rows by partition and send a PutBatch request to each tablet in parallel
+    bool PutRows(uint32_t tid, const std::shared_ptr<SQLInsertRows>& rows,
+                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                 ::hybridse::sdk::Status* status);
+
     bool IsConstQuery(::hybridse::vm::PhysicalOpNode* node);
     std::shared_ptr<SQLCache> GetCache(const std::string& db, const std::string& sql,
                                        hybridse::vm::EngineMode engine_mode);
@@ -282,8 +287,9 @@ class SQLClusterRouter : public SQLRouter {
 
     inline bool CheckSQLSyntax(const std::string& sql);
 
-    std::shared_ptr<openmldb::client::TabletClient> GetTablet(const std::string& db, const std::string& sp_name,
-                                                              hybridse::sdk::Status* status);
+    // the tablet to call the procedure on, see SQLRouterOptions::enable_follower_read
+    std::shared_ptr<::openmldb::catalog::TabletAccessor> GetTablet(const std::string& db, const std::string& sp_name,
+                                                                   hybridse::sdk::Status* status);
 
     bool ExtractDBTypes(const std::shared_ptr<hybridse::sdk::Schema>& schema,
                         std::vector<openmldb::type::DataType>* parameter_types);
@@ -47,6 +47,9 @@ struct BasicRouterOptions {
     int glog_level = 0;
     // empty means to stderr
     std::string glog_dir = "";
+    // the inserts return after their binlog is synced to disk by the tablets,
+    // the same as the tables created with binlog_durable
+    bool durable_put = false;
 };
 
 struct SQLRouterOptions : BasicRouterOptions {
@@ -56,6 +59,9 @@ struct SQLRouterOptions : BasicRouterOptions {
     std::string spark_conf_path;
     uint32_t zk_log_level = 3; // PY/JAVA SDK default info log
     std::string zk_log_file;
+    // call the procedures on the followers as well as the leaders, the data
+    // read may be stale by the follower_read_max_lag of the tablets
+    bool enable_follower_read = false;
 };
 
 struct StandaloneOptions : BasicRouterOptions {
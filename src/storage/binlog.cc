@@ -17,6 +17,7 @@
 #include "storage/binlog.h"
 
 #include <map>
+#include <memory>
 #include <set>
 #include <utility>
 #include <vector>
@@ -29,9 +30,13 @@
 #include "gflags/gflags.h"
 #include "log/log_writer.h"
 #include "log/status.h"
+#include "storage/sharded_loader.h"
 
 DECLARE_uint64(gc_on_table_recover_count);
 DECLARE_int32(binlog_name_length);
+DECLARE_uint32(load_table_batch);
+DECLARE_uint32(load_table_thread_num);
+DECLARE_uint32(load_table_queue_size);
 
 namespace openmldb {
 namespace storage {
@@ -44,7 +49,9 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
     PDLOG(INFO, "start recover table tid %u, pid %u from binlog with start offset %lu", tid, pid, offset);
     ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
     log_reader.SetOffset(offset);
-    ::openmldb::api::LogEntry entry;
+    // the entries are put by the writers of their keys, a delete waits for all
+    // the puts before it since it may remove the rows of any key
+    ShardedLoader loader(table, FLAGS_load_table_thread_num, FLAGS_load_table_batch, FLAGS_load_table_queue_size);
     uint64_t cur_offset = offset;
     std::string buffer;
     uint64_t succ_cnt = 0;
@@ -87,7 +94,8 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             failed_cnt++;
             continue;
         }
-        bool ok = entry.ParseFromString(record.ToString());
+        auto entry = std::make_unique<::openmldb::api::LogEntry>();
+        bool ok = entry->ParseFromArray(record.data(), record.size());
         if (!ok) {
             PDLOG(WARNING, "fail parse record for tid %u, pid %u with value %s", tid, pid,
                   ::openmldb::base::DebugString(record.ToString()).c_str());
@@ -95,28 +103,29 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             continue;
         }
 
-        if (cur_offset >= entry.log_index()) {
-            DEBUGLOG("offset %lu has been made snapshot", entry.log_index());
+        if (cur_offset >= entry->log_index()) {
+            DEBUGLOG("offset %lu has been made snapshot", entry->log_index());
             continue;
         }
 
-        if (cur_offset + 1 != entry.log_index()) {
+        if (cur_offset + 1 != entry->log_index()) {
             PDLOG(WARNING,
                   "missing log entry cur_offset %lu , new entry offset %lu for "
                   "tid %u, pid %u",
-                  cur_offset, entry.log_index(), tid, pid);
+                  cur_offset, entry->log_index(), tid, pid);
         }
+        cur_offset = entry->log_index();
 
-        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
-            if (entry.dimensions_size() == 0) {
-                PDLOG(WARNING, "no dimesion. tid %u pid %u offset %lu", tid, pid, entry.log_index());
+        if (entry->has_method_type() && entry->method_type() == ::openmldb::api::MethodType::kDelete) {
+            if (entry->dimensions_size() == 0) {
+                PDLOG(WARNING, "no dimesion. tid %u pid %u offset %lu", tid, pid, entry->log_index());
             } else {
-                table->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
+                loader.Flush();
+                table->Delete(entry->dimensions(0).key(), entry->dimensions(0).idx());
             }
         } else {
-            table->Put(entry);
+            loader.Add(entry.release());
         }
-        cur_offset = entry.log_index();
         succ_cnt++;
         if (succ_cnt % 100000 == 0) {
             PDLOG(INFO,
@@ -128,6 +137,7 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             table->SchedGc();
         }
     }
+    loader.Flush();
     latest_offset = cur_offset;
     if (!reach_end_log) {
         int log_index = log_reader.GetLogIndex();
@@ -139,6 +149,8 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
         DEBUGLOG("last record end offset[%lu] tid[%u] pid[%u]", pos, tid, pid);
         std::string full_path =
             log_path_ + "/" + ::openmldb::base::FormatToString(log_index, FLAGS_binlog_name_length) + ".log";
+        // the end log record is in the same format as the file
+        std::string compression = ::openmldb::log::GetLogCompression(full_path);
         FILE* fd = fopen(full_path.c_str(), "rb+");
         if (fd == NULL) {
             PDLOG(WARNING, "fail to open file %s", full_path.c_str());
@@ -148,7 +160,7 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             PDLOG(WARNING, "fail to seek. file[%s] pos[%lu]", full_path.c_str(), pos);
             return false;
         }
-        ::openmldb::log::WriteHandle wh("off", full_path, fd, pos);
+        ::openmldb::log::WriteHandle wh(compression, full_path, fd, pos);
         wh.EndLog();
         PDLOG(INFO, "append endlog record ok. file[%s]", full_path.c_str());
     }
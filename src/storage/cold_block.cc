@@ -0,0 +1,85 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/cold_block.h"
+
+#include <snappy.h>
+#include <string.h>
+
+#include <new>
+
+#include "base/slab.h"
+#include "storage/record.h"
+#include "storage/segment.h"
+
+namespace openmldb {
+namespace storage {
+
+ColdBlock* ColdBlock::New(const std::vector<DataBlock*>& rows) {
+    if (rows.empty() || rows.size() > kMaxRowCnt) {
+        return NULL;
+    }
+    uint32_t cnt = rows.size();
+    std::string raw;
+    uint64_t old_byte_size = 0;
+    for (const DataBlock* row : rows) {
+        raw.append(row->data, row->size);
+        old_byte_size += GetRecordSize(row->size);
+    }
+    std::string compressed;
+    ::snappy::Compress(raw.data(), raw.size(), &compressed);
+    uint32_t alloc_size = GetAllocSize(cnt, compressed.size());
+    uint64_t new_byte_size =
+        ::openmldb::base::Slab::ClassSize(alloc_size) + cnt * ::openmldb::base::Slab::ClassSize(DATA_BLOCK_BYTE_SIZE);
+    if (new_byte_size >= old_byte_size) {
+        return NULL;
+    }
+    void* mem = ::openmldb::base::Slab::Default()->Allocate(alloc_size);
+    ColdBlock* block = new (mem) ColdBlock(cnt, raw.size(), compressed.size());
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < cnt; i++) {
+        block->Offsets()[i] = offset;
+        offset += rows[i]->size;
+    }
+    memcpy(block->Data(), compressed.data(), compressed.size());
+    return block;
+}
+
+void ColdBlock::UnRef() {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        uint32_t alloc_size = GetAllocSize(cnt_, compressed_size_);
+        this->~ColdBlock();
+        ::openmldb::base::Slab::Default()->Free(this, alloc_size);
+    }
+}
+
+bool ColdBlock::Uncompress(std::string* value) const {
+    if (!::snappy::Uncompress(Data(), compressed_size_, value)) {
+        return false;
+    }
+    return value->size() == raw_size_;
+}
+
+uint32_t ColdBlock::GetByteSize() const {
+    return ::openmldb::base::Slab::ClassSize(GetAllocSize(cnt_, compressed_size_));
+}
+
+uint32_t ColdBlock::GetAllocSize(uint32_t cnt, uint32_t compressed_size) {
+    return sizeof(ColdBlock) + cnt * sizeof(uint32_t) + compressed_size;
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_COLD_BLOCK_H_
+#define SRC_STORAGE_COLD_BLOCK_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace openmldb {
+namespace storage {
+
+struct DataBlock;
+
+// ColdBlock keeps a run of old rows of one key compressed together with
+// snappy. The rows of a key share most of their column values, so a run
+// compresses much better than a single row. Every row of the run is replaced
+// by a small DataBlock which points to the block, the block is freed when the
+// last of them is released
+class ColdBlock {
+ public:
+    static constexpr uint32_t kMaxRowCnt = 64;
+    static constexpr uint32_t kMaxRawSize = 64 * 1024;
+
+    // return NULL if the rows do not take less memory after compression
+    static ColdBlock* New(const std::vector<DataBlock*>& rows);
+
+    ColdBlock(const ColdBlock&) = delete;
+    ColdBlock& operator=(const ColdBlock&) = delete;
+
+    // called by the cold DataBlock which is released
+    void UnRef();
+
+    bool Uncompress(std::string* value) const;
+
+    inline uint32_t GetOffset(uint32_t pos) const { return Offsets()[pos]; }
+
+    inline uint32_t GetCount() const { return cnt_; }
+
+    // the memory taken by the block
+    uint32_t GetByteSize() const;
+
+    // the share of the block memory of the row in pos, the shares of all the
+    // rows add up to GetByteSize
+    inline uint32_t GetRowByteSize(uint32_t pos) const {
+        uint32_t byte_size = GetByteSize();
+        return byte_size / cnt_ + (pos < byte_size % cnt_ ? 1 : 0);
+    }
+
+ private:
+    ColdBlock(uint32_t cnt, uint32_t raw_size, uint32_t compressed_size)
+        : refs_(cnt), cnt_(cnt), raw_size_(raw_size), compressed_size_(compressed_size) {}
+
+    static uint32_t GetAllocSize(uint32_t cnt, uint32_t compressed_size);
+
+    inline uint32_t* Offsets() const {
+        return reinterpret_cast<uint32_t*>(const_cast<ColdBlock*>(this) + 1);
+    }
+
+    inline char* Data() const { return reinterpret_cast<char*>(Offsets() + cnt_); }
+
+ private:
+    std::atomic<uint32_t> refs_;
+    uint32_t cnt_;
+    uint32_t raw_size_;
+    uint32_t compressed_size_;
+    // followed by the offsets of cnt_ rows and the compressed rows
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_COLD_BLOCK_H_
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/cold_block.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/record.h"
+#include "storage/segment.h"
+
+namespace openmldb {
+namespace storage {
+
+class ColdBlockTest : public ::testing::Test {
+ public:
+    ColdBlockTest() {}
+    ~ColdBlockTest() {}
+};
+
+TEST_F(ColdBlockTest, New) {
+    std::vector<DataBlock*> rows;
+    for (int i = 0; i < 8; i++) {
+        std::string value(200, 'a' + i);
+        rows.push_back(new DataBlock(1, value.c_str(), value.size()));
+    }
+    ColdBlock* block = ColdBlock::New(rows);
+    ASSERT_TRUE(block != NULL);
+    ASSERT_EQ(8u, block->GetCount());
+    std::string raw;
+    ASSERT_TRUE(block->Uncompress(&raw));
+    ASSERT_EQ(1600u, raw.size());
+    uint32_t byte_size = 0;
+    for (uint32_t i = 0; i < rows.size(); i++) {
+        ASSERT_EQ(i * 200, block->GetOffset(i));
+        ASSERT_EQ(std::string(200, 'a' + i), raw.substr(block->GetOffset(i), 200));
+        byte_size += block->GetRowByteSize(i);
+    }
+    ASSERT_EQ(block->GetByteSize(), byte_size);
+    std::vector<DataBlock*> cold_rows;
+    for (uint32_t i = 0; i < rows.size(); i++) {
+        cold_rows.push_back(new DataBlock(block, i, rows[i]->size));
+        delete rows[i];
+    }
+    // the block is freed with the last cold row
+    for (DataBlock* row : cold_rows) {
+        ASSERT_EQ(block, row->GetColdBlock());
+        delete row;
+    }
+}
+
+TEST_F(ColdBlockTest, NotCompressible) {
+    std::vector<DataBlock*> rows;
+    ASSERT_TRUE(ColdBlock::New(rows) == NULL);
+    rows.push_back(new DataBlock(1, "ab", 2));
+    rows.push_back(new DataBlock(1, "cd", 2));
+    // the small rows take no less memory after compression
+    ASSERT_TRUE(ColdBlock::New(rows) == NULL);
+    for (DataBlock* row : rows) {
+        delete row;
+    }
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
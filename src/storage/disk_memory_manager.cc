@@ -0,0 +1,77 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/disk_memory_manager.h"
+
+#include "base/glog_wrapper.h"
+#include "gflags/gflags.h"
+#include "rocksdb/env.h"
+
+DECLARE_uint32(block_cache_mb);
+DECLARE_uint32(block_cache_shardbits);
+DECLARE_uint32(disk_write_buffer_budget_mb);
+DECLARE_uint32(disk_flush_threads);
+DECLARE_uint32(disk_compaction_threads);
+
+namespace openmldb {
+namespace storage {
+
+DiskMemoryManager::DiskMemoryManager()
+    : budget_((uint64_t)FLAGS_block_cache_mb << 20), shared_cache_(), write_buffer_manager_(), mu_(),
+      reserved_percent_(0) {
+    shared_cache_ = rocksdb::NewLRUCache(budget_, FLAGS_block_cache_shardbits);
+    if (FLAGS_disk_write_buffer_budget_mb > 0) {
+        write_buffer_manager_ = std::make_shared<rocksdb::WriteBufferManager>(
+            (uint64_t)FLAGS_disk_write_buffer_budget_mb << 20, shared_cache_);
+    }
+    // all the tables share the threads of the default env
+    rocksdb::Env* env = rocksdb::Env::Default();
+    env->SetBackgroundThreads(FLAGS_disk_flush_threads, rocksdb::Env::Priority::HIGH);
+    env->SetBackgroundThreads(FLAGS_disk_compaction_threads, rocksdb::Env::Priority::LOW);
+}
+
+std::shared_ptr<rocksdb::Cache> DiskMemoryManager::AcquireCache(uint32_t* percent) {
+    if (*percent == 0) {
+        return shared_cache_;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    if (*percent + reserved_percent_ > kMaxReservedPercent) {
+        PDLOG(WARNING, "block cache percent %u exceeds the budget left %u, use the shared cache", *percent,
+              kMaxReservedPercent - reserved_percent_);
+        *percent = 0;
+        return shared_cache_;
+    }
+    reserved_percent_ += *percent;
+    shared_cache_->SetCapacity(budget_ * (100 - reserved_percent_) / 100);
+    return rocksdb::NewLRUCache(budget_ * *percent / 100, FLAGS_block_cache_shardbits);
+}
+
+void DiskMemoryManager::ReleaseCache(uint32_t percent) {
+    if (percent == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    reserved_percent_ -= percent;
+    shared_cache_->SetCapacity(budget_ * (100 - reserved_percent_) / 100);
+}
+
+uint32_t DiskMemoryManager::GetReservedPercent() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return reserved_percent_;
+}
+
+}  // namespace storage
+}  // namespace openmldb
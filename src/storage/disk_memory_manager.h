@@ -0,0 +1,76 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_DISK_MEMORY_MANAGER_H_
+#define SRC_STORAGE_DISK_MEMORY_MANAGER_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <mutex>  // NOLINT
+
+#include "rocksdb/cache.h"
+#include "rocksdb/write_buffer_manager.h"
+
+namespace openmldb {
+namespace storage {
+
+// DiskMemoryManager owns the memory shared by all the disk tables of a tablet.
+// The block cache budget is shared by default, a table may reserve a percent
+// of it as its own cache, which is taken out of the shared one. The memtables
+// of all the tables are limited by one write buffer manager which is charged
+// to the block cache, so block cache and memtables stay in one budget
+class DiskMemoryManager {
+ public:
+    // the tables may outlive static destruction
+    static DiskMemoryManager* Default() {
+        static DiskMemoryManager* manager = new DiskMemoryManager();
+        return manager;
+    }
+
+    DiskMemoryManager(const DiskMemoryManager&) = delete;
+    DiskMemoryManager& operator=(const DiskMemoryManager&) = delete;
+
+    // return the shared cache and set percent to 0 if percent is 0 or the
+    // budget left is not enough
+    std::shared_ptr<rocksdb::Cache> AcquireCache(uint32_t* percent);
+
+    // return the percent reserved by AcquireCache
+    void ReleaseCache(uint32_t percent);
+
+    std::shared_ptr<rocksdb::Cache> GetSharedCache() const { return shared_cache_; }
+
+    // return nullptr if the memtables are not limited
+    std::shared_ptr<rocksdb::WriteBufferManager> GetWriteBufferManager() const { return write_buffer_manager_; }
+
+    uint32_t GetReservedPercent();
+
+ private:
+    DiskMemoryManager();
+
+    // the percent of the budget that can be reserved by tables in total
+    static constexpr uint32_t kMaxReservedPercent = 80;
+
+    uint64_t budget_;
+    std::shared_ptr<rocksdb::Cache> shared_cache_;
+    std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager_;
+    std::mutex mu_;
+    uint32_t reserved_percent_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_DISK_MEMORY_MANAGER_H_
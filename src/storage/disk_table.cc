@@ -20,6 +20,7 @@
 #include "base/glog_wrapper.h"
 #include "base/hash.h"
 #include "config.h"  // NOLINT
+#include "storage/disk_memory_manager.h"
 
 DECLARE_bool(disable_wal);
 DECLARE_uint32(max_traverse_cnt);
@@ -29,14 +30,34 @@ DECLARE_uint32(block_cache_mb);
 DECLARE_uint32(write_buffer_mb);
 DECLARE_uint32(block_cache_shardbits);
 DECLARE_bool(verify_compression);
+DECLARE_uint32(disk_ttl_compaction_hours);
+DECLARE_uint32(disk_bloom_bits_per_key);
+DECLARE_uint32(ssd_block_size_kb);
+DECLARE_uint32(hdd_block_size_kb);
 
 namespace openmldb {
 namespace storage {
 
 static rocksdb::Options ssd_option_template;
 static rocksdb::Options hdd_option_template;
+// kept to build the table factory of a table with its own block cache
+static rocksdb::BlockBasedTableOptions ssd_table_option_template;
+static rocksdb::BlockBasedTableOptions hdd_table_option_template;
 static bool options_template_initialized = false;
 
+static rocksdb::CompressionType GetCompressionType(::openmldb::common::DiskCompression compression) {
+    switch (compression) {
+        case ::openmldb::common::kDiskSnappy:
+            return rocksdb::kSnappyCompression;
+        case ::openmldb::common::kDiskLZ4:
+            return rocksdb::kLZ4Compression;
+        case ::openmldb::common::kDiskZSTD:
+            return rocksdb::kZSTD;
+        default:
+            return rocksdb::kNoCompression;
+    }
+}
+
 DiskTable::DiskTable(const std::string& name, uint32_t id, uint32_t pid, const std::map<std::string, uint32_t>& mapping,
                      uint64_t ttl, ::openmldb::type::TTLType ttl_type, ::openmldb::common::StorageMode storage_mode,
                      const std::string& table_path)
@@ -44,7 +65,8 @@ DiskTable::DiskTable(const std::string& name, uint32_t id, uint32_t pid, const s
             ::openmldb::type::CompressType::kNoCompress),
       write_opts_(),
       offset_(0),
-      table_path_(table_path) {
+      table_path_(table_path),
+      block_cache_percent_(0) {
     if (!options_template_initialized) {
         initOptionTemplate();
     }
@@ -58,7 +80,8 @@ DiskTable::DiskTable(const ::openmldb::api::TableMeta& table_meta, const std::st
             ::openmldb::type::CompressType::kNoCompress),
       write_opts_(),
       offset_(0),
-      table_path_(table_path) {
+      table_path_(table_path),
+      block_cache_percent_(0) {
     if (!options_template_initialized) {
         initOptionTemplate();
     }
@@ -76,15 +99,15 @@ DiskTable::~DiskTable() {
         db_->Close();
         delete db_;
     }
+    DiskMemoryManager::Default()->ReleaseCache(block_cache_percent_);
 }
 
 void DiskTable::initOptionTemplate() {
-    std::shared_ptr<rocksdb::Cache> cache = rocksdb::NewLRUCache(FLAGS_block_cache_mb << 20,
-                                                                 FLAGS_block_cache_shardbits);  // Can be set by flags
+    // the block cache, the write buffer budget and the background threads are
+    // shared by all the tables and owned by DiskMemoryManager
+    std::shared_ptr<rocksdb::Cache> cache = DiskMemoryManager::Default()->GetSharedCache();
     // SSD options template
     ssd_option_template.max_open_files = -1;
-    ssd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::HIGH);  // flush threads
-    ssd_option_template.env->SetBackgroundThreads(4, rocksdb::Env::Priority::LOW);   // compaction threads
     ssd_option_template.memtable_prefix_bloom_size_ratio = 0.02;
     ssd_option_template.compaction_style = rocksdb::kCompactionStyleLevel;
     ssd_option_template.write_buffer_size = FLAGS_write_buffer_mb << 20;  // L0 file size = write_buffer_size
@@ -98,13 +121,23 @@ void DiskTable::initOptionTemplate() {
         ssd_option_template.max_bytes_for_level_base >> 4;  // number of L1 files = 16
 
     rocksdb::BlockBasedTableOptions table_options;
-    // table_options.cache_index_and_filter_blocks = true;
-    // table_options.pin_l0_filter_and_index_blocks_in_cache = true;
     table_options.block_cache = cache;
-    // table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10,
-    // false));
+    if (FLAGS_disk_bloom_bits_per_key > 0) {
+        // the bloom is built on the pk part given by KeyTsPrefixTransform, a seek
+        // to a missing pk skips the files without reading any data block
+        table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(FLAGS_disk_bloom_bits_per_key, false));
+        table_options.partition_filters = true;
+    }
     table_options.whole_key_filtering = false;
-    table_options.block_size = 256 << 10;
+    // partitioned index and filter blocks are loaded into the block cache on
+    // demand, the top level ones and those of L0 stay pinned
+    table_options.index_type = rocksdb::BlockBasedTableOptions::IndexType::kTwoLevelIndexSearch;
+    table_options.metadata_block_size = 4 << 10;
+    table_options.cache_index_and_filter_blocks = true;
+    table_options.cache_index_and_filter_blocks_with_high_priority = true;
+    table_options.pin_l0_filter_and_index_blocks_in_cache = true;
+    table_options.pin_top_level_index_and_filter = true;
+    table_options.block_size = FLAGS_ssd_block_size_kb << 10;
     table_options.use_delta_encoding = false;
 #ifdef PZFPGA_ENABLE
     if (FLAGS_file_compression.compare("pz") == 0) {
@@ -123,10 +156,9 @@ void DiskTable::initOptionTemplate() {
     if (FLAGS_verify_compression) table_options.verify_compression = true;
 #endif
     ssd_option_template.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    ssd_table_option_template = table_options;
     // HDD options template
     hdd_option_template.max_open_files = -1;
-    hdd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::HIGH);  // flush threads
-    hdd_option_template.env->SetBackgroundThreads(1, rocksdb::Env::Priority::LOW);   // compaction threads
     hdd_option_template.memtable_prefix_bloom_size_ratio = 0.02;
     hdd_option_template.optimize_filters_for_hits = true;
     hdd_option_template.level_compaction_dynamic_level_bytes = true;
@@ -141,7 +173,12 @@ void DiskTable::initOptionTemplate() {
     hdd_option_template.write_buffer_size = 256 << 20;
     hdd_option_template.target_file_size_base = 256 << 20;
     hdd_option_template.max_bytes_for_level_base = 1024 << 20;
+    // large blocks keep the reads on hdd sequential
+    table_options.block_size = FLAGS_hdd_block_size_kb << 10;
     hdd_option_template.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    hdd_table_option_template = table_options;
+    ssd_option_template.write_buffer_manager = DiskMemoryManager::Default()->GetWriteBufferManager();
+    hdd_option_template.write_buffer_manager = DiskMemoryManager::Default()->GetWriteBufferManager();
 
     options_template_initialized = true;
 }
@@ -164,9 +201,11 @@ bool DiskTable::InitColumnFamilyDescriptor() {
         cfo.prefix_extractor.reset(new KeyTsPrefixTransform());
         const auto& indexs = inner_index->GetIndex();
         auto index_def = indexs.front();
-        if (index_def->GetTTLType() == ::openmldb::storage::TTLType::kAbsoluteTime ||
-            index_def->GetTTLType() == ::openmldb::storage::TTLType::kAbsOrLat) {
-            cfo.compaction_filter_factory = std::make_shared<AbsoluteTTLFilterFactory>(inner_index);
+        // ttl may be updated later, so the filter is set for all ttl types
+        cfo.compaction_filter_factory = std::make_shared<AbsoluteTTLFilterFactory>(inner_index);
+        cfo.periodic_compaction_seconds = (uint64_t)FLAGS_disk_ttl_compaction_hours * 3600;
+        if (table_meta_ && table_meta_->has_storage_profile()) {
+            ApplyStorageProfile(table_meta_->storage_profile(), &cfo);
         }
         cf_ds_.push_back(rocksdb::ColumnFamilyDescriptor(index_def->GetName(), cfo));
         DEBUGLOG("add cf_name %s. tid %u pid %u", index_def->GetName().c_str(), id_, pid_);
@@ -174,6 +213,41 @@ bool DiskTable::InitColumnFamilyDescriptor() {
     return true;
 }
 
+void DiskTable::ApplyStorageProfile(const ::openmldb::common::StorageProfile& profile,
+                                    rocksdb::ColumnFamilyOptions* cfo) {
+    if (profile.has_write_buffer_mb() && profile.write_buffer_mb() > 0) {
+        cfo->write_buffer_size = (uint64_t)profile.write_buffer_mb() << 20;
+    }
+    if (profile.has_compaction_style()) {
+        if (profile.compaction_style() == ::openmldb::common::kUniversalCompaction) {
+            cfo->compaction_style = rocksdb::kCompactionStyleUniversal;
+            cfo->level_compaction_dynamic_level_bytes = false;
+        } else {
+            cfo->compaction_style = rocksdb::kCompactionStyleLevel;
+        }
+    }
+    if (profile.compression_per_level_size() > 0) {
+        cfo->compression_per_level.clear();
+        for (int i = 0; i < profile.compression_per_level_size(); i++) {
+            cfo->compression_per_level.push_back(GetCompressionType(profile.compression_per_level(i)));
+        }
+    }
+    if (profile.block_cache_percent() > 0) {
+        // the cache is reserved once and shared by all the column families
+        if (!block_cache_) {
+            block_cache_percent_ = profile.block_cache_percent();
+            block_cache_ = DiskMemoryManager::Default()->AcquireCache(&block_cache_percent_);
+        }
+        if (block_cache_percent_ > 0) {
+            rocksdb::BlockBasedTableOptions table_options =
+                storage_mode_ == ::openmldb::common::StorageMode::kSSD ? ssd_table_option_template
+                                                                       : hdd_table_option_template;
+            table_options.block_cache = block_cache_;
+            cfo->table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+        }
+    }
+}
+
 bool DiskTable::Init() {
     if (!InitFromMeta()) {
         return false;
@@ -315,132 +389,9 @@ bool DiskTable::Get(uint32_t idx, const std::string& pk, uint64_t ts, std::strin
 
 bool DiskTable::Get(const std::string& pk, uint64_t ts, std::string& value) { return Get(0, pk, ts, value); }
 
-void DiskTable::SchedGc() {
-    GcHead();
-    UpdateTTL();
-}
-
-void DiskTable::GcHead() {
-    uint64_t start_time = ::baidu::common::timer::get_micros() / 1000;
-    auto inner_indexs = table_index_.GetAllInnerIndex();
-    for (const auto& inner_index : *inner_indexs) {
-        uint32_t idx = inner_index->GetId();
-        rocksdb::ReadOptions ro = rocksdb::ReadOptions();
-        const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
-        ro.snapshot = snapshot;
-        // ro.prefix_same_as_start = true;
-        ro.pin_data = true;
-        rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[idx + 1]);
-        it->SeekToFirst();
-        const auto& indexs = inner_index->GetIndex();
-        if (indexs.size() > 1) {
-            bool need_ttl = false;
-            std::map<uint32_t, uint64_t> ttl_map;
-            for (const auto& index : indexs) {
-                auto ts_col = index->GetTsColumn();
-                if (ts_col) {
-                    auto lat_ttl = index->GetTTL()->lat_ttl;
-                    if (lat_ttl > 0) {
-                        ttl_map.emplace(ts_col->GetId(), lat_ttl);
-                        need_ttl = true;
-                    }
-                }
-            }
-            if (!need_ttl) {
-                continue;
-            }
-            std::map<uint32_t, uint32_t> key_cnt;
-            std::map<uint32_t, uint64_t> delete_key_map;
-            std::string last_pk;
-            while (it->Valid()) {
-                std::string cur_pk;
-                uint64_t ts = 0;
-                uint32_t ts_idx = 0;
-                ParseKeyAndTs(true, it->key(), cur_pk, ts, ts_idx);
-                if (!last_pk.empty() && cur_pk == last_pk) {
-                    auto ttl_iter = ttl_map.find(ts_idx);
-                    if (ttl_iter != ttl_map.end() && ttl_iter->second > 0) {
-                        auto key_cnt_iter = key_cnt.find(ts_idx);
-                        if (key_cnt_iter == key_cnt.end()) {
-                            key_cnt.insert(std::make_pair(ts_idx, 1));
-                        } else {
-                            key_cnt_iter->second++;
-                        }
-                        if (key_cnt_iter->second > ttl_iter->second &&
-                            delete_key_map.find(ts_idx) == delete_key_map.end()) {
-                            delete_key_map.insert(std::make_pair(ts_idx, ts));
-                        }
-                    }
-                } else {
-                    for (const auto& kv : delete_key_map) {
-                        std::string combine_key1 = CombineKeyTs(last_pk, kv.second, kv.first);
-                        std::string combine_key2 = CombineKeyTs(last_pk, 0, kv.first);
-                        rocksdb::Status s = db_->DeleteRange(write_opts_, cf_hs_[idx + 1], rocksdb::Slice(combine_key1),
-                                                             rocksdb::Slice(combine_key2));
-                        if (!s.ok()) {
-                            PDLOG(WARNING, "Delete failed. tid %u pid %u msg %s", id_, pid_, s.ToString().c_str());
-                        }
-                    }
-                    delete_key_map.clear();
-                    key_cnt.clear();
-                    key_cnt.insert(std::make_pair(ts_idx, 1));
-                    last_pk = cur_pk;
-                }
-                it->Next();
-            }
-            for (const auto& kv : delete_key_map) {
-                std::string combine_key1 = CombineKeyTs(last_pk, kv.second, kv.first);
-                std::string combine_key2 = CombineKeyTs(last_pk, 0, kv.first);
-                rocksdb::Status s = db_->DeleteRange(write_opts_, cf_hs_[idx + 1], rocksdb::Slice(combine_key1),
-                                                     rocksdb::Slice(combine_key2));
-                if (!s.ok()) {
-                    PDLOG(WARNING, "Delete failed. tid %u pid %u msg %s", id_, pid_, s.ToString().c_str());
-                }
-            }
-        } else {
-            auto index = indexs.front();
-            auto ttl_num = index->GetTTL()->lat_ttl;
-            if (ttl_num < 1) {
-                continue;
-            }
-            std::string last_pk;
-            uint64_t count = 0;
-            while (it->Valid()) {
-                std::string cur_pk;
-                uint64_t ts = 0;
-                ParseKeyAndTs(it->key(), cur_pk, ts);
-                if (!last_pk.empty() && cur_pk == last_pk) {
-                    if (ts == 0 || count < ttl_num) {
-                        it->Next();
-                        count++;
-                        continue;
-                    } else {
-                        std::string combine_key1 = CombineKeyTs(cur_pk, ts);
-                        std::string combine_key2 = CombineKeyTs(cur_pk, 0);
-                        rocksdb::Status s = db_->DeleteRange(write_opts_, cf_hs_[idx + 1], rocksdb::Slice(combine_key1),
-                                                             rocksdb::Slice(combine_key2));
-                        if (!s.ok()) {
-                            PDLOG(WARNING, "Delete failed. tid %u pid %u msg %s", id_, pid_, s.ToString().c_str());
-                        }
-                        it->Seek(rocksdb::Slice(combine_key2));
-                    }
-                } else {
-                    count = 1;
-                    last_pk = cur_pk;
-                    it->Next();
-                }
-            }
-        }
-        delete it;
-        db_->ReleaseSnapshot(snapshot);
-    }
-    uint64_t time_used = ::baidu::common::timer::get_micros() / 1000 - start_time;
-    PDLOG(INFO, "Gc used %lu second. tid %u pid %u", time_used / 1000, id_, pid_);
-}
-
-void DiskTable::GcTTLOrHead() {}
-
-void DiskTable::GcTTLAndHead() {}
+// the rows expired are dropped by AbsoluteTTLCompactionFilter when rocksdb
+// compacts, the files not compacted for long are picked by periodic compaction
+void DiskTable::SchedGc() { UpdateTTL(); }
 
 // ttl as ms
 uint64_t DiskTable::GetExpireTime(const TTLSt& ttl_st) {
@@ -512,7 +463,7 @@ TraverseIterator* DiskTable::NewTraverseIterator(uint32_t index) {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.total_order_seek = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
     if (inner_index && inner_index->GetIndex().size() > 1) {
@@ -846,7 +797,7 @@ void DiskTableTraverseIterator::NextPK() {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.total_order_seek = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
     if (inner_index && inner_index->GetIndex().size() > 1) {
@@ -959,7 +910,7 @@ std::unique_ptr<::hybridse::vm::RowIterator> DiskTableKeyIterator::GetValue() {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, column_handle_);
     return std::make_unique<DiskTableRowIterator>(db_, it, snapshot, ttl_type_, expire_time_,
@@ -970,7 +921,7 @@ std::unique_ptr<::hybridse::vm::RowIterator> DiskTableKeyIterator::GetValue() {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, column_handle_);
     return new DiskTableRowIterator(db_, it, snapshot, ttl_type_, expire_time_, expire_cnt_, pk_, ts_, has_ts_idx_,
@@ -1133,7 +1084,7 @@ int DiskTable::GetCount(uint32_t index, const std::string& pk, uint64_t& count)
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
 
@@ -28,6 +28,7 @@
 #include "gflags/gflags.h"
 #include "proto/common.pb.h"
 #include "proto/tablet.pb.h"
+#include "rocksdb/cache.h"
 #include "rocksdb/compaction_filter.h"
 #include "rocksdb/db.h"
 #include "rocksdb/filter_policy.h"
@@ -143,9 +144,17 @@ class KeyTsPrefixTransform : public rocksdb::SliceTransform {
     bool SameResultWhenAppended(const rocksdb::Slice& prefix) const override { return InDomain(prefix); }
 };
 
+// AbsoluteTTLCompactionFilter drops the rows expired by any ttl type while
+// rocksdb compacts, so disk tables need no gc scan. Rows of a key are ordered
+// by ts desc, the position of a row counted in a compaction is never greater
+// than the real one, so a row over the latest ttl can be dropped safely
 class AbsoluteTTLCompactionFilter : public rocksdb::CompactionFilter {
  public:
-    explicit AbsoluteTTLCompactionFilter(std::shared_ptr<InnerIndexSt> inner_index) : inner_index_(inner_index) {}
+    explicit AbsoluteTTLCompactionFilter(std::shared_ptr<InnerIndexSt> inner_index)
+        : inner_index_(inner_index),
+          cur_time_(::baidu::common::timer::get_micros() / 1000),
+          last_key_(),
+          key_cnt_(0) {}
     virtual ~AbsoluteTTLCompactionFilter() {}
 
     const char* Name() const override { return "AbsoluteTTLCompactionFilter"; }
@@ -155,7 +164,7 @@ class AbsoluteTTLCompactionFilter : public rocksdb::CompactionFilter {
         if (key.size() < TS_LEN) {
             return false;
         }
-        uint64_t real_ttl = 0;
+        std::shared_ptr<TTLSt> ttl;
         const auto& indexs = inner_index_->GetIndex();
         if (indexs.size() > 1) {
             if (key.size() < TS_LEN + TS_POS_LEN) {
@@ -163,39 +172,50 @@ class AbsoluteTTLCompactionFilter : public rocksdb::CompactionFilter {
             }
             uint32_t ts_idx = *((uint32_t*)(key.data() + key.size() - TS_LEN -  // NOLINT
                                           TS_POS_LEN));
-            bool has_found = false;
             for (const auto& index : indexs) {
                 auto ts_col = index->GetTsColumn();
                 if (!ts_col) {
                     return false;
                 }
                 if (ts_col->GetId() == ts_idx) {
-                    real_ttl = index->GetTTL()->abs_ttl;
-                    has_found = true;
+                    ttl = index->GetTTL();
                     break;
                 }
             }
-            if (!has_found) {
+            if (!ttl) {
                 return false;
             }
         } else {
-            real_ttl = indexs.front()->GetTTL()->abs_ttl;
+            ttl = indexs.front()->GetTTL();
         }
-        if (real_ttl < 1) {
+        // the key with ts pos is counted separately for every ts column
+        rocksdb::Slice cur_key(key.data(), key.size() - TS_LEN);
+        if (key_cnt_ == 0 || cur_key != rocksdb::Slice(last_key_)) {
+            last_key_.assign(cur_key.data(), cur_key.size());
+            key_cnt_ = 0;
+        }
+        key_cnt_++;
+        if (!ttl->NeedGc()) {
             return false;
         }
         uint64_t ts = 0;
         memcpy(static_cast<void*>(&ts), key.data() + key.size() - TS_LEN, TS_LEN);
         memrev64ifbe(static_cast<void*>(&ts));
-        uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
-        if (ts < cur_time - real_ttl) {
-            return true;
+        uint64_t expire_time = 0;
+        if (ttl->abs_ttl > 0 && cur_time_ > ttl->abs_ttl) {
+            expire_time = cur_time_ - ttl->abs_ttl;
         }
-        return false;
+        TTLSt expire_st(expire_time, ttl->lat_ttl, ttl->ttl_type);
+        return expire_st.IsExpired(ts, key_cnt_);
     }
 
  private:
     std::shared_ptr<InnerIndexSt> inner_index_;
+    uint64_t cur_time_;
+    // filter is called by one compaction in key order, count the rows of the
+    // last key
+    mutable std::string last_key_;
+    mutable uint64_t key_cnt_;
 };
 
 class AbsoluteTTLFilterFactory : public rocksdb::CompactionFilterFactory {
@@ -361,6 +381,9 @@ class DiskTable : public Table {
 
     bool InitColumnFamilyDescriptor();
 
+    // apply the tuning of the table meta on the options of the storage mode
+    void ApplyStorageProfile(const ::openmldb::common::StorageProfile& profile, rocksdb::ColumnFamilyOptions* cfo);
+
     bool Init() override;
 
     static void initOptionTemplate();
@@ -402,10 +425,6 @@ class DiskTable : public Table {
 
     void SchedGc() override;
 
-    void GcHead();
-    void GcTTLAndHead();
-    void GcTTLOrHead();
-
     bool IsExpire(const ::openmldb::api::LogEntry& entry) override;
 
     void CompactDB() {
@@ -434,6 +453,9 @@ class DiskTable : public Table {
     KeyTSComparator cmp_;
     std::atomic<uint64_t> offset_;
     std::string table_path_;
+    // the block cache reserved by the storage profile
+    std::shared_ptr<rocksdb::Cache> block_cache_;
+    uint32_t block_cache_percent_;
 };
 
 }  // namespace storage
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gflags/gflags.h>
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "base/file_util.h"
+#include "benchmark/benchmark.h"
+#include "common/timer.h"
+#include "storage/disk_table.h"
+#include "storage/ticket.h"
+
+DECLARE_string(ssd_root_path);
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t KEY_NUM = 20000;
+static const uint32_t RECORD_NUM_PER_KEY = 10;
+
+// the table is shared by the benchmarks and compacted, so the sst files are
+// seeked instead of the memtable
+static DiskTable* GetTable() {
+    static DiskTable* table = [] {
+        std::map<std::string, uint32_t> mapping;
+        mapping.insert(std::make_pair("idx0", 0));
+        std::string table_path = FLAGS_ssd_root_path + "/1_1";
+        DiskTable* table = new DiskTable("t1", 1, 1, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime,
+                                         ::openmldb::common::StorageMode::kSSD, table_path);
+        table->Init();
+        std::string value(128, 'a');
+        for (uint32_t i = 0; i < KEY_NUM; i++) {
+            std::string key = "key" + std::to_string(i);
+            for (uint32_t j = 0; j < RECORD_NUM_PER_KEY; j++) {
+                table->Put(key, 9527 + j, value.c_str(), value.size());
+            }
+        }
+        table->CompactDB();
+        return table;
+    }();
+    return table;
+}
+
+// run with --disk_bloom_bits_per_key=0 --ssd_block_size_kb=256 to get the
+// latency without the prefix bloom filter
+static void BM_DiskTableSeek(benchmark::State& state, const std::string& prefix) {  // NOLINT
+    DiskTable* table = GetTable();
+    uint32_t idx = 0;
+    for (auto _ : state) {
+        std::string key = prefix + std::to_string(idx++ % KEY_NUM);
+        Ticket ticket;
+        TableIterator* it = table->NewIterator(key, ticket);
+        it->Seek(9527 + RECORD_NUM_PER_KEY / 2);
+        benchmark::DoNotOptimize(it->Valid());
+        delete it;
+    }
+}
+
+BENCHMARK_CAPTURE(BM_DiskTableSeek, hit, std::string("key"))->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_DiskTableSeek, miss, std::string("miss"))->Unit(benchmark::kMicrosecond);
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    FLAGS_ssd_root_path = "/tmp/disk_table_bm" + std::to_string(::baidu::common::timer::get_micros());
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::openmldb::base::RemoveDir(FLAGS_ssd_root_path);
+    return 0;
+}
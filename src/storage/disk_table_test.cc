@@ -24,6 +24,7 @@
 #include "codec/sdk_codec.h"
 #include "common/timer.h"
 #include "gtest/gtest.h"
+#include "storage/disk_memory_manager.h"
 #include "storage/ticket.h"
 #include "test/util.h"
 
@@ -1024,7 +1025,7 @@ TEST_F(DiskTableTest, GcHeadMulTs) {
             }
         }
     }
-    table->SchedGc();
+    table->CompactDB();
     iter = table->NewIterator(0, "card0", ticket);
     iter->SeekToFirst();
     while (iter->Valid()) {
@@ -1103,7 +1104,7 @@ TEST_F(DiskTableTest, GcHead) {
             }
         }
     }
-    table->GcHead();
+    table->CompactDB();
     for (int idx = 0; idx < 100; idx++) {
         std::string key = "test" + std::to_string(idx);
         uint64_t ts = 9537;
@@ -1125,6 +1126,165 @@ TEST_F(DiskTableTest, GcHead) {
     RemoveData(table_path);
 }
 
+TEST_F(DiskTableTest, GcAbsOrLat) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_tid(16);
+    table_meta.set_pid(1);
+    table_meta.set_storage_mode(::openmldb::common::kHDD);
+    table_meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "idx0", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "value", ::openmldb::type::kString);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "idx0", "idx0", "", ::openmldb::type::kAbsOrLat, 3, 2);
+
+    std::string table_path = FLAGS_hdd_root_path + "/16_1";
+    DiskTable* table = new DiskTable(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        for (int k = 0; k < 5; k++) {
+            ASSERT_TRUE(table->Put(key, cur_time - k * 60 * 1000 - 1000, "value", 5));
+        }
+    }
+    table->SchedGc();
+    table->CompactDB();
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        for (int k = 0; k < 5; k++) {
+            std::string value;
+            // the rows after the latest two are expired
+            if (k < 2) {
+                ASSERT_TRUE(table->Get(key, cur_time - k * 60 * 1000 - 1000, value));
+                ASSERT_EQ("value", value);
+            } else {
+                ASSERT_FALSE(table->Get(key, cur_time - k * 60 * 1000 - 1000, value));
+            }
+        }
+    }
+    delete table;
+    RemoveData(table_path);
+}
+
+TEST_F(DiskTableTest, GcAbsAndLat) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_tid(17);
+    table_meta.set_pid(1);
+    table_meta.set_storage_mode(::openmldb::common::kHDD);
+    table_meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "idx0", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "value", ::openmldb::type::kString);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "idx0", "idx0", "", ::openmldb::type::kAbsAndLat, 1, 3);
+
+    std::string table_path = FLAGS_hdd_root_path + "/17_1";
+    DiskTable* table = new DiskTable(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        for (int k = 0; k < 5; k++) {
+            ASSERT_TRUE(table->Put(key, cur_time - k * 60 * 1000 - 1000, "value", 5));
+        }
+    }
+    table->SchedGc();
+    table->CompactDB();
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        for (int k = 0; k < 5; k++) {
+            std::string value;
+            // the rows older than one minute are kept if they are in the latest three
+            if (k < 3) {
+                ASSERT_TRUE(table->Get(key, cur_time - k * 60 * 1000 - 1000, value));
+                ASSERT_EQ("value", value);
+            } else {
+                ASSERT_FALSE(table->Get(key, cur_time - k * 60 * 1000 - 1000, value));
+            }
+        }
+    }
+    delete table;
+    RemoveData(table_path);
+}
+
+TEST_F(DiskTableTest, StorageProfile) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_tid(18);
+    table_meta.set_pid(1);
+    table_meta.set_storage_mode(::openmldb::common::kSSD);
+    table_meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "idx0", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "value", ::openmldb::type::kString);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "idx0", "idx0", "", ::openmldb::type::kAbsoluteTime, 0, 0);
+    auto profile = table_meta.mutable_storage_profile();
+    profile->set_write_buffer_mb(16);
+    profile->set_compaction_style(::openmldb::common::kUniversalCompaction);
+    profile->set_block_cache_percent(10);
+    profile->add_compression_per_level(::openmldb::common::kDiskNoCompression);
+    profile->add_compression_per_level(::openmldb::common::kDiskSnappy);
+
+    std::string table_path = FLAGS_ssd_root_path + "/18_1";
+    DiskTable* table = new DiskTable(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    ASSERT_EQ(10u, DiskMemoryManager::Default()->GetReservedPercent());
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        ASSERT_TRUE(table->Put(key, 9537, "value", 5));
+    }
+    table->CompactDB();
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        std::string value;
+        ASSERT_TRUE(table->Get(key, 9537, value));
+        ASSERT_EQ("value", value);
+    }
+    delete table;
+    // the reserved cache is returned to the shared one
+    ASSERT_EQ(0u, DiskMemoryManager::Default()->GetReservedPercent());
+    RemoveData(table_path);
+}
+
+// the pk prefix bloom and the prefix seek must not mix up the keys which
+// share a prefix, and a missing key is not found
+TEST_F(DiskTableTest, PrefixSeek) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = FLAGS_ssd_root_path + "/19_1";
+    DiskTable* table = new DiskTable("t1", 19, 1, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime,
+                                     ::openmldb::common::StorageMode::kSSD, table_path);
+    ASSERT_TRUE(table->Init());
+    for (int idx = 0; idx < 200; idx++) {
+        std::string key = "key" + std::to_string(idx);
+        for (int k = 0; k < 10; k++) {
+            ASSERT_TRUE(table->Put(key, 9527 + k, key.c_str(), key.size()));
+        }
+    }
+    table->CompactDB();
+    for (int idx = 0; idx < 200; idx++) {
+        std::string key = "key" + std::to_string(idx);
+        Ticket ticket;
+        TableIterator* it = table->NewIterator(key, ticket);
+        it->Seek(9527 + 5);
+        for (int k = 5; k >= 0; k--) {
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(key, it->GetPK());
+            ASSERT_EQ(9527 + k, (int64_t)it->GetKey());
+            ASSERT_EQ(key, it->GetValue().ToString());
+            it->Next();
+        }
+        ASSERT_FALSE(it->Valid());
+        delete it;
+    }
+    for (const std::string& key : {"miss", "key", "key1000", "key19x"}) {
+        Ticket ticket;
+        TableIterator* it = table->NewIterator(key, ticket);
+        it->Seek(9527 + 5);
+        ASSERT_FALSE(it->Valid());
+        it->SeekToFirst();
+        ASSERT_FALSE(it->Valid());
+        delete it;
+    }
+    delete table;
+    RemoveData(table_path);
+}
+
 TEST_F(DiskTableTest, CheckPoint) {
     std::map<std::string, uint32_t> mapping;
     mapping.insert(std::make_pair("idx0", 0));
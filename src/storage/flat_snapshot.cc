@@ -0,0 +1,376 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/flat_snapshot.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <mutex>  // NOLINT
+
+#include "base/glog_wrapper.h"
+#include "log/crc32c.h"
+
+namespace openmldb {
+namespace storage {
+
+static inline uint64_t AlignUp(uint64_t size, uint32_t align) { return (size + align - 1) / align * align; }
+
+Slice FlatRecord::GetKey(uint32_t pos) const {
+    const char* key = GetValue().data() + header_->value_size;
+    for (uint32_t i = 0; i < pos; i++) {
+        key += GetDimension(i).key_size;
+    }
+    return Slice(key, GetDimension(pos).key_size);
+}
+
+void FlatRecord::GetDimensions(std::vector<std::pair<uint32_t, Slice>>* dimensions) const {
+    dimensions->clear();
+    const char* key = GetValue().data() + header_->value_size;
+    for (uint32_t i = 0; i < header_->dim_cnt; i++) {
+        const FlatDimension& dim = GetDimension(i);
+        dimensions->emplace_back(dim.idx, Slice(key, dim.key_size));
+        key += dim.key_size;
+    }
+}
+
+void FlatRecord::ToLogEntry(::openmldb::api::LogEntry* entry) const {
+    entry->Clear();
+    entry->set_log_index(header_->log_index);
+    entry->set_term(header_->term);
+    entry->set_ts(header_->ts);
+    Slice value = GetValue();
+    entry->set_value(value.data(), value.size());
+    const char* key = value.data() + value.size();
+    for (uint32_t i = 0; i < header_->dim_cnt; i++) {
+        const FlatDimension& dim = GetDimension(i);
+        ::openmldb::api::Dimension* dimension = entry->add_dimensions();
+        dimension->set_idx(dim.idx);
+        dimension->set_key(key, dim.key_size);
+        key += dim.key_size;
+    }
+    for (uint32_t i = 0; i < header_->ts_dim_cnt; i++) {
+        ::openmldb::api::TSDimension* ts_dimension = entry->add_ts_dimensions();
+        ts_dimension->set_idx(GetTSDimension(i).idx);
+        ts_dimension->set_ts(GetTSDimension(i).ts);
+    }
+}
+
+uint32_t FlatRecord::ComputeCrc(const char* data, uint32_t size) {
+    uint32_t crc = ::openmldb::log::Value(data, offsetof(FlatRecordHeader, crc));
+    crc = ::openmldb::log::Extend(crc, data + sizeof(FlatRecordHeader), size - sizeof(FlatRecordHeader));
+    return ::openmldb::log::Mask(crc);
+}
+
+uint32_t FlatRecord::GetEncodeSize(const ::openmldb::api::LogEntry& entry) {
+    uint64_t size = sizeof(FlatRecordHeader) + entry.ts_dimensions_size() * sizeof(FlatTSDimension) +
+                    entry.value().size();
+    if (entry.dimensions_size() == 0) {
+        size += sizeof(FlatDimension) + entry.pk().size();
+    }
+    for (const auto& dim : entry.dimensions()) {
+        size += sizeof(FlatDimension) + dim.key().size();
+    }
+    return AlignUp(size, 8);
+}
+
+FlatSnapshotWriter::FlatSnapshotWriter(const std::string& fname, FILE* fd)
+    : fname_(fname), fd_(fd), count_(0), data_size_(0), buf_() {
+    // the header page is written at last
+    std::string header_page(FLAT_SNAPSHOT_PAGE_SIZE, '\0');
+    fwrite(header_page.data(), 1, header_page.size(), fd_);
+}
+
+FlatSnapshotWriter::~FlatSnapshotWriter() {
+    if (fd_ != NULL) {
+        fclose(fd_);
+        fd_ = NULL;
+    }
+}
+
+::openmldb::log::Status FlatSnapshotWriter::Write(const ::openmldb::api::LogEntry& entry) {
+    if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+        return ::openmldb::log::Status::OK();
+    }
+    uint32_t size = FlatRecord::GetEncodeSize(entry);
+    buf_.assign(size, '\0');
+    char* data = &buf_[0];
+    FlatRecordHeader* header = reinterpret_cast<FlatRecordHeader*>(data);
+    header->size = size;
+    header->value_size = entry.value().size();
+    header->log_index = entry.log_index();
+    header->term = entry.term();
+    header->ts = entry.ts();
+    // the pk of an entry without dimension is the key of index 0
+    header->dim_cnt = entry.dimensions_size() > 0 ? entry.dimensions_size() : 1;
+    header->ts_dim_cnt = entry.ts_dimensions_size();
+    char* cur = data + sizeof(FlatRecordHeader);
+    for (const auto& ts_dim : entry.ts_dimensions()) {
+        FlatTSDimension* ts_dimension = reinterpret_cast<FlatTSDimension*>(cur);
+        ts_dimension->idx = ts_dim.idx();
+        ts_dimension->ts = ts_dim.ts();
+        cur += sizeof(FlatTSDimension);
+    }
+    std::string keys;
+    if (entry.dimensions_size() == 0) {
+        FlatDimension* dimension = reinterpret_cast<FlatDimension*>(cur);
+        dimension->idx = 0;
+        dimension->key_size = entry.pk().size();
+        cur += sizeof(FlatDimension);
+        keys = entry.pk();
+    }
+    for (const auto& dim : entry.dimensions()) {
+        FlatDimension* dimension = reinterpret_cast<FlatDimension*>(cur);
+        dimension->idx = dim.idx();
+        dimension->key_size = dim.key().size();
+        cur += sizeof(FlatDimension);
+        keys.append(dim.key());
+    }
+    memcpy(cur, entry.value().data(), entry.value().size());
+    cur += entry.value().size();
+    memcpy(cur, keys.data(), keys.size());
+    header->crc = FlatRecord::ComputeCrc(data, size);
+    return Append(data, size);
+}
+
+::openmldb::log::Status FlatSnapshotWriter::Write(const FlatRecord& record) {
+    Slice raw = record.Raw();
+    return Append(raw.data(), raw.size());
+}
+
+::openmldb::log::Status FlatSnapshotWriter::Append(const char* data, uint32_t size) {
+    if (fwrite(data, 1, size, fd_) != size) {
+        return ::openmldb::log::Status::IOError(fname_, strerror(errno));
+    }
+    data_size_ += size;
+    count_++;
+    return ::openmldb::log::Status::OK();
+}
+
+::openmldb::log::Status FlatSnapshotWriter::EndLog() {
+    uint32_t padding = AlignUp(data_size_, FLAT_SNAPSHOT_PAGE_SIZE) - data_size_;
+    if (padding > 0) {
+        std::string zeros(padding, '\0');
+        if (fwrite(zeros.data(), 1, zeros.size(), fd_) != zeros.size()) {
+            return ::openmldb::log::Status::IOError(fname_, strerror(errno));
+        }
+    }
+    FlatSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FLAT_SNAPSHOT_MAGIC;
+    header.version = FLAT_SNAPSHOT_VERSION;
+    header.count = count_;
+    header.data_size = data_size_;
+    if (fseek(fd_, 0, SEEK_SET) != 0 || fwrite(&header, 1, sizeof(header), fd_) != sizeof(header) ||
+        fflush(fd_) == EOF || fsync(fileno(fd_)) == -1) {
+        return ::openmldb::log::Status::IOError(fname_, strerror(errno));
+    }
+    return ::openmldb::log::Status::OK();
+}
+
+std::shared_ptr<FlatSnapshotFile> FlatSnapshotFile::Open(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < FLAT_SNAPSHOT_PAGE_SIZE) {
+        PDLOG(WARNING, "invalid flat snapshot %s", path.c_str());
+        close(fd);
+        return nullptr;
+    }
+    void* base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping does not need the fd
+    close(fd);
+    if (base == MAP_FAILED) {
+        PDLOG(WARNING, "fail to mmap %s for error %s", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    madvise(base, st.st_size, MADV_SEQUENTIAL);
+    std::shared_ptr<FlatSnapshotFile> file(new FlatSnapshotFile(path, reinterpret_cast<char*>(base), st.st_size));
+    const FlatSnapshotHeader* header = file->header_;
+    if (header->magic != FLAT_SNAPSHOT_MAGIC || header->version != FLAT_SNAPSHOT_VERSION ||
+        header->data_size > file->size_ - FLAT_SNAPSHOT_PAGE_SIZE) {
+        PDLOG(WARNING, "invalid header of flat snapshot %s, magic %u version %u", path.c_str(), header->magic,
+              header->version);
+        return nullptr;
+    }
+    return file;
+}
+
+FlatSnapshotFile::FlatSnapshotFile(const std::string& path, char* base, uint64_t size)
+    : path_(path), base_(base), size_(size), header_(reinterpret_cast<const FlatSnapshotHeader*>(base)), rows_(0) {}
+
+// the files which have rows referring to them, keyed by the base address
+static std::mutex mapped_files_mu;
+static std::map<const char*, std::shared_ptr<FlatSnapshotFile>> mapped_files;
+
+void FlatSnapshotFile::RefRow() {
+    if (rows_.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::lock_guard<std::mutex> lock(mapped_files_mu);
+        mapped_files.emplace(base_, shared_from_this());
+    }
+}
+
+void FlatSnapshotFile::UnRefRow(const char* data) {
+    std::shared_ptr<FlatSnapshotFile> file;
+    {
+        std::lock_guard<std::mutex> lock(mapped_files_mu);
+        auto it = mapped_files.upper_bound(data);
+        if (it == mapped_files.begin()) {
+            return;
+        }
+        --it;
+        if (it->second->rows_.fetch_sub(1, std::memory_order_relaxed) != 1) {
+            return;
+        }
+        // unmap it out of the lock
+        file = std::move(it->second);
+        mapped_files.erase(it);
+    }
+    PDLOG(INFO, "the rows of flat snapshot %s are all freed", file->path_.c_str());
+}
+
+void UnRefMappedRow(const char* data) { FlatSnapshotFile::UnRefRow(data); }
+
+FlatSnapshotFile::~FlatSnapshotFile() {
+    if (munmap(base_, size_) != 0) {
+        PDLOG(WARNING, "fail to munmap %s for error %s", path_.c_str(), strerror(errno));
+    }
+}
+
+void FlatSnapshotFile::AdviseRandom() { madvise(base_, size_, MADV_RANDOM); }
+
+FlatSnapshotFile::Iterator::Iterator(const FlatSnapshotFile* file)
+    : cur_(file->base_ + FLAT_SNAPSHOT_PAGE_SIZE),
+      end_(file->base_ + FLAT_SNAPSHOT_PAGE_SIZE + file->header_->data_size),
+      valid_(false),
+      record_(),
+      status_() {
+    Parse();
+}
+
+void FlatSnapshotFile::Iterator::Next() {
+    cur_ += reinterpret_cast<const FlatRecordHeader*>(cur_)->size;
+    Parse();
+}
+
+void FlatSnapshotFile::Iterator::Parse() {
+    valid_ = false;
+    if (cur_ >= end_) {
+        return;
+    }
+    uint64_t left = end_ - cur_;
+    const FlatRecordHeader* header = reinterpret_cast<const FlatRecordHeader*>(cur_);
+    uint64_t size = sizeof(FlatRecordHeader);
+    if (left >= size) {
+        size += header->ts_dim_cnt * sizeof(FlatTSDimension) + header->dim_cnt * sizeof(FlatDimension) +
+                header->value_size;
+    }
+    if (left < sizeof(FlatRecordHeader) || header->size % 8 != 0 || header->size > left || size > header->size ||
+        header->dim_cnt == 0) {
+        status_ = ::openmldb::log::Status::Corruption("invalid flat record");
+        return;
+    }
+    const FlatDimension* dims = reinterpret_cast<const FlatDimension*>(
+        cur_ + sizeof(FlatRecordHeader) + header->ts_dim_cnt * sizeof(FlatTSDimension));
+    for (uint32_t i = 0; i < header->dim_cnt; i++) {
+        size += dims[i].key_size;
+    }
+    if (size > header->size) {
+        status_ = ::openmldb::log::Status::Corruption("invalid flat record");
+        return;
+    }
+    if (FlatRecord::ComputeCrc(cur_, header->size) != header->crc) {
+        status_ = ::openmldb::log::Status::Corruption("checksum mismatch");
+        return;
+    }
+    record_ = FlatRecord(cur_);
+    valid_ = true;
+}
+
+std::unique_ptr<SnapshotReader> SnapshotReader::Open(const std::string& path, ::openmldb::api::SnapshotFormat format,
+                                                     bool compressed) {
+    std::unique_ptr<SnapshotReader> reader(new SnapshotReader());
+    if (format == ::openmldb::api::kFlatSnapshot) {
+        reader->flat_ = FlatSnapshotFile::Open(path);
+        if (!reader->flat_) {
+            return nullptr;
+        }
+        reader->it_.reset(new FlatSnapshotFile::Iterator(reader->flat_.get()));
+        return reader;
+    }
+    FILE* fd = fopen(path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    reader->seq_file_ = ::openmldb::log::NewSeqFile(path, fd);
+    reader->reader_.reset(new ::openmldb::log::Reader(reader->seq_file_, NULL, false, 0, compressed));
+    return reader;
+}
+
+SnapshotReader::~SnapshotReader() {
+    reader_.reset();
+    // will close the fd atomic
+    delete seq_file_;
+}
+
+::openmldb::log::Status SnapshotReader::ReadEntry(::openmldb::api::LogEntry* entry, Slice* record,
+                                                  std::string* buffer) {
+    if (flat_) {
+        if (!it_->Valid()) {
+            return it_->GetStatus().ok() ? ::openmldb::log::Status::Eof() : it_->GetStatus();
+        }
+        *record = it_->GetValue().Raw();
+        it_->GetValue().ToLogEntry(entry);
+        it_->Next();
+        return ::openmldb::log::Status::OK();
+    }
+    ::openmldb::log::Status status = reader_->ReadRecord(record, buffer);
+    if (!status.ok()) {
+        return status;
+    }
+    if (!entry->ParseFromArray(record->data(), record->size())) {
+        return ::openmldb::log::Status::Corruption("fail to parse log entry");
+    }
+    return status;
+}
+
+::openmldb::log::Status SnapshotReader::ReadRecord(Slice* record, std::string* buffer) {
+    if (!flat_) {
+        return reader_->ReadRecord(record, buffer);
+    }
+    ::openmldb::api::LogEntry entry;
+    ::openmldb::log::Status status = ReadEntry(&entry, record, buffer);
+    if (!status.ok()) {
+        return status;
+    }
+    buffer->clear();
+    entry.SerializeToString(buffer);
+    record->reset(buffer->data(), buffer->size());
+    return status;
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,250 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_FLAT_SNAPSHOT_H_
+#define SRC_STORAGE_FLAT_SNAPSHOT_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/slice.h"
+#include "log/log_reader.h"
+#include "log/sequential_file.h"
+#include "log/status.h"
+#include "proto/tablet.pb.h"
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::base::Slice;
+
+// A flat snapshot stores the rows as they are kept in a memtable, so it is
+// loaded by mapping the file instead of parsing log entries. The first page is
+// the header, the records start at the second page and are 8 bytes aligned,
+// the file is padded to the page size.
+//
+// record: FlatRecordHeader | ts dimensions | dimensions | value | keys
+//
+// The crc of a record covers the header fields before it and the rest of the
+// record, it is masked as the crc of a binlog record.
+static const uint32_t FLAT_SNAPSHOT_MAGIC = 0x53464d4f;  // "OMFS"
+static const uint32_t FLAT_SNAPSHOT_VERSION = 1;
+static const uint32_t FLAT_SNAPSHOT_PAGE_SIZE = 4096;
+const std::string FLAT_SNAPSHOT_SUFFIX = ".flat";  // NOLINT
+
+struct FlatSnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+    // the bytes of the records, not including the padding of the last page
+    uint64_t data_size;
+};
+
+struct FlatRecordHeader {
+    // the bytes of the record including this header and the padding
+    uint32_t size;
+    uint32_t value_size;
+    uint64_t log_index;
+    uint64_t term;
+    uint64_t ts;
+    uint16_t dim_cnt;
+    uint16_t ts_dim_cnt;
+    uint32_t crc;
+};
+
+struct FlatDimension {
+    uint32_t idx;
+    uint32_t key_size;
+};
+
+struct FlatTSDimension {
+    uint32_t idx;
+    uint32_t reserved;
+    uint64_t ts;
+};
+
+// a view of a record in the mapping, it is valid while the mapping lives
+class FlatRecord {
+ public:
+    FlatRecord() : header_(NULL) {}
+    explicit FlatRecord(const char* data) : header_(reinterpret_cast<const FlatRecordHeader*>(data)) {}
+
+    inline Slice Raw() const { return Slice(reinterpret_cast<const char*>(header_), header_->size); }
+    inline uint64_t GetLogIndex() const { return header_->log_index; }
+    inline uint64_t GetTerm() const { return header_->term; }
+    inline uint64_t GetTs() const { return header_->ts; }
+    inline uint32_t GetDimCnt() const { return header_->dim_cnt; }
+    inline uint32_t GetTSDimCnt() const { return header_->ts_dim_cnt; }
+
+    inline const FlatTSDimension& GetTSDimension(uint32_t pos) const {
+        return reinterpret_cast<const FlatTSDimension*>(header_ + 1)[pos];
+    }
+
+    inline const FlatDimension& GetDimension(uint32_t pos) const {
+        return reinterpret_cast<const FlatDimension*>(&GetTSDimension(header_->ts_dim_cnt))[pos];
+    }
+
+    inline Slice GetValue() const {
+        return Slice(reinterpret_cast<const char*>(&GetDimension(header_->dim_cnt)), header_->value_size);
+    }
+
+    // the key of dimension pos, keys are stored after the value in order
+    Slice GetKey(uint32_t pos) const;
+
+    // fill in the dimension pairs of index id and key
+    void GetDimensions(std::vector<std::pair<uint32_t, Slice>>* dimensions) const;
+
+    void ToLogEntry(::openmldb::api::LogEntry* entry) const;
+
+    // the bytes of the record encoded from entry
+    static uint32_t GetEncodeSize(const ::openmldb::api::LogEntry& entry);
+
+    // the masked crc of the record in data whose header is filled in
+    static uint32_t ComputeCrc(const char* data, uint32_t size);
+
+ private:
+    const FlatRecordHeader* header_;
+};
+
+// FlatSnapshotWriter appends the records of a new flat snapshot to fd, the
+// header is written back by EndLog, so fd is not opened in append mode. It
+// owns fd
+class FlatSnapshotWriter {
+ public:
+    FlatSnapshotWriter(const std::string& fname, FILE* fd);
+    ~FlatSnapshotWriter();
+
+    FlatSnapshotWriter(const FlatSnapshotWriter&) = delete;
+    FlatSnapshotWriter& operator=(const FlatSnapshotWriter&) = delete;
+
+    // a delete entry is not a row of the snapshot
+    ::openmldb::log::Status Write(const ::openmldb::api::LogEntry& entry);
+
+    // copy the record read from another flat snapshot
+    ::openmldb::log::Status Write(const FlatRecord& record);
+
+    // pad the last page, write the header and sync the file
+    ::openmldb::log::Status EndLog();
+
+    uint64_t GetCount() const { return count_; }
+
+    uint64_t GetSize() const { return data_size_; }
+
+ private:
+    ::openmldb::log::Status Append(const char* data, uint32_t size);
+
+    std::string fname_;
+    FILE* fd_;
+    uint64_t count_;
+    uint64_t data_size_;
+    std::string buf_;
+};
+
+// FlatSnapshotFile maps a flat snapshot read only. The rows loaded with
+// keep_mapped refer to the mapping, every such row holds the file by RefRow
+// and the file is unmapped once the last of them is freed
+class FlatSnapshotFile : public std::enable_shared_from_this<FlatSnapshotFile> {
+ public:
+    // return nullptr if the file is not a valid flat snapshot
+    static std::shared_ptr<FlatSnapshotFile> Open(const std::string& path);
+
+    ~FlatSnapshotFile();
+
+    FlatSnapshotFile(const FlatSnapshotFile&) = delete;
+    FlatSnapshotFile& operator=(const FlatSnapshotFile&) = delete;
+
+    uint64_t GetCount() const { return header_->count; }
+
+    uint64_t GetMappedSize() const { return size_; }
+
+    // the pages are read in order while loading and at random afterwards
+    void AdviseRandom();
+
+    // a row refers to the mapping
+    void RefRow();
+
+    // the row which refers to data is freed, see UnRefMappedRow
+    static void UnRefRow(const char* data);
+
+    uint64_t GetRowCnt() const { return rows_.load(std::memory_order_relaxed); }
+
+    class Iterator {
+     public:
+        explicit Iterator(const FlatSnapshotFile* file);
+        // false at the end or if the record is corrupted, see status
+        bool Valid() const { return valid_; }
+        void Next();
+        const FlatRecord& GetValue() const { return record_; }
+        const ::openmldb::log::Status& GetStatus() const { return status_; }
+
+     private:
+        void Parse();
+
+        const char* cur_;
+        const char* end_;
+        bool valid_;
+        FlatRecord record_;
+        ::openmldb::log::Status status_;
+    };
+
+ private:
+    FlatSnapshotFile(const std::string& path, char* base, uint64_t size);
+
+    std::string path_;
+    char* base_;
+    uint64_t size_;
+    const FlatSnapshotHeader* header_;
+    std::atomic<uint64_t> rows_;
+};
+
+// SnapshotReader reads the entries of a snapshot in any format
+class SnapshotReader {
+ public:
+    // return nullptr if the file can not be opened
+    static std::unique_ptr<SnapshotReader> Open(const std::string& path, ::openmldb::api::SnapshotFormat format,
+                                                bool compressed);
+    ~SnapshotReader();
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    // the record is the serialized entry of a log snapshot, it is encoded in
+    // the flat format if IsFlat
+    ::openmldb::log::Status ReadEntry(::openmldb::api::LogEntry* entry, Slice* record, std::string* buffer);
+
+    // the same as log::Reader::ReadRecord, a flat record is serialized into buffer
+    ::openmldb::log::Status ReadRecord(Slice* record, std::string* buffer);
+
+    bool IsFlat() const { return flat_ != nullptr; }
+
+ private:
+    SnapshotReader() : seq_file_(NULL), reader_(), flat_(), it_() {}
+
+    ::openmldb::log::SequentialFile* seq_file_;
+    std::unique_ptr<::openmldb::log::Reader> reader_;
+    std::shared_ptr<FlatSnapshotFile> flat_;
+    std::unique_ptr<FlatSnapshotFile::Iterator> it_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_FLAT_SNAPSHOT_H_
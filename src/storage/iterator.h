@@ -39,6 +39,8 @@ class TableIterator {
     virtual void Seek(const std::string& pk, uint64_t time) {}
     virtual void Seek(uint64_t time) {}
     virtual uint64_t GetCount() const { return 0; }
+    // the value is uncompressed into the iterator and is only valid until it moves on
+    virtual bool IsCold() const { return false; }
 };
 
 class TraverseIterator : public TableIterator {
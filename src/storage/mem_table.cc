@@ -33,6 +33,8 @@ DECLARE_uint32(key_entry_max_height);
 DECLARE_uint32(absolute_default_skiplist_height);
 DECLARE_uint32(latest_default_skiplist_height);
 DECLARE_uint32(max_traverse_cnt);
+DECLARE_uint32(latest_ring_max_cnt);
+DECLARE_uint32(cold_row_compress_minute);
 
 namespace openmldb {
 namespace storage {
@@ -81,6 +83,19 @@ MemTable::~MemTable() {
     PDLOG(INFO, "drop memtable. tid %u pid %u", id_, pid_);
 }
 
+// the ring only holds one ts column and keeps a fixed count of rows per key
+static uint32_t GetRingCapacity(const InnerIndexSt& inner_index) {
+    if (FLAGS_latest_ring_max_cnt == 0 || inner_index.GetTsIdx().size() > 1 || inner_index.GetIndex().size() != 1) {
+        return 0;
+    }
+    auto ttl = inner_index.GetIndex().front()->GetTTL();
+    if (!ttl || ttl->ttl_type != ::openmldb::storage::TTLType::kLatestTime || ttl->lat_ttl == 0 ||
+        ttl->lat_ttl > FLAGS_latest_ring_max_cnt) {
+        return 0;
+    }
+    return ttl->lat_ttl;
+}
+
 bool MemTable::Init() {
     key_entry_max_height_ = FLAGS_key_entry_max_height;
     if (!InitFromMeta()) {
@@ -105,7 +120,14 @@ bool MemTable::Init() {
                                                                                  FLAGS_latest_default_skiplist_height);
         }
         Segment** seg_arr = new Segment*[seg_cnt_];
-        if (!ts_vec.empty()) {
+        uint32_t ring_capacity = GetRingCapacity(*(inner_indexs->at(i)));
+        if (ring_capacity > 0) {
+            for (uint32_t j = 0; j < seg_cnt_; j++) {
+                seg_arr[j] = new Segment(cur_key_entry_max_height, ts_vec, ring_capacity);
+                PDLOG(INFO, "init %u, %u ring segment. height %u, ring capacity %u. tid %u pid %u", i, j,
+                      cur_key_entry_max_height, ring_capacity, id_, pid_);
+            }
+        } else if (!ts_vec.empty()) {
             for (uint32_t j = 0; j < seg_cnt_; j++) {
                 seg_arr[j] = new Segment(cur_key_entry_max_height, ts_vec);
                 PDLOG(INFO, "init %u, %u segment. height %u, ts col num %u. tid %u pid %u", i, j,
@@ -147,10 +169,6 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
         PDLOG(WARNING, "empty dimension. tid %u pid %u", id_, pid_);
         return false;
     }
-    if (value.length() < codec::HEADER_LENGTH) {
-        PDLOG(WARNING, "invalid value. tid %u pid %u", id_, pid_);
-        return false;
-    }
     std::map<int32_t, Slice> inner_index_key_map;
     for (auto iter = dimensions.begin(); iter != dimensions.end(); iter++) {
         int32_t inner_pos = table_index_.GetInnerIndexPos(iter->idx());
@@ -160,6 +178,33 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
         }
         inner_index_key_map.emplace(inner_pos, iter->key());
     }
+    return PutRow(time, Slice(value), inner_index_key_map, nullptr);
+}
+
+bool MemTable::Put(uint64_t time, const Slice& value, const std::vector<std::pair<uint32_t, Slice>>& dimensions,
+                   FlatSnapshotFile* mapping) {
+    if (dimensions.empty()) {
+        PDLOG(WARNING, "empty dimension. tid %u pid %u", id_, pid_);
+        return false;
+    }
+    std::map<int32_t, Slice> inner_index_key_map;
+    for (const auto& dim : dimensions) {
+        int32_t inner_pos = table_index_.GetInnerIndexPos(dim.first);
+        if (inner_pos < 0) {
+            PDLOG(WARNING, "invalid dimension. dimension idx %u, tid %u pid %u", dim.first, id_, pid_);
+            return false;
+        }
+        inner_index_key_map.emplace(inner_pos, dim.second);
+    }
+    return PutRow(time, value, inner_index_key_map, mapping);
+}
+
+bool MemTable::PutRow(uint64_t time, const Slice& value, const std::map<int32_t, Slice>& inner_index_key_map,
+                      FlatSnapshotFile* mapping) {
+    if (value.size() < codec::HEADER_LENGTH) {
+        PDLOG(WARNING, "invalid value. tid %u pid %u", id_, pid_);
+        return false;
+    }
     uint32_t real_ref_cnt = 0;
     const int8_t* data = reinterpret_cast<const int8_t*>(value.data());
     uint8_t version = codec::RowView::GetSchemaVersion(data);
@@ -195,7 +240,16 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
     if (ts_map.empty()) {
         return false;
     }
-    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    DataBlock* block = nullptr;
+    uint32_t record_size = 0;
+    if (mapping != nullptr) {
+        mapping->RefRow();
+        block = new DataBlock(real_ref_cnt, value.data(), value.size(), kMappedData);
+        record_size = ::openmldb::base::Slab::ClassSize(DATA_BLOCK_BYTE_SIZE);
+    } else {
+        block = new DataBlock(real_ref_cnt, value.data(), value.size());
+        record_size = GetRecordSize(value.size());
+    }
     for (const auto& kv : inner_index_key_map) {
         auto inner_index = table_index_.GetInnerIndex(kv.first);
         bool need_put = false;
@@ -216,7 +270,7 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
         }
     }
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
-    record_byte_size_.fetch_add(GetRecordSize(value.length()));
+    record_byte_size_.fetch_add(record_size);
     return true;
 }
 
@@ -310,6 +364,10 @@ void MemTable::SchedGc() {
             } else {
                 segment->ExecuteGc(ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             }
+            if (FLAGS_cold_row_compress_minute > 0) {
+                uint64_t cold_time = seg_gc_time - (uint64_t)FLAGS_cold_row_compress_minute * 60 * 1000;
+                segment->CompressCold(cold_time, gc_record_byte_size);
+            }
             seg_gc_time = ::baidu::common::timer::get_micros() / 1000 - seg_gc_time;
             PDLOG(INFO, "gc segment[%u][%u] done consumed %lu for table %s tid %u pid %u", i, j, seg_gc_time,
                   name_.c_str(), id_, pid_);
@@ -443,6 +501,24 @@ int MemTable::GetCount(uint32_t index, const std::string& pk, uint64_t& count) {
     return segment->GetCount(spk, count);
 }
 
+bool MemTable::GetWriteVersion(uint32_t index, const std::string& pk, uint64_t* version) {
+    std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(index);
+    if (!index_def || !index_def->IsReady()) {
+        return false;
+    }
+    // rows expire by an absolute ttl as time goes by, the version can't tell it
+    auto ttl = index_def->GetTTL();
+    if (ttl && ttl->ttl_type != ::openmldb::storage::TTLType::kLatestTime && ttl->abs_ttl > 0) {
+        return false;
+    }
+    uint32_t seg_idx = 0;
+    if (seg_cnt_ > 1) {
+        seg_idx = ::openmldb::base::hash(pk.c_str(), pk.length(), SEED) % seg_cnt_;
+    }
+    *version = segments_[index_def->GetInnerPos()][seg_idx]->GetWriteVersion();
+    return true;
+}
+
 TableIterator* MemTable::NewIterator(const std::string& pk, Ticket& ticket) { return NewIterator(0, pk, ticket); }
 
 TableIterator* MemTable::NewIterator(uint32_t index, const std::string& pk, Ticket& ticket) {
@@ -843,15 +919,7 @@ void MemTableTraverseIterator::NextPK() {
             delete it_;
             it_ = NULL;
         }
-        if (segments_[seg_idx_]->GetTsCnt() > 1) {
-            KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[0];  // NOLINT
-            it_ = entry->entries.NewIterator();
-            ticket_.Push(entry);
-        } else {
-            it_ = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                      ->entries.NewIterator();
-            ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-        }
+        it_ = segments_[seg_idx_]->NewEntryIterator(pk_it_->GetValue(), 0, ticket_);
         it_->SeekToFirst();
         record_idx_ = 1;
         traverse_cnt_++;
@@ -878,15 +946,7 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
     pk_it_ = segments_[seg_idx_]->GetKeyEntries()->NewIterator();
     pk_it_->Seek(spk);
     if (pk_it_->Valid()) {
-        if (segments_[seg_idx_]->GetTsCnt() > 1) {
-            KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-            ticket_.Push(entry);
-            it_ = entry->entries.NewIterator();
-        } else {
-            ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-            it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                      ->entries.NewIterator();
-        }
+        it_ = segments_[seg_idx_]->NewEntryIterator(pk_it_->GetValue(), ts_idx_, ticket_);
         if (spk.compare(pk_it_->GetKey()) != 0 || ts == 0) {
             it_->SeekToFirst();
             traverse_cnt_++;
@@ -923,9 +983,9 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
     }
 }
 
-openmldb::base::Slice MemTableTraverseIterator::GetValue() const {
-    return openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
-}
+openmldb::base::Slice MemTableTraverseIterator::GetValue() const { return it_->GetValue(); }
+
+bool MemTableTraverseIterator::IsCold() const { return it_->IsCold(); }
 
 uint64_t MemTableTraverseIterator::GetKey() const {
     if (it_ != NULL && it_->Valid()) {
@@ -955,15 +1015,7 @@ void MemTableTraverseIterator::SeekToFirst() {
         pk_it_ = segments_[seg_idx_]->GetKeyEntries()->NewIterator();
         pk_it_->SeekToFirst();
         while (pk_it_->Valid()) {
-            if (segments_[seg_idx_]->GetTsCnt() > 1) {
-                KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-                ticket_.Push(entry);
-                it_ = entry->entries.NewIterator();
-            } else {
-                ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-                it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                          ->entries.NewIterator();
-            }
+            it_ = segments_[seg_idx_]->NewEntryIterator(pk_it_->GetValue(), ts_idx_, ticket_);
             it_->SeekToFirst();
             traverse_cnt_++;
             if (it_->Valid() && !expire_value_.IsExpired(it_->GetKey(), record_idx_)) {
@@ -20,10 +20,13 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "proto/tablet.pb.h"
+#include "storage/flat_snapshot.h"
 #include "storage/iterator.h"
 #include "storage/segment.h"
 #include "storage/table.h"
@@ -48,6 +51,7 @@ class MemTableTraverseIterator : public TraverseIterator {
     void NextPK() override;
     void Seek(const std::string& key, uint64_t time) override;
     openmldb::base::Slice GetValue() const override;
+    bool IsCold() const override;
     std::string GetPK() const override;
     uint64_t GetKey() const override;
     void SeekToFirst() override;
@@ -58,7 +62,7 @@ class MemTableTraverseIterator : public TraverseIterator {
     uint32_t const seg_cnt_;
     uint32_t seg_idx_;
     KeyEntries::Iterator* pk_it_;
-    TimeEntries::Iterator* it_;
+    MemTableIterator* it_;
     uint32_t record_idx_;
     uint32_t ts_idx_;
     // uint64_t expire_value_;
@@ -83,6 +87,12 @@ class MemTable : public Table {
 
     bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) override;
 
+    // put a row of a flat snapshot, the dimensions are pairs of index id and key.
+    // the row refers to value in mapping instead of a copy if mapping is not
+    // null, and holds the mapping until it is freed
+    bool Put(uint64_t time, const Slice& value, const std::vector<std::pair<uint32_t, Slice>>& dimensions,
+             FlatSnapshotFile* mapping);
+
     bool GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response);
 
     bool BulkLoad(const std::vector<DataBlock*>& data_blocks,
@@ -106,6 +116,8 @@ class MemTable : public Table {
 
     int GetCount(uint32_t index, const std::string& pk, uint64_t& count) override;  // NOLINT
 
+    bool GetWriteVersion(uint32_t index, const std::string& pk, uint64_t* version) override;
+
     uint64_t GetRecordIdxCnt() override;
     bool GetRecordIdxCnt(uint32_t idx, uint64_t** stat, uint32_t* size) override;
     uint64_t GetRecordIdxByteSize() override;
@@ -139,6 +151,9 @@ class MemTable : public Table {
     bool AddIndex(const ::openmldb::common::ColumnKey& column_key);
 
  private:
+    bool PutRow(uint64_t time, const Slice& value, const std::map<int32_t, Slice>& inner_index_key_map,
+                FlatSnapshotFile* mapping);
+
     bool CheckAbsolute(const TTLSt& ttl, uint64_t ts);
 
     bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
@@ -23,7 +23,9 @@
 #include <snappy.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <set>
+#include <thread>  // NOLINT
 #include <utility>
 
 #include "base/file_util.h"
@@ -31,15 +33,15 @@
 #include "base/hash.h"
 #include "base/slice.h"
 #include "base/strings.h"
-#include "base/taskpool.hpp"
-#include "boost/bind.hpp"
 #include "codec/row_codec.h"
 #include "common/thread_pool.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
+#include "log/log_format.h"
 #include "log/log_reader.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/mem_table.h"
 
 using google::protobuf::RepeatedPtrField;
 using ::openmldb::codec::SchemaCodec;
@@ -50,7 +52,12 @@ DECLARE_uint32(make_snapshot_max_deleted_keys);
 DECLARE_uint32(load_table_batch);
 DECLARE_uint32(load_table_thread_num);
 DECLARE_uint32(load_table_queue_size);
+DECLARE_uint32(load_snapshot_chunk_mb);
 DECLARE_string(snapshot_compression);
+DECLARE_string(snapshot_format);
+DECLARE_bool(snapshot_keep_mapped);
+DECLARE_uint32(snapshot_max_delta_num);
+DECLARE_uint32(snapshot_merge_rate_mb);
 
 namespace openmldb {
 namespace storage {
@@ -60,7 +67,7 @@ const uint32_t KEY_NUM_DISPLAY = 1000000;    // NOLINT
 const std::string MANIFEST = "MANIFEST";     // NOLINT
 
 MemTableSnapshot::MemTableSnapshot(uint32_t tid, uint32_t pid, LogParts* log_part, const std::string& db_root_path)
-    : Snapshot(tid, pid), log_part_(log_part), db_root_path_(db_root_path) {}
+    : Snapshot(tid, pid), log_part_(log_part), db_root_path_(db_root_path), merge_start_time_(0) {}
 
 bool MemTableSnapshot::Init() {
     snapshot_path_ = db_root_path_ + "/" + std::to_string(tid_) + "_" + std::to_string(pid_) + "/snapshot/";
@@ -84,7 +91,8 @@ bool MemTableSnapshot::Recover(std::shared_ptr<Table> table, uint64_t& latest_of
         return false;
     }
     if (ret == 0) {
-        RecoverFromSnapshot(manifest.name(), manifest.count(), table);
+        RecoverFromSnapshot(manifest.name(), manifest.count(), table, manifest.format());
+        RecoverDeltas(manifest, table);
         latest_offset = manifest.offset();
         offset_ = latest_offset;
     }
@@ -92,11 +100,15 @@ bool MemTableSnapshot::Recover(std::shared_ptr<Table> table, uint64_t& latest_of
 }
 
 void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt,
-                                           std::shared_ptr<Table> table) {
+                                           std::shared_ptr<Table> table, ::openmldb::api::SnapshotFormat format) {
     std::string full_path = snapshot_path_ + "/" + snapshot_name;
     std::atomic<uint64_t> g_succ_cnt(0);
     std::atomic<uint64_t> g_failed_cnt(0);
-    RecoverSingleSnapshot(full_path, table, &g_succ_cnt, &g_failed_cnt);
+    if (format == ::openmldb::api::kFlatSnapshot) {
+        RecoverFlatSnapshot(full_path, table, &g_succ_cnt, &g_failed_cnt);
+    } else {
+        RecoverSingleSnapshot(full_path, table, &g_succ_cnt, &g_failed_cnt);
+    }
     PDLOG(INFO, "[Recover] progress done stat: success count %lu, failed count %lu",
           g_succ_cnt.load(std::memory_order_relaxed), g_failed_cnt.load(std::memory_order_relaxed));
     if (g_succ_cnt.load(std::memory_order_relaxed) != expect_cnt) {
@@ -107,105 +119,151 @@ void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uin
 
 void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table,
                                              std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
-    ::openmldb::base::TaskPool load_pool_(FLAGS_load_table_thread_num, FLAGS_load_table_batch);
-    std::atomic<uint64_t> succ_cnt, failed_cnt;
-    succ_cnt = failed_cnt = 0;
+    if (table == NULL) {
+        PDLOG(WARNING, "table input is NULL");
+        return;
+    }
+    uint64_t file_size = 0;
+    if (!::openmldb::base::GetFileSize(path, file_size)) {
+        PDLOG(WARNING, "fail to get size of path %s", path.c_str());
+        return;
+    }
+    // the records of an uncompressed file are read from the boundary of any
+    // block, so the file is split into chunks decoded by several readers. The
+    // blocks of a compressed file are not fixed-size, it is read by one reader
+    bool compressed = IsCompressed(path);
+    uint64_t chunk_size = (uint64_t)FLAGS_load_snapshot_chunk_mb << 20;
+    uint64_t chunk_num = 1;
+    if (!compressed && chunk_size > 0) {
+        chunk_num = std::min<uint64_t>((file_size + chunk_size - 1) / chunk_size, FLAGS_load_table_thread_num);
+        chunk_num = std::max<uint64_t>(chunk_num, 1);
+        chunk_size = (file_size / chunk_num + ::openmldb::log::kBlockSize - 1) / ::openmldb::log::kBlockSize *
+                     ::openmldb::log::kBlockSize;
+    }
+    uint64_t consumed = ::baidu::common::timer::now_time();
+    std::atomic<uint64_t> failed_cnt(0);
+    ShardedLoader loader(table, FLAGS_load_table_thread_num, FLAGS_load_table_batch, FLAGS_load_table_queue_size);
+    std::vector<std::thread> readers;
+    for (uint64_t i = 0; i < chunk_num; i++) {
+        uint64_t start = i * chunk_size;
+        uint64_t end = (i + 1 == chunk_num) ? UINT64_MAX : start + chunk_size;
+        readers.emplace_back(&MemTableSnapshot::RecoverChunk, this, path, compressed, start, end, &loader,
+                             &failed_cnt);
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    loader.Flush();
+    consumed = ::baidu::common::timer::now_time() - consumed;
+    PDLOG(INFO,
+          "read path %s for table tid %u pid %u completed with %lu chunks, "
+          "succ_cnt %lu, failed_cnt %lu, consumed %us",
+          path.c_str(), tid_, pid_, chunk_num, loader.GetSuccCnt(), failed_cnt.load(std::memory_order_relaxed),
+          consumed);
+    if (g_succ_cnt) {
+        g_succ_cnt->fetch_add(loader.GetSuccCnt(), std::memory_order_relaxed);
+    }
+    if (g_failed_cnt) {
+        g_failed_cnt->fetch_add(failed_cnt.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
 
-    do {
-        if (table == NULL) {
-            PDLOG(WARNING, "table input is NULL");
-            break;
-        }
-        FILE* fd = fopen(path.c_str(), "rb");
-        if (fd == NULL) {
-            PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+void MemTableSnapshot::RecoverChunk(const std::string& path, bool compressed, uint64_t start, uint64_t end,
+                                   ShardedLoader* loader, std::atomic<uint64_t>* failed_cnt) {
+    FILE* fd = fopen(path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        return;
+    }
+    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
+    // the record across the start belongs to the last chunk and is skipped by the reader
+    ::openmldb::log::Reader reader(seq_file, NULL, false, start, compressed);
+    std::string buffer;
+    uint64_t cnt = 0;
+    while (true) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (status.IsWaitRecord() || status.IsEof()) {
             break;
         }
-        bool compressed = IsCompressed(path);
-        ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
-        ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
-        std::string buffer;
-        // second
-        uint64_t consumed = ::baidu::common::timer::now_time();
-        std::vector<std::string*> recordPtr;
-        recordPtr.reserve(FLAGS_load_table_batch);
-
-        while (true) {
-            buffer.clear();
-            ::openmldb::base::Slice record;
-            ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
-            if (status.IsWaitRecord() || status.IsEof()) {
-                consumed = ::baidu::common::timer::now_time() - consumed;
-                PDLOG(INFO,
-                      "read path %s for table tid %u pid %u completed, "
-                      "succ_cnt %lu, failed_cnt %lu, consumed %us",
-                      path.c_str(), tid_, pid_, succ_cnt.load(std::memory_order_relaxed),
-                      failed_cnt.load(std::memory_order_relaxed), consumed);
-                break;
-            }
-
-            if (!status.ok()) {
-                PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
-                      status.ToString().c_str());
-                failed_cnt.fetch_add(1, std::memory_order_relaxed);
-                continue;
-            }
-            std::string* sp = new std::string(record.data(), record.size());
-            recordPtr.push_back(sp);
-            if (recordPtr.size() >= FLAGS_load_table_batch) {
-                load_pool_.AddTask(
-                    boost::bind(&MemTableSnapshot::Put, this, path, table, recordPtr, &succ_cnt, &failed_cnt));
-                recordPtr.clear();
-            }
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                  status.ToString().c_str());
+            failed_cnt->fetch_add(1, std::memory_order_relaxed);
+            continue;
         }
-        if (recordPtr.size() > 0) {
-            load_pool_.AddTask(
-                boost::bind(&MemTableSnapshot::Put, this, path, table, recordPtr, &succ_cnt, &failed_cnt));
+        // the record starting after the end belongs to the next chunk
+        if (reader.LastRecordOffset() >= end) {
+            break;
         }
-        // will close the fd atomic
-        delete seq_file;
-        if (g_succ_cnt) {
-            g_succ_cnt->fetch_add(succ_cnt, std::memory_order_relaxed);
+        auto entry = new ::openmldb::api::LogEntry();
+        if (!entry->ParseFromArray(record.data(), record.size())) {
+            failed_cnt->fetch_add(1, std::memory_order_relaxed);
+            delete entry;
+            continue;
         }
-        if (g_failed_cnt) {
-            g_failed_cnt->fetch_add(failed_cnt, std::memory_order_relaxed);
+        loader->Add(entry);
+        if (++cnt % 100000 == 0) {
+            PDLOG(INFO, "load snapshot %s from offset %lu with cnt %lu, failed_cnt %lu", path.c_str(), start, cnt,
+                  failed_cnt->load(std::memory_order_relaxed));
         }
-    } while (false);
-    load_pool_.Stop();
+    }
+    // will close the fd atomic
+    delete seq_file;
 }
 
-void MemTableSnapshot::Put(std::string& path, std::shared_ptr<Table>& table, std::vector<std::string*> recordPtr,
-                           std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt) {
-    ::openmldb::api::LogEntry entry;
-    for (auto it = recordPtr.cbegin(); it != recordPtr.cend(); it++) {
-        bool ok = entry.ParseFromString(**it);
-        if (!ok) {
-            failed_cnt->fetch_add(1, std::memory_order_relaxed);
-            delete *it;
-            continue;
+void MemTableSnapshot::RecoverFlatSnapshot(const std::string& path, std::shared_ptr<Table> table,
+                                           std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
+    if (table == NULL) {
+        PDLOG(WARNING, "table input is NULL");
+        return;
+    }
+    std::shared_ptr<FlatSnapshotFile> file = FlatSnapshotFile::Open(path);
+    if (!file) {
+        return;
+    }
+    // the rows point to the mapping which lives until the last of them is freed
+    auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    bool keep_mapped = FLAGS_snapshot_keep_mapped && mem_table;
+    uint64_t consumed = ::baidu::common::timer::now_time();
+    uint64_t failed_cnt = 0;
+    {
+        ShardedLoader loader(table, FLAGS_load_table_thread_num, FLAGS_load_table_batch, FLAGS_load_table_queue_size);
+        FlatSnapshotFile::Iterator it(file.get());
+        for (; it.Valid(); it.Next()) {
+            loader.Add(it.GetValue(), keep_mapped ? file.get() : nullptr);
+        }
+        if (!it.GetStatus().ok()) {
+            PDLOG(WARNING, "fail to read flat snapshot %s for tid %u, pid %u with error %s", path.c_str(), tid_, pid_,
+                  it.GetStatus().ToString().c_str());
+            failed_cnt++;
         }
-        auto scount = succ_cnt->fetch_add(1, std::memory_order_relaxed);
-        if (scount % 100000 == 0) {
-            PDLOG(INFO, "load snapshot %s with succ_cnt %lu, failed_cnt %lu", path.c_str(), scount,
-                  failed_cnt->load(std::memory_order_relaxed));
+        loader.Flush();
+        if (g_succ_cnt) {
+            g_succ_cnt->fetch_add(loader.GetSuccCnt(), std::memory_order_relaxed);
         }
-        table->Put(entry);
-        delete *it;
+    }
+    if (keep_mapped) {
+        file->AdviseRandom();
+    }
+    consumed = ::baidu::common::timer::now_time() - consumed;
+    PDLOG(INFO, "read flat snapshot %s for table tid %u pid %u completed, count %lu, mapped %lu bytes, consumed %us",
+          path.c_str(), tid_, pid_, file->GetCount(), keep_mapped ? file->GetMappedSize() : 0, consumed);
+    if (g_failed_cnt) {
+        g_failed_cnt->fetch_add(failed_cnt, std::memory_order_relaxed);
     }
 }
 
 int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
-                                  WriteHandle* wh, uint64_t& count, uint64_t& expired_key_num,
-                                  uint64_t& deleted_key_num) {
+                                  WriteHandle* wh, FlatSnapshotWriter* flat_wh, uint64_t& count,
+                                  uint64_t& expired_key_num, uint64_t& deleted_key_num) {
     std::string full_path = snapshot_path_ + manifest.name();
-    FILE* fd = fopen(full_path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+    std::unique_ptr<SnapshotReader> reader =
+        SnapshotReader::Open(full_path, manifest.format(), IsCompressed(full_path));
+    if (!reader) {
         return -1;
     }
-    bool compressed = IsCompressed(full_path);
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
 
     std::string buffer;
     std::string tmp_buf;
@@ -219,7 +277,7 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
     }
     while (true) {
         ::openmldb::base::Slice record;
-        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        ::openmldb::log::Status status = reader->ReadEntry(&entry, &record, &buffer);
         if (status.IsEof()) {
             break;
         }
@@ -229,24 +287,32 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
             has_error = true;
             break;
         }
-        if (!entry.ParseFromString(record.ToString())) {
-            PDLOG(WARNING, "fail parse record for tid %u, pid %u with value %s", tid_, pid_,
-                  ::openmldb::base::DebugString(record.ToString()).c_str());
-            has_error = true;
-            break;
-        }
+        // the record is copied as it is if the formats are the same
+        bool flat_record = reader->IsFlat();
         int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
         if (ret == 1) {
             deleted_key_num++;
             continue;
         } else if (ret == 2) {
             record.reset(tmp_buf.data(), tmp_buf.size());
+            flat_record = false;
         }
         if (table->IsExpire(entry)) {
             expired_key_num++;
             continue;
         }
-        status = wh->Write(record);
+        if (flat_wh != NULL) {
+            if (ret == 2) {
+                entry.ParseFromString(tmp_buf);
+            }
+            status = flat_record ? flat_wh->Write(FlatRecord(record.data())) : flat_wh->Write(entry);
+        } else if (flat_record) {
+            tmp_buf.clear();
+            entry.SerializeToString(&tmp_buf);
+            status = wh->Write(::openmldb::base::Slice(tmp_buf));
+        } else {
+            status = wh->Write(record);
+        }
         if (!status.ok()) {
             PDLOG(WARNING, "fail to write snapshot. status[%s]", status.ToString().c_str());
             has_error = true;
@@ -255,9 +321,10 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
         if ((count + expired_key_num + deleted_key_num) % KEY_NUM_DISPLAY == 0) {
             PDLOG(INFO, "tackled key num[%lu] total[%lu]", count + expired_key_num, manifest.count());
         }
-        count++;
+        if (++count % 1000 == 0) {
+            ThrottleMerge(flat_wh != NULL ? flat_wh->GetSize() : wh->GetSize());
+        }
     }
-    delete seq_file;
     if (expired_key_num + count + deleted_key_num != manifest.count()) {
         PDLOG(WARNING,
               "key num not match! total key num[%lu] load key num[%lu] ttl key "
@@ -341,8 +408,184 @@ uint64_t MemTableSnapshot::CollectDeletedKey(uint64_t end_offset) {
     return cur_offset;
 }
 
+int MemTableSnapshot::CollectDeltaDeletedKey(const ::openmldb::api::Manifest& manifest) {
+    std::string buffer;
+    ::openmldb::api::LogEntry entry;
+    for (const auto& delta : manifest.deltas()) {
+        std::string full_path = snapshot_path_ + delta.name();
+        std::unique_ptr<SnapshotReader> reader =
+            SnapshotReader::Open(full_path, ::openmldb::api::kLogSnapshot, IsCompressed(full_path));
+        if (!reader) {
+            return -1;
+        }
+        while (true) {
+            ::openmldb::base::Slice record;
+            ::openmldb::log::Status status = reader->ReadEntry(&entry, &record, &buffer);
+            if (status.IsEof()) {
+                break;
+            }
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to read delta %s for tid %u, pid %u with error %s", full_path.c_str(), tid_, pid_,
+                      status.ToString().c_str());
+                return -1;
+            }
+            if (!entry.has_method_type() || entry.method_type() != ::openmldb::api::MethodType::kDelete ||
+                entry.dimensions_size() == 0) {
+                continue;
+            }
+            std::string combined_key = entry.dimensions(0).key() + "|" + std::to_string(entry.dimensions(0).idx());
+            uint64_t& offset = deleted_keys_[combined_key];
+            offset = std::max(offset, entry.log_index());
+        }
+    }
+    return 0;
+}
+
+int MemTableSnapshot::MergeDeltas(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
+                                  WriteHandle* wh, FlatSnapshotWriter* flat_wh, uint64_t& count,
+                                  uint64_t& expired_key_num, uint64_t& deleted_key_num) {
+    std::set<uint32_t> deleted_index;
+    for (const auto& it : table->GetAllIndex()) {
+        if (it->GetStatus() == ::openmldb::storage::IndexStatus::kDeleted) {
+            deleted_index.insert(it->GetId());
+        }
+    }
+    std::string buffer;
+    std::string tmp_buf;
+    ::openmldb::api::LogEntry entry;
+    for (const auto& delta : manifest.deltas()) {
+        std::string full_path = snapshot_path_ + delta.name();
+        std::unique_ptr<SnapshotReader> reader =
+            SnapshotReader::Open(full_path, ::openmldb::api::kLogSnapshot, IsCompressed(full_path));
+        if (!reader) {
+            return -1;
+        }
+        while (true) {
+            ::openmldb::base::Slice record;
+            ::openmldb::log::Status status = reader->ReadEntry(&entry, &record, &buffer);
+            if (status.IsEof()) {
+                break;
+            }
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to read delta %s for tid %u, pid %u with error %s", full_path.c_str(), tid_, pid_,
+                      status.ToString().c_str());
+                return -1;
+            }
+            if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+                continue;
+            }
+            int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
+            if (ret == 1) {
+                deleted_key_num++;
+                continue;
+            } else if (ret == 2) {
+                record.reset(tmp_buf.data(), tmp_buf.size());
+            }
+            if (table->IsExpire(entry)) {
+                expired_key_num++;
+                continue;
+            }
+            if (flat_wh != NULL && ret == 2) {
+                entry.ParseFromString(tmp_buf);
+            }
+            status = flat_wh != NULL ? flat_wh->Write(entry) : wh->Write(record);
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to write snapshot. status[%s]", status.ToString().c_str());
+                return -1;
+            }
+            if (++count % 1000 == 0) {
+                ThrottleMerge(flat_wh != NULL ? flat_wh->GetSize() : wh->GetSize());
+            }
+        }
+        PDLOG(INFO, "merge delta %s tid %u pid %u. write key num[%lu] ttl key num[%lu] deleted key num[%lu]",
+              delta.name().c_str(), tid_, pid_, count, expired_key_num, deleted_key_num);
+    }
+    return 0;
+}
+
+void MemTableSnapshot::RecoverDeltas(const ::openmldb::api::Manifest& manifest, std::shared_ptr<Table> table) {
+    std::string buffer;
+    for (const auto& delta : manifest.deltas()) {
+        std::string full_path = snapshot_path_ + delta.name();
+        std::unique_ptr<SnapshotReader> reader =
+            SnapshotReader::Open(full_path, ::openmldb::api::kLogSnapshot, IsCompressed(full_path));
+        if (!reader) {
+            continue;
+        }
+        uint64_t cnt = 0;
+        uint64_t failed_cnt = 0;
+        ShardedLoader loader(table, FLAGS_load_table_thread_num, FLAGS_load_table_batch, FLAGS_load_table_queue_size);
+        while (true) {
+            auto entry = std::make_unique<::openmldb::api::LogEntry>();
+            ::openmldb::base::Slice record;
+            ::openmldb::log::Status status = reader->ReadEntry(entry.get(), &record, &buffer);
+            if (status.IsEof()) {
+                break;
+            }
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to read delta %s for tid %u, pid %u with error %s", full_path.c_str(), tid_, pid_,
+                      status.ToString().c_str());
+                failed_cnt++;
+                break;
+            }
+            cnt++;
+            // the puts before the delete of a key should be in the table
+            if (entry->has_method_type() && entry->method_type() == ::openmldb::api::MethodType::kDelete) {
+                if (entry->dimensions_size() == 0) {
+                    PDLOG(WARNING, "no dimesion. tid %u pid %u offset %lu", tid_, pid_, entry->log_index());
+                } else {
+                    loader.Flush();
+                    table->Delete(entry->dimensions(0).key(), entry->dimensions(0).idx());
+                }
+            } else {
+                loader.Add(entry.release());
+            }
+        }
+        loader.Flush();
+        PDLOG(INFO, "recover delta %s for table tid %u pid %u. read %lu, put %lu, failed %lu", delta.name().c_str(),
+              tid_, pid_, cnt, loader.GetSuccCnt(), failed_cnt);
+        if (cnt != delta.count()) {
+            PDLOG(WARNING, "delta %s, expect cnt %lu but read %lu", delta.name().c_str(), delta.count(), cnt);
+        }
+    }
+}
+
+void MemTableSnapshot::ThrottleMerge(uint64_t written_bytes) {
+    if (FLAGS_snapshot_merge_rate_mb == 0) {
+        return;
+    }
+    // the time to write written_bytes at the rate, in microseconds
+    uint64_t expect_us = static_cast<uint64_t>(written_bytes * 1000000.0 / FLAGS_snapshot_merge_rate_mb / (1 << 20));
+    uint64_t elapsed_us = ::baidu::common::timer::get_micros() - merge_start_time_;
+    if (expect_us > elapsed_us) {
+        std::this_thread::sleep_for(std::chrono::microseconds(expect_us - elapsed_us));
+    }
+}
+
+int MemTableSnapshot::MergeSnapshot(std::shared_ptr<Table> table) {
+    ::openmldb::api::Manifest manifest;
+    if (GetLocalManifest(snapshot_path_ + MANIFEST, manifest) != 0 || manifest.deltas_size() == 0) {
+        return 0;
+    }
+    uint64_t offset = 0;
+    return MakeFullSnapshot(table, offset, 0, manifest.term());
+}
+
 int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_offset, uint64_t end_offset,
                                    uint64_t term) {
+    if (FLAGS_snapshot_max_delta_num > 0) {
+        ::openmldb::api::Manifest manifest;
+        // the first snapshot and the one reaching the max delta num are full
+        if (GetLocalManifest(snapshot_path_ + MANIFEST, manifest) == 0 &&
+            (uint32_t)manifest.deltas_size() < FLAGS_snapshot_max_delta_num) {
+            return MakeDeltaSnapshot(manifest, out_offset, end_offset);
+        }
+    }
+    return MakeFullSnapshot(table, out_offset, end_offset, term);
+}
+
+int MemTableSnapshot::MakeDeltaSnapshot(::openmldb::api::Manifest& manifest, uint64_t& out_offset,
+                                        uint64_t end_offset) {
     if (making_snapshot_.load(std::memory_order_acquire)) {
         PDLOG(INFO, "snapshot is doing now!");
         return 0;
@@ -353,7 +596,8 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
     }
     making_snapshot_.store(true, std::memory_order_release);
     std::string now_time = ::openmldb::base::GetNowTime();
-    std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
+    std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".delta" +
+                                std::to_string(manifest.deltas_size() + 1) + ".sdb";
     if (FLAGS_snapshot_compression != "off") {
         snapshot_name.append(".");
         snapshot_name.append(FLAGS_snapshot_compression);
@@ -367,19 +611,151 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         making_snapshot_.store(false, std::memory_order_release);
         return -1;
     }
+    uint64_t start_time = ::baidu::common::timer::now_time();
+    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, tmp_file_path, fd);
+    bool has_error = false;
+    uint64_t write_count = 0;
+    uint64_t last_term = manifest.term();
+    ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
+    log_reader.SetOffset(offset_);
+    uint64_t cur_offset = offset_;
+    std::string buffer;
+    // the deleted keys and the expired rows are kept until the deltas are merged
+    while (end_offset == 0 || cur_offset < end_offset) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = log_reader.ReadNextRecord(&record, &buffer);
+        if (status.ok()) {
+            ::openmldb::api::LogEntry entry;
+            if (!entry.ParseFromString(record.ToString())) {
+                PDLOG(WARNING, "fail to parse LogEntry. record[%s] size[%ld]",
+                      ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size());
+                has_error = true;
+                break;
+            }
+            if (entry.log_index() <= cur_offset) {
+                continue;
+            }
+            if (cur_offset + 1 != entry.log_index()) {
+                PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", cur_offset + 1,
+                      entry.log_index(), tid_, pid_);
+                continue;
+            }
+            cur_offset = entry.log_index();
+            if (entry.has_term()) {
+                last_term = entry.term();
+            }
+            status = wh->Write(record);
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to write snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
+                      status.ToString().c_str());
+                has_error = true;
+                break;
+            }
+            write_count++;
+        } else if (status.IsEof()) {
+            continue;
+        } else if (status.IsWaitRecord()) {
+            int end_log_index = log_reader.GetEndLogIndex();
+            int cur_log_index = log_reader.GetLogIndex();
+            if (end_log_index >= 0 && end_log_index > cur_log_index) {
+                log_reader.RollRLogFile();
+                continue;
+            }
+            break;
+        } else {
+            PDLOG(WARNING, "fail to get record. status is %s", status.ToString().c_str());
+            has_error = true;
+            break;
+        }
+    }
+    wh->EndLog();
+    delete wh;
+    int ret = 0;
+    if (has_error || write_count == 0) {
+        unlink(tmp_file_path.c_str());
+        ret = has_error ? -1 : 0;
+        out_offset = offset_;
+    } else if (rename(tmp_file_path.c_str(), full_path.c_str()) != 0) {
+        PDLOG(WARNING, "rename[%s] failed", snapshot_name.c_str());
+        unlink(tmp_file_path.c_str());
+        ret = -1;
+    } else {
+        ::openmldb::api::SnapshotDelta* delta = manifest.add_deltas();
+        delta->set_name(snapshot_name);
+        delta->set_count(write_count);
+        delta->set_offset(cur_offset);
+        manifest.set_offset(cur_offset);
+        manifest.set_term(last_term);
+        if (WriteManifest(manifest) == 0) {
+            PDLOG(INFO, "make delta snapshot[%s] success. update offset from %lu to %lu. use %lu second. write key %lu",
+                  snapshot_name.c_str(), offset_, cur_offset, ::baidu::common::timer::now_time() - start_time,
+                  write_count);
+            offset_ = cur_offset;
+            out_offset = cur_offset;
+        } else {
+            PDLOG(WARNING, "WriteManifest failed. delete snapshot file[%s]", full_path.c_str());
+            unlink(full_path.c_str());
+            ret = -1;
+        }
+    }
+    making_snapshot_.store(false, std::memory_order_release);
+    return ret;
+}
+
+int MemTableSnapshot::MakeFullSnapshot(std::shared_ptr<Table> table, uint64_t& out_offset, uint64_t end_offset,
+                                       uint64_t term) {
+    if (making_snapshot_.load(std::memory_order_acquire)) {
+        PDLOG(INFO, "snapshot is doing now!");
+        return 0;
+    }
+    if (end_offset > 0 && end_offset <= offset_) {
+        PDLOG(WARNING, "end_offset %lu less than or equal offset_ %lu, do nothing", end_offset, offset_);
+        return -1;
+    }
+    making_snapshot_.store(true, std::memory_order_release);
+    std::string now_time = ::openmldb::base::GetNowTime();
+    std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
+    // a flat snapshot is mapped as it is, so it is never compressed
+    bool flat = FLAGS_snapshot_format == "flat";
+    if (flat) {
+        snapshot_name.append(FLAT_SNAPSHOT_SUFFIX);
+    } else if (FLAGS_snapshot_compression != "off") {
+        snapshot_name.append(".");
+        snapshot_name.append(FLAGS_snapshot_compression);
+    }
+    std::string snapshot_name_tmp = snapshot_name + ".tmp";
+    std::string full_path = snapshot_path_ + snapshot_name;
+    std::string tmp_file_path = snapshot_path_ + snapshot_name_tmp;
+    // the header of a flat snapshot is written back at last
+    FILE* fd = fopen(tmp_file_path.c_str(), flat ? "wb+" : "ab+");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
+        making_snapshot_.store(false, std::memory_order_release);
+        return -1;
+    }
     uint64_t collected_offset = CollectDeletedKey(end_offset);
     uint64_t start_time = ::baidu::common::timer::now_time();
-    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
+    WriteHandle* wh = NULL;
+    FlatSnapshotWriter* flat_wh = NULL;
+    if (flat) {
+        flat_wh = new FlatSnapshotWriter(tmp_file_path, fd);
+    } else {
+        wh = new WriteHandle(FLAGS_snapshot_compression, tmp_file_path, fd);
+    }
     ::openmldb::api::Manifest manifest;
     bool has_error = false;
     uint64_t write_count = 0;
     uint64_t expired_key_num = 0;
     uint64_t deleted_key_num = 0;
     uint64_t last_term = term;
+    merge_start_time_ = ::baidu::common::timer::get_micros();
     int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
     if (result == 0) {
-        // filter old snapshot
-        if (TTLSnapshot(table, manifest, wh, write_count, expired_key_num, deleted_key_num) < 0) {
+        // filter old snapshot and merge the deltas on it
+        if (CollectDeltaDeletedKey(manifest) < 0 ||
+            TTLSnapshot(table, manifest, wh, flat_wh, write_count, expired_key_num, deleted_key_num) < 0 ||
+            MergeDeltas(table, manifest, wh, flat_wh, write_count, expired_key_num, deleted_key_num) < 0) {
             has_error = true;
         }
         last_term = manifest.term();
@@ -439,7 +815,10 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
                 expired_key_num++;
                 continue;
             }
-            ::openmldb::log::Status status = wh->Write(record);
+            if (flat_wh != NULL && ret == 2) {
+                entry.ParseFromString(tmp_buf);
+            }
+            ::openmldb::log::Status status = flat_wh != NULL ? flat_wh->Write(entry) : wh->Write(record);
             if (!status.ok()) {
                 PDLOG(WARNING, "fail to write snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
                       status.ToString().c_str());
@@ -450,6 +829,9 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
             if ((write_count + expired_key_num + deleted_key_num) % KEY_NUM_DISPLAY == 0) {
                 PDLOG(INFO, "has write key num[%lu] expired key num[%lu]", write_count, expired_key_num);
             }
+            if (write_count % 1000 == 0) {
+                ThrottleMerge(flat_wh != NULL ? flat_wh->GetSize() : wh->GetSize());
+            }
         } else if (status.IsEof()) {
             continue;
         } else if (status.IsWaitRecord()) {
@@ -477,18 +859,32 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         delete wh;
         wh = NULL;
     }
+    if (flat_wh != NULL) {
+        ::openmldb::log::Status status = flat_wh->EndLog();
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to end flat snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
+                  status.ToString().c_str());
+            has_error = true;
+        }
+        delete flat_wh;
+        flat_wh = NULL;
+    }
     int ret = 0;
     if (has_error) {
         unlink(tmp_file_path.c_str());
         ret = -1;
     } else {
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
-            if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
+            if (GenManifest(snapshot_name, write_count, cur_offset, last_term,
+                            flat ? ::openmldb::api::kFlatSnapshot : ::openmldb::api::kLogSnapshot) == 0) {
                 // delete old snapshot
                 if (manifest.has_name() && manifest.name() != snapshot_name) {
                     DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
                     unlink((snapshot_path_ + manifest.name()).c_str());
                 }
+                for (const auto& delta : manifest.deltas()) {
+                    unlink((snapshot_path_ + delta.name()).c_str());
+                }
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
                       "make snapshot[%s] success. update offset from %lu to %lu."
@@ -671,14 +1067,11 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
         index_vec.push_back(index_def);
     }
     std::string full_path = snapshot_path_ + manifest.name();
-    FILE* fd = fopen(full_path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+    std::unique_ptr<SnapshotReader> reader =
+        SnapshotReader::Open(full_path, manifest.format(), IsCompressed(full_path));
+    if (!reader) {
         return base::Status(base::ReturnCode::kError, "fail to open file");
     }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
-    bool compressed = IsCompressed(full_path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
     std::string buffer;
     ::openmldb::api::LogEntry entry;
     bool has_error = false;
@@ -687,7 +1080,7 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
     DLOG(INFO) << "extract index data from snapshot";
     while (true) {
         ::openmldb::base::Slice record;
-        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        ::openmldb::log::Status status = reader->ReadRecord(&record, &buffer);
         if (status.IsEof()) {
             break;
         }
@@ -770,7 +1163,6 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
         }
         (*count)++;
     }
-    delete seq_file;
     if (*expired_key_num + write_count + *deleted_key_num != manifest.count()) {
         PDLOG(WARNING, "key num not match! total key[%lu] load key[%lu] ttl key[%lu] delete key [%lu], tid %u pid %u",
                 manifest.count(), *count, *expired_key_num, *deleted_key_num, tid, pid);
@@ -791,14 +1183,11 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
     std::string full_path = snapshot_path_ + manifest.name();
-    FILE* fd = fopen(full_path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+    std::unique_ptr<SnapshotReader> reader =
+        SnapshotReader::Open(full_path, manifest.format(), IsCompressed(full_path));
+    if (!reader) {
         return -1;
     }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
-    bool compressed = IsCompressed(full_path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
     std::string buffer;
     ::openmldb::api::LogEntry entry;
     bool has_error = false;
@@ -808,7 +1197,7 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
     DLOG(INFO) << "extract index data from snapshot";
     while (true) {
         ::openmldb::base::Slice record;
-        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        ::openmldb::log::Status status = reader->ReadRecord(&record, &buffer);
         if (status.IsEof()) {
             break;
         }
@@ -928,7 +1317,6 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
         }
         count++;
     }
-    delete seq_file;
     if (expired_key_num + count + deleted_key_num + schame_size_less_count + other_error_count != manifest.count()) {
         LOG(WARNING) << "key num not match ! total key num[" << manifest.count() << "] load key num[" << count
                      << "] ttl key num[" << expired_key_num << "] schema size less num[" << schame_size_less_count
@@ -1101,6 +1489,10 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table,
     }
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
+    if (MergeSnapshot(table) < 0) {
+        PDLOG(WARNING, "fail to merge the deltas of snapshot. tid %u, pid %u", tid, pid);
+        return -1;
+    }
     if (making_snapshot_.exchange(true, std::memory_order_consume)) {
         PDLOG(INFO, "snapshot is doing now. tid %u, pid %u", tid, pid);
         return -1;
@@ -1117,7 +1509,7 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table,
     }
     uint64_t collected_offset = CollectDeletedKey(0);
     uint64_t start_time = ::baidu::common::timer::now_time();
-    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
+    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, tmp_file_path, fd);
     ::openmldb::api::Manifest manifest;
     bool has_error = false;
     uint64_t write_count = 0;
@@ -1193,6 +1585,10 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
                                        uint32_t idx, uint32_t partition_num, uint64_t& out_offset) {
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
+    if (MergeSnapshot(table) < 0) {
+        PDLOG(WARNING, "fail to merge the deltas of snapshot. tid %u, pid %u", tid, pid);
+        return -1;
+    }
     if (making_snapshot_.exchange(true, std::memory_order_consume)) {
         PDLOG(INFO, "snapshot is doing now. tid %u, pid %u", tid, pid);
         return -1;
@@ -1214,7 +1610,7 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
     }
     uint64_t collected_offset = CollectDeletedKey(0);
     uint64_t start_time = ::baidu::common::timer::now_time();
-    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
+    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, tmp_file_path, fd);
     ::openmldb::api::Manifest manifest;
     bool has_error = false;
     uint64_t write_count = 0;
@@ -1548,14 +1944,10 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
     std::string path = snapshot_path_ + "/" + manifest.name();
     uint64_t succ_cnt = 0;
     uint64_t failed_cnt = 0;
-    FILE* fd = fopen(path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+    std::unique_ptr<SnapshotReader> reader = SnapshotReader::Open(path, manifest.format(), IsCompressed(path));
+    if (!reader) {
         return false;
     }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
-    bool compressed = IsCompressed(path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
     ::openmldb::api::LogEntry entry;
     std::string buffer;
     std::string entry_buff;
@@ -1563,7 +1955,7 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
     while (true) {
         buffer.clear();
         ::openmldb::base::Slice record;
-        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        ::openmldb::log::Status status = reader->ReadRecord(&record, &buffer);
         if (status.IsWaitRecord() || status.IsEof()) {
             PDLOG(INFO,
                   "read path %s for table tid %u pid %u completed, succ_cnt "
@@ -1593,7 +1985,6 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         ::openmldb::base::Slice new_record(entry_str);
         status = whs[index_pid]->Write(new_record);
         if (!status.ok()) {
-            delete seq_file;
             PDLOG(WARNING,
                   "fail to dump index entrylog in snapshot to pid[%u]. tid "
                   "%u pid %u",
@@ -1602,7 +1993,6 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         }
         succ_cnt++;
     }
-    delete seq_file;
     return true;
 }
 
@@ -1610,6 +2000,10 @@ bool MemTableSnapshot::DumpIndexData(std::shared_ptr<Table> table, const ::openm
                                      uint32_t idx, const std::vector<::openmldb::log::WriteHandle*>& whs) {
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
+    if (MergeSnapshot(table) < 0) {
+        PDLOG(WARNING, "fail to merge the deltas of snapshot. tid %u, pid %u", tid, pid);
+        return false;
+    }
     if (making_snapshot_.exchange(true, std::memory_order_consume)) {
         PDLOG(INFO, "snapshot is doing now. tid %u, pid %u", tid, pid);
         return false;
@@ -29,6 +29,8 @@
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/flat_snapshot.h"
+#include "storage/sharded_loader.h"
 #include "storage/snapshot.h"
 
 using ::openmldb::api::LogEntry;
@@ -50,20 +52,20 @@ class MemTableSnapshot : public Snapshot {
 
     bool Recover(std::shared_ptr<Table> table, uint64_t& latest_offset) override;
 
-    void RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt, std::shared_ptr<Table> table);
+    void RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt, std::shared_ptr<Table> table,
+                             ::openmldb::api::SnapshotFormat format = ::openmldb::api::kLogSnapshot);
 
     int MakeSnapshot(std::shared_ptr<Table> table,
                      uint64_t& out_offset,  // NOLINT
                      uint64_t end_offset,
                      uint64_t term = 0) override;
 
+    // the old snapshot is written to wh, or flat_wh if the new one is flat
     int TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest, WriteHandle* wh,
+                    FlatSnapshotWriter* flat_wh,
                     uint64_t& count, uint64_t& expired_key_num,  // NOLINT
                     uint64_t& deleted_key_num);                  // NOLINT
 
-    void Put(std::string& path, std::shared_ptr<Table>& table,  // NOLINT
-             std::vector<std::string*> recordPtr, std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt);
-
     std::string GenSnapshotName();
 
     base::Status GetAllDecoder(std::shared_ptr<Table> table, std::map<uint8_t, codec::RowView>* decoder_map);
@@ -120,8 +122,43 @@ class MemTableSnapshot : public Snapshot {
     void RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table, std::atomic<uint64_t>* g_succ_cnt,
                                std::atomic<uint64_t>* g_failed_cnt);
 
+    // read the records starting in [start, end) of the snapshot file
+    void RecoverChunk(const std::string& path, bool compressed, uint64_t start, uint64_t end, ShardedLoader* loader,
+                      std::atomic<uint64_t>* failed_cnt);
+
+    // map the flat snapshot and put the rows without parsing
+    void RecoverFlatSnapshot(const std::string& path, std::shared_ptr<Table> table, std::atomic<uint64_t>* g_succ_cnt,
+                             std::atomic<uint64_t>* g_failed_cnt);
+
     uint64_t CollectDeletedKey(uint64_t end_offset);
 
+    // write the binlog after offset_ to a delta of the snapshot as it is
+    int MakeDeltaSnapshot(::openmldb::api::Manifest& manifest, uint64_t& out_offset,  // NOLINT
+                          uint64_t end_offset);
+
+    // merge the snapshot, its deltas and the binlog into a new snapshot
+    int MakeFullSnapshot(std::shared_ptr<Table> table, uint64_t& out_offset, uint64_t end_offset,  // NOLINT
+                         uint64_t term);
+
+    // merge the deltas into a full snapshot if there are any, the index
+    // extraction reads the snapshot without deltas
+    int MergeSnapshot(std::shared_ptr<Table> table);
+
+    // add the keys deleted in the deltas to deleted_keys_
+    int CollectDeltaDeletedKey(const ::openmldb::api::Manifest& manifest);
+
+    // write the rows put in the deltas, the deleted and expired ones are skipped
+    int MergeDeltas(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest, WriteHandle* wh,
+                    FlatSnapshotWriter* flat_wh,
+                    uint64_t& count, uint64_t& expired_key_num,  // NOLINT
+                    uint64_t& deleted_key_num);                  // NOLINT
+
+    // replay the deltas on the table recovered from the snapshot
+    void RecoverDeltas(const ::openmldb::api::Manifest& manifest, std::shared_ptr<Table> table);
+
+    // sleep if the merge writes faster than snapshot_merge_rate_mb
+    void ThrottleMerge(uint64_t written_bytes);
+
     int DecodeData(std::shared_ptr<Table> table, const openmldb::api::LogEntry& entry, uint32_t maxIdx,
                    std::vector<std::string>& row);  // NOLINT
 
@@ -132,6 +169,7 @@ class MemTableSnapshot : public Snapshot {
     std::string log_path_;
     std::map<std::string, uint64_t> deleted_keys_;
     std::string db_root_path_;
+    uint64_t merge_start_time_;
 };
 
 }  // namespace storage
@@ -17,6 +17,7 @@
 #ifndef SRC_STORAGE_RECORD_H_
 #define SRC_STORAGE_RECORD_H_
 
+#include "base/slab.h"
 #include "storage/segment.h"
 
 namespace openmldb {
@@ -27,21 +28,50 @@ static const uint32_t KEY_ENTRY_BYTE_SIZE = sizeof(KeyEntry);
 static const uint32_t ENTRY_NODE_SIZE = sizeof(::openmldb::base::Node<::openmldb::base::Slice, void*>);
 static const uint32_t DATA_NODE_SIZE = sizeof(::openmldb::base::Node<uint64_t, void*>);
 static const uint32_t KEY_ENTRY_PTR_SIZE = sizeof(KeyEntry*);
+static const uint32_t TIME_RING_BYTE_SIZE = sizeof(TimeRing);
 
-static inline uint32_t GetRecordSize(uint32_t value_size) { return value_size + DATA_BLOCK_BYTE_SIZE; }
+// sizes are rounded up to the slab size class, the same as the real memory the
+// objects occupy
+static inline uint32_t GetRecordSize(uint32_t value_size) {
+    return ::openmldb::base::Slab::ClassSize(value_size) + ::openmldb::base::Slab::ClassSize(DATA_BLOCK_BYTE_SIZE);
+}
+
+// a cold row takes its share of the cold block instead of the payload, the
+// payload of a mapped row is in the page cache
+static inline uint32_t GetRecordSize(const DataBlock* block) {
+    if (block->cold_pos > 0) {
+        return block->GetColdBlock()->GetRowByteSize(block->cold_pos - 1) +
+               ::openmldb::base::Slab::ClassSize(DATA_BLOCK_BYTE_SIZE);
+    }
+    if (block->storage == kMappedData) {
+        return ::openmldb::base::Slab::ClassSize(DATA_BLOCK_BYTE_SIZE);
+    }
+    return GetRecordSize(block->size);
+}
+
+// the size of a skiplist node with the input height
+static inline uint32_t GetNodeSize(uint32_t node_size, uint8_t height) {
+    return ::openmldb::base::Slab::ClassSize(node_size) + ::openmldb::base::Slab::ClassSize(height * 8);
+}
 
 // the input height which is the height of skiplist node
 static inline uint32_t GetRecordPkIdxSize(uint8_t height, uint32_t key_size, uint8_t key_entry_max_height) {
-    return height * 8 + ENTRY_NODE_SIZE + KEY_ENTRY_BYTE_SIZE + key_size + key_entry_max_height * 8 + DATA_NODE_SIZE;
+    return GetNodeSize(ENTRY_NODE_SIZE, height) + KEY_ENTRY_BYTE_SIZE + key_size +
+           GetNodeSize(DATA_NODE_SIZE, key_entry_max_height);
 }
 
 static inline uint32_t GetRecordPkMultiIdxSize(uint8_t height, uint32_t key_size, uint8_t key_entry_max_height,
                                                uint32_t ts_cnt) {
-    return height * 8 + ENTRY_NODE_SIZE + key_size +
-           (KEY_ENTRY_PTR_SIZE + KEY_ENTRY_BYTE_SIZE + key_entry_max_height * 8 + DATA_NODE_SIZE) * ts_cnt;
+    return GetNodeSize(ENTRY_NODE_SIZE, height) + key_size +
+           (KEY_ENTRY_PTR_SIZE + KEY_ENTRY_BYTE_SIZE + GetNodeSize(DATA_NODE_SIZE, key_entry_max_height)) * ts_cnt;
+}
+
+// the ring slots are allocated with the key, so there is no per row index size
+static inline uint32_t GetRecordPkRingSize(uint8_t height, uint32_t key_size, uint32_t ring_capacity) {
+    return GetNodeSize(ENTRY_NODE_SIZE, height) + key_size + TIME_RING_BYTE_SIZE + ring_capacity * sizeof(TimeRow);
 }
 
-static inline uint32_t GetRecordTsIdxSize(uint8_t height) { return height * 8 + DATA_NODE_SIZE; }
+static inline uint32_t GetRecordTsIdxSize(uint8_t height) { return GetNodeSize(DATA_NODE_SIZE, height); }
 
 }  // namespace storage
 }  // namespace openmldb
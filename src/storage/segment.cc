@@ -18,6 +18,10 @@
 
 #include <gflags/gflags.h>
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
 #include "common/timer.h"
@@ -31,6 +35,30 @@ namespace openmldb {
 namespace storage {
 
 static const SliceComparator scmp;
+
+// free the rows and return the count of rows
+static uint64_t FreeRows(const std::vector<DataBlock*>& rows, uint64_t& gc_record_cnt,  // NOLINT
+                         uint64_t& gc_record_byte_size) {                               // NOLINT
+    for (DataBlock* block : rows) {
+        // Avoid double free
+        if (block->dim_cnt_down > 1) {
+            block->dim_cnt_down--;
+        } else {
+            gc_record_byte_size += GetRecordSize(block);
+            delete block;
+            gc_record_cnt++;
+        }
+    }
+    return rows.size();
+}
+
+static uint64_t ReleaseRing(TimeRing* ring, uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {  // NOLINT
+    std::vector<DataBlock*> rows;
+    ring->Clear(&rows);
+    delete ring;
+    return FreeRows(rows, gc_record_cnt, gc_record_byte_size);
+}
+
 Segment::Segment()
     : entries_(NULL),
       mu_(),
@@ -39,7 +67,11 @@ Segment::Segment()
       pk_cnt_(0),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      write_version_(0),
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      ring_(false),
+      ring_capacity_(0),
+      evicted_rows_(nullptr) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     key_entry_max_height_ = (uint8_t)FLAGS_skiplist_max_height;
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
@@ -54,7 +86,11 @@ Segment::Segment(uint8_t height)
       key_entry_max_height_(height),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      write_version_(0),
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      ring_(false),
+      ring_capacity_(0),
+      evicted_rows_(nullptr) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
 }
@@ -68,13 +104,43 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
       key_entry_max_height_(height),
       ts_cnt_(ts_idx_vec.size()),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      write_version_(0),
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      ring_(false),
+      ring_capacity_(0),
+      evicted_rows_(nullptr) {
+    entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
+    entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    for (uint32_t i = 0; i < ts_idx_vec.size(); i++) {
+        ts_idx_map_[ts_idx_vec[i]] = i;
+        idx_cnt_vec_.push_back(std::make_shared<std::atomic<uint64_t>>(0));
+    }
+}
+
+Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec, uint32_t ring_capacity)
+    : entries_(NULL),
+      mu_(),
+      idx_cnt_(0),
+      idx_byte_size_(0),
+      pk_cnt_(0),
+      key_entry_max_height_(height),
+      ts_cnt_(ts_idx_vec.empty() ? 1 : ts_idx_vec.size()),
+      gc_version_(0),
+      write_version_(0),
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      ring_(false),
+      ring_capacity_(0),
+      evicted_rows_(nullptr) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
     for (uint32_t i = 0; i < ts_idx_vec.size(); i++) {
         ts_idx_map_[ts_idx_vec[i]] = i;
         idx_cnt_vec_.push_back(std::make_shared<std::atomic<uint64_t>>(0));
     }
+    if (ts_cnt_ == 1 && ring_capacity > 0) {
+        ring_ = true;
+        ring_capacity_.store(ring_capacity, std::memory_order_relaxed);
+    }
 }
 
 Segment::~Segment() {
@@ -84,12 +150,18 @@ Segment::~Segment() {
 
 uint64_t Segment::Release() {
     uint64_t cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // the evicted rows hold their rings, so they go first
+    GcEvictedRows(UINT64_MAX, gc_record_cnt, gc_record_byte_size);
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
     while (it->Valid()) {
         delete[] it->GetKey().data();
         if (it->GetValue() != NULL) {
-            if (ts_cnt_ > 1) {
+            if (ring_) {
+                cnt += ReleaseRing((TimeRing*)it->GetValue(), gc_record_cnt, gc_record_byte_size);  // NOLINT
+            } else if (ts_cnt_ > 1) {
                 KeyEntry** entry_arr = (KeyEntry**)it->GetValue();  // NOLINT
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
                     cnt += entry_arr[i]->Release();
@@ -112,7 +184,9 @@ uint64_t Segment::Release() {
     while (f_it->Valid()) {
         ::openmldb::base::Node<Slice, void*>* node = f_it->GetValue();
         delete[] node->GetKey().data();
-        if (ts_cnt_ > 1) {
+        if (ring_) {
+            ReleaseRing((TimeRing*)node->GetValue(), gc_record_cnt, gc_record_byte_size);  // NOLINT
+        } else if (ts_cnt_ > 1) {
             KeyEntry** entry_arr = (KeyEntry**)node->GetValue();  // NOLINT
             for (uint32_t i = 0; i < ts_cnt_; i++) {
                 entry_arr[i]->Release();
@@ -134,13 +208,14 @@ uint64_t Segment::Release() {
 }
 
 void Segment::ReleaseAndCount(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    GcEvictedRows(UINT64_MAX, gc_record_cnt, gc_record_byte_size);
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
     while (it->Valid()) {
         Slice key = it->GetKey();
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<std::shared_mutex> lock(mu_);
             entry_node = entries_->Remove(key);
         }
         if (entry_node != NULL) {
@@ -167,11 +242,131 @@ void Segment::Put(const Slice& key, uint64_t time, DataBlock* row) {
     if (ts_cnt_ > 1) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mu_);
-    PutUnlock(key, time, row);
+    std::shared_lock<std::shared_mutex> lock(mu_);
+    if (ring_) {
+        PutRing(key, time, row);
+        return;
+    }
+    void* entry = nullptr;
+    uint32_t byte_size = 0;
+    int ret = entries_->Get(key, entry);
+    if (ret < 0 || entry == NULL) {
+        char* pk = new char[key.size()];
+        memcpy(pk, key.data(), key.size());
+        Slice skey(pk, key.size());
+        void* new_entry = (void*)new KeyEntry(key_entry_max_height_);  // NOLINT
+        bool inserted = false;
+        auto* entry_node = entries_->InsertIfAbsentConcurrently(skey, new_entry, &inserted);
+        if (inserted) {
+            byte_size += GetRecordPkIdxSize(entry_node->Height(), key.size(), key_entry_max_height_);
+            pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // other writer has inserted the same key
+            delete (KeyEntry*)new_entry;  // NOLINT
+            delete[] pk;
+        }
+        entry = entry_node->GetValue();
+    }
+    idx_cnt_.fetch_add(1, std::memory_order_relaxed);
+    uint8_t height = ((KeyEntry*)entry)->entries.InsertConcurrently(time, row);  // NOLINT
+    ((KeyEntry*)entry)                                                           // NOLINT
+        ->count_.fetch_add(1, std::memory_order_relaxed);
+    byte_size += GetRecordTsIdxSize(height);
+    idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+    IncrWriteVersion();
+}
+
+void Segment::PutRing(const Slice& key, uint64_t time, DataBlock* row) {
+    void* entry = nullptr;
+    uint32_t byte_size = 0;
+    int ret = entries_->Get(key, entry);
+    if (ret < 0 || entry == NULL) {
+        char* pk = new char[key.size()];
+        memcpy(pk, key.data(), key.size());
+        Slice skey(pk, key.size());
+        TimeRing* ring = new TimeRing(ring_capacity_.load(std::memory_order_relaxed));
+        void* new_entry = (void*)ring;  // NOLINT
+        bool inserted = false;
+        auto* entry_node = entries_->InsertIfAbsentConcurrently(skey, new_entry, &inserted);
+        if (inserted) {
+            byte_size += GetRecordPkRingSize(entry_node->Height(), key.size(), ring->GetCapacity());
+            pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            delete ring;
+            delete[] pk;
+        }
+        entry = entry_node->GetValue();
+    }
+    // the slots of ring are allocated already, so no index byte size for the row
+    // unless an unbounded ring grows
+    TimeRing* ring = (TimeRing*)entry;  // NOLINT
+    uint32_t grown = 0;
+    DataBlock* evicted = ring->Put(time, row, &grown);
+    byte_size += grown * sizeof(TimeRow);
+    if (evicted == NULL) {
+        idx_cnt_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // readers may still hold the evicted row
+        DeferFree(evicted, false, ring);
+    }
+    idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+    IncrWriteVersion();
+}
+
+void Segment::DeferFree(DataBlock* row, bool replaced, TimeRing* ring) {
+    if (ring != nullptr) {
+        ring->Hold();
+    }
+    EvictedRow* node = new EvictedRow{row, gc_version_.load(std::memory_order_relaxed), replaced, ring, nullptr};
+    node->next = evicted_rows_.load(std::memory_order_relaxed);
+    while (!evicted_rows_.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+    }
+}
+
+void Segment::GcEvictedRows(uint64_t version, uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    EvictedRow* node = evicted_rows_.exchange(nullptr, std::memory_order_acquire);
+    EvictedRow* keep_head = nullptr;
+    EvictedRow* keep_tail = nullptr;
+    std::vector<DataBlock*> rows;
+    while (node != nullptr) {
+        EvictedRow* tmp = node;
+        node = node->next;
+        if (tmp->version <= version && (tmp->ring == nullptr || !tmp->ring->IsReading())) {
+            if (tmp->replaced) {
+                delete tmp->row;
+            } else {
+                rows.push_back(tmp->row);
+            }
+            if (tmp->ring != nullptr) {
+                tmp->ring->UnHold();
+            }
+            delete tmp;
+        } else {
+            tmp->next = nullptr;
+            if (keep_tail == nullptr) {
+                keep_head = tmp;
+            } else {
+                keep_tail->next = tmp;
+            }
+            keep_tail = tmp;
+        }
+    }
+    FreeRows(rows, gc_record_cnt, gc_record_byte_size);
+    if (keep_head != nullptr) {
+        // put back the rows which may be still read
+        keep_tail->next = evicted_rows_.load(std::memory_order_relaxed);
+        while (!evicted_rows_.compare_exchange_weak(keep_tail->next, keep_head, std::memory_order_release,
+                                                    std::memory_order_relaxed)) {
+        }
+    }
 }
 
 void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
+    if (ring_) {
+        PutRing(key, time, row);
+        return;
+    }
     void* entry = nullptr;
     uint32_t byte_size = 0;
     int ret = entries_->Get(key, entry);
@@ -191,12 +386,13 @@ void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
         ->count_.fetch_add(1, std::memory_order_relaxed);
     byte_size += GetRecordTsIdxSize(height);
     idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+    IncrWriteVersion();
 }
 
 void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row) {
     void* key_entry_or_list = nullptr;
     uint32_t byte_size = 0;
-    std::lock_guard<std::mutex> lock(mu_);  // TODO(hw): need lock?
+    std::lock_guard<std::shared_mutex> lock(mu_);  // TODO(hw): need lock?
     int ret = entries_->Get(key, key_entry_or_list);
     if (ts_cnt_ == 1) {
         PutUnlock(key, time, row);
@@ -221,6 +417,7 @@ void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t
         byte_size += GetRecordTsIdxSize(height);
         idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
         idx_cnt_vec_[key_entry_id]->fetch_add(1, std::memory_order_relaxed);
+        IncrWriteVersion();
     }
 }
 
@@ -237,7 +434,7 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
         return;
     }
     void* entry_arr = NULL;
-    std::lock_guard<std::mutex> lock(mu_);
+    std::shared_lock<std::shared_mutex> lock(mu_);
     for (const auto& kv : ts_map) {
         uint32_t byte_size = 0;
         auto pos = ts_idx_map_.find(kv.first);
@@ -254,13 +451,24 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
                     entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
                 }
-                entry_arr = (void*)entry_arr_tmp;  // NOLINT
-                uint8_t height = entries_->Insert(skey, entry_arr);
-                byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
-                pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+                void* new_entry_arr = (void*)entry_arr_tmp;  // NOLINT
+                bool inserted = false;
+                auto* entry_node = entries_->InsertIfAbsentConcurrently(skey, new_entry_arr, &inserted);
+                if (inserted) {
+                    byte_size +=
+                        GetRecordPkMultiIdxSize(entry_node->Height(), key.size(), key_entry_max_height_, ts_cnt_);
+                    pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    for (uint32_t i = 0; i < ts_cnt_; i++) {
+                        delete entry_arr_tmp[i];
+                    }
+                    delete[] entry_arr_tmp;
+                    delete[] pk;
+                }
+                entry_arr = entry_node->GetValue();
             }
         }
-        uint8_t height = ((KeyEntry**)entry_arr)[pos->second]->entries.Insert(  // NOLINT
+        uint8_t height = ((KeyEntry**)entry_arr)[pos->second]->entries.InsertConcurrently(  // NOLINT
             kv.second, row);
         ((KeyEntry**)entry_arr)[pos->second]->count_.fetch_add(  // NOLINT
             1, std::memory_order_relaxed);
@@ -268,17 +476,19 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
         idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
         idx_cnt_vec_[pos->second]->fetch_add(1, std::memory_order_relaxed);
     }
+    IncrWriteVersion();
 }
 
 bool Segment::Delete(const Slice& key) {
     ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
     {
-        std::lock_guard<std::mutex> lock(mu_);
+        std::lock_guard<std::shared_mutex> lock(mu_);
         entry_node = entries_->Remove(key);
         if (entry_node == NULL) {
             return false;
         }
     }
+    IncrWriteVersion();
     {
         std::lock_guard<std::mutex> lock(gc_mu_);
         entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
@@ -298,7 +508,7 @@ void Segment::FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint6
             tmp->GetValue()->dim_cnt_down--;
         } else {
             DEBUGLOG("delele data block for key %lu", tmp->GetKey());
-            gc_record_byte_size += GetRecordSize(tmp->GetValue()->size);
+            gc_record_byte_size += GetRecordSize(tmp->GetValue());
             delete tmp->GetValue();
             gc_record_cnt++;
         }
@@ -313,7 +523,15 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
     }
     // free pk memory
     delete[] entry_node->GetKey().data();
-    if (ts_cnt_ > 1) {
+    if (ring_) {
+        TimeRing* ring = (TimeRing*)entry_node->GetValue();  // NOLINT
+        uint64_t byte_size =
+            GetRecordPkRingSize(entry_node->Height(), entry_node->GetKey().size(), ring->GetCapacity());
+        uint64_t cnt = ReleaseRing(ring, gc_record_cnt, gc_record_byte_size);
+        gc_idx_cnt += cnt;
+        idx_cnt_.fetch_sub(cnt, std::memory_order_relaxed);
+        idx_byte_size_.fetch_sub(byte_size, std::memory_order_relaxed);
+    } else if (ts_cnt_ > 1) {
         KeyEntry** entry_arr = (KeyEntry**)entry_node->GetValue();  // NOLINT
         for (uint32_t i = 0; i < ts_cnt_; i++) {
             uint64_t old = gc_idx_cnt;
@@ -359,13 +577,20 @@ void Segment::GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt, uint64_t&
         std::lock_guard<std::mutex> lock(gc_mu_);
         node = entry_free_list_->Split(version);
     }
+    uint64_t cur_version = gc_version_.load(std::memory_order_relaxed);
     while (node != NULL) {
         ::openmldb::base::Node<Slice, void*>* entry_node = node->GetValue();
-        FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
-        delete entry_node;
         ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<Slice, void*>*>* tmp = node;
         node = node->GetNextNoBarrier(0);
         delete tmp;
+        if (ring_ && ((TimeRing*)entry_node->GetValue())->IsPinned()) {  // NOLINT
+            // it is still read or held by the evicted rows, try it at the next round
+            std::lock_guard<std::mutex> lock(gc_mu_);
+            entry_free_list_->Insert(cur_version, entry_node);
+            continue;
+        }
+        FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        delete entry_node;
         pk_cnt_.fetch_sub(1, std::memory_order_relaxed);
     }
 }
@@ -377,10 +602,19 @@ void Segment::GcFreeList(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t
     }
     uint64_t free_list_version = cur_version - FLAGS_gc_deleted_pk_version_delta;
     GcEntryFreeList(free_list_version, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    GcEvictedRows(free_list_version, gc_record_cnt, gc_record_byte_size);
 }
 
 void Segment::ExecuteGc(const TTLSt& ttl_st, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                         uint64_t& gc_record_byte_size) {
+    uint64_t old_gc_idx_cnt = gc_idx_cnt;
+    if (ring_) {
+        GcRing(ttl_st, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        if (gc_idx_cnt != old_gc_idx_cnt) {
+            IncrWriteVersion();
+        }
+        return;
+    }
     uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
     switch (ttl_st.ttl_type) {
         case ::openmldb::storage::TTLType::kAbsoluteTime: {
@@ -417,6 +651,9 @@ void Segment::ExecuteGc(const TTLSt& ttl_st, uint64_t& gc_idx_cnt, uint64_t& gc_
         default:
             PDLOG(WARNING, "ttl type %d is unsupported", ttl_st.ttl_type);
     }
+    if (gc_idx_cnt != old_gc_idx_cnt) {
+        IncrWriteVersion();
+    }
 }
 
 void Segment::ExecuteGc(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
@@ -440,7 +677,11 @@ void Segment::ExecuteGc(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
     if (!need_gc) {
         return;
     }
+    uint64_t old_gc_idx_cnt = gc_idx_cnt;
     GcAllType(ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    if (gc_idx_cnt != old_gc_idx_cnt) {
+        IncrWriteVersion();
+    }
 }
 
 void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
@@ -456,7 +697,7 @@ void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_reco
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<std::shared_mutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByPos(keep_cnt);
             }
@@ -473,6 +714,150 @@ void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_reco
     delete it;
 }
 
+// rows over the keep count are evicted at put, gc only walks the rings if
+// the ttl is changed
+void Segment::GcRing(const TTLSt& ttl_st, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                     uint64_t& gc_record_byte_size) {
+    uint32_t capacity = ring_capacity_.load(std::memory_order_relaxed);
+    // the ring is unbounded and keeps all the rows if the keep count is removed
+    uint32_t new_capacity = 0;
+    if (ttl_st.lat_ttl > 0 && ttl_st.lat_ttl <= UINT32_MAX) {
+        new_capacity = ttl_st.lat_ttl;
+    }
+    bool need_truncate = ttl_st.ttl_type != ::openmldb::storage::TTLType::kLatestTime && ttl_st.NeedGc();
+    if (new_capacity == capacity && !need_truncate) {
+        return;
+    }
+    ring_capacity_.store(new_capacity, std::memory_order_relaxed);
+    TTLSt expire_st(ttl_st);
+    if (ttl_st.abs_ttl > 0) {
+        expire_st.abs_ttl = ::baidu::common::timer::get_micros() / 1000 - ttl_offset_ - ttl_st.abs_ttl;
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t old = gc_idx_cnt;
+    std::vector<DataBlock*> evicted;
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        TimeRing* ring = (TimeRing*)it->GetValue();  // NOLINT
+        Slice key = it->GetKey();
+        it->Next();
+        uint32_t old_capacity = ring->GetCapacity();
+        if (old_capacity != new_capacity) {
+            ring->Resize(new_capacity, &evicted);
+            // an unbounded ring keeps the slots it has grown to
+            uint32_t cur_capacity = ring->GetCapacity();
+            if (cur_capacity > old_capacity) {
+                idx_byte_size_.fetch_add((cur_capacity - old_capacity) * sizeof(TimeRow), std::memory_order_relaxed);
+            } else {
+                idx_byte_size_.fetch_sub((old_capacity - cur_capacity) * sizeof(TimeRow), std::memory_order_relaxed);
+            }
+        }
+        if (need_truncate) {
+            ring->Truncate(expire_st, &evicted);
+            ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+            if (ring->GetSize() == 0) {
+                std::lock_guard<std::shared_mutex> lock(mu_);
+                if (ring->GetSize() == 0) {
+                    entry_node = entries_->Remove(key);
+                }
+            }
+            if (entry_node != NULL) {
+                std::lock_guard<std::mutex> lock(gc_mu_);
+                entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+            }
+        }
+        for (DataBlock* row : evicted) {
+            DeferFree(row, false, ring);
+        }
+        gc_idx_cnt += evicted.size();
+        idx_cnt_.fetch_sub(evicted.size(), std::memory_order_relaxed);
+        evicted.clear();
+    }
+    delete it;
+    DEBUGLOG("[GcRing] segment gc capacity %u consumed %lu, count %lu", new_capacity,
+             (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
+}
+
+// it runs in the gc thread which is the only one changes the existing nodes,
+// so runs are compressed out of the lock and only swapped in with it held
+void Segment::CompressCold(const uint64_t time, uint64_t& saved_byte_size) {
+    if (ring_ || ts_cnt_ > 1) {
+        return;
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t cold_cnt = 0;
+    std::vector<DataBlock**> slots;
+    std::vector<DataBlock*> rows;
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
+        it->Next();
+        uint32_t raw_size = 0;
+        TimeEntries::Iterator* data_it = entry->entries.NewIterator();
+        data_it->Seek(time);
+        while (data_it->Valid()) {
+            DataBlock* row = data_it->GetValue();
+            if (row->cold_pos > 0 || row->dim_cnt_down > 1 || row->storage == kMappedData) {
+                // compressed already, shared with other indexes or kept in the mapping
+                cold_cnt += CompressRun(entry, &slots, &rows, saved_byte_size);
+                raw_size = 0;
+                data_it->Next();
+                continue;
+            }
+            if (rows.size() == ColdBlock::kMaxRowCnt || raw_size + row->size > ColdBlock::kMaxRawSize) {
+                cold_cnt += CompressRun(entry, &slots, &rows, saved_byte_size);
+                raw_size = 0;
+            }
+            slots.push_back(&data_it->GetValue());
+            rows.push_back(row);
+            raw_size += row->size;
+            data_it->Next();
+        }
+        cold_cnt += CompressRun(entry, &slots, &rows, saved_byte_size);
+        delete data_it;
+    }
+    delete it;
+    DEBUGLOG("[CompressCold] segment compress with key %lu consumed %lu, count %lu", time,
+             (::baidu::common::timer::get_micros() - consumed) / 1000, cold_cnt);
+}
+
+uint64_t Segment::CompressRun(KeyEntry* entry, std::vector<DataBlock**>* slots, std::vector<DataBlock*>* rows,
+                              uint64_t& saved_byte_size) {
+    uint64_t cnt = 0;
+    ColdBlock* block = rows->size() > 1 ? ColdBlock::New(*rows) : NULL;
+    if (block != NULL) {
+        std::lock_guard<std::shared_mutex> lock(mu_);
+        // skip entry that ocupied by reader, it will be compressed next time
+        if (entry->refs_.load(std::memory_order_acquire) <= 0) {
+            uint64_t old_byte_size = 0;
+            uint64_t new_byte_size = 0;
+            for (uint32_t i = 0; i < rows->size(); i++) {
+                DataBlock* cold_row = new DataBlock(block, i, rows->at(i)->size);
+                old_byte_size += GetRecordSize(rows->at(i));
+                new_byte_size += GetRecordSize(cold_row);
+                *(slots->at(i)) = cold_row;
+            }
+            saved_byte_size += old_byte_size - new_byte_size;
+            cnt = rows->size();
+        }
+    }
+    if (cnt > 0) {
+        // readers may still hold the replaced rows
+        for (DataBlock* row : *rows) {
+            DeferFree(row, true, nullptr);
+        }
+    } else if (block != NULL) {
+        for (uint32_t i = 0; i < rows->size(); i++) {
+            block->UnRef();
+        }
+    }
+    slots->clear();
+    rows->clear();
+    return cnt;
+}
+
 void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                         uint64_t& gc_record_byte_size) {
     uint64_t old = gc_idx_cnt;
@@ -502,7 +887,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<std::shared_mutex> lock(mu_);
                         SplitList(entry, kv.second.abs_ttl, &node);
                         if (entry->entries.IsEmpty()) {
                             empty_cnt++;
@@ -511,7 +896,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                     break;
                 }
                 case ::openmldb::storage::TTLType::kLatestTime: {
-                    std::lock_guard<std::mutex> lock(mu_);
+                    std::lock_guard<std::shared_mutex> lock(mu_);
                     if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                         node = entry->entries.SplitByPos(kv.second.lat_ttl);
                     }
@@ -523,7 +908,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<std::shared_mutex> lock(mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             node = entry->entries.SplitByKeyAndPos(kv.second.abs_ttl, kv.second.lat_ttl);
                         }
@@ -536,7 +921,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<std::shared_mutex> lock(mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             if (kv.second.abs_ttl == 0) {
                                 node = entry->entries.SplitByPos(kv.second.lat_ttl);
@@ -568,7 +953,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             bool is_empty = true;
             ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
             {
-                std::lock_guard<std::mutex> lock(mu_);
+                std::lock_guard<std::shared_mutex> lock(mu_);
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
                     if (!entry_arr[i]->entries.IsEmpty()) {
                         is_empty = false;
@@ -621,7 +1006,7 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
         node = NULL;
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<std::shared_mutex> lock(mu_);
             SplitList(entry, time, &node);
             if (entry->entries.IsEmpty()) {
                 entry_node = entries_->Remove(key);
@@ -667,7 +1052,7 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
         }
         node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<std::shared_mutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByKeyAndPos(time, keep_cnt);
             }
@@ -712,7 +1097,7 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
         node = NULL;
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<std::shared_mutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByKeyOrPos(time, keep_cnt);
             }
@@ -745,6 +1130,10 @@ int Segment::GetCount(const Slice& key, uint64_t& count) {
     if (entries_->Get(key, entry) < 0 || entry == NULL) {
         return -1;
     }
+    if (ring_) {
+        count = ((TimeRing*)entry)->GetSize();  // NOLINT
+        return 0;
+    }
     count = ((KeyEntry*)entry)->count_.load(std::memory_order_relaxed);  // NOLINT
     return 0;
 }
@@ -769,33 +1158,49 @@ int Segment::GetCount(const Slice& key, uint32_t idx, uint64_t& count) {
 // Iterator
 MemTableIterator* Segment::NewIterator(const Slice& key, Ticket& ticket) {
     if (entries_ == NULL || ts_cnt_ > 1) {
-        return new MemTableIterator(NULL);
+        return new MemTableIterator(NULL, NULL);
     }
     void* entry = NULL;
     if (entries_->Get(key, entry) < 0 || entry == NULL) {
-        return new MemTableIterator(NULL);
+        return new MemTableIterator(NULL, NULL);
     }
-    ticket.Push((KeyEntry*)entry);                                           // NOLINT
-    return new MemTableIterator(((KeyEntry*)entry)->entries.NewIterator());  // NOLINT
+    return NewEntryIterator(entry, 0, ticket);
+}
+
+MemTableIterator* Segment::NewEntryIterator(void* entry, uint32_t real_idx, Ticket& ticket) {
+    if (ring_) {
+        TimeRing* ring = (TimeRing*)entry;  // NOLINT
+        // pin the ring before the snapshot, so the rows evicted after it are kept
+        ticket.Push(ring);
+        std::vector<TimeRow> rows;
+        ring->Snapshot(&rows);
+        return new MemTableIterator(std::move(rows), &ticket);
+    }
+    KeyEntry* key_entry = ts_cnt_ > 1 ? ((KeyEntry**)entry)[real_idx] : (KeyEntry*)entry;  // NOLINT
+    ticket.Push(key_entry);
+    return new MemTableIterator(key_entry->entries.NewIterator(), &ticket);
 }
 
 MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& ticket) {
     auto pos = ts_idx_map_.find(idx);
     if (pos == ts_idx_map_.end()) {
-        return new MemTableIterator(NULL);
+        return new MemTableIterator(NULL, NULL);
     }
     if (ts_cnt_ == 1) {
         return NewIterator(key, ticket);
     }
     void* entry_arr = NULL;
     if (entries_->Get(key, entry_arr) < 0 || entry_arr == NULL) {
-        return new MemTableIterator(NULL);
+        return new MemTableIterator(NULL, NULL);
     }
-    ticket.Push(((KeyEntry**)entry_arr)[pos->second]);                                         // NOLINT
-    return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]->entries.NewIterator());  // NOLINT
+    return NewEntryIterator(entry_arr, pos->second, ticket);
 }
 
-MemTableIterator::MemTableIterator(TimeEntries::Iterator* it) : it_(it) {}
+MemTableIterator::MemTableIterator(TimeEntries::Iterator* it, Ticket* ticket)
+    : it_(it), is_ring_(false), rows_(), pos_(0), ticket_(ticket), cold_block_(NULL), cold_value_() {}
+
+MemTableIterator::MemTableIterator(std::vector<TimeRow>&& rows, Ticket* ticket)
+    : it_(NULL), is_ring_(true), rows_(std::move(rows)), pos_(0), ticket_(ticket), cold_block_(NULL), cold_value_() {}
 
 MemTableIterator::~MemTableIterator() {
     if (it_ != NULL) {
@@ -804,6 +1209,13 @@ MemTableIterator::~MemTableIterator() {
 }
 
 void MemTableIterator::Seek(const uint64_t time) {
+    if (is_ring_) {
+        pos_ = 0;
+        while (pos_ < rows_.size() && rows_[pos_].time > time) {
+            pos_++;
+        }
+        return;
+    }
     if (it_ == NULL) {
         return;
     }
@@ -811,6 +1223,9 @@ void MemTableIterator::Seek(const uint64_t time) {
 }
 
 bool MemTableIterator::Valid() {
+    if (is_ring_) {
+        return pos_ < rows_.size();
+    }
     if (it_ == NULL) {
         return false;
     }
@@ -818,6 +1233,10 @@ bool MemTableIterator::Valid() {
 }
 
 void MemTableIterator::Next() {
+    if (is_ring_) {
+        pos_++;
+        return;
+    }
     if (it_ == NULL) {
         return;
     }
@@ -825,12 +1244,46 @@ void MemTableIterator::Next() {
 }
 
 ::openmldb::base::Slice MemTableIterator::GetValue() const {
-    return ::openmldb::base::Slice(it_->GetValue()->data, it_->GetValue()->size);
+    const DataBlock* row = is_ring_ ? rows_[pos_].row : it_->GetValue();
+    if (row->cold_pos > 0) {
+        return GetColdValue(row);
+    }
+    return ::openmldb::base::Slice(row->data, row->size);
 }
 
-uint64_t MemTableIterator::GetKey() const { return it_->GetKey(); }
+bool MemTableIterator::IsCold() const {
+    const DataBlock* row = is_ring_ ? rows_[pos_].row : it_->GetValue();
+    return row->cold_pos > 0;
+}
+
+// the rows of a cold block are read one after another, so the block is
+// uncompressed once and replaced by the next block the iterator reaches
+::openmldb::base::Slice MemTableIterator::GetColdValue(const DataBlock* row) const {
+    ColdBlock* block = row->GetColdBlock();
+    if (block != cold_block_) {
+        cold_block_ = NULL;
+        cold_value_.clear();
+        if (!block->Uncompress(&cold_value_)) {
+            PDLOG(WARNING, "fail to uncompress cold block");
+            return ::openmldb::base::Slice();
+        }
+        cold_block_ = block;
+    }
+    return ::openmldb::base::Slice(cold_value_.data() + block->GetOffset(row->cold_pos - 1), row->size);
+}
+
+uint64_t MemTableIterator::GetKey() const {
+    if (is_ring_) {
+        return rows_[pos_].time;
+    }
+    return it_->GetKey();
+}
 
 void MemTableIterator::SeekToFirst() {
+    if (is_ring_) {
+        pos_ = 0;
+        return;
+    }
     if (it_ == NULL) {
         return;
     }
@@ -838,6 +1291,10 @@ void MemTableIterator::SeekToFirst() {
 }
 
 void MemTableIterator::SeekToLast() {
+    if (is_ring_) {
+        pos_ = rows_.empty() ? 0 : rows_.size() - 1;
+        return;
+    }
     if (it_ == NULL) {
         return;
     }
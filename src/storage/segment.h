@@ -21,14 +21,18 @@
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <vector>
 
 #include "base/skiplist.h"
+#include "base/slab.h"
 #include "base/slice.h"
 #include "proto/tablet.pb.h"
+#include "storage/cold_block.h"
 #include "storage/iterator.h"
 #include "storage/schema.h"
 #include "storage/ticket.h"
+#include "storage/time_ring.h"
 
 namespace openmldb {
 namespace storage {
@@ -40,31 +44,72 @@ using ::openmldb::base::Slice;
 class Segment;
 class Ticket;
 
+// where the payload of a DataBlock lives
+enum DataStorage : uint8_t {
+    kSlabData = 0,
+    // passed in by caller with new[]
+    kHeapData = 1,
+    // the page of a mapped flat snapshot which the row holds
+    kMappedData = 2,
+};
+
+// release the flat snapshot which the mapped row refers to, see FlatSnapshotFile
+void UnRefMappedRow(const char* data);
+
+// DataBlock and its payload are allocated from the slab, so a put does not
+// hit the global allocator and a freed row is reused by a row of similar size
 struct DataBlock {
     // dimension count down
     uint8_t dim_cnt_down;
+    DataStorage storage;
+    // 0 if the row is stored plain, otherwise data points to a ColdBlock and
+    // it is the position of the row in the block plus one
+    uint16_t cold_pos;
     uint32_t size;
     char* data;
 
-    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len) : dim_cnt_down(dim_cnt), size(len), data(NULL) {
-        data = new char[len];
+    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len)
+        : dim_cnt_down(dim_cnt), storage(kSlabData), cold_pos(0), size(len), data(NULL) {
+        data = reinterpret_cast<char*>(::openmldb::base::Slab::Default()->Allocate(len));
         memcpy(data, input, len);
     }
 
     DataBlock(uint8_t dim_cnt, char* input, uint32_t len, bool skip_copy)
-        : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+        : dim_cnt_down(dim_cnt), storage(skip_copy ? kHeapData : kSlabData), cold_pos(0), size(len), data(NULL) {
         if (skip_copy) {
             data = input;
         } else {
-            data = new char[len];
+            data = reinterpret_cast<char*>(::openmldb::base::Slab::Default()->Allocate(len));
             memcpy(data, input, len);
         }
     }
 
+    // the row refers to a mapped page, the mapping is held until the row is freed
+    DataBlock(uint8_t dim_cnt, const char* mapped, uint32_t len, DataStorage mapped_storage)
+        : dim_cnt_down(dim_cnt), storage(mapped_storage), cold_pos(0), size(len), data(const_cast<char*>(mapped)) {}
+
+    // the row in pos of a cold block, it holds a ref of the block
+    DataBlock(ColdBlock* block, uint16_t pos, uint32_t len)
+        : dim_cnt_down(1), storage(kHeapData), cold_pos(pos + 1), size(len), data(reinterpret_cast<char*>(block)) {}
+
+    inline ColdBlock* GetColdBlock() const { return reinterpret_cast<ColdBlock*>(data); }
+
     ~DataBlock() {
-        delete[] data;
+        if (cold_pos > 0) {
+            GetColdBlock()->UnRef();
+        } else if (storage == kSlabData) {
+            ::openmldb::base::Slab::Default()->Free(data, size);
+        } else if (storage == kHeapData) {
+            delete[] data;
+        } else if (storage == kMappedData) {
+            UnRefMappedRow(data);
+        }
         data = NULL;
     }
+
+    static void* operator new(size_t size) { return ::openmldb::base::Slab::Default()->Allocate(size); }
+
+    static void operator delete(void* ptr, size_t size) { ::openmldb::base::Slab::Default()->Free(ptr, size); }
 };
 
 // the desc time comparator
@@ -84,7 +129,11 @@ typedef ::openmldb::base::Skiplist<uint64_t, DataBlock*, TimeComparator> TimeEnt
 
 class MemTableIterator : public TableIterator {
  public:
-    explicit MemTableIterator(TimeEntries::Iterator* it);
+    // the value of a cold row is valid until the iterator moves to a row
+    // of another cold block, the one which keeps it longer need copy it
+    MemTableIterator(TimeEntries::Iterator* it, Ticket* ticket);
+    // iterate the rows copied from a time ring
+    MemTableIterator(std::vector<TimeRow>&& rows, Ticket* ticket);
     virtual ~MemTableIterator();
     void Seek(const uint64_t time) override;
     bool Valid() override;
@@ -94,8 +143,20 @@ class MemTableIterator : public TableIterator {
     void SeekToFirst() override;
     void SeekToLast() override;
 
+    bool IsCold() const override;
+
+ private:
+    openmldb::base::Slice GetColdValue(const DataBlock* row) const;
+
  private:
     TimeEntries::Iterator* it_;
+    bool is_ring_;
+    std::vector<TimeRow> rows_;
+    uint32_t pos_;
+    Ticket* ticket_;
+    // only the last uncompressed cold block is kept
+    mutable ColdBlock* cold_block_;
+    mutable std::string cold_value_;
 };
 
 class KeyEntry {
@@ -145,18 +206,38 @@ struct SliceComparator {
 typedef ::openmldb::base::Skiplist<::openmldb::base::Slice, void*, SliceComparator> KeyEntries;
 typedef ::openmldb::base::Skiplist<uint64_t, ::openmldb::base::Node<Slice, void*>*, TimeComparator> KeyEntryNodeList;
 
+// deferred free of the rows evicted from time rings and the rows replaced by
+// cold rows
+struct EvictedRow {
+    DataBlock* row;
+    uint64_t version;
+    // the row is replaced by a cold row, only its memory need be freed
+    bool replaced;
+    // the ring the row is evicted from, the row is kept while it is read
+    TimeRing* ring;
+    EvictedRow* next;
+
+    static void* operator new(size_t size) { return ::openmldb::base::Slab::Default()->Allocate(size); }
+
+    static void operator delete(void* ptr, size_t size) { ::openmldb::base::Slab::Default()->Free(ptr, size); }
+};
+
 class Segment {
  public:
     Segment();
     explicit Segment(uint8_t height);
     Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec);
+    // rows of a key are kept in a time ring with ring_capacity instead of a
+    // skiplist. it's only for the latest ttl index with one ts column
+    Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec, uint32_t ring_capacity);
     ~Segment();
 
-    // Put time data
+    // Put time data, puts run concurrently with each other
     void Put(const Slice& key, uint64_t time, const char* data, uint32_t size);
 
     void Put(const Slice& key, uint64_t time, DataBlock* row);
 
+    // need external synchronized with all other puts
     void PutUnlock(const Slice& key, uint64_t time, DataBlock* row);
 
     void BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row);
@@ -192,6 +273,15 @@ class Segment {
     MemTableIterator* NewIterator(const Slice& key, Ticket& ticket);                   // NOLINT
     MemTableIterator* NewIterator(const Slice& key, uint32_t idx,
                                   Ticket& ticket);  // NOLINT
+    // iterator of the value in KeyEntries, real_idx is the position of ts
+    MemTableIterator* NewEntryIterator(void* entry, uint32_t real_idx,
+                                       Ticket& ticket);  // NOLINT
+
+    inline bool IsRing() const { return ring_; }
+
+    // compress the rows older than time into cold blocks, the memory saved
+    // is added to saved_byte_size
+    void CompressCold(const uint64_t time, uint64_t& saved_byte_size);  // NOLINT
 
     inline uint64_t GetIdxCnt() {
         return ts_cnt_ > 1 ? idx_cnt_vec_[0]->load(std::memory_order_relaxed)
@@ -225,6 +315,10 @@ class Segment {
 
     inline uint64_t GetPkCnt() { return pk_cnt_.load(std::memory_order_relaxed); }
 
+    // it grows after the rows are put, deleted or gc. the cached results of
+    // a read are valid while the version read before it is unchanged
+    inline uint64_t GetWriteVersion() const { return write_version_.load(std::memory_order_acquire); }
+
     void GcFreeList(uint64_t& entry_gc_idx_cnt,      // NOLINT
                     uint64_t& gc_record_cnt,         // NOLINT
                     uint64_t& gc_record_byte_size);  // NOLINT
@@ -253,10 +347,22 @@ class Segment {
                    uint64_t& gc_record_cnt,         // NOLINT
                    uint64_t& gc_record_byte_size);  // NOLINT
 
+    void PutRing(const Slice& key, uint64_t time, DataBlock* row);
+    void GcRing(const TTLSt& ttl_st, uint64_t& gc_idx_cnt,  // NOLINT
+                uint64_t& gc_record_cnt,                    // NOLINT
+                uint64_t& gc_record_byte_size);             // NOLINT
+    void DeferFree(DataBlock* row, bool replaced, TimeRing* ring);
+    inline void IncrWriteVersion() { write_version_.fetch_add(1, std::memory_order_release); }
+    uint64_t CompressRun(KeyEntry* entry, std::vector<DataBlock**>* slots, std::vector<DataBlock*>* rows,
+                         uint64_t& saved_byte_size);  // NOLINT
+    void GcEvictedRows(uint64_t version, uint64_t& gc_record_cnt,  // NOLINT
+                       uint64_t& gc_record_byte_size);             // NOLINT
+
  private:
     KeyEntries* entries_;
-    // only Put need mutex
-    std::mutex mu_;
+    // put holds it shared and inserts into skiplists with cas, the ones which
+    // unlink nodes (gc, delete) hold it exclusively
+    std::shared_mutex mu_;
     std::mutex gc_mu_;
     std::atomic<uint64_t> idx_cnt_;
     std::atomic<uint64_t> idx_byte_size_;
@@ -265,9 +371,13 @@ class Segment {
     KeyEntryNodeList* entry_free_list_;
     uint32_t ts_cnt_;
     std::atomic<uint64_t> gc_version_;
+    std::atomic<uint64_t> write_version_;
     std::map<uint32_t, uint32_t> ts_idx_map_;
     std::vector<std::shared_ptr<std::atomic<uint64_t>>> idx_cnt_vec_;
     uint64_t ttl_offset_;
+    bool ring_;
+    std::atomic<uint32_t> ring_capacity_;
+    std::atomic<EvictedRow*> evicted_rows_;
 };
 
 }  // namespace storage
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/slice.h"
+#include "benchmark/benchmark.h"
+#include "storage/segment.h"
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t KEY_NUM_PER_THREAD = 1000;
+static const uint32_t RECORD_NUM_PER_KEY = 100;
+
+// every thread writes its own keys, so different writers never touch the same key
+static void RunPut(Segment* segment, uint32_t thread_id, const std::string& value) {
+    for (uint32_t i = 0; i < RECORD_NUM_PER_KEY; i++) {
+        for (uint32_t j = 0; j < KEY_NUM_PER_THREAD; j++) {
+            std::string key = "key" + std::to_string(thread_id) + "_" + std::to_string(j);
+            segment->Put(::openmldb::base::Slice(key), 9527 + i, value.c_str(), value.size());
+        }
+    }
+}
+
+static void BM_SegmentPut(benchmark::State& state) {  // NOLINT
+    uint32_t thread_num = state.range(0);
+    std::string value(128, 'a');
+    for (auto _ : state) {
+        Segment segment;
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < thread_num; i++) {
+            threads.emplace_back(RunPut, &segment, i, value);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        state.PauseTiming();
+        segment.Release();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * thread_num * KEY_NUM_PER_THREAD * RECORD_NUM_PER_KEY);
+}
+
+BENCHMARK(BM_SegmentPut)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace storage
+}  // namespace openmldb
+
+BENCHMARK_MAIN();
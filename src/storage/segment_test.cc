@@ -18,6 +18,8 @@
 
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "base/glog_wrapper.h"
 #include "base/slice.h"
@@ -107,7 +109,7 @@ TEST_F(SegmentTest, Delete) {
     segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
     ASSERT_EQ(4, (int64_t)gc_idx_cnt);
     ASSERT_EQ(4, (int64_t)gc_record_cnt);
-    ASSERT_EQ(84, (int64_t)gc_record_byte_size);
+    ASSERT_EQ(4 * GetRecordSize(5), (int64_t)gc_record_byte_size);
 }
 
 TEST_F(SegmentTest, GetCount) {
@@ -214,6 +216,136 @@ TEST_F(SegmentTest, TestGc4Head) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SegmentTest, TestRing) {
+    Segment segment(8, std::vector<uint32_t>(), 2);
+    ASSERT_TRUE(segment.IsRing());
+    Slice pk("PK");
+    segment.Put(pk, 9768, "test1", 5);
+    segment.Put(pk, 9770, "test3", 5);
+    segment.Put(pk, 9769, "test2", 5);
+    segment.Put(pk, 9767, "test0", 5);
+    ASSERT_EQ(1, (int64_t)segment.GetPkCnt());
+    ASSERT_EQ(2, (int64_t)segment.GetIdxCnt());
+    uint64_t count = 0;
+    ASSERT_EQ(0, segment.GetCount(pk, count));
+    ASSERT_EQ(2, (int64_t)count);
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(9770, (int64_t)it->GetKey());
+        it->Next();
+        ASSERT_EQ(9769, (int64_t)it->GetKey());
+        ::openmldb::base::Slice value = it->GetValue();
+        ASSERT_EQ("test2", std::string(value.data(), value.size()));
+        it->Next();
+        ASSERT_FALSE(it->Valid());
+        delete it;
+    }
+    // the evicted rows are freed after the gc version moves on and the ring is not read
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)gc_record_cnt);
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(2, (int64_t)gc_record_cnt);
+    ASSERT_EQ(2 * GetRecordSize(5), (int64_t)gc_record_byte_size);
+    // the ring shrinks when the ttl is changed
+    TTLSt ttl(0, 1, ::openmldb::storage::TTLType::kLatestTime);
+    segment.ExecuteGc(ttl, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(1, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(1, (int64_t)segment.GetIdxCnt());
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(pk, ticket);
+    it->Seek(9770);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(9770, (int64_t)it->GetKey());
+    it->Next();
+    ASSERT_FALSE(it->Valid());
+    delete it;
+}
+
+TEST_F(SegmentTest, TestRingUnbounded) {
+    Segment segment(8, std::vector<uint32_t>(), 2);
+    Slice pk("PK");
+    segment.Put(pk, 1, "test1", 5);
+    segment.Put(pk, 2, "test2", 5);
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // the keep count is removed, so no row is evicted any more
+    TTLSt ttl(0, 0, ::openmldb::storage::TTLType::kLatestTime);
+    segment.ExecuteGc(ttl, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)gc_idx_cnt);
+    for (uint64_t ts = 3; ts <= 10; ts++) {
+        segment.Put(pk, ts, "test", 4);
+    }
+    ASSERT_EQ(10, (int64_t)segment.GetIdxCnt());
+    uint64_t count = 0;
+    ASSERT_EQ(0, segment.GetCount(pk, count));
+    ASSERT_EQ(10, (int64_t)count);
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(pk, ticket);
+    it->SeekToFirst();
+    for (uint64_t ts = 10; ts >= 1; ts--) {
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(ts, it->GetKey());
+        it->Next();
+    }
+    ASSERT_FALSE(it->Valid());
+    delete it;
+    // it is bounded again with a keep count
+    TTLSt lat_ttl(0, 3, ::openmldb::storage::TTLType::kLatestTime);
+    segment.ExecuteGc(lat_ttl, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(7, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(3, (int64_t)segment.GetIdxCnt());
+}
+
+TEST_F(SegmentTest, TestRingPinned) {
+    Segment segment(8, std::vector<uint32_t>(), 1);
+    Slice pk("PK");
+    segment.Put(pk, 1, "test1", 5);
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        // the row under the iterator is evicted
+        segment.Put(pk, 2, "test2", 5);
+        segment.IncrGcVersion();
+        segment.IncrGcVersion();
+        segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(0, (int64_t)gc_record_cnt);
+        ::openmldb::base::Slice value = it->GetValue();
+        ASSERT_EQ("test1", std::string(value.data(), value.size()));
+        // the removed ring is kept while it is read
+        TTLSt ttl(1, 0, ::openmldb::storage::TTLType::kAbsoluteTime);
+        segment.ExecuteGc(ttl, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(0, (int64_t)segment.GetIdxCnt());
+        segment.IncrGcVersion();
+        segment.IncrGcVersion();
+        segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(0, (int64_t)gc_record_cnt);
+        value = it->GetValue();
+        ASSERT_EQ("test1", std::string(value.data(), value.size()));
+        delete it;
+    }
+    // the evicted rows go first, then the ring they held
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(2, (int64_t)gc_record_cnt);
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)segment.GetPkCnt());
+}
+
 TEST_F(SegmentTest, TestGc4TTL) {
     Segment segment;
     segment.Put("PK", 9768, "test1", 5);
@@ -235,6 +367,55 @@ TEST_F(SegmentTest, TestGc4TTL) {
     ASSERT_EQ(2 * GetRecordSize(5), (int64_t)gc_record_byte_size);
 }
 
+TEST_F(SegmentTest, TestCompressCold) {
+    Segment segment;
+    Slice pk("PK");
+    for (int i = 1; i <= 10; i++) {
+        std::string value(100, 'a' + i);
+        segment.Put(pk, i, value.c_str(), value.size());
+    }
+    uint64_t saved_byte_size = 0;
+    segment.CompressCold(5, saved_byte_size);
+    ASSERT_GT(saved_byte_size, 0u);
+    // compressed rows are not compressed again
+    uint64_t tmp_byte_size = 0;
+    segment.CompressCold(5, tmp_byte_size);
+    ASSERT_EQ(0u, tmp_byte_size);
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator(pk, ticket);
+        it->SeekToFirst();
+        int i = 10;
+        while (it->Valid()) {
+            ASSERT_EQ(i, (int64_t)it->GetKey());
+            ::openmldb::base::Slice value = it->GetValue();
+            ASSERT_EQ(std::string(100, 'a' + i), std::string(value.data(), value.size()));
+            // only the current cold block is kept by the iterator
+            ASSERT_EQ(i <= 5, it->IsCold());
+            it->Next();
+            i--;
+        }
+        ASSERT_EQ(0, i);
+        delete it;
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // the replaced rows are freed without changing the record count
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)gc_record_cnt);
+    ASSERT_EQ(0, (int64_t)gc_record_byte_size);
+    segment.Gc4TTL(3, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(3, (int64_t)gc_record_cnt);
+    ASSERT_LT(gc_record_byte_size, 3 * GetRecordSize(100));
+    segment.Gc4TTL(10, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(10, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(10, (int64_t)gc_record_cnt);
+    ASSERT_EQ(10 * GetRecordSize(100), gc_record_byte_size + saved_byte_size);
+}
+
 TEST_F(SegmentTest, TestGc4TTLAndHead) {
     Segment segment;
     segment.Put("PK1", 9766, "test1", 5);
@@ -354,6 +535,101 @@ TEST_F(SegmentTest, TestStat) {
     ASSERT_EQ(0, (int64_t)segment.GetIdxCnt());
 }
 
+// every thread writes its own keys, so different writers never touch the same key
+TEST_F(SegmentTest, MultiThreadPut) {
+    const uint32_t thread_num = 4;
+    const uint32_t key_num = 100;
+    const uint32_t record_num = 50;
+    std::string value(128, 'a');
+    Segment segment;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < thread_num; t++) {
+        threads.emplace_back([&segment, &value, t] {
+            for (uint32_t i = 0; i < record_num; i++) {
+                for (uint32_t j = 0; j < key_num; j++) {
+                    std::string key = "key" + std::to_string(t) + "_" + std::to_string(j);
+                    segment.Put(Slice(key), 9527 + i, value.c_str(), value.size());
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(thread_num * key_num, segment.GetPkCnt());
+    ASSERT_EQ(thread_num * key_num * record_num, segment.GetIdxCnt());
+    for (uint32_t t = 0; t < thread_num; t++) {
+        std::string key = "key" + std::to_string(t) + "_0";
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetCount(Slice(key), count));
+        ASSERT_EQ(record_num, count);
+    }
+}
+
+TEST_F(SegmentTest, MultiThreadPutSameKey) {
+    const uint32_t thread_num = 8;
+    const uint32_t record_num = 1000;
+    std::string value(128, 'a');
+    Segment segment;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < thread_num; t++) {
+        threads.emplace_back([&segment, &value, t] {
+            for (uint32_t j = 0; j < record_num; j++) {
+                segment.Put(Slice("pk"), t * record_num + j, value.c_str(), value.size());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(1u, segment.GetPkCnt());
+    ASSERT_EQ(thread_num * record_num, segment.GetIdxCnt());
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(Slice("pk"), ticket);
+    it->SeekToFirst();
+    uint64_t last = UINT64_MAX;
+    uint32_t cnt = 0;
+    while (it->Valid()) {
+        ASSERT_LT(it->GetKey(), last);
+        last = it->GetKey();
+        cnt++;
+        it->Next();
+    }
+    ASSERT_EQ(thread_num * record_num, cnt);
+    delete it;
+}
+
+TEST_F(SegmentTest, WriteVersion) {
+    Segment segment;
+    Slice pk("PK");
+    uint64_t version = segment.GetWriteVersion();
+    segment.Put(pk, 9768, "test1", 5);
+    ASSERT_GT(segment.GetWriteVersion(), version);
+    version = segment.GetWriteVersion();
+    segment.Put(pk, 9769, "test2", 5);
+    ASSERT_GT(segment.GetWriteVersion(), version);
+
+    // gc without expired rows keeps the version
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    version = segment.GetWriteVersion();
+    segment.ExecuteGc(TTLSt(0, 2, ::openmldb::storage::TTLType::kLatestTime), gc_idx_cnt, gc_record_cnt,
+                      gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(version, segment.GetWriteVersion());
+    segment.ExecuteGc(TTLSt(0, 1, ::openmldb::storage::TTLType::kLatestTime), gc_idx_cnt, gc_record_cnt,
+                      gc_record_byte_size);
+    ASSERT_EQ(1, (int64_t)gc_idx_cnt);
+    ASSERT_GT(segment.GetWriteVersion(), version);
+
+    version = segment.GetWriteVersion();
+    ASSERT_FALSE(segment.Delete(Slice("PK2")));
+    ASSERT_EQ(version, segment.GetWriteVersion());
+    ASSERT_TRUE(segment.Delete(pk));
+    ASSERT_GT(segment.GetWriteVersion(), version);
+}
+
 TEST_F(SegmentTest, GetTsIdx) {
     std::vector<uint32_t> ts_idx_vec = {1, 3, 5};
     Segment segment(8, ts_idx_vec);
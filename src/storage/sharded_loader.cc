@@ -0,0 +1,164 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/sharded_loader.h"
+
+#include "base/hash.h"
+#include "boost/bind.hpp"
+#include "storage/mem_table.h"
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t SEED = 0xe17a1465;
+
+ShardedLoader::ShardedLoader(std::shared_ptr<Table> table, uint32_t shard_num, uint32_t batch_size,
+                             uint32_t queue_size)
+    : table_(table), mem_table_(std::dynamic_pointer_cast<MemTable>(table)),
+      batch_size_(batch_size > 0 ? batch_size : 1), seg_cnt_(1), shards_(), succ_cnt_(0), mu_(), cv_(),
+      pending_(0) {
+    if (mem_table_) {
+        seg_cnt_ = mem_table_->GetSegCnt();
+    }
+    if (shard_num == 0) {
+        shard_num = 1;
+    }
+    for (uint32_t i = 0; i < shard_num; i++) {
+        auto shard = std::make_unique<Shard>();
+        shard->batch = nullptr;
+        shard->flat_batch = nullptr;
+        shard->writer = std::make_unique<::openmldb::base::TaskPool>(1, queue_size);
+        shards_.push_back(std::move(shard));
+    }
+}
+
+ShardedLoader::~ShardedLoader() {
+    Flush();
+    for (auto& shard : shards_) {
+        shard->writer->Stop();
+    }
+}
+
+uint32_t ShardedLoader::GetShard(const Slice& key) const {
+    if (shards_.size() == 1) {
+        return 0;
+    }
+    uint32_t hash = ::openmldb::base::hash(key.data(), key.size(), SEED);
+    if (seg_cnt_ > 1) {
+        // the same as the segment index of MemTable
+        return hash % seg_cnt_ % shards_.size();
+    }
+    return hash % shards_.size();
+}
+
+void ShardedLoader::Add(::openmldb::api::LogEntry* entry) {
+    const std::string& key = entry->dimensions_size() > 0 ? entry->dimensions(0).key() : entry->pk();
+    Shard* shard = shards_[GetShard(key)].get();
+    std::lock_guard<std::mutex> lock(shard->mu);
+    if (shard->batch == nullptr) {
+        shard->batch = new std::vector<::openmldb::api::LogEntry*>();
+        shard->batch->reserve(batch_size_);
+    }
+    shard->batch->push_back(entry);
+    if (shard->batch->size() >= batch_size_) {
+        Submit(shard);
+    }
+}
+
+void ShardedLoader::Add(const FlatRecord& record, FlatSnapshotFile* mapping) {
+    Shard* shard = shards_[GetShard(record.GetKey(0))].get();
+    std::lock_guard<std::mutex> lock(shard->mu);
+    if (shard->flat_batch == nullptr) {
+        shard->flat_batch = new FlatBatch();
+        shard->flat_batch->records.reserve(batch_size_);
+        shard->flat_batch->mapping = mapping;
+    }
+    shard->flat_batch->records.push_back(record);
+    if (shard->flat_batch->records.size() >= batch_size_) {
+        SubmitFlat(shard);
+    }
+}
+
+void ShardedLoader::Submit(Shard* shard) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        pending_++;
+    }
+    // the batches of a shard are put by its only writer in order
+    shard->writer->AddTask(boost::bind(&ShardedLoader::PutBatch, this, shard->batch));
+    shard->batch = nullptr;
+}
+
+void ShardedLoader::SubmitFlat(Shard* shard) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        pending_++;
+    }
+    shard->writer->AddTask(boost::bind(&ShardedLoader::PutFlatBatch, this, shard->flat_batch));
+    shard->flat_batch = nullptr;
+}
+
+void ShardedLoader::PutBatch(std::vector<::openmldb::api::LogEntry*>* batch) {
+    for (auto entry : *batch) {
+        table_->Put(*entry);
+        delete entry;
+    }
+    uint64_t cnt = batch->size();
+    delete batch;
+    Done(cnt);
+}
+
+void ShardedLoader::PutFlatBatch(FlatBatch* batch) {
+    std::vector<std::pair<uint32_t, Slice>> dimensions;
+    ::openmldb::api::LogEntry entry;
+    for (const auto& record : batch->records) {
+        if (mem_table_) {
+            record.GetDimensions(&dimensions);
+            mem_table_->Put(record.GetTs(), record.GetValue(), dimensions, batch->mapping);
+        } else {
+            record.ToLogEntry(&entry);
+            table_->Put(entry);
+        }
+    }
+    uint64_t cnt = batch->records.size();
+    delete batch;
+    Done(cnt);
+}
+
+void ShardedLoader::Done(uint64_t cnt) {
+    succ_cnt_.fetch_add(cnt, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mu_);
+    if (--pending_ == 0) {
+        cv_.notify_all();
+    }
+}
+
+void ShardedLoader::Flush() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mu);
+        if (shard->batch != nullptr) {
+            Submit(shard.get());
+        }
+        if (shard->flat_batch != nullptr) {
+            SubmitFlat(shard.get());
+        }
+    }
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this] { return pending_ == 0; });
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_SHARDED_LOADER_H_
+#define SRC_STORAGE_SHARDED_LOADER_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/taskpool.hpp"
+#include "proto/tablet.pb.h"
+#include "storage/flat_snapshot.h"
+#include "storage/table.h"
+
+namespace openmldb {
+namespace storage {
+
+class MemTable;
+
+// ShardedLoader puts the recovered log entries into a table with a writer
+// thread per shard. Entries are routed by the key of the first dimension,
+// for a memtable the shard is derived from the segment of the key, so every
+// segment of the first index has one writer and the entries of a key are put
+// in the order they are added. Add may be called by several readers.
+// The records of a flat snapshot are put without parsing, the file should
+// outlive the loader
+class ShardedLoader {
+ public:
+    ShardedLoader(std::shared_ptr<Table> table, uint32_t shard_num, uint32_t batch_size, uint32_t queue_size);
+    ~ShardedLoader();
+
+    ShardedLoader(const ShardedLoader&) = delete;
+    ShardedLoader& operator=(const ShardedLoader&) = delete;
+
+    void Add(::openmldb::api::LogEntry* entry);
+
+    // the rows refer to the record in mapping instead of a copy if mapping is
+    // not null, the caller holds the mapping until Flush
+    void Add(const FlatRecord& record, FlatSnapshotFile* mapping);
+
+    // return when all the entries added are put
+    void Flush();
+
+    uint64_t GetSuccCnt() const { return succ_cnt_.load(std::memory_order_relaxed); }
+
+ private:
+    struct FlatBatch {
+        std::vector<FlatRecord> records;
+        FlatSnapshotFile* mapping;
+    };
+
+    struct Shard {
+        std::mutex mu;
+        std::vector<::openmldb::api::LogEntry*>* batch;
+        FlatBatch* flat_batch;
+        std::unique_ptr<::openmldb::base::TaskPool> writer;
+    };
+
+    uint32_t GetShard(const Slice& key) const;
+
+    // the caller holds the lock of the shard
+    void Submit(Shard* shard);
+
+    void SubmitFlat(Shard* shard);
+
+    void PutBatch(std::vector<::openmldb::api::LogEntry*>* batch);
+
+    void PutFlatBatch(FlatBatch* batch);
+
+    void Done(uint64_t cnt);
+
+ private:
+    std::shared_ptr<Table> table_;
+    std::shared_ptr<MemTable> mem_table_;
+    uint32_t batch_size_;
+    uint32_t seg_cnt_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> succ_cnt_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    uint64_t pending_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_SHARDED_LOADER_H_
@@ -38,7 +38,10 @@ class Snapshot {
     virtual bool Recover(std::shared_ptr<Table> table,
                          uint64_t& latest_offset) = 0;  // NOLINT
     uint64_t GetOffset() { return offset_; }
-    int GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term);
+    int GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term,
+                    ::openmldb::api::SnapshotFormat format = ::openmldb::api::kLogSnapshot);
+    // replace the manifest file atomically
+    int WriteManifest(const ::openmldb::api::Manifest& manifest);
     static int GetLocalManifest(const std::string& full_path,
                                 ::openmldb::api::Manifest& manifest);  // NOLINT
 
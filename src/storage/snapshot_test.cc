@@ -23,7 +23,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <fstream>
 #include <iostream>
+#include <iterator>
 
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
@@ -31,6 +33,7 @@
 #include "codec/schema_codec.h"
 #include "common/timer.h"
 #include "gtest/gtest.h"
+#include "log/direct_io.h"
 #include "log/log_writer.h"
 #include "log/status.h"
 #include "proto/tablet.pb.h"
@@ -41,7 +44,13 @@
 #include "test/util.h"
 
 DECLARE_string(db_root_path);
+DECLARE_string(direct_io_root_path);
 DECLARE_string(snapshot_compression);
+DECLARE_uint32(load_snapshot_chunk_mb);
+DECLARE_uint32(load_table_thread_num);
+DECLARE_string(snapshot_format);
+DECLARE_bool(snapshot_keep_mapped);
+DECLARE_uint32(snapshot_max_delta_num);
 
 using ::openmldb::api::LogEntry;
 namespace openmldb {
@@ -1630,6 +1639,63 @@ TEST_F(SnapshotTest, Recover_large_snapshot) {
     delete it;
 }
 
+TEST_F(SnapshotTest, MakeSnapshotWithDirectIO) {
+    std::string binlog_dir = FLAGS_db_root_path + "/101_0/binlog/";
+    ::openmldb::base::MkdirRecur(binlog_dir);
+    // the file system of tmp may not support direct io, the snapshot is written with buffered io then
+    std::string probe_path = binlog_dir + "probe";
+    int probe_fd = ::openmldb::log::OpenDirect(probe_path, O_CREAT | O_WRONLY);
+    bool direct_io_supported = probe_fd >= 0;
+    if (direct_io_supported) {
+        close(probe_fd);
+    }
+    unlink(probe_path.c_str());
+    FLAGS_direct_io_root_path = FLAGS_db_root_path;
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    for (int count = 0; count < 10000; count++) {
+        offset++;
+        auto entry = ::openmldb::test::PackKVEntry(offset, "key", "value" + std::to_string(count), count + 1, 1);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    }
+    wh->Sync();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    {
+        MemTableSnapshot snapshot(101, 0, log_part, FLAGS_db_root_path);
+        snapshot.Init();
+        std::shared_ptr<MemTable> table =
+            std::make_shared<MemTable>("test", 101, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        table->Init();
+        uint64_t open_cnt = ::openmldb::log::GetDirectOpenCount();
+        uint64_t offset_value = 0;
+        ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+        if (direct_io_supported) {
+            // the snapshot is written under direct_io_root_path with its full path
+            ASSERT_LT(open_cnt, ::openmldb::log::GetDirectOpenCount());
+        }
+    }
+    // recover from the snapshot only
+    delete wh;
+    LogParts* empty_log_part = new LogParts(12, 4, scmp);
+    MemTableSnapshot snapshot(101, 0, empty_log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 101, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t snapshot_offset = 0;
+    ASSERT_TRUE(snapshot.Recover(table, snapshot_offset));
+    ASSERT_EQ(10000u, snapshot_offset);
+    ASSERT_EQ(10000u, table->GetRecordCnt());
+    FLAGS_direct_io_root_path = "";
+    RemoveData(FLAGS_db_root_path);
+}
+
 TEST_F(SnapshotTest, Recover_large_snapshot_and_binlog) {
     std::string snapshot_dir = FLAGS_db_root_path + "/101_0/snapshot/";
     std::string binlog_dir = FLAGS_db_root_path + "/101_0/binlog/";
@@ -1707,6 +1773,284 @@ TEST_F(SnapshotTest, Recover_large_snapshot_and_binlog) {
     delete it;
 }
 
+TEST_F(SnapshotTest, Recover_snapshot_in_chunks) {
+    std::string binlog_dir = FLAGS_db_root_path + "/102_0/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    uint32_t key_num = 1000;
+    uint32_t count = 200000;
+    std::string value(32, 'a');
+    for (uint32_t i = 0; i < count; i++) {
+        offset++;
+        auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(i % key_num), value, i + 1, 1);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ::openmldb::base::Slice slice(buffer);
+        ::openmldb::log::Status status = wh->Write(slice);
+        ASSERT_TRUE(status.ok());
+    }
+    wh->Sync();
+    MemTableSnapshot snapshot(102, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+
+    // the uncompressed snapshot is read by several readers
+    uint32_t chunk_mb = FLAGS_load_snapshot_chunk_mb;
+    uint32_t thread_num = FLAGS_load_table_thread_num;
+    FLAGS_load_snapshot_chunk_mb = 1;
+    FLAGS_load_table_thread_num = 4;
+    std::shared_ptr<MemTable> new_table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    new_table->Init();
+    uint64_t snapshot_offset = 0;
+    ASSERT_TRUE(snapshot.Recover(new_table, snapshot_offset));
+    FLAGS_load_snapshot_chunk_mb = chunk_mb;
+    FLAGS_load_table_thread_num = thread_num;
+    ASSERT_EQ(count, snapshot_offset);
+    ASSERT_EQ(count, new_table->GetRecordCnt());
+    for (uint32_t i = 0; i < key_num; i++) {
+        uint64_t cnt = 0;
+        ASSERT_EQ(0, new_table->GetCount(0, "key" + std::to_string(i), cnt));
+        ASSERT_EQ(count / key_num, cnt);
+    }
+    RemoveData(FLAGS_db_root_path);
+}
+
+TEST_F(SnapshotTest, Recover_flat_snapshot) {
+    std::string binlog_dir = FLAGS_db_root_path + "/103_0/binlog/";
+    std::string snapshot_path = FLAGS_db_root_path + "/103_0/snapshot/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    uint32_t key_num = 100;
+    uint32_t count = 2000;
+    auto write_entries = [&](uint32_t start, uint32_t end) {
+        for (uint32_t i = start; i < end; i++) {
+            offset++;
+            auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(i % key_num), "value", i + 1, 1);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            ::openmldb::base::Slice slice(buffer);
+            ASSERT_TRUE(wh->Write(slice).ok());
+        }
+        wh->Sync();
+    };
+    auto read_manifest = [&](::openmldb::api::Manifest* manifest) {
+        int fd = open((snapshot_path + "MANIFEST").c_str(), O_RDONLY);
+        google::protobuf::io::FileInputStream fileInput(fd);
+        fileInput.SetCloseOnDelete(true);
+        google::protobuf::TextFormat::Parse(&fileInput, manifest);
+    };
+    write_entries(0, count / 2);
+    MemTableSnapshot snapshot(103, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 103, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    std::string format = FLAGS_snapshot_format;
+    FLAGS_snapshot_format = "flat";
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    // the old flat snapshot is copied into the new one
+    write_entries(count / 2, count);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ::openmldb::api::Manifest manifest;
+    read_manifest(&manifest);
+    ASSERT_EQ(::openmldb::api::kFlatSnapshot, manifest.format());
+    ASSERT_EQ(count, manifest.count());
+
+    FLAGS_snapshot_keep_mapped = true;
+    std::shared_ptr<MemTable> new_table =
+        std::make_shared<MemTable>("test", 103, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    new_table->Init();
+    uint64_t snapshot_offset = 0;
+    ASSERT_TRUE(snapshot.Recover(new_table, snapshot_offset));
+    FLAGS_snapshot_keep_mapped = false;
+    ASSERT_EQ(count, snapshot_offset);
+    ASSERT_EQ(count, new_table->GetRecordCnt());
+    for (uint32_t i = 0; i < key_num; i++) {
+        uint64_t cnt = 0;
+        ASSERT_EQ(0, new_table->GetCount(0, "key" + std::to_string(i), cnt));
+        ASSERT_EQ(count / key_num, cnt);
+    }
+    Ticket ticket;
+    std::unique_ptr<TableIterator> it(new_table->NewIterator(0, "key1", ticket));
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(count - key_num + 2, it->GetKey());
+
+    // every mapped row holds the file, it is unmapped once the rows are freed
+    std::string snapshot_file = snapshot_path + manifest.name();
+    {
+        std::shared_ptr<FlatSnapshotFile> file = FlatSnapshotFile::Open(snapshot_file);
+        ASSERT_TRUE(file);
+        std::weak_ptr<FlatSnapshotFile> weak_file = file;
+        std::shared_ptr<MemTable> mapped_table =
+            std::make_shared<MemTable>("test", 105, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        mapped_table->Init();
+        std::vector<std::pair<uint32_t, Slice>> dimensions;
+        for (FlatSnapshotFile::Iterator fit(file.get()); fit.Valid(); fit.Next()) {
+            const FlatRecord& record = fit.GetValue();
+            record.GetDimensions(&dimensions);
+            ASSERT_TRUE(mapped_table->Put(record.GetTs(), record.GetValue(), dimensions, file.get()));
+        }
+        ASSERT_EQ(count, file->GetRowCnt());
+        file.reset();
+        ASSERT_FALSE(weak_file.expired());
+        mapped_table.reset();
+        ASSERT_TRUE(weak_file.expired());
+    }
+    // a flipped byte of a record is found by its crc
+    {
+        std::string corrupted_file = snapshot_path + "corrupted.flat";
+        std::ifstream in(snapshot_file, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        ASSERT_GT(data.size(), FLAT_SNAPSHOT_PAGE_SIZE);
+        data[FLAT_SNAPSHOT_PAGE_SIZE + sizeof(FlatRecordHeader) + 4] ^= 0x1;
+        std::ofstream out(corrupted_file, std::ios::binary);
+        out.write(data.data(), data.size());
+        out.close();
+        std::shared_ptr<FlatSnapshotFile> file = FlatSnapshotFile::Open(corrupted_file);
+        ASSERT_TRUE(file);
+        FlatSnapshotFile::Iterator fit(file.get());
+        ASSERT_FALSE(fit.Valid());
+        ASSERT_TRUE(fit.GetStatus().IsCorruption());
+    }
+
+    // back to the log format
+    FLAGS_snapshot_format = "log";
+    write_entries(count, count + 1);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    read_manifest(&manifest);
+    ASSERT_EQ(::openmldb::api::kLogSnapshot, manifest.format());
+    ASSERT_EQ(count + 1, manifest.count());
+    FLAGS_snapshot_format = format;
+    RemoveData(FLAGS_db_root_path);
+}
+
+TEST_F(SnapshotTest, MakeDeltaSnapshot) {
+    std::string binlog_dir = FLAGS_db_root_path + "/104_0/binlog/";
+    std::string snapshot_path = FLAGS_db_root_path + "/104_0/snapshot/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    uint32_t key_num = 100;
+    uint32_t count = 2000;
+    auto write_entries = [&](uint32_t start, uint32_t end) {
+        for (uint32_t i = start; i < end; i++) {
+            offset++;
+            auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(i % key_num), "value", i + 1, 1);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            ::openmldb::base::Slice slice(buffer);
+            ASSERT_TRUE(wh->Write(slice).ok());
+        }
+        wh->Sync();
+    };
+    auto read_manifest = [&](::openmldb::api::Manifest* manifest) {
+        manifest->Clear();
+        int fd = open((snapshot_path + "MANIFEST").c_str(), O_RDONLY);
+        google::protobuf::io::FileInputStream fileInput(fd);
+        fileInput.SetCloseOnDelete(true);
+        google::protobuf::TextFormat::Parse(&fileInput, manifest);
+    };
+    auto check_recover = [&](uint64_t expect_offset, uint64_t key0_cnt, uint64_t key1_cnt) {
+        std::map<std::string, uint32_t> mapping;
+        mapping.insert(std::make_pair("idx0", 0));
+        std::shared_ptr<MemTable> new_table =
+            std::make_shared<MemTable>("test", 104, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        new_table->Init();
+        MemTableSnapshot new_snapshot(104, 0, log_part, FLAGS_db_root_path);
+        new_snapshot.Init();
+        uint64_t snapshot_offset = 0;
+        ASSERT_TRUE(new_snapshot.Recover(new_table, snapshot_offset));
+        ASSERT_EQ(expect_offset, snapshot_offset);
+        uint64_t cnt = 0;
+        new_table->GetCount(0, "key0", cnt);
+        ASSERT_EQ(key0_cnt, cnt);
+        ASSERT_EQ(0, new_table->GetCount(0, "key1", cnt));
+        ASSERT_EQ(key1_cnt, cnt);
+    };
+    write_entries(0, count / 2);
+    MemTableSnapshot snapshot(104, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 104, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint32_t max_delta_num = FLAGS_snapshot_max_delta_num;
+    FLAGS_snapshot_max_delta_num = 2;
+    uint64_t offset_value = 0;
+    // the first snapshot is full
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ::openmldb::api::Manifest manifest;
+    read_manifest(&manifest);
+    ASSERT_EQ(count / 2, manifest.count());
+    ASSERT_EQ(0, manifest.deltas_size());
+
+    // the delete is kept in the delta
+    write_entries(count / 2, count);
+    {
+        offset++;
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(offset);
+        entry.set_method_type(::openmldb::api::MethodType::kDelete);
+        ::openmldb::api::Dimension* dimension = entry.add_dimensions();
+        dimension->set_key("key0");
+        dimension->set_idx(0);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        wh->Sync();
+    }
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(offset, offset_value);
+    read_manifest(&manifest);
+    ASSERT_EQ(count / 2, manifest.count());
+    ASSERT_EQ(1, manifest.deltas_size());
+    ASSERT_EQ(count / 2 + 1, manifest.deltas(0).count());
+    ASSERT_EQ(offset, manifest.offset());
+    std::string delta_name = manifest.deltas(0).name();
+    check_recover(offset, 0, count / key_num);
+
+    // no new binlog, no delta
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    read_manifest(&manifest);
+    ASSERT_EQ(1, manifest.deltas_size());
+    write_entries(count, count + 1);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    read_manifest(&manifest);
+    ASSERT_EQ(2, manifest.deltas_size());
+
+    // the deltas are merged into a full snapshot
+    write_entries(count + 1, count + 2);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    read_manifest(&manifest);
+    ASSERT_EQ(0, manifest.deltas_size());
+    ASSERT_EQ(count - count / key_num + 2, manifest.count());
+    ASSERT_EQ(offset, manifest.offset());
+    ASSERT_NE(0, access((snapshot_path + delta_name).c_str(), F_OK));
+    check_recover(offset, 1, count / key_num + 1);
+    FLAGS_snapshot_max_delta_num = max_delta_num;
+    RemoveData(FLAGS_db_root_path);
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -178,6 +178,11 @@ class Table {
 
     virtual int GetCount(uint32_t index, const std::string& pk, uint64_t& count) = 0; // NOLINT
 
+    // the write version of the rows of pk in index, see Segment::GetWriteVersion.
+    // return false if the table does not keep it, or the rows expire by an
+    // absolute ttl without being written
+    virtual bool GetWriteVersion(uint32_t index, const std::string& pk, uint64_t* version) { return false; }
+
  protected:
     void UpdateTTL();
     bool InitFromMeta();
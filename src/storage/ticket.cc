@@ -26,6 +26,9 @@ Ticket::~Ticket() {
     for (; it != entries_.end(); ++it) {
         (*it)->UnRef();
     }
+    for (TimeRing* ring : rings_) {
+        ring->UnRef();
+    }
 }
 
 void Ticket::Push(KeyEntry* entry) {
@@ -36,11 +39,23 @@ void Ticket::Push(KeyEntry* entry) {
     entries_.push_back(entry);
 }
 
+void Ticket::Push(TimeRing* ring) {
+    if (ring == NULL) {
+        return;
+    }
+    ring->Ref();
+    rings_.push_back(ring);
+}
+
 void Ticket::Pop() {
     if (!entries_.empty()) {
         KeyEntry* entry = entries_.back();
         entries_.pop_back();
         entry->UnRef();
+    } else if (!rings_.empty()) {
+        TimeRing* ring = rings_.back();
+        rings_.pop_back();
+        ring->UnRef();
     }
 }
 
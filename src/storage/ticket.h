@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "storage/segment.h"
+#include "storage/time_ring.h"
 
 namespace openmldb {
 namespace storage {
@@ -34,10 +35,12 @@ class Ticket {
     Ticket& operator=(const Ticket& s) = delete;
 
     void Push(KeyEntry* entry);
+    void Push(TimeRing* ring);
     void Pop();
 
  private:
     std::vector<KeyEntry*> entries_;
+    std::vector<TimeRing*> rings_;
 };
 
 }  // namespace storage
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/time_ring.h"
+
+#include <mutex>  // NOLINT
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t UNBOUNDED_INIT_CAPACITY = 4;
+
+TimeRing::TimeRing(uint32_t capacity)
+    : mu_(),
+      unbounded_(capacity == 0),
+      capacity_(capacity == 0 ? UNBOUNDED_INIT_CAPACITY : capacity),
+      head_(0),
+      size_(0),
+      buf_(NULL),
+      refs_(0),
+      holds_(0) {
+    buf_ = new TimeRow[capacity_];
+}
+
+TimeRing::~TimeRing() { delete[] buf_; }
+
+DataBlock* TimeRing::Put(uint64_t time, DataBlock* row, uint32_t* grown) {
+    std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+    DataBlock* evicted = NULL;
+    if (size_ == capacity_ && unbounded_) {
+        if (grown != NULL) {
+            *grown = capacity_;
+        }
+        ReallocUnLock(capacity_ * 2);
+    } else if (size_ == capacity_) {
+        TimeRow& oldest = At(size_ - 1);
+        if (time < oldest.time) {
+            return row;
+        }
+        evicted = oldest.row;
+        size_--;
+    }
+    // the same as skiplist, the new row is placed before the rows with the same time
+    uint32_t pos = 0;
+    while (pos < size_ && At(pos).time > time) {
+        pos++;
+    }
+    if (pos == 0) {
+        head_ = (head_ + capacity_ - 1) % capacity_;
+    } else {
+        for (uint32_t idx = size_; idx > pos; idx--) {
+            At(idx) = At(idx - 1);
+        }
+    }
+    At(pos) = TimeRow{time, row};
+    size_++;
+    return evicted;
+}
+
+void TimeRing::Snapshot(std::vector<TimeRow>* rows) {
+    std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+    rows->reserve(size_);
+    for (uint32_t idx = 0; idx < size_; idx++) {
+        rows->push_back(At(idx));
+    }
+}
+
+void TimeRing::Resize(uint32_t capacity, std::vector<DataBlock*>* evicted) {
+    std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+    unbounded_ = capacity == 0;
+    if (unbounded_ || capacity == capacity_) {
+        return;
+    }
+    TruncateUnLock(capacity, evicted);
+    ReallocUnLock(capacity);
+}
+
+uint32_t TimeRing::Truncate(const TTLSt& ttl, std::vector<DataBlock*>* evicted) {
+    std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+    uint32_t old_size = size_;
+    // rows are ordered by time desc, so the expired rows are always at the end
+    uint32_t pos = 0;
+    while (pos < size_ && !ttl.IsExpired(At(pos).time, pos + 1)) {
+        pos++;
+    }
+    TruncateUnLock(pos, evicted);
+    return old_size - size_;
+}
+
+void TimeRing::Clear(std::vector<DataBlock*>* rows) {
+    std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+    TruncateUnLock(0, rows);
+}
+
+uint32_t TimeRing::GetSize() {
+    std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+    return size_;
+}
+
+uint32_t TimeRing::GetCapacity() {
+    std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+    return capacity_;
+}
+
+void TimeRing::ReallocUnLock(uint32_t capacity) {
+    TimeRow* buf = new TimeRow[capacity];
+    for (uint32_t idx = 0; idx < size_; idx++) {
+        buf[idx] = At(idx);
+    }
+    delete[] buf_;
+    buf_ = buf;
+    capacity_ = capacity;
+    head_ = 0;
+}
+
+void TimeRing::TruncateUnLock(uint32_t size, std::vector<DataBlock*>* evicted) {
+    while (size_ > size) {
+        evicted->push_back(At(size_ - 1).row);
+        size_--;
+    }
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_TIME_RING_H_
+#define SRC_STORAGE_TIME_RING_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include "base/spinlock.h"
+#include "storage/schema.h"
+
+namespace openmldb {
+namespace storage {
+
+struct DataBlock;
+
+struct TimeRow {
+    uint64_t time;
+    DataBlock* row;
+};
+
+// TimeRing keeps the latest rows of one key for the latest ttl index with a
+// small keep count. Rows are ordered by time desc in a fixed capacity ring, a
+// put into a full ring evicts the oldest row in place, so the index need not
+// be walked by gc. Readers copy the rows out with Snapshot, the evicted rows
+// must be freed after the readers are done, so readers pin the ring with Ref
+// and every deferred evicted row holds it until the row is freed.
+// A ring with capacity 0 is unbounded, it grows instead of evicting
+class TimeRing {
+ public:
+    explicit TimeRing(uint32_t capacity);
+    ~TimeRing();
+    TimeRing(const TimeRing&) = delete;
+    TimeRing& operator=(const TimeRing&) = delete;
+
+    // return the evicted row, it is the input row if the ring is full and
+    // the row is older than all rows in the ring. grown is set to the count
+    // of slots added if an unbounded ring grows
+    DataBlock* Put(uint64_t time, DataBlock* row, uint32_t* grown = NULL);
+
+    // copy the rows ordered by time desc
+    void Snapshot(std::vector<TimeRow>* rows);
+
+    // change the capacity, the oldest rows which do not fit are evicted.
+    // capacity 0 makes the ring unbounded and keeps all the rows
+    void Resize(uint32_t capacity, std::vector<DataBlock*>* evicted);
+
+    // evict the rows expired by ttl, return the count of evicted rows
+    uint32_t Truncate(const TTLSt& ttl, std::vector<DataBlock*>* evicted);
+
+    // remove all the rows, need external synchronized with readers
+    void Clear(std::vector<DataBlock*>* rows);
+
+    uint32_t GetSize();
+
+    uint32_t GetCapacity();
+
+    inline void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+    inline void UnRef() { refs_.fetch_sub(1, std::memory_order_release); }
+
+    inline void Hold() { holds_.fetch_add(1, std::memory_order_relaxed); }
+
+    inline void UnHold() { holds_.fetch_sub(1, std::memory_order_relaxed); }
+
+    // a reader may still read the rows evicted from the ring
+    inline bool IsReading() { return refs_.load(std::memory_order_acquire) > 0; }
+
+    // the ring can be freed only when no reader and no deferred row hold it
+    inline bool IsPinned() { return IsReading() || holds_.load(std::memory_order_relaxed) > 0; }
+
+ private:
+    inline TimeRow& At(uint32_t idx) { return buf_[(head_ + idx) % capacity_]; }
+
+    void TruncateUnLock(uint32_t size, std::vector<DataBlock*>* evicted);
+
+    void ReallocUnLock(uint32_t capacity);
+
+ private:
+    ::openmldb::base::SpinMutex mu_;
+    bool unbounded_;
+    uint32_t capacity_;
+    uint32_t head_;
+    uint32_t size_;
+    TimeRow* buf_;
+    std::atomic<uint32_t> refs_;
+    std::atomic<uint32_t> holds_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_TIME_RING_H_
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/time_ring.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace storage {
+
+class TimeRingTest : public ::testing::Test {
+ public:
+    TimeRingTest() {}
+    ~TimeRingTest() {}
+};
+
+// the ring only stores the pointers, so fake rows are enough
+static DataBlock* FakeRow(uint64_t id) { return reinterpret_cast<DataBlock*>(id); }
+
+TEST_F(TimeRingTest, Put) {
+    TimeRing ring(3);
+    ASSERT_EQ(3u, ring.GetCapacity());
+    ASSERT_TRUE(ring.Put(10, FakeRow(1)) == NULL);
+    ASSERT_TRUE(ring.Put(30, FakeRow(2)) == NULL);
+    ASSERT_TRUE(ring.Put(20, FakeRow(3)) == NULL);
+    ASSERT_EQ(3u, ring.GetSize());
+    std::vector<TimeRow> rows;
+    ring.Snapshot(&rows);
+    ASSERT_EQ(3u, rows.size());
+    ASSERT_EQ(30u, rows[0].time);
+    ASSERT_EQ(20u, rows[1].time);
+    ASSERT_EQ(10u, rows[2].time);
+    // the oldest row is evicted
+    ASSERT_EQ(FakeRow(1), ring.Put(40, FakeRow(4)));
+    // the row older than all rows in a full ring is not put
+    ASSERT_EQ(FakeRow(5), ring.Put(5, FakeRow(5)));
+    ASSERT_EQ(FakeRow(3), ring.Put(25, FakeRow(6)));
+    rows.clear();
+    ring.Snapshot(&rows);
+    ASSERT_EQ(3u, rows.size());
+    ASSERT_EQ(40u, rows[0].time);
+    ASSERT_EQ(30u, rows[1].time);
+    ASSERT_EQ(25u, rows[2].time);
+    ASSERT_EQ(FakeRow(6), rows[2].row);
+}
+
+TEST_F(TimeRingTest, PutSameTime) {
+    TimeRing ring(2);
+    ASSERT_TRUE(ring.Put(10, FakeRow(1)) == NULL);
+    ASSERT_TRUE(ring.Put(10, FakeRow(2)) == NULL);
+    std::vector<TimeRow> rows;
+    ring.Snapshot(&rows);
+    // the later row comes first as the skiplist does
+    ASSERT_EQ(FakeRow(2), rows[0].row);
+    ASSERT_EQ(FakeRow(1), rows[1].row);
+    ASSERT_EQ(FakeRow(1), ring.Put(10, FakeRow(3)));
+}
+
+TEST_F(TimeRingTest, Resize) {
+    TimeRing ring(4);
+    for (uint64_t i = 1; i <= 4; i++) {
+        ASSERT_TRUE(ring.Put(i, FakeRow(i)) == NULL);
+    }
+    std::vector<DataBlock*> evicted;
+    ring.Resize(2, &evicted);
+    ASSERT_EQ(2u, ring.GetCapacity());
+    ASSERT_EQ(2u, ring.GetSize());
+    ASSERT_EQ(2u, evicted.size());
+    ASSERT_EQ(FakeRow(1), evicted[0]);
+    ASSERT_EQ(FakeRow(2), evicted[1]);
+    evicted.clear();
+    ring.Resize(5, &evicted);
+    ASSERT_TRUE(evicted.empty());
+    ASSERT_TRUE(ring.Put(6, FakeRow(6)) == NULL);
+    ASSERT_TRUE(ring.Put(5, FakeRow(5)) == NULL);
+    std::vector<TimeRow> rows;
+    ring.Snapshot(&rows);
+    ASSERT_EQ(4u, rows.size());
+    for (uint32_t i = 0; i < rows.size(); i++) {
+        ASSERT_EQ(6 - i, rows[i].time);
+    }
+}
+
+TEST_F(TimeRingTest, Truncate) {
+    TimeRing ring(5);
+    for (uint64_t i = 1; i <= 5; i++) {
+        ASSERT_TRUE(ring.Put(i * 10, FakeRow(i)) == NULL);
+    }
+    std::vector<DataBlock*> evicted;
+    TTLSt abs_ttl(25, 0, ::openmldb::storage::TTLType::kAbsoluteTime);
+    ASSERT_EQ(2u, ring.Truncate(abs_ttl, &evicted));
+    ASSERT_EQ(3u, ring.GetSize());
+    TTLSt lat_ttl(0, 2, ::openmldb::storage::TTLType::kLatestTime);
+    ASSERT_EQ(1u, ring.Truncate(lat_ttl, &evicted));
+    ASSERT_EQ(3u, evicted.size());
+    ASSERT_EQ(2u, ring.GetSize());
+    evicted.clear();
+    ring.Clear(&evicted);
+    ASSERT_EQ(2u, evicted.size());
+    ASSERT_EQ(0u, ring.GetSize());
+}
+
+TEST_F(TimeRingTest, Unbounded) {
+    TimeRing ring(0);
+    ASSERT_EQ(4u, ring.GetCapacity());
+    uint32_t grown = 0;
+    for (uint64_t i = 1; i <= 4; i++) {
+        ASSERT_TRUE(ring.Put(i, FakeRow(i), &grown) == NULL);
+    }
+    ASSERT_EQ(0u, grown);
+    // the full ring grows instead of evicting
+    ASSERT_TRUE(ring.Put(5, FakeRow(5), &grown) == NULL);
+    ASSERT_EQ(4u, grown);
+    ASSERT_EQ(8u, ring.GetCapacity());
+    ASSERT_EQ(5u, ring.GetSize());
+    // a bounded ring becomes unbounded with capacity 0 and keeps its rows
+    TimeRing bounded(2);
+    ASSERT_TRUE(bounded.Put(1, FakeRow(1)) == NULL);
+    ASSERT_TRUE(bounded.Put(2, FakeRow(2)) == NULL);
+    std::vector<DataBlock*> evicted;
+    bounded.Resize(0, &evicted);
+    ASSERT_TRUE(evicted.empty());
+    ASSERT_TRUE(bounded.Put(3, FakeRow(3)) == NULL);
+    std::vector<TimeRow> rows;
+    bounded.Snapshot(&rows);
+    ASSERT_EQ(3u, rows.size());
+    for (uint32_t i = 0; i < rows.size(); i++) {
+        ASSERT_EQ(3 - i, rows[i].time);
+    }
+    bounded.Resize(1, &evicted);
+    ASSERT_EQ(2u, evicted.size());
+    ASSERT_EQ(FakeRow(3), bounded.Put(4, FakeRow(4)));
+}
+
+TEST_F(TimeRingTest, Pin) {
+    TimeRing ring(2);
+    ASSERT_FALSE(ring.IsPinned());
+    ring.Ref();
+    ASSERT_TRUE(ring.IsReading());
+    ring.UnRef();
+    ring.Hold();
+    ASSERT_FALSE(ring.IsReading());
+    ASSERT_TRUE(ring.IsPinned());
+    ring.UnHold();
+    ASSERT_FALSE(ring.IsPinned());
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -16,6 +16,8 @@
 
 #include "storage/window_iterator.h"
 
+#include <string.h>
+
 #include <string>
 #include "base/hash.h"
 
@@ -41,11 +43,20 @@ void MemTableWindowIterator::Next() {
 }
 
 const uint64_t& MemTableWindowIterator::GetKey() const {
-    return it_->GetKey();
+    key_ = it_->GetKey();
+    return key_;
 }
 
 const ::hybridse::codec::Row& MemTableWindowIterator::GetValue() {
-    row_.Reset(reinterpret_cast<const int8_t*>(it_->GetValue()->data), it_->GetValue()->size);
+    ::openmldb::base::Slice value = it_->GetValue();
+    if (it_->IsCold()) {
+        // the window may keep the row after the iterator drops its cold block
+        int8_t* copyed_row_data = new int8_t[value.size()];
+        memcpy(copyed_row_data, value.data(), value.size());
+        row_.Reset(::hybridse::base::RefCountedSlice::CreateManaged(copyed_row_data, value.size()));
+    } else {
+        row_.Reset(reinterpret_cast<const int8_t*>(value.data()), value.size());
+    }
     return row_;
 }
 
@@ -128,16 +139,7 @@ void MemTableKeyIterator::Next() {
 }
 
 ::hybridse::vm::RowIterator* MemTableKeyIterator::GetRawValue() {
-    TimeEntries::Iterator* it = nullptr;
-    if (segments_[seg_idx_]->GetTsCnt() > 1) {
-        KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-        it = entry->entries.NewIterator();
-        ticket_.Push(entry);
-    } else {
-        it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                 ->entries.NewIterator();
-        ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
-    }
+    MemTableIterator* it = segments_[seg_idx_]->NewEntryIterator(pk_it_->GetValue(), ts_idx_, ticket_);
     it->SeekToFirst();
     return new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_);
 }
@@ -26,9 +26,9 @@ namespace storage {
 
 class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
  public:
-    MemTableWindowIterator(TimeEntries::Iterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
+    MemTableWindowIterator(MemTableIterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
                            uint64_t expire_cnt)
-        : it_(it), record_idx_(1), expire_value_(expire_time, expire_cnt, ttl_type), row_() {}
+        : it_(it), record_idx_(1), expire_value_(expire_time, expire_cnt, ttl_type), row_(), key_(0) {}
 
     ~MemTableWindowIterator();
 
@@ -47,10 +47,11 @@ class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
     bool IsSeekable() const override { return true; }
 
  private:
-    TimeEntries::Iterator* it_;
+    MemTableIterator* it_;
     uint32_t record_idx_;
     TTLSt expire_value_;
     ::hybridse::codec::Row row_;
+    mutable uint64_t key_;
 };
 
 class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
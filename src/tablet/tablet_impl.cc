@@ -48,12 +48,14 @@
 #include "base/status.h"
 #include "base/strings.h"
 #include "brpc/controller.h"
+#include "bthread/countdown_event.h"
 #include "butil/iobuf.h"
 #include "codec/codec.h"
 #include "codec/row_codec.h"
 #include "codec/sql_rpc_row_codec.h"
 #include "common/timer.h"
 #include "glog/logging.h"
+#include "log/crc32c.h"
 #include "schema/schema_adapter.h"
 #include "storage/binlog.h"
 #include "storage/segment.h"
@@ -97,6 +99,7 @@ DECLARE_uint32(load_index_max_wait_time);
 DECLARE_bool(use_name);
 DECLARE_bool(enable_distsql);
 DECLARE_string(snapshot_compression);
+DECLARE_string(snapshot_format);
 DECLARE_string(file_compression);
 
 // cluster config
@@ -108,6 +111,7 @@ DECLARE_int32(zk_keep_alive_check_interval);
 
 DECLARE_int32(binlog_sync_to_disk_interval);
 DECLARE_int32(binlog_delete_interval);
+DECLARE_int32(binlog_sync_wait_time);
 DECLARE_uint32(absolute_ttl_max);
 DECLARE_uint32(latest_ttl_max);
 DECLARE_uint32(max_traverse_cnt);
@@ -116,6 +120,9 @@ DECLARE_uint32(snapshot_ttl_check_interval);
 DECLARE_uint32(put_slow_log_threshold);
 DECLARE_uint32(query_slow_log_threshold);
 DECLARE_int32(snapshot_pool_size);
+DECLARE_int32(follower_apply_pool_size);
+DECLARE_uint64(follower_read_max_lag);
+DECLARE_int32(follower_read_check_interval);
 
 namespace openmldb {
 namespace tablet {
@@ -136,6 +143,7 @@ TabletImpl::TabletImpl()
       task_pool_(FLAGS_task_pool_size),
       io_pool_(FLAGS_io_pool_size),
       snapshot_pool_(FLAGS_snapshot_pool_size),
+      apply_pool_(std::max(FLAGS_follower_apply_pool_size, 1)),
       mode_root_paths_(),
       mode_recycle_root_paths_(),
       follower_(false),
@@ -155,6 +163,7 @@ TabletImpl::~TabletImpl() {
     gc_pool_.Stop(true);
     io_pool_.Stop(true);
     snapshot_pool_.Stop(true);
+    apply_pool_.Stop(true);
     if (zk_client_) {
         delete zk_client_;
     }
@@ -215,6 +224,10 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
         LOG(ERROR) << "wrong snapshot_compression: " << FLAGS_snapshot_compression;
         return false;
     }
+    if (FLAGS_snapshot_format != "log" && FLAGS_snapshot_format != "flat") {
+        LOG(ERROR) << "wrong snapshot_format: " << FLAGS_snapshot_format;
+        return false;
+    }
     std::set<std::string> file_compression_set{"off", "zlib", "lz4"};
     if (file_compression_set.find(FLAGS_file_compression) == file_compression_set.end()) {
         LOG(ERROR) << "wrong FLAGS_file_compression: " << FLAGS_file_compression;
@@ -302,6 +315,10 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     if (FLAGS_recycle_ttl != 0) {
         task_pool_.DelayTask(FLAGS_recycle_ttl * 60 * 1000, boost::bind(&TabletImpl::SchedDelRecycle, this));
     }
+    if (FLAGS_follower_read_max_lag != 0) {
+        task_pool_.DelayTask(FLAGS_follower_read_check_interval,
+                             boost::bind(&TabletImpl::SchedRefreshReadTables, this));
+    }
 #ifdef TCMALLOC_ENABLE
     MallocExtension* tcmalloc = MallocExtension::instance();
     tcmalloc->SetMemoryReleaseRate(FLAGS_mem_release_rate);
@@ -702,6 +719,23 @@ void TabletImpl::Get(RpcController* controller, const ::openmldb::api::GetReques
     }
 }
 
+bool TabletImpl::IsDurablePut(bool durable, const std::shared_ptr<Table>& table) {
+    return durable || table->GetTableMeta()->binlog_durable();
+}
+
+template <class Response>
+void TabletImpl::WaitDurable(const std::shared_ptr<LogReplicator>& replicator, uint64_t offset, Response* response,
+                             Closure* done) {
+    // the response is sent once the binlog of the rows is synced
+    replicator->WaitDurable(offset, [response, done](bool ok) {
+        if (!ok) {
+            response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+            response->set_msg("fail to sync binlog");
+        }
+        done->Run();
+    });
+}
+
 void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutRequest* request,
                      ::openmldb::api::PutResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -751,10 +785,18 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
     response->set_code(::openmldb::base::ReturnCode::kOk);
     std::shared_ptr<LogReplicator> replicator;
     ::openmldb::api::LogEntry entry;
+    bool durable = IsDurablePut(request->durable(), table);
+    uint64_t durable_offset = 0;
     do {
         replicator = GetReplicator(request->tid(), request->pid());
         if (!replicator) {
             PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", request->tid(), request->pid());
+            if (durable) {
+                // the row can not be durable without binlog
+                response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+                response->set_msg("fail to find log replicator");
+                return;
+            }
             break;
         }
         entry.set_pk(request->pk());
@@ -776,12 +818,20 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
                                request->dimensions(), entry.log_index());
         };
         UpdateAggrClosure closure(update_aggr);
-        replicator->AppendEntry(entry, &closure);
+        bool appended = replicator->AppendEntry(entry, &closure);
         if (!ok) {
             response->set_code(::openmldb::base::ReturnCode::kError);
             response->set_msg("update aggr failed");
             return;
         }
+        if (durable) {
+            if (!appended) {
+                response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+                response->set_msg("fail to write binlog");
+                return;
+            }
+            durable_offset = entry.log_index();
+        }
     } while (false);
 
     uint64_t end_time = ::baidu::common::timer::get_micros();
@@ -813,6 +863,130 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         table->GetName() == openmldb::nameserver::GLOBAL_VARIABLES) {
         UpdateGlobalVarTable();
     }
+    if (durable_offset > 0) {
+        WaitDurable(replicator, durable_offset, response, done_guard.release());
+    }
+}
+
+void TabletImpl::PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                          ::openmldb::api::PutBatchResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    if (follower_.load(std::memory_order_relaxed)) {
+        response->set_code(::openmldb::base::ReturnCode::kIsFollowerCluster);
+        response->set_msg("is follower cluster");
+        return;
+    }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    uint32_t tid = request->tid();
+    uint32_t pid = request->pid();
+    std::shared_ptr<Table> table = GetTable(tid, pid);
+    if (!table) {
+        PDLOG(WARNING, "table is not exist. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table is not exist");
+        return;
+    }
+    if (!table->IsLeader()) {
+        response->set_code(::openmldb::base::ReturnCode::kTableIsFollower);
+        response->set_msg("table is follower");
+        return;
+    }
+    if (table->GetTableStat() == ::openmldb::storage::kLoading) {
+        PDLOG(WARNING, "table is loading. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
+        response->set_msg("table is loading");
+        return;
+    }
+    auto& request_buf = static_cast<brpc::Controller*>(controller)->request_attachment();
+    uint64_t total_size = 0;
+    for (const auto& row : request->rows()) {
+        if (row.dimensions_size() == 0 || CheckDimessionPut(row.dimensions(), table->GetIdxCnt()) != 0) {
+            response->set_code(::openmldb::base::ReturnCode::kInvalidDimensionParameter);
+            response->set_msg("invalid dimension parameter");
+            return;
+        }
+        total_size += row.value_size();
+    }
+    if (total_size != request_buf.size()) {
+        PDLOG(WARNING, "the size of rows %lu mismatch the attachment %lu. tid %u, pid %u", total_size,
+              request_buf.size(), tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+        response->set_msg("invalid attachment size");
+        return;
+    }
+    std::shared_ptr<LogReplicator> replicator = GetReplicator(tid, pid);
+    uint64_t term = replicator ? replicator->GetLeaderTerm() : 0;
+    uint64_t durable_offset = 0;
+    // the rows put are appended to binlog in one batch even if a later row fails
+    std::vector<::openmldb::api::LogEntry> entries;
+    entries.reserve(request->rows_size());
+    for (const auto& row : request->rows()) {
+        ::openmldb::api::LogEntry entry;
+        request_buf.cutn(entry.mutable_value(), row.value_size());
+        if (!table->Put(row.time(), entry.value(), row.dimensions())) {
+            response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+            response->set_msg("put failed");
+            break;
+        }
+        entry.set_ts(row.time());
+        entry.set_term(term);
+        entry.mutable_dimensions()->CopyFrom(row.dimensions());
+        entries.push_back(std::move(entry));
+    }
+    response->set_put_cnt(entries.size());
+    if (!response->has_code()) {
+        response->set_code(::openmldb::base::ReturnCode::kOk);
+    }
+    if (!replicator) {
+        PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", tid, pid);
+        if (IsDurablePut(request->durable(), table)) {
+            // the rows can not be durable without binlog
+            response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+            response->set_msg("fail to find log replicator");
+            return;
+        }
+    } else if (!entries.empty()) {
+        // the entries get consecutive offsets, so the aggregators are updated in order
+        bool ok = true;
+        auto update_aggr = [this, tid, pid, &ok, &entries]() {
+            for (const auto& entry : entries) {
+                if (!UpdateAggrs(tid, pid, entry.value(), entry.dimensions(), entry.log_index())) {
+                    ok = false;
+                }
+            }
+        };
+        UpdateAggrClosure closure(update_aggr);
+        bool appended = replicator->AppendEntries(&entries, &closure);
+        if (!ok) {
+            response->set_code(::openmldb::base::ReturnCode::kError);
+            response->set_msg("update aggr failed");
+            return;
+        }
+        if (IsDurablePut(request->durable(), table)) {
+            if (!appended) {
+                response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+                response->set_msg("fail to write binlog");
+                return;
+            }
+            durable_offset = entries.back().log_index();
+        }
+        if (FLAGS_binlog_notify_on_put) {
+            replicator->Notify();
+        }
+    }
+    uint64_t end_time = ::baidu::common::timer::get_micros();
+    if (start_time + FLAGS_put_slow_log_threshold < end_time) {
+        PDLOG(INFO, "slow log[put batch]. rows %d time %lu. tid %u, pid %u", request->rows_size(),
+              end_time - start_time, tid, pid);
+    }
+    // update global var in standalone mode
+    if (!IsClusterMode() && table->GetDB() == openmldb::nameserver::INFORMATION_SCHEMA_DB &&
+        table->GetName() == openmldb::nameserver::GLOBAL_VARIABLES) {
+        UpdateGlobalVarTable();
+    }
+    if (durable_offset > 0) {
+        WaitDurable(replicator, durable_offset, response, done_guard.release());
+    }
 }
 
 int TabletImpl::CheckTableMeta(const openmldb::api::TableMeta* table_meta, std::string& msg) {
@@ -2023,6 +2197,7 @@ void TabletImpl::ChangeRole(RpcController* controller, const ::openmldb::api::Ch
         PDLOG(INFO, "change to follower. tid[%u] pid[%u]", tid, pid);
         if (!table->GetDB().empty()) {
             catalog_->DeleteTable(table->GetDB(), table->GetName(), pid);
+            AddFollowerToCatalog(table, replicator);
         }
     }
     response->set_code(::openmldb::base::ReturnCode::kOk);
@@ -2156,6 +2331,175 @@ void TabletImpl::DelReplica(RpcController* controller, const ::openmldb::api::Re
     SetTaskStatus(task_ptr, ::openmldb::api::TaskStatus::kFailed);
 }
 
+// cut the binlog records of request from attachment and parse them, the
+// records refer to buffer
+static bool UnpackRecords(const ::openmldb::api::AppendEntriesRequest& request, const butil::IOBuf& attachment,
+                          std::string* buffer, std::vector<::openmldb::api::LogEntry>* entries,
+                          std::vector<::openmldb::base::Slice>* records) {
+    attachment.copy_to(buffer);
+    if (::openmldb::log::Value(buffer->data(), buffer->size()) != request.record_crc()) {
+        PDLOG(WARNING, "crc mismatch. size %lu", buffer->size());
+        return false;
+    }
+    if (request.record_compress_type() == ::openmldb::type::CompressType::kSnappy) {
+        std::string uncompressed;
+        if (!::snappy::Uncompress(buffer->data(), buffer->size(), &uncompressed)) {
+            PDLOG(WARNING, "fail to uncompress the records");
+            return false;
+        }
+        buffer->swap(uncompressed);
+    }
+    entries->resize(request.record_size_size());
+    records->reserve(request.record_size_size());
+    size_t offset = 0;
+    for (int i = 0; i < request.record_size_size(); i++) {
+        uint32_t size = request.record_size(i);
+        if (offset + size > buffer->size()) {
+            PDLOG(WARNING, "record size %u exceeds the attachment", size);
+            return false;
+        }
+        records->emplace_back(buffer->data() + offset, size);
+        if (!(*entries)[i].ParseFromArray(buffer->data() + offset, size)) {
+            PDLOG(WARNING, "bad protobuf format. size %u", size);
+            return false;
+        }
+        offset += size;
+    }
+    return offset == buffer->size();
+}
+
+static bool IsDeleteEntry(const ::openmldb::api::LogEntry& entry) {
+    return entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete;
+}
+
+static bool PutReplicatedEntry(const std::shared_ptr<Table>& table, const ::openmldb::api::LogEntry& entry) {
+    if (IsDeleteEntry(entry)) {
+        if (entry.dimensions_size() == 0) {
+            PDLOG(WARNING, "no dimesion. tid %u pid %u", table->GetId(), table->GetPid());
+            return false;
+        }
+        // a delete entry has no value to put
+        table->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
+        return true;
+    }
+    return table->Put(entry);
+}
+
+void TabletImpl::AddFollowerToCatalog(const std::shared_ptr<Table>& table,
+                                      const std::shared_ptr<LogReplicator>& replicator) {
+    if (FLAGS_follower_read_max_lag == 0) {
+        return;
+    }
+    std::weak_ptr<LogReplicator> weak_replicator = replicator;
+    Table* raw_table = table.get();
+    auto readable = [weak_replicator, raw_table]() {
+        auto replicator = weak_replicator.lock();
+        return replicator && raw_table->GetTableStat() == ::openmldb::storage::kNormal &&
+               replicator->IsReadable(FLAGS_follower_read_max_lag);
+    };
+    if (catalog_->AddFollowerTable(*(table->GetTableMeta()), table, readable)) {
+        LOG(INFO) << "add follower table " << table->GetName() << " to catalog with db " << table->GetDB();
+    } else {
+        LOG(WARNING) << "fail to add follower table " << table->GetName() << " to catalog with db "
+                     << table->GetDB();
+    }
+}
+
+static size_t FindGroup(std::vector<size_t>* parent, size_t pos) {
+    while ((*parent)[pos] != pos) {
+        (*parent)[pos] = (*parent)[(*parent)[pos]];
+        pos = (*parent)[pos];
+    }
+    return pos;
+}
+
+bool TabletImpl::PutReplicatedEntries(const std::shared_ptr<Table>& table,
+                                      const std::vector<const ::openmldb::api::LogEntry*>& entries) {
+    // the binlog of all the entries has been written and the leader skips them
+    // when it sends the batch again, so a failed entry does not stop the others
+    // like the entries of a synchronous follower
+    if (FLAGS_follower_apply_pool_size <= 1 || entries.size() <= 1) {
+        bool ok = true;
+        for (const auto entry : entries) {
+            if (!PutReplicatedEntry(table, *entry)) {
+                ok = false;
+            }
+        }
+        return ok;
+    }
+    // the entries sharing a key of any index are put in order by one task, so
+    // they are grouped by the keys of all the dimensions. a delete entry waits
+    // for the entries before it
+    uint32_t shard_num = FLAGS_follower_apply_pool_size;
+    std::vector<std::vector<const ::openmldb::api::LogEntry*>> shards(shard_num);
+    std::vector<size_t> parent;
+    std::unordered_map<std::string, size_t> key_group;
+    std::atomic<bool> ok(true);
+    size_t pos = 0;
+    while (pos < entries.size()) {
+        size_t end = pos;
+        while (end < entries.size() && !IsDeleteEntry(*entries[end])) {
+            end++;
+        }
+        parent.resize(end - pos);
+        for (size_t i = 0; i < parent.size(); i++) {
+            parent[i] = i;
+        }
+        key_group.clear();
+        auto join = [&parent, &key_group](const std::string& key, size_t i) {
+            auto it = key_group.emplace(key, i);
+            if (!it.second) {
+                size_t group = FindGroup(&parent, it.first->second);
+                size_t cur = FindGroup(&parent, i);
+                parent[std::max(group, cur)] = std::min(group, cur);
+            }
+        };
+        for (size_t i = pos; i < end; i++) {
+            const auto& entry = *entries[i];
+            if (entry.dimensions_size() == 0) {
+                join(entry.pk(), i - pos);
+            }
+            for (const auto& dim : entry.dimensions()) {
+                join(std::to_string(dim.idx()) + "|" + dim.key(), i - pos);
+            }
+        }
+        uint32_t task_num = 0;
+        for (size_t i = pos; i < end; i++) {
+            auto& shard = shards[FindGroup(&parent, i - pos) % shard_num];
+            if (shard.empty()) {
+                task_num++;
+            }
+            shard.push_back(entries[i]);
+        }
+        bthread::CountdownEvent event(task_num);
+        for (auto& shard : shards) {
+            if (shard.empty()) {
+                continue;
+            }
+            apply_pool_.AddTask([&table, &shard, &ok, &event]() {
+                for (const auto entry : shard) {
+                    if (!PutReplicatedEntry(table, *entry)) {
+                        ok.store(false, std::memory_order_relaxed);
+                    }
+                }
+                event.signal();
+            });
+        }
+        event.wait();
+        for (auto& shard : shards) {
+            shard.clear();
+        }
+        pos = end;
+        if (pos < entries.size()) {
+            if (!PutReplicatedEntry(table, *entries[pos])) {
+                ok.store(false, std::memory_order_relaxed);
+            }
+            pos++;
+        }
+    }
+    return ok.load(std::memory_order_relaxed);
+}
+
 void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                                ::openmldb::api::AppendEntriesResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -2200,7 +2544,13 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
     uint64_t last_log_offset = replicator->GetOffset();
-    if (request->pre_log_index() == 0 && request->entries_size() == 0) {
+    if (request->has_leader_offset() && request->entries_size() == 0 && request->record_size_size() == 0) {
+        // the heartbeat of an idle leader
+        replicator->SetLeaderOffset(request->leader_offset());
+        response->set_log_offset(last_log_offset);
+        return;
+    }
+    if (request->pre_log_index() == 0 && request->entries_size() == 0 && request->record_size_size() == 0) {
         response->set_log_offset(last_log_offset);
         if (!FLAGS_zk_cluster.empty() && request->term() > term) {
             replicator->SetLeaderTerm(request->term());
@@ -2211,35 +2561,63 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
         PDLOG(INFO, "first sync log_index! log_offset[%lu] tid[%u] pid[%u]", last_log_offset, tid, pid);
         return;
     }
-    for (int32_t i = 0; i < request->entries_size(); i++) {
-        const auto& entry = request->entries(i);
-        if (entry.log_index() <= last_log_offset) {
-            PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", request->entries(i).log_index(),
-                    last_log_offset, tid, pid);
-            continue;
-        }
-        if (!replicator->ApplyEntry(entry)) {
-            PDLOG(WARNING, "fail to write binlog. tid %u pid %u", tid, pid);
+    if (request->pre_log_index() > last_log_offset) {
+        // the previous batch is still in flight if the leader pipelines the requests
+        if (!replicator->WaitOffset(request->pre_log_index(), FLAGS_binlog_sync_wait_time)) {
+            PDLOG(WARNING, "pre log index %lu is larger than log offset %lu. tid %u pid %u", request->pre_log_index(),
+                  replicator->GetOffset(), tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
-            response->set_msg("fail to append entries to replicator");
+            response->set_msg("log offset mismatch");
+            response->set_log_offset(replicator->GetOffset());
             return;
         }
-        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
-            if (entry.dimensions_size() == 0) {
-                PDLOG(WARNING, "no dimesion. tid %u pid %u", tid, pid);
-                response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
-                response->set_msg("fail to append entries to replicator");
-                return;
-            }
-            table->Delete(entry.dimensions(0).key(), entry.dimensions(0).idx());
-        }
-        if (!table->Put(entry)) {
-            PDLOG(WARNING, "fail to put entry. tid %u pid %u", tid, pid);
+        last_log_offset = replicator->GetOffset();
+    }
+    // the entries sent as binlog records are written to binlog as they are
+    std::string buffer;
+    std::vector<::openmldb::api::LogEntry> parsed_entries;
+    std::vector<::openmldb::base::Slice> all_records;
+    if (request->record_size_size() > 0) {
+        auto cntl = static_cast<brpc::Controller*>(controller);
+        if (!UnpackRecords(*request, cntl->request_attachment(), &buffer, &parsed_entries, &all_records)) {
+            PDLOG(WARNING, "invalid binlog records. tid %u pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
-            response->set_msg("fail to append entry to table");
+            response->set_msg("invalid binlog records");
             return;
         }
     }
+    std::vector<const ::openmldb::api::LogEntry*> entries;
+    std::vector<::openmldb::base::Slice> records;
+    size_t entry_cnt = parsed_entries.empty() ? request->entries_size() : parsed_entries.size();
+    entries.reserve(entry_cnt);
+    for (size_t i = 0; i < entry_cnt; i++) {
+        const auto& entry = parsed_entries.empty() ? request->entries(i) : parsed_entries[i];
+        if (entry.log_index() <= last_log_offset) {
+            PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", entry.log_index(),
+                    last_log_offset, tid, pid);
+            continue;
+        }
+        entries.push_back(&entry);
+        if (!parsed_entries.empty()) {
+            records.push_back(all_records[i]);
+        }
+    }
+    bool ok = parsed_entries.empty() ? replicator->ApplyEntries(entries) : replicator->ApplyRecords(entries, records);
+    if (!ok) {
+        PDLOG(WARNING, "fail to write binlog. tid %u pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+        response->set_msg("fail to append entries to replicator");
+        return;
+    }
+    if (!PutReplicatedEntries(table, entries)) {
+        PDLOG(WARNING, "fail to put entry. tid %u pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+        response->set_msg("fail to append entry to table");
+        return;
+    }
+    if (request->has_leader_offset()) {
+        replicator->SetLeaderOffset(request->leader_offset());
+    }
     response->set_log_offset(replicator->GetOffset());
 }
 
@@ -2800,6 +3178,7 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
         full_path.append("snapshot/");
         std::string manifest_file = full_path + "MANIFEST";
         std::string snapshot_file;
+        std::vector<std::string> delta_files;
         {
             int fd = open(manifest_file.c_str(), O_RDONLY);
             if (fd < 0) {
@@ -2815,6 +3194,9 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
                 break;
             }
             snapshot_file = manifest.name();
+            for (const auto& delta : manifest.deltas()) {
+                delta_files.push_back(delta.name());
+            }
         }
         if (table->GetStorageMode() == common::kMemory) {
             // send snapshot file
@@ -2822,6 +3204,18 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
                 PDLOG(WARNING, "send snapshot failed. tid[%u] pid[%u]", tid, pid);
                 break;
             }
+            // the deltas are replayed on the snapshot in order
+            bool send_delta_failed = false;
+            for (const auto& delta_file : delta_files) {
+                if (sender.SendFile(delta_file, full_path + delta_file) < 0) {
+                    PDLOG(WARNING, "send snapshot delta %s failed. tid[%u] pid[%u]", delta_file.c_str(), tid, pid);
+                    send_delta_failed = true;
+                    break;
+                }
+            }
+            if (send_delta_failed) {
+                break;
+            }
         } else {
             if (sender.SendDir(snapshot_file, full_path + snapshot_file) < 0) {
                 PDLOG(WARNING, "send snapshot failed. tid[%u] pid[%u]", tid, pid);
@@ -3844,6 +4238,9 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
         msg.assign("fail create replicator for table");
         return -1;
     }
+    if (table_meta->has_binlog_compression()) {
+        replicator->SetCompression(table_meta->binlog_compression());
+    }
     ok = replicator->Init();
     if (!ok) {
         PDLOG(WARNING, "fail to init replicator for table tid %u, pid %u", tid, pid);
@@ -3883,6 +4280,8 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
         if (boost::iequals(table_meta->db(), openmldb::nameserver::PRE_AGG_DB)) {
             RefreshAggrCatalog();
         }
+    } else if (!table_meta->db().empty()) {
+        AddFollowerToCatalog(table, replicator);
     }
     return 0;
 }
@@ -4425,16 +4824,20 @@ bool TabletImpl::RefreshAggrCatalog() {
 }
 
 int TabletImpl::CheckDimessionPut(const ::openmldb::api::PutRequest* request, uint32_t idx_cnt) {
-    for (int32_t i = 0; i < request->dimensions_size(); i++) {
-        if (idx_cnt <= request->dimensions(i).idx()) {
+    return CheckDimessionPut(request->dimensions(), idx_cnt);
+}
+
+int TabletImpl::CheckDimessionPut(const ::openmldb::storage::Dimensions& dimensions, uint32_t idx_cnt) {
+    for (const auto& dimension : dimensions) {
+        if (idx_cnt <= dimension.idx()) {
             PDLOG(WARNING,
                   "invalid put request dimensions, request idx %u is greater "
                   "than table idx cnt %u",
-                  request->dimensions(i).idx(), idx_cnt);
+                  dimension.idx(), idx_cnt);
             return -1;
         }
-        if (request->dimensions(i).key().length() <= 0) {
-            PDLOG(WARNING, "invalid put request dimension key is empty with idx %u", request->dimensions(i).idx());
+        if (dimension.key().length() <= 0) {
+            PDLOG(WARNING, "invalid put request dimension key is empty with idx %u", dimension.idx());
             return 1;
         }
     }
@@ -4449,6 +4852,11 @@ void TabletImpl::SchedSyncDisk(uint32_t tid, uint32_t pid) {
     }
 }
 
+void TabletImpl::SchedRefreshReadTables() {
+    catalog_->RefreshReadTables();
+    task_pool_.DelayTask(FLAGS_follower_read_check_interval, boost::bind(&TabletImpl::SchedRefreshReadTables, this));
+}
+
 void TabletImpl::SchedDelBinlog(uint32_t tid, uint32_t pid) {
     std::shared_ptr<LogReplicator> replicator = GetReplicator(tid, pid);
     if (replicator) {
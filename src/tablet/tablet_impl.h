@@ -86,6 +86,9 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void Put(RpcController* controller, const ::openmldb::api::PutRequest* request,
              ::openmldb::api::PutResponse* response, Closure* done);
 
+    void PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                  ::openmldb::api::PutBatchResponse* response, Closure* done);
+
     void Get(RpcController* controller, const ::openmldb::api::GetRequest* request,
              ::openmldb::api::GetResponse* response, Closure* done);
 
@@ -388,12 +391,34 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     int CheckDimessionPut(const ::openmldb::api::PutRequest* request, uint32_t idx_cnt);
 
+    int CheckDimessionPut(const ::openmldb::storage::Dimensions& dimensions, uint32_t idx_cnt);
+
+    // the request asks for durability or the table is durable
+    static bool IsDurablePut(bool durable, const std::shared_ptr<Table>& table);
+
+    // run done after the binlog up to offset is synced, see LogReplicator::WaitDurable
+    template <class Response>
+    static void WaitDurable(const std::shared_ptr<LogReplicator>& replicator, uint64_t offset, Response* response,
+                     Closure* done);
+
+    // put the entries of an AppendEntries request by apply_pool_, return after all of them are put.
+    // return false if any of them fails, the others are put anyway
+    bool PutReplicatedEntries(const std::shared_ptr<Table>& table,
+                              const std::vector<const ::openmldb::api::LogEntry*>& entries);
+
+    // the follower serves the request mode queries while it is behind the
+    // leader by no more than follower_read_max_lag entries
+    void AddFollowerToCatalog(const std::shared_ptr<Table>& table, const std::shared_ptr<LogReplicator>& replicator);
+
     // sync log data from page cache to disk
     void SchedSyncDisk(uint32_t tid, uint32_t pid);
 
     // sched replicator to delete binlog
     void SchedDelBinlog(uint32_t tid, uint32_t pid);
 
+    // publish the local followers readable now to the catalog, see follower_read_max_lag
+    void SchedRefreshReadTables();
+
     bool CheckGetDone(::openmldb::api::GetType type, uint64_t ts, uint64_t target_ts);
 
     bool ChooseDBRootPath(uint32_t tid, uint32_t pid, const ::openmldb::common::StorageMode& mode,
@@ -464,6 +489,8 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     ThreadPool task_pool_;
     ThreadPool io_pool_;
     ThreadPool snapshot_pool_;
+    // puts the entries replicated to a follower
+    ThreadPool apply_pool_;
     std::map<uint64_t, std::list<std::shared_ptr<::openmldb::api::TaskInfo>>> task_map_;
     std::set<std::string> sync_snapshot_set_;
     std::map<std::string, std::shared_ptr<FileReceiver>> file_receiver_map_;
@@ -20,9 +20,11 @@
 #include <gflags/gflags.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
+#include <snappy.h>
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <future>
 #include <utility>
 
 #include "absl/cleanup/cleanup.h"
@@ -36,6 +38,7 @@
 #include "codec/schema_codec.h"
 #include "common/timer.h"
 #include "gtest/gtest.h"
+#include "log/crc32c.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
 #include "proto/tablet.pb.h"
@@ -51,6 +54,8 @@ DECLARE_int32(gc_interval);
 DECLARE_int32(disk_gc_interval);
 DECLARE_int32(make_snapshot_threshold_offset);
 DECLARE_int32(binlog_delete_interval);
+DECLARE_int32(binlog_sync_wait_time);
+DECLARE_int32(follower_apply_pool_size);
 DECLARE_uint32(max_traverse_cnt);
 DECLARE_bool(recycle_bin_enabled);
 DECLARE_string(recycle_bin_root_path);
@@ -1817,6 +1822,462 @@ TEST_P(TabletImplTest, Scan) {
 }
 
 
+TEST_P(TabletImplTest, PutBatch) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    ASSERT_EQ(0, CreateDefaultTable("", "t0", id, 1, 0, 0, kAbsoluteTime, storage_mode, &tablet));
+    MockClosure closure;
+    ::openmldb::api::PutBatchRequest request;
+    request.set_tid(id);
+    request.set_pid(1);
+    brpc::Controller cntl;
+    for (int i = 0; i < 10; i++) {
+        std::string key = "test" + std::to_string(i % 2);
+        std::string value = ::openmldb::test::EncodeKV(key, "value" + std::to_string(i));
+        auto row = request.add_rows();
+        row->set_time(9527 + i);
+        row->set_value_size(value.size());
+        auto dimension = row->add_dimensions();
+        dimension->set_key(key);
+        dimension->set_idx(0);
+        cntl.request_attachment().append(value);
+    }
+    {
+        // the attachment does not match the rows
+        brpc::Controller bad_cntl;
+        bad_cntl.request_attachment().append("123");
+        ::openmldb::api::PutBatchResponse response;
+        tablet.PutBatch(&bad_cntl, &request, &response, &closure);
+        ASSERT_NE(0, response.code());
+    }
+    ::openmldb::api::PutBatchResponse response;
+    tablet.PutBatch(&cntl, &request, &response, &closure);
+    ASSERT_EQ(0, response.code());
+    ASSERT_EQ(10u, response.put_cnt());
+    for (int i = 0; i < 2; i++) {
+        ::openmldb::api::ScanRequest sr;
+        sr.set_tid(id);
+        sr.set_pid(1);
+        sr.set_pk("test" + std::to_string(i));
+        sr.set_st(9600);
+        sr.set_et(0);
+        ::openmldb::api::ScanResponse srp;
+        tablet.Scan(NULL, &sr, &srp, &closure);
+        ASSERT_EQ(0, srp.code());
+        ASSERT_EQ(5, (signed)srp.count());
+    }
+}
+
+TEST_P(TabletImplTest, DurablePut) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    ASSERT_EQ(0, CreateDefaultTable("", "t0", id, 1, 0, 0, kAbsoluteTime, storage_mode, &tablet));
+    // the puts of a table created with binlog_durable are durable without the flag of request
+    uint32_t durable_id = counter++;
+    {
+        ::openmldb::api::CreateTableRequest request;
+        ::openmldb::api::TableMeta* table_meta = request.mutable_table_meta();
+        table_meta->set_name("t1");
+        table_meta->set_tid(durable_id);
+        table_meta->set_pid(1);
+        table_meta->set_mode(::openmldb::api::TableMode::kTableLeader);
+        table_meta->set_storage_mode(storage_mode);
+        table_meta->set_binlog_durable(true);
+        AddDefaultSchema(0, 0, kAbsoluteTime, table_meta);
+        ::openmldb::api::CreateTableResponse response;
+        MockClosure closure;
+        tablet.CreateTable(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+    }
+    class SyncedClosure : public ::google::protobuf::Closure {
+     public:
+        void Run() override { synced.set_value(); }
+        std::promise<void> synced;
+    };
+    for (int i = 0; i < 20; i++) {
+        ::openmldb::api::PutRequest prequest;
+        ::openmldb::test::SetDimension(0, "test", prequest.add_dimensions());
+        prequest.set_time(9527 + i);
+        prequest.set_value(::openmldb::test::EncodeKV("test", "value" + std::to_string(i)));
+        prequest.set_pid(1);
+        if (i < 10) {
+            prequest.set_tid(id);
+            prequest.set_durable(true);
+        } else {
+            prequest.set_tid(durable_id);
+        }
+        ::openmldb::api::PutResponse presponse;
+        SyncedClosure closure;
+        tablet.Put(NULL, &prequest, &presponse, &closure);
+        // the response is sent after the binlog is synced
+        closure.synced.get_future().wait();
+        ASSERT_EQ(0, presponse.code());
+    }
+}
+
+TEST_P(TabletImplTest, AppendEntries) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    MockClosure closure;
+    {
+        ::openmldb::api::CreateTableRequest request;
+        ::openmldb::api::TableMeta* table_meta = request.mutable_table_meta();
+        table_meta->set_name("t0");
+        table_meta->set_tid(id);
+        table_meta->set_pid(1);
+        table_meta->set_mode(::openmldb::api::TableMode::kTableFollower);
+        table_meta->set_storage_mode(storage_mode);
+        AddDefaultSchema(0, 0, kAbsoluteTime, table_meta);
+        ::openmldb::api::CreateTableResponse response;
+        tablet.CreateTable(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+    }
+    // the puts of a batch are applied in parallel, the delete waits for the puts before it
+    ::openmldb::api::AppendEntriesRequest request;
+    request.set_tid(id);
+    request.set_pid(1);
+    request.set_pre_log_index(0);
+    uint64_t log_index = 0;
+    auto add_put = [&](int i) {
+        std::string key = "test" + std::to_string(i % 10);
+        auto entry = request.add_entries();
+        entry->set_log_index(++log_index);
+        entry->set_ts(9527 + i);
+        entry->set_value(::openmldb::test::EncodeKV(key, "value" + std::to_string(i)));
+        ::openmldb::test::AddDimension(0, key, entry);
+    };
+    for (int i = 0; i < 100; i++) {
+        add_put(i);
+    }
+    auto entry = request.add_entries();
+    entry->set_log_index(++log_index);
+    entry->set_method_type(::openmldb::api::MethodType::kDelete);
+    ::openmldb::test::AddDimension(0, "test0", entry);
+    for (int i = 100; i < 120; i++) {
+        add_put(i);
+    }
+    ::openmldb::api::AppendEntriesResponse response;
+    tablet.AppendEntries(NULL, &request, &response, &closure);
+    ASSERT_EQ(0, response.code());
+    ASSERT_EQ(log_index, response.log_offset());
+    for (int i = 0; i < 10; i++) {
+        ::openmldb::api::ScanRequest sr;
+        sr.set_tid(id);
+        sr.set_pid(1);
+        sr.set_pk("test" + std::to_string(i));
+        sr.set_st(9700);
+        sr.set_et(0);
+        ::openmldb::api::ScanResponse srp;
+        tablet.Scan(NULL, &sr, &srp, &closure);
+        ASSERT_EQ(0, srp.code());
+        ASSERT_EQ(i == 0 ? 2 : 12, (signed)srp.count());
+    }
+    // the entries already applied are skipped
+    response.Clear();
+    tablet.AppendEntries(NULL, &request, &response, &closure);
+    ASSERT_EQ(0, response.code());
+    ASSERT_EQ(log_index, response.log_offset());
+}
+
+TEST_P(TabletImplTest, AppendEntriesRecords) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    MockClosure closure;
+    {
+        ::openmldb::api::CreateTableRequest request;
+        ::openmldb::api::TableMeta* table_meta = request.mutable_table_meta();
+        table_meta->set_name("t0");
+        table_meta->set_tid(id);
+        table_meta->set_pid(1);
+        table_meta->set_mode(::openmldb::api::TableMode::kTableFollower);
+        table_meta->set_storage_mode(storage_mode);
+        AddDefaultSchema(0, 0, kAbsoluteTime, table_meta);
+        ::openmldb::api::CreateTableResponse response;
+        tablet.CreateTable(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+    }
+    // the entries are sent as the binlog records in the attachment
+    auto make_request = [id](uint64_t pre_log_index, int num, ::openmldb::api::AppendEntriesRequest* request,
+                             std::string* records) {
+        request->set_tid(id);
+        request->set_pid(1);
+        request->set_pre_log_index(pre_log_index);
+        for (int i = 0; i < num; i++) {
+            std::string key = "test" + std::to_string(i % 2);
+            ::openmldb::api::LogEntry entry;
+            entry.set_log_index(pre_log_index + i + 1);
+            entry.set_ts(9527 + pre_log_index + i);
+            entry.set_value(::openmldb::test::EncodeKV(key, "value" + std::to_string(i)));
+            ::openmldb::test::AddDimension(0, key, &entry);
+            std::string record;
+            entry.SerializeToString(&record);
+            request->add_record_size(record.size());
+            records->append(record);
+        }
+    };
+    {
+        ::openmldb::api::AppendEntriesRequest request;
+        std::string records;
+        make_request(0, 10, &request, &records);
+        request.set_record_crc(::openmldb::log::Value(records.data(), records.size()) + 1);
+        brpc::Controller cntl;
+        cntl.request_attachment().append(records);
+        ::openmldb::api::AppendEntriesResponse response;
+        tablet.AppendEntries(&cntl, &request, &response, &closure);
+        ASSERT_NE(0, response.code());
+    }
+    {
+        ::openmldb::api::AppendEntriesRequest request;
+        std::string records;
+        make_request(0, 10, &request, &records);
+        request.set_record_crc(::openmldb::log::Value(records.data(), records.size()));
+        brpc::Controller cntl;
+        cntl.request_attachment().append(records);
+        ::openmldb::api::AppendEntriesResponse response;
+        tablet.AppendEntries(&cntl, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+        ASSERT_EQ(10u, response.log_offset());
+    }
+    {
+        ::openmldb::api::AppendEntriesRequest request;
+        std::string records;
+        make_request(10, 10, &request, &records);
+        std::string compressed;
+        ::snappy::Compress(records.data(), records.size(), &compressed);
+        request.set_record_compress_type(::openmldb::type::CompressType::kSnappy);
+        request.set_record_crc(::openmldb::log::Value(compressed.data(), compressed.size()));
+        brpc::Controller cntl;
+        cntl.request_attachment().append(compressed);
+        ::openmldb::api::AppendEntriesResponse response;
+        tablet.AppendEntries(&cntl, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+        ASSERT_EQ(20u, response.log_offset());
+    }
+    for (int i = 0; i < 2; i++) {
+        ::openmldb::api::ScanRequest sr;
+        sr.set_tid(id);
+        sr.set_pid(1);
+        sr.set_pk("test" + std::to_string(i));
+        sr.set_st(9700);
+        sr.set_et(0);
+        ::openmldb::api::ScanResponse srp;
+        tablet.Scan(NULL, &sr, &srp, &closure);
+        ASSERT_EQ(0, srp.code());
+        ASSERT_EQ(10, (signed)srp.count());
+    }
+}
+
+TEST_P(TabletImplTest, AppendEntriesPreLogIndex) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    MockClosure closure;
+    {
+        ::openmldb::api::CreateTableRequest request;
+        ::openmldb::api::TableMeta* table_meta = request.mutable_table_meta();
+        table_meta->set_name("t0");
+        table_meta->set_tid(id);
+        table_meta->set_pid(1);
+        table_meta->set_mode(::openmldb::api::TableMode::kTableFollower);
+        table_meta->set_storage_mode(storage_mode);
+        AddDefaultSchema(0, 0, kAbsoluteTime, table_meta);
+        ::openmldb::api::CreateTableResponse response;
+        tablet.CreateTable(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+    }
+    auto make_request = [id](uint64_t pre_log_index, int num, ::openmldb::api::AppendEntriesRequest* request) {
+        request->set_tid(id);
+        request->set_pid(1);
+        request->set_pre_log_index(pre_log_index);
+        for (int i = 0; i < num; i++) {
+            auto entry = request->add_entries();
+            entry->set_log_index(pre_log_index + i + 1);
+            entry->set_ts(9527 + pre_log_index + i);
+            entry->set_value(::openmldb::test::EncodeKV("test0", "value" + std::to_string(pre_log_index + i)));
+            ::openmldb::test::AddDimension(0, "test0", entry);
+        }
+    };
+    // the entries after a gap are rejected whether the leader pipelines the
+    // batches or not, the leader matches the log offset again
+    {
+        ::openmldb::api::AppendEntriesRequest request;
+        make_request(5, 5, &request);
+        ::openmldb::api::AppendEntriesResponse response;
+        tablet.AppendEntries(NULL, &request, &response, &closure);
+        ASSERT_EQ(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator, response.code());
+        ASSERT_EQ(0u, response.log_offset());
+    }
+    // a batch that arrives before the previous one waits for it and both are
+    // applied in order
+    int32_t old_wait_time = FLAGS_binlog_sync_wait_time;
+    FLAGS_binlog_sync_wait_time = 10000;
+    absl::Cleanup reset = [old_wait_time]() { FLAGS_binlog_sync_wait_time = old_wait_time; };
+    ::openmldb::api::AppendEntriesRequest later_request;
+    make_request(5, 5, &later_request);
+    ::openmldb::api::AppendEntriesResponse later_response;
+    auto later = std::async(std::launch::async, [&]() {
+        MockClosure later_closure;
+        tablet.AppendEntries(NULL, &later_request, &later_response, &later_closure);
+    });
+    {
+        ::openmldb::api::AppendEntriesRequest request;
+        make_request(0, 5, &request);
+        ::openmldb::api::AppendEntriesResponse response;
+        tablet.AppendEntries(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+    }
+    later.wait();
+    ASSERT_EQ(0, later_response.code());
+    ASSERT_EQ(10u, later_response.log_offset());
+    ::openmldb::api::ScanRequest sr;
+    sr.set_tid(id);
+    sr.set_pid(1);
+    sr.set_pk("test0");
+    sr.set_st(9700);
+    sr.set_et(0);
+    ::openmldb::api::ScanResponse srp;
+    tablet.Scan(NULL, &sr, &srp, &closure);
+    ASSERT_EQ(0, srp.code());
+    ASSERT_EQ(10, (signed)srp.count());
+}
+
+TEST_P(TabletImplTest, AppendEntriesMultiIndex) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    tablet.Init("");
+    MockClosure closure;
+    int32_t old_pool_size = FLAGS_follower_apply_pool_size;
+    absl::Cleanup reset = [old_pool_size]() { FLAGS_follower_apply_pool_size = old_pool_size; };
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_name("t0");
+    table_meta.set_pid(1);
+    table_meta.set_mode(::openmldb::api::TableMode::kTableFollower);
+    table_meta.set_storage_mode(storage_mode);
+    table_meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "mcc", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "value", ::openmldb::type::kString);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "", ::openmldb::type::kAbsoluteTime, 0, 0);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "mcc", "mcc", "", ::openmldb::type::kAbsoluteTime, 0, 0);
+    // the entries differ on the first index and share the key of the second
+    // one, they are put with the same ts so the result depends on their order
+    ::openmldb::api::AppendEntriesRequest request;
+    request.set_pre_log_index(0);
+    for (int i = 0; i < 100; i++) {
+        auto entry = request.add_entries();
+        entry->set_log_index(i + 1);
+        entry->set_ts(9527);
+        std::string card = "card" + std::to_string(i);
+        ::openmldb::codec::RowCodec::EncodeRow({card, "mcc0", "value" + std::to_string(i)}, table_meta.column_desc(),
+                                               1, *(entry->mutable_value()));
+        ::openmldb::test::AddDimension(0, card, entry);
+        ::openmldb::test::AddDimension(1, "mcc0", entry);
+    }
+    // the serial apply is the reference
+    std::vector<std::string> pairs;
+    for (int32_t pool_size : {1, 4}) {
+        FLAGS_follower_apply_pool_size = pool_size;
+        uint32_t id = counter++;
+        {
+            ::openmldb::api::CreateTableRequest create_request;
+            create_request.mutable_table_meta()->CopyFrom(table_meta);
+            create_request.mutable_table_meta()->set_tid(id);
+            ::openmldb::api::CreateTableResponse response;
+            tablet.CreateTable(NULL, &create_request, &response, &closure);
+            ASSERT_EQ(0, response.code());
+        }
+        request.set_tid(id);
+        request.set_pid(1);
+        ::openmldb::api::AppendEntriesResponse response;
+        tablet.AppendEntries(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+        ASSERT_EQ(100u, response.log_offset());
+        ::openmldb::api::ScanRequest sr;
+        sr.set_tid(id);
+        sr.set_pid(1);
+        sr.set_pk("mcc0");
+        sr.set_idx_name("mcc");
+        sr.set_st(9700);
+        sr.set_et(0);
+        ::openmldb::api::ScanResponse srp;
+        tablet.Scan(NULL, &sr, &srp, &closure);
+        ASSERT_EQ(0, srp.code());
+        pairs.push_back(srp.pairs());
+    }
+    ASSERT_EQ(pairs[0], pairs[1]);
+}
+
+TEST_P(TabletImplTest, AppendEntriesPutFailure) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    // a disk table accepts an entry without a dimension
+    if (storage_mode != ::openmldb::common::kMemory) {
+        GTEST_SKIP();
+    }
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    MockClosure closure;
+    {
+        ::openmldb::api::CreateTableRequest request;
+        ::openmldb::api::TableMeta* table_meta = request.mutable_table_meta();
+        table_meta->set_name("t0");
+        table_meta->set_tid(id);
+        table_meta->set_pid(1);
+        table_meta->set_mode(::openmldb::api::TableMode::kTableFollower);
+        table_meta->set_storage_mode(storage_mode);
+        AddDefaultSchema(0, 0, kAbsoluteTime, table_meta);
+        ::openmldb::api::CreateTableResponse response;
+        tablet.CreateTable(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+    }
+    ::openmldb::api::AppendEntriesRequest request;
+    request.set_tid(id);
+    request.set_pid(1);
+    request.set_pre_log_index(0);
+    for (int i = 0; i < 20; i++) {
+        std::string key = "test" + std::to_string(i % 2);
+        auto entry = request.add_entries();
+        entry->set_log_index(i + 1);
+        entry->set_ts(9527 + i);
+        entry->set_value(::openmldb::test::EncodeKV(key, "value" + std::to_string(i)));
+        // the fifth entry fails to put
+        if (i != 4) {
+            ::openmldb::test::AddDimension(0, key, entry);
+        }
+    }
+    ::openmldb::api::AppendEntriesResponse response;
+    tablet.AppendEntries(NULL, &request, &response, &closure);
+    ASSERT_EQ(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator, response.code());
+    // the leader sends the batch again after it matches the log offset, all the
+    // entries are in the binlog and skipped
+    response.Clear();
+    tablet.AppendEntries(NULL, &request, &response, &closure);
+    ASSERT_EQ(0, response.code());
+    ASSERT_EQ(20u, response.log_offset());
+    // all the entries but the failed one are put
+    for (int i = 0; i < 2; i++) {
+        ::openmldb::api::ScanRequest sr;
+        sr.set_tid(id);
+        sr.set_pid(1);
+        sr.set_pk("test" + std::to_string(i));
+        sr.set_st(9700);
+        sr.set_et(0);
+        ::openmldb::api::ScanResponse srp;
+        tablet.Scan(NULL, &sr, &srp, &closure);
+        ASSERT_EQ(0, srp.code());
+        ASSERT_EQ(i == 0 ? 9 : 10, (signed)srp.count());
+    }
+}
+
 TEST_P(TabletImplTest, GCWithUpdateLatest) {
     ::openmldb::common::StorageMode storage_mode = GetParam();
     int32_t old_gc_interval = FLAGS_gc_interval;